@@ -0,0 +1,352 @@
+// Copyright 2023 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "dnn.h"
+#include "nnlinear_opt.h"
+#include "snrt.h"
+
+/**
+ * @struct nnlinear_stats_t
+ * @brief Statistics of a training run
+ *
+ * @var nnlinear_stats_t::cycles
+ * Cycles of the training loop, including the final write-back
+ * @var nnlinear_stats_t::images
+ * Number of images trained on, over all epochs
+ * @var nnlinear_stats_t::correct
+ * Correct predictions, each made before the update of its mini-batch
+ * @var nnlinear_stats_t::loss
+ * Mean cross-entropy loss over all images
+ */
+typedef struct {
+    uint32_t cycles;
+    uint32_t images;
+    uint32_t correct;
+    float loss;
+} nnlinear_stats_t;
+
+/**
+ * @brief Load a tile of images and labels into TCDM
+ *
+ * @param n network
+ * @param images TCDM buffer of the images
+ * @param labels TCDM buffer of the labels
+ * @param first index of the first image in the dataset
+ * @param rows number of images
+ * @param in_ch number of input channels
+ */
+static inline void nnlinear_load_tile(const network_fp32_t *n, float *images,
+                                      uint32_t *labels, uint32_t first,
+                                      uint32_t rows, uint32_t in_ch) {
+    snrt_dma_start_1d(images, n->images + first * in_ch,
+                      rows * in_ch * sizeof(float));
+    snrt_dma_start_1d(labels, n->targets + first, rows * sizeof(uint32_t));
+}
+
+/**
+ * @brief Sum the gradients of all clusters and update the parameters
+ *
+ * Every cluster stores its gradients to its slot in main memory. Each
+ * cluster then reduces one share of the weight gradients, updates its share
+ * of the weights and stores it, while the bias gradients are reduced by every
+ * cluster. Finally every cluster reloads the complete weights.
+ *
+ * @param scratch TCDM buffer for the gradients of the other clusters
+ * @param scratch_len size of the scratch buffer in elements
+ * @param scale learning rate divided by the batch size
+ */
+static inline void nnlinear_allreduce_opt(
+    const network_fp32_t *n, float *biases, float *weights,
+    float *W_gradients, const float *b_gradients, float *scratch,
+    uint32_t scratch_len, uint32_t in_ch, uint32_t out_ch, float scale) {
+    const uint32_t cluster_num = snrt_cluster_num();
+    const uint32_t cluster_id = snrt_cluster_idx();
+    const uint32_t compute_num = snrt_cluster_compute_core_num();
+    const uint32_t compute_id = snrt_cluster_core_idx();
+    const uint32_t params = out_ch * in_ch;
+
+    if (snrt_is_dm_core()) {
+        snrt_dma_start_1d(n->W_grad + cluster_id * params, W_gradients,
+                          params * sizeof(float));
+        snrt_dma_start_1d(n->b_grad + cluster_id * out_ch, b_gradients,
+                          out_ch * sizeof(float));
+        snrt_dma_wait_all();
+    }
+
+    snrt_global_barrier();
+
+    // Share of the weights of this cluster, in packed pairs
+    uint32_t frac = params / 2 / cluster_num;
+    uint32_t rem = params / 2 % cluster_num;
+    uint32_t share0 = 2 * (cluster_id * frac + min(cluster_id, rem));
+    uint32_t share = 2 * (frac + (cluster_id < rem));
+
+    // Gradients of the other clusters are loaded in chunks which fit into
+    // the scratch buffer side by side
+    uint32_t others = cluster_num - 1;
+    uint32_t chunk = (scratch_len / others) & ~1;
+
+    for (uint32_t off = 0; off < share; off += chunk) {
+        uint32_t len = min(chunk, share - off);
+        uint32_t i0 = share0 + off;
+
+        if (snrt_is_dm_core()) {
+            for (uint32_t c = 0, s = 0; c < cluster_num; c++) {
+                if (c == cluster_id) continue;
+                snrt_dma_start_1d(scratch + s++ * chunk,
+                                  n->W_grad + c * params + i0,
+                                  len * sizeof(float));
+            }
+            snrt_dma_wait_all();
+        }
+
+        snrt_cluster_hw_barrier();
+
+        if (snrt_is_compute_core()) {
+            for (uint32_t i = compute_id; i < len; i += compute_num) {
+                float grad = W_gradients[i0 + i];
+                for (uint32_t s = 0; s < others; s++)
+                    grad += scratch[s * chunk + i];
+                weights[i0 + i] -= scale * grad;
+            }
+        }
+
+        snrt_cluster_hw_barrier();
+    }
+
+    if (snrt_is_dm_core()) {
+        snrt_dma_start_1d(n->W + share0, weights + share0,
+                          share * sizeof(float));
+        snrt_dma_start_1d(scratch, n->b_grad,
+                          cluster_num * out_ch * sizeof(float));
+        snrt_dma_wait_all();
+    }
+
+    snrt_cluster_hw_barrier();
+
+    // All clusters sum the bias gradients in the same order and therefore
+    // keep identical biases
+    if (snrt_is_compute_core() && compute_id == 0) {
+        for (uint32_t o = 0; o < out_ch; o++) {
+            float grad = 0;
+            for (uint32_t c = 0; c < cluster_num; c++)
+                grad += scratch[c * out_ch + o];
+            biases[o] -= scale * grad;
+        }
+    }
+
+    snrt_global_barrier();
+
+    if (snrt_is_dm_core()) {
+        snrt_dma_start_1d(weights, n->W, params * sizeof(float));
+        snrt_dma_wait_all();
+    }
+
+    snrt_cluster_hw_barrier();
+}
+
+/**
+ * @brief MNIST network trained with mini-batch SGD on all clusters and
+ *        compute cores
+ *
+ * Every mini-batch is split into contiguous slices, one per cluster. The DM
+ * core of a cluster streams its slice from main memory through two TCDM tiles
+ * of images and labels, loading the next tile while the compute cores process
+ * the current one. The forward pass and the weight gradient are computed with
+ * SSR and FREP kernels. After every mini-batch the gradients are summed
+ * across clusters and all clusters apply the same SGD update to their copy of
+ * the parameters, which stays resident in TCDM.
+ *
+ * n->W_grad and n->b_grad provide one slot of gradients per cluster in main
+ * memory and are used as scratch. The first two words of the weight gradient
+ * slots are overwritten by the statistics of the clusters at the end. The
+ * trained parameters are written back to n->W and n->b. Images beyond the
+ * last whole mini-batch are not used.
+ *
+ * Must be called by all cores of all clusters.
+ *
+ * @param n network with images, labels and parameters in main memory
+ * @param n_images number of images in the dataset
+ * @param batch_size number of images per mini-batch
+ * @param epochs number of passes over the dataset
+ * @param stats returns the statistics of the run on global core 0
+ * @return 0 on success, -1 if the configuration is not supported or the
+ *         parameters do not fit into TCDM
+ */
+static inline int nnlinear_backend_opt(const network_fp32_t *n,
+                                       uint32_t n_images, uint32_t batch_size,
+                                       uint32_t epochs,
+                                       nnlinear_stats_t *stats) {
+    const uint32_t cluster_num = snrt_cluster_num();
+    const uint32_t cluster_id = snrt_cluster_idx();
+    const uint32_t compute_num = snrt_cluster_compute_core_num();
+    const uint32_t compute_id = snrt_cluster_core_idx();
+
+    const uint32_t in_ch = n->IN_CH1 * n->IN_CH2;
+    const uint32_t out_ch = n->OUT_CH;
+    const uint32_t params = out_ch * in_ch;
+    const uint32_t ldl = ALIGN_UP(out_ch, 2);
+
+    // The kernels stream packed pairs of input channels
+    if (in_ch % 2 || batch_size == 0 || n_images < batch_size) return -1;
+
+    uint32_t first;
+    uint32_t n_rows = dnn_cluster_rows(batch_size, &first);
+
+    // TCDM holds the parameters, their gradients and per-core statistics,
+    // followed by the tiles. Every image of a tile needs its logits, the
+    // gradients of its logits and two buffers for the image and its label.
+    uint32_t base = ALIGN_UP((uint32_t)snrt_l1_next(), sizeof(double));
+    uint32_t end = snrt_l1_end_addr() - DNN_L1_RESERVE;
+    uint32_t fixed = (2 * params + 2 * ldl + 2 * compute_num) * sizeof(float);
+    uint32_t per_image = 2 * in_ch * sizeof(float) + 2 * sizeof(uint32_t) +
+                         out_ch * sizeof(v2f32) + ldl * sizeof(float);
+    uint32_t slack = 4 * sizeof(double);
+    if (end < base + fixed + slack + per_image) return -1;
+    uint32_t tile = (end - base - fixed - slack) / per_image;
+    if (n_rows && tile >= n_rows)
+        tile = n_rows;
+    else if (tile > compute_num)
+        tile -= tile % compute_num;
+
+    // The gradients of all clusters are reduced through a tile buffer
+    if (cluster_num > 1 && tile * in_ch < 2 * cluster_num * out_ch) return -1;
+
+    float *weights = (float *)base;
+    float *weight_grads = weights + params;
+    float *biases = weight_grads + params;
+    float *bias_grads = biases + ldl;
+    float *core_loss = bias_grads + ldl;
+    uint32_t *core_correct = (uint32_t *)(core_loss + compute_num);
+    v2f32 *grads = (v2f32 *)(core_correct + compute_num);
+    float *logits = (float *)(grads + tile * out_ch);
+    uint32_t *labels[2];
+    labels[0] = (uint32_t *)(logits + tile * ldl);
+    labels[1] = labels[0] + ALIGN_UP(tile, 2);
+    float *images[2];
+    images[0] = (float *)(labels[1] + ALIGN_UP(tile, 2));
+    images[1] = images[0] + tile * in_ch;
+
+    uint32_t batches = n_images / batch_size;
+    uint32_t steps = epochs * batches;
+    uint32_t tiles = (n_rows + tile - 1) / tile;
+    uint32_t n_tiles = steps * tiles;
+    float scale = n->learning_rate / batch_size;
+
+    if (snrt_is_dm_core()) {
+        snrt_dma_start_1d(weights, n->W, params * sizeof(float));
+        snrt_dma_start_1d(biases, n->b, out_ch * sizeof(float));
+        if (n_tiles)
+            nnlinear_load_tile(n, images[0], labels[0], first,
+                               min(tile, n_rows), in_ch);
+        snrt_dma_wait_all();
+    }
+
+    float loss = 0;
+    uint32_t correct = 0;
+
+    snrt_global_barrier();
+
+    uint32_t start = snrt_mcycle();
+
+    for (uint32_t step = 0; step < steps; step++) {
+        for (uint32_t t = 0; t < tiles; t++) {
+            uint32_t i = step * tiles + t;
+            uint32_t rows = min(tile, n_rows - t * tile);
+
+            if (snrt_is_dm_core()) {
+                // Prefetch the next tile, which may belong to the next
+                // mini-batch
+                if (i + 1 < n_tiles) {
+                    uint32_t t1 = (t + 1) % tiles;
+                    uint32_t step1 = step + (t1 == 0);
+                    nnlinear_load_tile(n, images[(i + 1) % 2],
+                                       labels[(i + 1) % 2],
+                                       (step1 % batches) * batch_size + first +
+                                           t1 * tile,
+                                       min(tile, n_rows - t1 * tile), in_ch);
+                }
+                snrt_cluster_hw_barrier();
+                snrt_dma_wait_all();
+                snrt_cluster_hw_barrier();
+            } else {
+                FeedForward_opt(images[i % 2], logits, biases, weights, rows,
+                                in_ch, out_ch, ldl, compute_id, compute_num);
+                SoftMaxLoss_opt(logits, grads, labels[i % 2], rows, out_ch,
+                                ldl, compute_id, compute_num, &loss, &correct);
+                snrt_cluster_hw_barrier();
+                GradientUpdate_opt(images[i % 2], grads, weight_grads,
+                                   bias_grads, rows, in_ch, out_ch, t > 0,
+                                   compute_id, compute_num);
+                snrt_cluster_hw_barrier();
+            }
+        }
+
+        // Clusters without images contribute zero gradients
+        if (tiles == 0 && snrt_is_compute_core()) {
+            for (uint32_t j = compute_id; j < params; j += compute_num)
+                weight_grads[j] = 0;
+            if (compute_id == 0)
+                for (uint32_t o = 0; o < out_ch; o++) bias_grads[o] = 0;
+        }
+
+        if (cluster_num == 1) {
+            if (snrt_is_compute_core())
+                TrainingStep_opt(biases, weights, weight_grads, bias_grads,
+                                 in_ch, out_ch, scale, compute_id,
+                                 compute_num);
+            snrt_cluster_hw_barrier();
+        } else {
+            // The tile buffer processed last is free, the other one may
+            // hold the prefetched tile
+            nnlinear_allreduce_opt(
+                n, biases, weights, weight_grads, bias_grads,
+                images[(step * tiles + tiles - 1) % 2], tile * in_ch, in_ch,
+                out_ch, scale);
+        }
+    }
+
+    // Reduce the statistics of the cluster into its gradient slot
+    if (snrt_is_compute_core()) {
+        core_loss[compute_id] = loss;
+        core_correct[compute_id] = correct;
+    }
+
+    snrt_cluster_hw_barrier();
+
+    if (snrt_is_compute_core() && compute_id == 0) {
+        for (uint32_t c = 1; c < compute_num; c++) {
+            loss += core_loss[c];
+            correct += core_correct[c];
+        }
+        n->W_grad[cluster_id * params] = loss;
+        ((uint32_t *)n->W_grad)[cluster_id * params + 1] = correct;
+    }
+
+    // Weights in main memory are already up to date with multiple clusters
+    if (snrt_is_dm_core() && cluster_id == 0) {
+        if (cluster_num == 1)
+            snrt_dma_start_1d(n->W, weights, params * sizeof(float));
+        snrt_dma_start_1d(n->b, biases, out_ch * sizeof(float));
+        snrt_dma_wait_all();
+    }
+
+    snrt_global_barrier();
+
+    if (snrt_global_core_idx() == 0) {
+        stats->cycles = snrt_mcycle() - start;
+        stats->images = steps * batch_size;
+        stats->correct = 0;
+        stats->loss = 0;
+        for (uint32_t c = 0; c < cluster_num; c++) {
+            stats->loss += n->W_grad[c * params];
+            stats->correct += ((uint32_t *)n->W_grad)[c * params + 1];
+        }
+        if (stats->images) stats->loss /= stats->images;
+    }
+
+    return 0;
+}
@@ -40,7 +40,7 @@ void nnlinear_backend_baseline(const network_fp32_t *n) {
     uint32_t global_compute_num =
         snrt_global_core_num();  // Total cores incl. DM core per cluster
     uint32_t compute_id =
-        snrt_cluster_compute_core_num();  // Core ID of each compute core
+        snrt_cluster_core_idx();  // Core ID of each compute core
     uint32_t dm_id = snrt_cluster_dm_core_idx();  // DM core ID of each cluster
     uint32_t global_compute_id =
         snrt_global_core_idx();  // Core ID of each core on all clusters
@@ -0,0 +1,261 @@
+// Copyright 2023 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "dnn.h"
+#include "math.h"
+#include "snrt.h"
+
+/**
+ * Optimized kernels for mini-batch training on all compute cores of a
+ * cluster. The images of a tile are interleaved across the compute cores in
+ * the forward pass, the weight gradient is split along the input channels.
+ */
+
+// Packed pairs of input channels accumulated per step of the weight gradient
+#define NNLINEAR_UNROLL 8
+
+// Input channels of a block of the weight gradient
+#define NNLINEAR_BLOCK (2 * NNLINEAR_UNROLL)
+
+/**
+ * @brief Blocks of input channels assigned to a compute core
+ *
+ * Remainder blocks are given to the first cores, one each. Input channels
+ * beyond the last whole block are handled by the last core.
+ *
+ * @param in_ch number of input channels
+ * @param core index of the calling compute core
+ * @param cores number of compute cores
+ * @param first returns the first input channel of the core
+ * @return number of blocks of the core
+ */
+static inline uint32_t nnlinear_core_blocks(uint32_t in_ch, uint32_t core,
+                                            uint32_t cores, uint32_t *first) {
+    uint32_t blocks = in_ch / NNLINEAR_BLOCK;
+    uint32_t frac = blocks / cores;
+    uint32_t rem = blocks % cores;
+    *first = (core * frac + (core < rem ? core : rem)) * NNLINEAR_BLOCK;
+    return frac + (core < rem);
+}
+
+/**
+ * FeedForward calculation
+ *
+ * Logits of the images of the calling core, computed with the SSR/FREP GEMM
+ * kernel on top of the biases. Logit rows are ldl elements apart, which must
+ * be even for the packed stores of the kernel.
+ */
+
+static inline void FeedForward_opt(const float *images, float *logits,
+                                   const float *biases, const float *weights,
+                                   uint32_t rows, uint32_t in_ch,
+                                   uint32_t out_ch, uint32_t ldl, uint32_t core,
+                                   uint32_t cores) {
+    uint32_t m_core = rows / cores + (core < rows % cores);
+    if (m_core == 0) return;
+
+    for (uint32_t r = core; r < rows; r += cores) {
+        for (uint32_t o = 0; o < out_ch; o++) logits[r * ldl + o] = biases[o];
+    }
+
+    gemm_core(FP32, 0, 1, 0, 1, m_core, out_ch, in_ch, 1,
+              (void *)(images + core * in_ch), cores * in_ch, (void *)weights,
+              in_ch, 1, logits + core * ldl, cores * ldl);
+}
+
+/**
+ * SoftMax and cross-entropy loss calculation
+ *
+ * Replaces the logits of the images of the calling core by their softmax
+ * activations and stores the gradient of the loss with respect to the
+ * logits, replicated into both lanes of a packed vector. The loss and the
+ * number of correct predictions are accumulated.
+ */
+
+static inline void SoftMaxLoss_opt(float *logits, v2f32 *grads,
+                                   const uint32_t *labels, uint32_t rows,
+                                   uint32_t out_ch, uint32_t ldl,
+                                   uint32_t core, uint32_t cores, float *loss,
+                                   uint32_t *correct) {
+    for (uint32_t r = core; r < rows; r += cores) {
+        float *z = logits + r * ldl;
+        v2f32 *g = grads + r * out_ch;
+        uint32_t label = labels[r];
+
+        float max = z[0];
+        uint32_t predict = 0;
+        for (uint32_t o = 1; o < out_ch; o++) {
+            if (z[o] > max) {
+                max = z[o];
+                predict = o;
+            }
+        }
+        float z_label = z[label];
+
+        float sum = 0;
+        for (uint32_t o = 0; o < out_ch; o++) {
+            z[o] = fast_expf(z[o] - max);
+            sum += z[o];
+        }
+
+        *loss += log2f(sum) * (float)M_LN2 + max - z_label;
+        *correct += (predict == label);
+
+        float inv = fast_recipf(sum);
+        for (uint32_t o = 0; o < out_ch; o++) {
+            float p = z[o] * inv - (o == label);
+            g[o] = (v2f32){p, p};
+        }
+    }
+}
+
+/**
+ * Gradient update calculation
+ *
+ * Accumulates the outer products of the logit gradients and the images of a
+ * tile into the weight and bias gradients, or overwrites them if accumulate
+ * is zero. Every core computes its blocks of input channels for all outputs:
+ * SSR 0 streams the image columns of a block, SSR 1 repeats every logit
+ * gradient over the packed pairs of the block and FREP iterates over the
+ * images. Requires an even number of input channels.
+ */
+
+static inline void GradientUpdate_opt(const float *images, const v2f32 *grads,
+                                      float *W_gradients, float *b_gradients,
+                                      uint32_t rows, uint32_t in_ch,
+                                      uint32_t out_ch, uint32_t accumulate,
+                                      uint32_t core, uint32_t cores) {
+    uint32_t c0;
+    uint32_t blocks = nnlinear_core_blocks(in_ch, core, cores, &c0);
+
+    if (blocks) {
+        snrt_ssr_loop_4d(SNRT_SSR_DM0, NNLINEAR_UNROLL, rows, blocks, out_ch,
+                         sizeof(v2f32), in_ch * sizeof(float),
+                         NNLINEAR_BLOCK * sizeof(float), 0);
+        snrt_ssr_repeat(SNRT_SSR_DM0, 1);
+        snrt_ssr_loop_3d(SNRT_SSR_DM1, rows, blocks, out_ch,
+                         out_ch * sizeof(v2f32), 0, sizeof(v2f32));
+        snrt_ssr_repeat(SNRT_SSR_DM1, NNLINEAR_UNROLL);
+
+        snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_4D, (void *)(images + c0));
+        snrt_ssr_read(SNRT_SSR_DM1, SNRT_SSR_3D, (void *)grads);
+        snrt_ssr_enable();
+
+        const uint32_t n_frep = rows - 1;
+        const register float zero = 0.0;
+
+        for (uint32_t o = 0; o < out_ch; o++) {
+            for (uint32_t b = 0; b < blocks; b++) {
+                float *dw = W_gradients + o * in_ch + c0 + b * NNLINEAR_BLOCK;
+                v2f32 c[NNLINEAR_UNROLL];
+
+                asm volatile(
+                    "beqz    %[acc], 1f \n"
+                    // Load intermediate results
+                    "fld     %[c0], 0(%[dw]) \n"
+                    "fld     %[c1], 8(%[dw]) \n"
+                    "fld     %[c2], 16(%[dw]) \n"
+                    "fld     %[c3], 24(%[dw]) \n"
+                    "fld     %[c4], 32(%[dw]) \n"
+                    "fld     %[c5], 40(%[dw]) \n"
+                    "fld     %[c6], 48(%[dw]) \n"
+                    "fld     %[c7], 56(%[dw]) \n"
+                    "j       2f \n"
+                    "1: \n"
+                    // Initialize SIMD vector with zeros
+                    "vfcpka.s.s %[c0], %[zero], %[zero] \n"
+                    "vfcpka.s.s %[c1], %[zero], %[zero] \n"
+                    "vfcpka.s.s %[c2], %[zero], %[zero] \n"
+                    "vfcpka.s.s %[c3], %[zero], %[zero] \n"
+                    "vfcpka.s.s %[c4], %[zero], %[zero] \n"
+                    "vfcpka.s.s %[c5], %[zero], %[zero] \n"
+                    "vfcpka.s.s %[c6], %[zero], %[zero] \n"
+                    "vfcpka.s.s %[c7], %[zero], %[zero] \n"
+                    "2: \n"
+                    // frep over images
+                    "frep.o  %[n_frep], 8, 0, 0 \n"
+                    "vfmac.s %[c0], ft0, ft1 \n"
+                    "vfmac.s %[c1], ft0, ft1 \n"
+                    "vfmac.s %[c2], ft0, ft1 \n"
+                    "vfmac.s %[c3], ft0, ft1 \n"
+                    "vfmac.s %[c4], ft0, ft1 \n"
+                    "vfmac.s %[c5], ft0, ft1 \n"
+                    "vfmac.s %[c6], ft0, ft1 \n"
+                    "vfmac.s %[c7], ft0, ft1 \n"
+                    // Store results
+                    "fsd     %[c0], 0(%[dw]) \n"
+                    "fsd     %[c1], 8(%[dw]) \n"
+                    "fsd     %[c2], 16(%[dw]) \n"
+                    "fsd     %[c3], 24(%[dw]) \n"
+                    "fsd     %[c4], 32(%[dw]) \n"
+                    "fsd     %[c5], 40(%[dw]) \n"
+                    "fsd     %[c6], 48(%[dw]) \n"
+                    "fsd     %[c7], 56(%[dw]) \n"
+                    : [ c0 ] "=&f"(c[0]), [ c1 ] "=&f"(c[1]),
+                      [ c2 ] "=&f"(c[2]), [ c3 ] "=&f"(c[3]),
+                      [ c4 ] "=&f"(c[4]), [ c5 ] "=&f"(c[5]),
+                      [ c6 ] "=&f"(c[6]), [ c7 ] "=&f"(c[7])
+                    : [ dw ] "r"(dw), [ acc ] "r"(accumulate),
+                      [ zero ] "f"(zero), [ n_frep ] "r"(n_frep)
+                    : "ft0", "ft1", "ft2", "memory");
+            }
+        }
+
+        snrt_fpu_fence();
+        snrt_ssr_disable();
+
+        // Other kernels expect streams without repetition
+        snrt_ssr_repeat(SNRT_SSR_DM1, 1);
+    }
+
+    // Input channels beyond the last whole block
+    if (core == cores - 1) {
+        for (uint32_t o = 0; o < out_ch; o++) {
+            for (uint32_t j = in_ch - in_ch % NNLINEAR_BLOCK; j < in_ch; j++) {
+                float acc = accumulate ? W_gradients[o * in_ch + j] : 0;
+                for (uint32_t t = 0; t < rows; t++)
+                    acc += grads[t * out_ch + o][0] * images[t * in_ch + j];
+                W_gradients[o * in_ch + j] = acc;
+            }
+        }
+    }
+
+    if (core == 0) {
+        for (uint32_t o = 0; o < out_ch; o++) {
+            float acc = accumulate ? b_gradients[o] : 0;
+            for (uint32_t t = 0; t < rows; t++) acc += grads[t * out_ch + o][0];
+            b_gradients[o] = acc;
+        }
+    }
+}
+
+/**
+ * Training step calculation
+ *
+ * SGD update of the weights in the input channels of the calling core, with
+ * the same split as the gradient update. Biases are updated by core 0. The
+ * scale includes the division by the batch size.
+ */
+
+static inline void TrainingStep_opt(float *biases, float *weights,
+                                    const float *W_gradients,
+                                    const float *b_gradients, uint32_t in_ch,
+                                    uint32_t out_ch, float scale,
+                                    uint32_t core, uint32_t cores) {
+    uint32_t c0;
+    uint32_t blocks = nnlinear_core_blocks(in_ch, core, cores, &c0);
+    uint32_t c1 = (core == cores - 1) ? in_ch : c0 + blocks * NNLINEAR_BLOCK;
+
+    for (uint32_t o = 0; o < out_ch; o++) {
+        for (uint32_t j = c0; j < c1; j++)
+            weights[o * in_ch + j] -= scale * W_gradients[o * in_ch + j];
+    }
+
+    if (core == 0) {
+        for (uint32_t o = 0; o < out_ch; o++)
+            biases[o] -= scale * b_gradients[o];
+    }
+}
@@ -0,0 +1,74 @@
+// Copyright 2023 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+// Monte Carlo integration of pi with the built-in integrand and of x^2 over
+// [0, 1) with an integrand defined here, on all cores of all clusters. Reports
+// the throughput in samples per cycle and returns the number of estimates
+// whose error exceeds about four standard deviations.
+
+#include "math.h"
+#include "montecarlo.h"
+#include "snrt.h"
+
+#define N_BATCHES 8
+#define SEED 42
+
+// Sum of x^2 over the samples, two packed samples per operand
+static double square_integrand(const double *samples, uint32_t n,
+                               const void *args) {
+    const register float zero = 0.0f;
+    const uint32_t n_frep = n / 4 - 1;
+    v2f32 acc0, acc1, x0, x1;
+
+    snrt_ssr_loop_1d(SNRT_SSR_DM0, n / 2, 2 * sizeof(double));
+    snrt_ssr_loop_1d(SNRT_SSR_DM1, n / 2, 2 * sizeof(double));
+    snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_1D, (void *)samples);
+    snrt_ssr_read(SNRT_SSR_DM1, SNRT_SSR_1D, (void *)(samples + 1));
+    snrt_ssr_enable();
+
+    asm volatile(
+        "vfcpka.s.s %[acc0], %[zero], %[zero] \n"
+        "vfcpka.s.s %[acc1], %[zero], %[zero] \n"
+        "frep.o     %[n_frep], 4, 0, 0 \n"
+        "vfcpka.s.d %[x0], ft0, ft1 \n"
+        "vfcpka.s.d %[x1], ft0, ft1 \n"
+        "vfmac.s    %[acc0], %[x0], %[x0] \n"
+        "vfmac.s    %[acc1], %[x1], %[x1] \n"
+        "vfadd.s    %[acc0], %[acc0], %[acc1] \n"
+        : [ acc0 ] "=&f"(acc0), [ acc1 ] "=&f"(acc1), [ x0 ] "=&f"(x0),
+          [ x1 ] "=&f"(x1)
+        : [ zero ] "f"(zero), [ n_frep ] "r"(n_frep)
+        : "ft0", "ft1", "ft2");
+
+    snrt_fpu_fence();
+    snrt_ssr_disable();
+
+    return (double)acc0[0] + (double)acc0[1];
+}
+
+static inline uint32_t check(const char *name, double estimate, double exact,
+                             double max_err, const mc_stats_t *stats) {
+    double err = fabs(estimate - exact);
+    printf("%s: estimate %f, error %f, %u samples in %u cycles, %f "
+           "samples/cycle\n",
+           name, estimate, err, stats->samples, stats->cycles,
+           (double)stats->samples / stats->cycles);
+    return err > max_err;
+}
+
+int main() {
+    uint32_t errors = 0;
+    mc_stats_t stats;
+
+    double pi = mc_integrate(mc_pi_integrand, NULL, 2, N_BATCHES, SEED, &stats);
+    if (snrt_global_core_idx() == 0)
+        errors += check("pi", pi, M_PI, 0.06, &stats);
+
+    double third =
+        mc_integrate(square_integrand, NULL, 1, N_BATCHES, SEED + 1, &stats);
+    if (snrt_global_core_idx() == 0)
+        errors += check("x^2", third, 1.0 / 3, 0.01, &stats);
+
+    return errors;
+}
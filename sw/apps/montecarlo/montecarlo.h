@@ -0,0 +1,250 @@
+// Copyright 2023 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+// Monte Carlo integration over the unit hypercube on all compute cores of all
+// clusters. Every core draws batches of uniform samples into a TCDM buffer and
+// passes them to the integrand, which typically evaluates them with SSRs and
+// packed-SIMD FP32 arithmetic. The sums of the integrand are reduced across
+// cores and clusters.
+//
+// The random numbers come from the LCG in lcg.h. Every core runs MC_LANES
+// independent sequences, which start at equally spaced offsets of the full
+// period computed by skip-ahead. A sequence is stepped in the FPU as
+// u_{i+1} = frac(a * u_i + c / 2^32), with u_i = x_i / 2^32. All intermediate
+// results are exact in FP64, since a < 2^21, so the samples are the LCG
+// numbers scaled to [0, 1) and the generation runs under FREP.
+
+#pragma once
+
+#include "lcg.h"
+#include "snrt.h"
+
+// Independent sequences per core, stepped in lock-step and interleaved in the
+// sample buffer
+#define MC_LANES 3
+
+// Samples per batch, a multiple of MC_LANES and of the dimensions of the
+// integrands below
+#define MC_BATCH 384
+
+// Sample buffer and partial sums of a core in TCDM
+#define MC_CORE_L1_SIZE ((MC_BATCH + 1) * sizeof(double))
+
+typedef float v2f32 __attribute__((vector_size(8)));
+
+/**
+ * @brief Integrand evaluated on a batch of samples
+ *
+ * @param samples n uniform samples in [0, 1), consecutive groups of dim
+ *                samples are the coordinates of a point. Conversion to FP32
+ *                rounds to nearest and may yield 1.
+ * @param n number of samples, a multiple of dim
+ * @param args integrand specific arguments
+ * @return sum of the integrand over the n / dim points
+ */
+typedef double (*mc_integrand_t)(const double *samples, uint32_t n,
+                                 const void *args);
+
+typedef struct {
+    double u[MC_LANES];
+} mc_rng_t;
+
+typedef struct {
+    uint32_t cycles;   // Cycles of the sampling and reduction
+    uint32_t samples;  // Samples drawn by all cores
+} mc_stats_t;
+
+// Partial sums of the clusters, in main memory
+static volatile double mc_cluster_sum[SNRT_CLUSTER_NUM];
+
+/**
+ * @brief Initialize the sequences of the calling compute core
+ *
+ * @param rng sequence states
+ * @param seed first number of the sequence of the first lane
+ */
+static inline void mc_rng_init(mc_rng_t *rng, uint32_t seed) {
+    uint32_t lanes =
+        snrt_cluster_num() * snrt_cluster_compute_core_num() * MC_LANES;
+    uint32_t lane0 = snrt_global_compute_core_idx() * MC_LANES;
+    uint32_t spacing = 0xffffffff / lanes;
+
+    for (uint32_t l = 0; l < MC_LANES; l++) {
+        uint32_t x = right_seed(seed, LCG_A, LCG_C, (lane0 + l) * spacing);
+        rng->u[l] = normalize(x);
+    }
+}
+
+/**
+ * @brief Draw the next n samples of the calling core
+ *
+ * The samples are written through SSR 0. Every FREP iteration advances all
+ * lanes by one step, flooring with a static round-down addition of 2^52.
+ *
+ * @param rng sequence states
+ * @param buf TCDM buffer of n samples
+ * @param n number of samples, a positive multiple of MC_LANES
+ */
+static inline void mc_rng_fill(mc_rng_t *rng, double *buf, uint32_t n) {
+    const register double a = LCG_A;
+    const register double c = LCG_C / MAX_UINT_PLUS1;
+    const register double m = 4503599627370496.0;
+    const uint32_t n_frep = n / MC_LANES - 1;
+    double u0 = rng->u[0], u1 = rng->u[1], u2 = rng->u[2];
+    double y0, y1, y2;
+
+    snrt_ssr_loop_1d(SNRT_SSR_DM0, n, sizeof(double));
+    snrt_ssr_write(SNRT_SSR_DM0, SNRT_SSR_1D, buf);
+    snrt_ssr_enable();
+
+    asm volatile(
+        "frep.o  %[n_frep], 15, 0, 0 \n"
+        "fmadd.d %[y0], %[a], %[u0], %[c] \n"
+        "fmadd.d %[y1], %[a], %[u1], %[c] \n"
+        "fmadd.d %[y2], %[a], %[u2], %[c] \n"
+        "fadd.d  %[u0], %[y0], %[m], rdn \n"
+        "fadd.d  %[u1], %[y1], %[m], rdn \n"
+        "fadd.d  %[u2], %[y2], %[m], rdn \n"
+        "fsub.d  %[u0], %[u0], %[m] \n"
+        "fsub.d  %[u1], %[u1], %[m] \n"
+        "fsub.d  %[u2], %[u2], %[m] \n"
+        "fsub.d  %[u0], %[y0], %[u0] \n"
+        "fsub.d  %[u1], %[y1], %[u1] \n"
+        "fsub.d  %[u2], %[y2], %[u2] \n"
+        "fsgnj.d ft0, %[u0], %[u0] \n"
+        "fsgnj.d ft0, %[u1], %[u1] \n"
+        "fsgnj.d ft0, %[u2], %[u2] \n"
+        : [ u0 ] "+f"(u0), [ u1 ] "+f"(u1), [ u2 ] "+f"(u2),
+          [ y0 ] "=&f"(y0), [ y1 ] "=&f"(y1), [ y2 ] "=&f"(y2)
+        : [ a ] "f"(a), [ c ] "f"(c), [ m ] "f"(m), [ n_frep ] "r"(n_frep)
+        : "ft0", "ft1", "ft2", "memory");
+
+    snrt_fpu_fence();
+    __builtin_ssr_barrier(SNRT_SSR_DM0);
+    snrt_ssr_disable();
+
+    rng->u[0] = u0;
+    rng->u[1] = u1;
+    rng->u[2] = u2;
+}
+
+/**
+ * @brief Fraction of the points in the quarter of the unit disk, times 4
+ *
+ * Evaluates two points per packed-SIMD operation: x of both points is packed
+ * from the first two samples, y from the next two. SSR 0 and SSR 1 stream the
+ * even and odd samples, as an instruction reading the same SSR twice gets a
+ * single element. The sign of 1 - x^2 - y^2 is copied onto 1 and
+ * accumulated, which counts the points inside minus the points outside.
+ *
+ * @param n number of samples, a positive multiple of 8
+ */
+static inline double mc_pi_integrand(const double *samples, uint32_t n,
+                                     const void *args) {
+    const register float one = 1.0f;
+    const uint32_t n_frep = n / 8 - 1;
+    v2f32 one2, acc0, acc1, x0, y0, x1, y1;
+
+    snrt_ssr_loop_1d(SNRT_SSR_DM0, n / 2, 2 * sizeof(double));
+    snrt_ssr_loop_1d(SNRT_SSR_DM1, n / 2, 2 * sizeof(double));
+    snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_1D, (void *)samples);
+    snrt_ssr_read(SNRT_SSR_DM1, SNRT_SSR_1D, (void *)(samples + 1));
+    snrt_ssr_enable();
+
+    asm volatile(
+        "vfcpka.s.s %[one2], %[one], %[one] \n"
+        "vfsub.s    %[acc0], %[one2], %[one2] \n"
+        "vfsub.s    %[acc1], %[one2], %[one2] \n"
+        "frep.o     %[n_frep], 14, 0, 0 \n"
+        "vfcpka.s.d %[x0], ft0, ft1 \n"
+        "vfcpka.s.d %[y0], ft0, ft1 \n"
+        "vfcpka.s.d %[x1], ft0, ft1 \n"
+        "vfcpka.s.d %[y1], ft0, ft1 \n"
+        "vfmul.s    %[x0], %[x0], %[x0] \n"
+        "vfmul.s    %[x1], %[x1], %[x1] \n"
+        "vfmac.s    %[x0], %[y0], %[y0] \n"
+        "vfmac.s    %[x1], %[y1], %[y1] \n"
+        "vfsub.s    %[x0], %[one2], %[x0] \n"
+        "vfsub.s    %[x1], %[one2], %[x1] \n"
+        "vfsgnj.s   %[x0], %[one2], %[x0] \n"
+        "vfsgnj.s   %[x1], %[one2], %[x1] \n"
+        "vfadd.s    %[acc0], %[acc0], %[x0] \n"
+        "vfadd.s    %[acc1], %[acc1], %[x1] \n"
+        "vfadd.s    %[acc0], %[acc0], %[acc1] \n"
+        : [ one2 ] "=&f"(one2), [ acc0 ] "=&f"(acc0), [ acc1 ] "=&f"(acc1),
+          [ x0 ] "=&f"(x0), [ y0 ] "=&f"(y0), [ x1 ] "=&f"(x1),
+          [ y1 ] "=&f"(y1)
+        : [ one ] "f"(one), [ n_frep ] "r"(n_frep)
+        : "ft0", "ft1", "ft2");
+
+    snrt_fpu_fence();
+    snrt_ssr_disable();
+
+    // Points inside are (points + inside - outside) / 2
+    double balance = (double)acc0[0] + (double)acc0[1];
+    return 2 * (n / 2 + balance);
+}
+
+/**
+ * @brief Integrate over the unit hypercube on all compute cores and clusters
+ *
+ * Every compute core draws n_batches batches of MC_BATCH samples. Uses
+ * MC_CORE_L1_SIZE bytes of TCDM per compute core, starting at the first free
+ * address. Must be called by all cores of all clusters.
+ *
+ * @param f integrand
+ * @param args arguments passed to the integrand
+ * @param dim dimension of the integration domain, a divisor of MC_BATCH
+ * @param n_batches number of batches per compute core
+ * @param seed seed of the random number sequences
+ * @param stats returns the cycles and samples on global core 0
+ * @return estimate of the integral on global core 0
+ */
+static inline double mc_integrate(mc_integrand_t f, const void *args,
+                                  uint32_t dim, uint32_t n_batches,
+                                  uint32_t seed, mc_stats_t *stats) {
+    const uint32_t compute_num = snrt_cluster_compute_core_num();
+    const uint32_t compute_id = snrt_cluster_core_idx();
+
+    double *partial = snrt_l1_next();
+    double *buf = partial + compute_num + compute_id * MC_BATCH;
+
+    mc_rng_t rng;
+    if (snrt_is_compute_core()) mc_rng_init(&rng, seed);
+
+    snrt_global_barrier();
+
+    uint32_t start = snrt_mcycle();
+
+    if (snrt_is_compute_core()) {
+        double sum = 0;
+        for (uint32_t b = 0; b < n_batches; b++) {
+            mc_rng_fill(&rng, buf, MC_BATCH);
+            sum += f(buf, MC_BATCH, args);
+        }
+        partial[compute_id] = sum;
+    }
+
+    snrt_cluster_hw_barrier();
+
+    if (snrt_is_compute_core() && compute_id == 0) {
+        double sum = 0;
+        for (uint32_t c = 0; c < compute_num; c++) sum += partial[c];
+        mc_cluster_sum[snrt_cluster_idx()] = sum;
+    }
+
+    snrt_global_barrier();
+
+    double result = 0;
+    if (snrt_global_core_idx() == 0) {
+        for (uint32_t c = 0; c < snrt_cluster_num(); c++)
+            result += mc_cluster_sum[c];
+        stats->cycles = snrt_mcycle() - start;
+        stats->samples = snrt_cluster_num() * compute_num * n_batches *
+                         MC_BATCH;
+        result /= stats->samples / dim;
+    }
+
+    return result;
+}
@@ -16,32 +16,42 @@
 
 __thread double max_uint_plus_1_inverse = (double)1.0 / (double)MAX_UINT_PLUS1;
 
+// Calculate the constants A and C of the LCG which advances n steps at once,
+// x_{i+n} = A * x_i + C, by square-and-multiply in O(log n) steps
+inline void lcg_skip_constants(uint32_t n, uint32_t a, uint32_t c,
+                               uint32_t* A, uint32_t* C) {
+    uint32_t A_tmp = 1;
+    uint32_t C_tmp = 0;
+    // a and c always advance 2^p steps, for the current bit p of n
+    while (n) {
+        if (n & 1) {
+            A_tmp *= a;
+            C_tmp = C_tmp * a + c;
+        }
+        c *= a + 1;
+        a *= a;
+        n >>= 1;
+    }
+
+    // Store temporary variables to outputs
+    *A = A_tmp;
+    *C = C_tmp;
+}
+
 // Calculate A' and C' constants
 inline void leapfrog_constants(unsigned int num_sequences, uint32_t a,
                                uint32_t c, uint32_t* Ap, uint32_t* Cp) {
     // Ap = a^k
     // Cp = (a^(k-1) + a^(k-2) + ... + a^1 + a^0)*c
-    uint32_t Ap_tmp = 1;
-    uint32_t Cp_tmp = 0;
-    for (unsigned int p = 0; p < num_sequences; p++) {
-        Cp_tmp += Ap_tmp;
-        Ap_tmp *= a;
-    }
-    Cp_tmp *= c;
-
-    // Store temporary variables to outputs
-    *Ap = Ap_tmp;
-    *Cp = Cp_tmp;
+    lcg_skip_constants(num_sequences, a, c, Ap, Cp);
 }
 
 // Calculate seed for leapfrog method's right sequence of index `sequence_idx`
 inline uint32_t right_seed(uint32_t left_seed, uint32_t a, uint32_t c,
                            unsigned int sequence_idx) {
-    uint32_t seed = left_seed;
-    for (unsigned int p = 1; p <= sequence_idx; p++) {
-        seed = seed * a + c;
-    }
-    return seed;
+    uint32_t A, C;
+    lcg_skip_constants(sequence_idx, a, c, &A, &C);
+    return left_seed * A + C;
 }
 
 // Generate next PRN from LCG recurrence equation
@@ -0,0 +1,198 @@
+// Copyright 2023 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <math.h>
+
+#include "blas_utils.h"
+
+/**
+ * Sum of the absolute values of a vector on the calling core
+ *
+ * SSR 0 streams the words of x. FREP copies the sign of one onto BLAS_UNROLL
+ * words and accumulates them into independent accumulators. FP16 words are
+ * expanded to FP32 by a dot product with a vector of ones. Elements beyond
+ * the last whole block of BLAS_UNROLL words are accumulated in scalar code.
+ * The vector must be 8-byte aligned.
+ */
+
+static inline double asum_fp64(uint32_t n, const double *x) {
+    const uint32_t blocks = n / BLAS_UNROLL;
+    double sum = 0;
+
+    if (blocks) {
+        const register double one = 1.0;
+        double c0, c1, c2, c3, t0, t1, t2, t3;
+
+        snrt_ssr_loop_1d(SNRT_SSR_DM0, blocks * BLAS_UNROLL, sizeof(double));
+        snrt_ssr_repeat(SNRT_SSR_DM0, 1);
+        snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_1D, (void *)x);
+        snrt_ssr_enable();
+
+        asm volatile(
+            "fcvt.d.w %[c0], zero \n"
+            "fcvt.d.w %[c1], zero \n"
+            "fcvt.d.w %[c2], zero \n"
+            "fcvt.d.w %[c3], zero \n"
+            "frep.o   %[n_frep], 8, 0, 0 \n"
+            "fsgnj.d  %[t0], ft0, %[one] \n"
+            "fsgnj.d  %[t1], ft0, %[one] \n"
+            "fsgnj.d  %[t2], ft0, %[one] \n"
+            "fsgnj.d  %[t3], ft0, %[one] \n"
+            "fadd.d   %[c0], %[c0], %[t0] \n"
+            "fadd.d   %[c1], %[c1], %[t1] \n"
+            "fadd.d   %[c2], %[c2], %[t2] \n"
+            "fadd.d   %[c3], %[c3], %[t3] \n"
+            : [ c0 ] "=&f"(c0), [ c1 ] "=&f"(c1), [ c2 ] "=&f"(c2),
+              [ c3 ] "=&f"(c3), [ t0 ] "=&f"(t0), [ t1 ] "=&f"(t1),
+              [ t2 ] "=&f"(t2), [ t3 ] "=&f"(t3)
+            : [ one ] "f"(one), [ n_frep ] "r"(blocks - 1)
+            : "ft0", "ft1", "ft2");
+
+        snrt_fpu_fence();
+        snrt_ssr_disable();
+
+        sum = (c0 + c1) + (c2 + c3);
+    }
+
+    for (uint32_t i = blocks * BLAS_UNROLL; i < n; i++) sum += fabs(x[i]);
+
+    return sum;
+}
+
+static inline double asum_fp32(uint32_t n, const float *x) {
+    const uint32_t blocks = n / (2 * BLAS_UNROLL);
+    double sum = 0;
+
+    if (blocks) {
+        const register float one = 1.0;
+        v2f32 one2, c0, c1, c2, c3, t0, t1, t2, t3;
+
+        snrt_ssr_loop_1d(SNRT_SSR_DM0, blocks * BLAS_UNROLL, sizeof(v2f32));
+        snrt_ssr_repeat(SNRT_SSR_DM0, 1);
+        snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_1D, (void *)x);
+        snrt_ssr_enable();
+
+        asm volatile(
+            "vfcpka.s.s %[one2], %[one], %[one] \n"
+            "vfsub.s    %[c0], %[one2], %[one2] \n"
+            "vfsub.s    %[c1], %[one2], %[one2] \n"
+            "vfsub.s    %[c2], %[one2], %[one2] \n"
+            "vfsub.s    %[c3], %[one2], %[one2] \n"
+            "frep.o     %[n_frep], 8, 0, 0 \n"
+            "vfsgnj.s   %[t0], ft0, %[one2] \n"
+            "vfsgnj.s   %[t1], ft0, %[one2] \n"
+            "vfsgnj.s   %[t2], ft0, %[one2] \n"
+            "vfsgnj.s   %[t3], ft0, %[one2] \n"
+            "vfadd.s    %[c0], %[c0], %[t0] \n"
+            "vfadd.s    %[c1], %[c1], %[t1] \n"
+            "vfadd.s    %[c2], %[c2], %[t2] \n"
+            "vfadd.s    %[c3], %[c3], %[t3] \n"
+            : [ one2 ] "=&f"(one2), [ c0 ] "=&f"(c0), [ c1 ] "=&f"(c1),
+              [ c2 ] "=&f"(c2), [ c3 ] "=&f"(c3), [ t0 ] "=&f"(t0),
+              [ t1 ] "=&f"(t1), [ t2 ] "=&f"(t2), [ t3 ] "=&f"(t3)
+            : [ one ] "f"(one), [ n_frep ] "r"(blocks - 1)
+            : "ft0", "ft1", "ft2");
+
+        snrt_fpu_fence();
+        snrt_ssr_disable();
+
+        sum = ((double)c0[0] + c0[1]) + ((double)c1[0] + c1[1]) +
+              ((double)c2[0] + c2[1]) + ((double)c3[0] + c3[1]);
+    }
+
+    for (uint32_t i = blocks * 2 * BLAS_UNROLL; i < n; i++)
+        sum += fabs(x[i]);
+
+    return sum;
+}
+
+static inline double asum_fp16(uint32_t n, const __fp16 *x) {
+    const uint32_t blocks = n / (4 * BLAS_UNROLL);
+    double sum = 0;
+
+    if (blocks) {
+        const register float zero = 0.0;
+        const register float one = 1.0;
+        v4f16 one4, t0, t1, t2, t3;
+        v2f32 c0, c1, c2, c3;
+
+        snrt_ssr_loop_1d(SNRT_SSR_DM0, blocks * BLAS_UNROLL, sizeof(v4f16));
+        snrt_ssr_repeat(SNRT_SSR_DM0, 1);
+        snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_1D, (void *)x);
+        snrt_ssr_enable();
+
+        asm volatile(
+            "vfcpka.h.s   %[one4], %[one], %[one] \n"
+            "vfcpkb.h.s   %[one4], %[one], %[one] \n"
+            "vfcpka.s.s   %[c0], %[zero], %[zero] \n"
+            "vfcpka.s.s   %[c1], %[zero], %[zero] \n"
+            "vfcpka.s.s   %[c2], %[zero], %[zero] \n"
+            "vfcpka.s.s   %[c3], %[zero], %[zero] \n"
+            "frep.o       %[n_frep], 8, 0, 0 \n"
+            "vfsgnj.h     %[t0], ft0, %[one4] \n"
+            "vfsgnj.h     %[t1], ft0, %[one4] \n"
+            "vfsgnj.h     %[t2], ft0, %[one4] \n"
+            "vfsgnj.h     %[t3], ft0, %[one4] \n"
+            "vfdotpex.s.h %[c0], %[t0], %[one4] \n"
+            "vfdotpex.s.h %[c1], %[t1], %[one4] \n"
+            "vfdotpex.s.h %[c2], %[t2], %[one4] \n"
+            "vfdotpex.s.h %[c3], %[t3], %[one4] \n"
+            : [ one4 ] "=&f"(one4), [ c0 ] "=&f"(c0), [ c1 ] "=&f"(c1),
+              [ c2 ] "=&f"(c2), [ c3 ] "=&f"(c3), [ t0 ] "=&f"(t0),
+              [ t1 ] "=&f"(t1), [ t2 ] "=&f"(t2), [ t3 ] "=&f"(t3)
+            : [ zero ] "f"(zero), [ one ] "f"(one), [ n_frep ] "r"(blocks - 1)
+            : "ft0", "ft1", "ft2");
+
+        snrt_fpu_fence();
+        snrt_ssr_disable();
+
+        sum = ((double)c0[0] + c0[1]) + ((double)c1[0] + c1[1]) +
+              ((double)c2[0] + c2[1]) + ((double)c3[0] + c3[1]);
+    }
+
+    for (uint32_t i = blocks * 4 * BLAS_UNROLL; i < n; i++)
+        sum += fabs((float)x[i]);
+
+    return sum;
+}
+
+/**
+ * @brief Sum of the absolute values on all compute cores of the cluster
+ *
+ * Must be called by all cores of the cluster. The vector is split across the
+ * compute cores in whole blocks of BLAS_UNROLL words.
+ *
+ * @param prec precision of the vector: FP64, FP32 or FP16
+ * @param n number of elements
+ * @param x 8-byte aligned vector in TCDM
+ * @param partial TCDM buffer of one double per compute core
+ * @return the sum on all cores
+ */
+static inline double asum(precision_t prec, uint32_t n, const void *x,
+                          double *partial) {
+    double sum = 0;
+
+    if (snrt_is_compute_core()) {
+        uint32_t first;
+        uint32_t len = blas_split(n, BLAS_UNROLL * blas_lanes(prec),
+                                  snrt_cluster_core_idx(),
+                                  snrt_cluster_compute_core_num(), &first);
+
+        switch (prec) {
+            case FP64:
+                sum = asum_fp64(len, (const double *)x + first);
+                break;
+            case FP32:
+                sum = asum_fp32(len, (const float *)x + first);
+                break;
+            default:
+                sum = asum_fp16(len, (const __fp16 *)x + first);
+                break;
+        }
+    }
+
+    return blas_cluster_sum(sum, partial);
+}
@@ -0,0 +1,49 @@
+// Copyright 2023 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <math.h>
+#include <stdint.h>
+
+#include "data.h"
+#include "asum.h"
+#include "snrt.h"
+
+// Partial results of the clusters, in main memory
+static volatile double cluster_asum[SNRT_CLUSTER_NUM];
+
+int main() {
+    const precision_t prec = dtype_size;
+
+    // Calculate size and pointers for each cluster
+    uint32_t first;
+    uint32_t len = blas_split(N, BLAS_UNROLL * blas_lanes(prec),
+                              snrt_cluster_idx(), snrt_cluster_num(), &first);
+    size_t size = len * prec;
+
+    // Allocate space in TCDM
+    char *local_x = (char *)snrt_l1_next();
+    double *partial = (double *)(local_x + ALIGN_UP(size, sizeof(double)));
+
+    // Copy data in TCDM
+    if (snrt_is_dm_core()) {
+        snrt_dma_start_1d(local_x, (char *)x + first * prec, size);
+        snrt_dma_wait_all();
+    }
+
+    snrt_cluster_hw_barrier();
+
+    // Compute
+    uint32_t start_cycle = snrt_mcycle();
+    double sum = asum(prec, len, local_x, partial);
+    sum = blas_global_sum(sum, cluster_asum);
+    uint32_t end_cycle = snrt_mcycle();
+
+    // Check computation is correct
+    if (snrt_global_core_idx() != 0) return 0;
+
+    printf("asum: %f, expected %f, %u cycles\n", sum, result,
+           end_cycle - start_cycle);
+    double scale = fabs(result) > 1 ? fabs(result) : 1;
+    return fabs(sum - result) > tolerance * scale;
+}
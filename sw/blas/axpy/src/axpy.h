@@ -2,6 +2,9 @@
 // Licensed under the Apache License, Version 2.0, see LICENSE for details.
 // SPDX-License-Identifier: Apache-2.0
 
+#pragma once
+
+#include "blas_utils.h"
 #include "snrt.h"
 
 inline void axpy(uint32_t l, double a, double* x, double* y, double* z) {
@@ -43,3 +46,156 @@ inline void axpy(uint32_t l, double a, double* x, double* y, double* z) {
 
 #endif
 }
+
+/**
+ * Streaming AXPY z = a * x + y on vectors which reside outside of the TCDM,
+ * e.g. in main memory, and may be larger than the TCDM.
+ *
+ * The vectors are split into contiguous slices across clusters. Every cluster
+ * streams its slice through the TCDM in chunks, double-buffering x, y and z:
+ * while the compute cores process a chunk, the DM core writes back the
+ * previous chunk of z and fetches the next chunks of x and y. Compute is a
+ * single FREP'd fmadd.d per core, fed by three SSRs, so the cores can consume
+ * one element per cycle and the throughput is bound by the DMA.
+ */
+
+// TCDM left to the stacks and to the caller
+#ifndef AXPY_STREAM_L1_RESERVE
+#define AXPY_STREAM_L1_RESERVE \
+    (snrt_cluster_core_num() * ((1 << SNRT_LOG2_STACK_SIZE) + 8) + 1024)
+#endif
+
+// Granularity of the cluster slices and chunks, in elements. Multiple of a
+// 512-bit beat, so that all transfers start on a beat boundary.
+#define AXPY_STREAM_ALIGN 8
+
+// Compute z = a * x + y on n elements with the calling core
+static inline void axpy_core(uint32_t n, double a, const double *x,
+                             const double *y, double *z) {
+    if (!n) return;
+
+    // The data movers are configured one by one, since Banshee does not
+    // support SNRT_SSR_DM_ALL
+    snrt_ssr_loop_1d(SNRT_SSR_DM0, n, sizeof(double));
+    snrt_ssr_loop_1d(SNRT_SSR_DM1, n, sizeof(double));
+    snrt_ssr_loop_1d(SNRT_SSR_DM2, n, sizeof(double));
+    snrt_ssr_repeat(SNRT_SSR_DM0, 1);
+    snrt_ssr_repeat(SNRT_SSR_DM1, 1);
+    snrt_ssr_repeat(SNRT_SSR_DM2, 1);
+    snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_1D, (void *)x);
+    snrt_ssr_read(SNRT_SSR_DM1, SNRT_SSR_1D, (void *)y);
+    snrt_ssr_write(SNRT_SSR_DM2, SNRT_SSR_1D, z);
+    snrt_ssr_enable();
+
+    asm volatile(
+        "frep.o  %[n_frep], 1, 0, 0 \n"
+        "fmadd.d ft2, %[a], ft0, ft1 \n"
+        :
+        : [ n_frep ] "r"(n - 1), [ a ] "f"(a)
+        : "ft0", "ft1", "ft2", "memory");
+
+    snrt_fpu_fence();
+    __builtin_ssr_barrier(SNRT_SSR_DM2);
+    snrt_ssr_disable();
+}
+
+// Compute z = a * x + y on n elements in TCDM, splitting them across the
+// compute cores of the cluster. The DM core returns without computing.
+static inline void axpy_cluster(uint32_t n, double a, const double *x,
+                                const double *y, double *z) {
+    if (!snrt_is_compute_core()) return;
+
+    uint32_t first;
+    uint32_t len = blas_split(n, 1, snrt_cluster_core_idx(),
+                              snrt_cluster_compute_core_num(), &first);
+    axpy_core(len, a, x + first, y + first, z + first);
+}
+
+/**
+ * @brief Streaming AXPY on vectors of arbitrary length outside of the TCDM.
+ * @details Must be called by all cores of all participating clusters. The
+ * chunk size is chosen as the largest one for which the six buffers fit into
+ * the free TCDM space above `snrt_l1_next()`. Returns once the slice of the
+ * calling cluster has been written back, the caller synchronizes the clusters
+ * before using z.
+ * @return 0 on success, -1 if the buffers do not fit into the TCDM.
+ */
+static inline int axpy_stream(uint32_t n, double a, const double *x,
+                              const double *y, double *z) {
+    uint32_t first;
+    uint32_t len = blas_split(n, AXPY_STREAM_ALIGN, snrt_cluster_idx(),
+                              snrt_cluster_num(), &first);
+
+    // Carve the double buffers out of the free TCDM space
+    uint32_t l1_base = ALIGN_UP((uint32_t)snrt_l1_next(), 64);
+    uint32_t l1_end = snrt_l1_end_addr() - AXPY_STREAM_L1_RESERVE;
+    if (l1_base >= l1_end) return -1;
+    uint32_t chunk = (l1_end - l1_base) / (6 * sizeof(double));
+    chunk -= chunk % AXPY_STREAM_ALIGN;
+    if (!chunk) return -1;
+    if (!len) return 0;
+    if (chunk > len) chunk = ALIGN_UP(len, AXPY_STREAM_ALIGN);
+
+    double *local_x[2], *local_y[2], *local_z[2];
+    local_x[0] = (double *)l1_base;
+    local_x[1] = local_x[0] + chunk;
+    local_y[0] = local_x[1] + chunk;
+    local_y[1] = local_y[0] + chunk;
+    local_z[0] = local_y[1] + chunk;
+    local_z[1] = local_z[0] + chunk;
+
+    x += first;
+    y += first;
+    z += first;
+    const uint32_t n_chunks = (len + chunk - 1) / chunk;
+    const uint32_t last = len - (n_chunks - 1) * chunk;
+
+    if (snrt_is_dm_core()) {
+        // Prologue: bring in the first chunk
+        size_t size = (n_chunks > 1 ? chunk : last) * sizeof(double);
+        snrt_dma_start_1d(local_x[0], x, size);
+        snrt_dma_start_1d(local_y[0], y, size);
+        snrt_dma_wait_all();
+        snrt_cluster_hw_barrier();
+
+        for (uint32_t i = 0; i < n_chunks; i++) {
+            // Write back the chunk completed in the previous iteration. Its
+            // buffer is only reused in the next iteration.
+            if (i > 0) {
+                snrt_dma_start_1d(z + (i - 1) * chunk, local_z[(i - 1) % 2],
+                                  chunk * sizeof(double));
+            }
+
+            // Prefetch the next chunk
+            if (i + 1 < n_chunks) {
+                uint32_t next = (i + 2 < n_chunks) ? chunk : last;
+                size_t size = next * sizeof(double);
+                snrt_dma_start_1d(local_x[(i + 1) % 2], x + (i + 1) * chunk,
+                                  size);
+                snrt_dma_start_1d(local_y[(i + 1) % 2], y + (i + 1) * chunk,
+                                  size);
+            }
+            snrt_dma_wait_all();
+
+            // Wait for the compute cores to finish the current chunk
+            snrt_cluster_hw_barrier();
+        }
+
+        // Epilogue: write back the last chunk
+        snrt_dma_start_1d(z + (n_chunks - 1) * chunk,
+                          local_z[(n_chunks - 1) % 2], last * sizeof(double));
+        snrt_dma_wait_all();
+    } else {
+        // Wait for the first chunk
+        snrt_cluster_hw_barrier();
+
+        for (uint32_t i = 0; i < n_chunks; i++) {
+            uint32_t size = (i + 1 < n_chunks) ? chunk : last;
+            axpy_cluster(size, a, local_x[i % 2], local_y[i % 2],
+                         local_z[i % 2]);
+            snrt_cluster_hw_barrier();
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,93 @@
+// Copyright 2023 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+// Memory bandwidth benchmark: streaming AXPY on vectors in main memory which
+// do not fit into the TCDM. Reports the achieved main memory traffic in bytes
+// per cycle next to the peak of the clusters' wide AXI ports. Reads and writes
+// use separate AXI channels, so the 2:1 read to write traffic of AXPY can
+// exceed the width of a single channel by up to 50%. The kernel is timed with
+// the benchmark harness of the runtime, and the bandwidth is computed from its
+// fastest run. Operands are small integers, so the result must match exactly.
+
+#include <stdint.h>
+
+#include "axpy.h"
+#include "snrt.h"
+
+#ifndef AXPY_STREAM_N
+#define AXPY_STREAM_N 32768
+#endif
+
+#ifndef AXPY_STREAM_RUNS
+#define AXPY_STREAM_RUNS 3
+#endif
+
+#define N AXPY_STREAM_N
+
+// Aligned to 4KB, as AXI splits bursts crossing 4KB address boundaries
+static double x[N] __attribute__((aligned(4096)));
+static double y[N] __attribute__((aligned(4096)));
+static double z[N] __attribute__((aligned(4096)));
+
+// Per-cluster error counts, in main memory
+static volatile double cluster_errors[SNRT_CLUSTER_NUM];
+
+static const double a = 1.5;
+
+// Deterministic operand values in [-8, 8]
+static inline double operand(uint32_t i, uint32_t salt) {
+    return (double)((int32_t)((i * 7 + salt * 3) % 17) - 8);
+}
+
+static int run_axpy_stream(void *args) {
+    (void)args;
+    return axpy_stream(N, a, x, y, z);
+}
+
+int main() {
+    // Every cluster initializes the slice of the vectors it processes
+    uint32_t first;
+    uint32_t len = blas_split(N, AXPY_STREAM_ALIGN, snrt_cluster_idx(),
+                              snrt_cluster_num(), &first);
+    for (uint32_t i = first + snrt_cluster_core_idx(); i < first + len;
+         i += snrt_cluster_core_num()) {
+        x[i] = operand(i, 1);
+        y[i] = operand(i, 2);
+    }
+
+    // Compute
+    snrt_bench_t bench = {.name = "axpy_stream",
+                          .warmup = 1,
+                          .runs = AXPY_STREAM_RUNS,
+                          .flops = 2 * N,
+                          .elem_size = sizeof(double)};
+    int ret = snrt_bench_run(&bench, run_axpy_stream, NULL);
+
+    // Check the slice of every cluster on its compute cores
+    double errors = 0;
+    if (snrt_is_compute_core()) {
+        for (uint32_t i = first + snrt_cluster_core_idx(); i < first + len;
+             i += snrt_cluster_compute_core_num()) {
+            if (z[i] != a * operand(i, 1) + operand(i, 2)) errors++;
+        }
+    }
+    errors = blas_cluster_sum(errors, (double *)snrt_l1_next());
+    errors = blas_global_sum(errors, cluster_errors);
+
+    if (snrt_global_core_idx() != 0) return 0;
+
+    if (ret) {
+        printf("axpy_stream: buffers do not fit into the TCDM\n");
+        return -1;
+    }
+
+    uint32_t cycles = bench.cycles;
+    uint32_t bytes = 3 * N * sizeof(double);
+    uint32_t peak = snrt_cluster_num() * SNRT_DMA_DATA_WIDTH / 8;
+    printf("axpy_stream: %u/%u errors, %u cycles\n", (uint32_t)errors, N,
+           cycles);
+    printf("axpy_stream: %u bytes, %f B/cycle, AXI width %u B/cycle\n", bytes,
+           (double)bytes / cycles, peak);
+    return (int)errors;
+}
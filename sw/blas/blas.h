@@ -4,5 +4,11 @@
 
 #pragma once
 
+#include "asum/src/asum.h"
 #include "axpy/src/axpy.h"
-#include "gemm/src/gemm.h"
\ No newline at end of file
+#include "dot/src/dot.h"
+#include "gemm/src/gemm.h"
+#include "gemv/src/gemv.h"
+#include "ger/src/ger.h"
+#include "nrm2/src/nrm2.h"
+#include "scal/src/scal.h"
\ No newline at end of file
@@ -0,0 +1,128 @@
+// Copyright 2023 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+// Common definitions of the level-1/2 BLAS kernels. The kernels stream
+// 64-bit words through the SSRs, so FP32 and FP16 vectors are processed as
+// packed-SIMD words of two and four elements.
+
+#pragma once
+
+#include <stdint.h>
+
+#include "snrt.h"
+
+// Guard to avoid conflict with DNN and GEMM header files
+#ifndef PRECISION_T
+#define PRECISION_T
+typedef enum { FP64 = 8, FP32 = 4, FP16 = 2, FP8 = 1 } precision_t;
+
+typedef float v2f32 __attribute__((vector_size(8)));
+typedef __fp16 v4f16 __attribute__((vector_size(8)));
+typedef char v8f8 __attribute__((vector_size(8)));
+#endif
+
+// Words processed per FREP iteration with independent accumulators. Should be
+// at least as high as the FMA latency for maximum utilization.
+#define BLAS_UNROLL 4
+
+// Elements of the given precision in a 64-bit word
+static inline uint32_t blas_lanes(precision_t prec) {
+    return sizeof(double) / prec;
+}
+
+/**
+ * @brief Elements of a vector assigned to one of num units
+ *
+ * The vector is split into chunks of align elements, remainder chunks are
+ * given to the first units, one each. Elements beyond the last whole chunk go
+ * to the last unit. Used to split work across cores and clusters.
+ *
+ * @param n number of elements
+ * @param align elements per chunk
+ * @param idx index of the unit
+ * @param num number of units
+ * @param first returns the first element of the unit
+ * @return number of elements of the unit
+ */
+static inline uint32_t blas_split(uint32_t n, uint32_t align, uint32_t idx,
+                                  uint32_t num, uint32_t *first) {
+    uint32_t chunks = n / align;
+    uint32_t frac = chunks / num;
+    uint32_t rem = chunks % num;
+    uint32_t len = (frac + (idx < rem)) * align;
+    *first = (idx * frac + (idx < rem ? idx : rem)) * align;
+    if (idx == num - 1) len += n % align;
+    return len;
+}
+
+// Scalar access to the i-th element of a vector of the given precision
+static inline double blas_load(precision_t prec, const void *p, uint32_t i) {
+    switch (prec) {
+        case FP64:
+            return ((const double *)p)[i];
+        case FP32:
+            return ((const float *)p)[i];
+        default:
+            return ((const __fp16 *)p)[i];
+    }
+}
+
+static inline void blas_store(precision_t prec, void *p, uint32_t i,
+                              double v) {
+    switch (prec) {
+        case FP64:
+            ((double *)p)[i] = v;
+            break;
+        case FP32:
+            ((float *)p)[i] = v;
+            break;
+        default:
+            ((__fp16 *)p)[i] = v;
+            break;
+    }
+}
+
+/**
+ * @brief Sum a value over the compute cores of the cluster
+ *
+ * Must be called by all cores of the cluster. The value of the DM core is
+ * ignored.
+ *
+ * @param v value of the calling core
+ * @param partial TCDM buffer of one double per compute core
+ * @return sum on all cores
+ */
+static inline double blas_cluster_sum(double v, double *partial) {
+    if (snrt_is_compute_core()) partial[snrt_cluster_core_idx()] = v;
+    snrt_cluster_hw_barrier();
+
+    double sum = 0;
+    for (uint32_t c = 0; c < snrt_cluster_compute_core_num(); c++)
+        sum += partial[c];
+
+    // The buffer can be reused once all cores have read it
+    snrt_cluster_hw_barrier();
+    return sum;
+}
+
+/**
+ * @brief Sum a value over the clusters
+ *
+ * Must be called by all cores of all clusters, with the same value on all
+ * cores of a cluster.
+ *
+ * @param v value of the calling cluster
+ * @param partial main memory buffer of one double per cluster
+ * @return sum on all cores
+ */
+static inline double blas_global_sum(double v, volatile double *partial) {
+    if (snrt_cluster_core_idx() == 0) partial[snrt_cluster_idx()] = v;
+    snrt_global_barrier();
+
+    double sum = 0;
+    for (uint32_t c = 0; c < snrt_cluster_num(); c++) sum += partial[c];
+
+    snrt_global_barrier();
+    return sum;
+}
@@ -0,0 +1,192 @@
+// Copyright 2023 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "blas_utils.h"
+
+/**
+ * Dot product of two vectors on the calling core
+ *
+ * SSR 0 and SSR 1 stream the words of x and y, FREP accumulates BLAS_UNROLL
+ * words into independent accumulators. FP32 words are accumulated lane-wise,
+ * FP16 words are expanded to FP32 by the dot-product instruction. Elements
+ * beyond the last whole block of BLAS_UNROLL words are accumulated in scalar
+ * code. The vectors must be 8-byte aligned.
+ */
+
+static inline double dot_fp64(uint32_t n, const double *x, const double *y) {
+    const uint32_t blocks = n / BLAS_UNROLL;
+    double sum = 0;
+
+    if (blocks) {
+        double c0, c1, c2, c3;
+
+        snrt_ssr_loop_1d(SNRT_SSR_DM0, blocks * BLAS_UNROLL, sizeof(double));
+        snrt_ssr_loop_1d(SNRT_SSR_DM1, blocks * BLAS_UNROLL, sizeof(double));
+        snrt_ssr_repeat(SNRT_SSR_DM0, 1);
+        snrt_ssr_repeat(SNRT_SSR_DM1, 1);
+        snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_1D, (void *)x);
+        snrt_ssr_read(SNRT_SSR_DM1, SNRT_SSR_1D, (void *)y);
+        snrt_ssr_enable();
+
+        asm volatile(
+            "fcvt.d.w %[c0], zero \n"
+            "fcvt.d.w %[c1], zero \n"
+            "fcvt.d.w %[c2], zero \n"
+            "fcvt.d.w %[c3], zero \n"
+            "frep.o   %[n_frep], 4, 0, 0 \n"
+            "fmadd.d  %[c0], ft0, ft1, %[c0] \n"
+            "fmadd.d  %[c1], ft0, ft1, %[c1] \n"
+            "fmadd.d  %[c2], ft0, ft1, %[c2] \n"
+            "fmadd.d  %[c3], ft0, ft1, %[c3] \n"
+            : [ c0 ] "=&f"(c0), [ c1 ] "=&f"(c1), [ c2 ] "=&f"(c2),
+              [ c3 ] "=&f"(c3)
+            : [ n_frep ] "r"(blocks - 1)
+            : "ft0", "ft1", "ft2");
+
+        snrt_fpu_fence();
+        snrt_ssr_disable();
+
+        sum = (c0 + c1) + (c2 + c3);
+    }
+
+    for (uint32_t i = blocks * BLAS_UNROLL; i < n; i++) sum += x[i] * y[i];
+
+    return sum;
+}
+
+static inline double dot_fp32(uint32_t n, const float *x, const float *y) {
+    const uint32_t blocks = n / (2 * BLAS_UNROLL);
+    double sum = 0;
+
+    if (blocks) {
+        const register float zero = 0.0;
+        v2f32 c0, c1, c2, c3;
+
+        snrt_ssr_loop_1d(SNRT_SSR_DM0, blocks * BLAS_UNROLL, sizeof(v2f32));
+        snrt_ssr_loop_1d(SNRT_SSR_DM1, blocks * BLAS_UNROLL, sizeof(v2f32));
+        snrt_ssr_repeat(SNRT_SSR_DM0, 1);
+        snrt_ssr_repeat(SNRT_SSR_DM1, 1);
+        snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_1D, (void *)x);
+        snrt_ssr_read(SNRT_SSR_DM1, SNRT_SSR_1D, (void *)y);
+        snrt_ssr_enable();
+
+        asm volatile(
+            "vfcpka.s.s %[c0], %[zero], %[zero] \n"
+            "vfcpka.s.s %[c1], %[zero], %[zero] \n"
+            "vfcpka.s.s %[c2], %[zero], %[zero] \n"
+            "vfcpka.s.s %[c3], %[zero], %[zero] \n"
+            "frep.o     %[n_frep], 4, 0, 0 \n"
+            "vfmac.s    %[c0], ft0, ft1 \n"
+            "vfmac.s    %[c1], ft0, ft1 \n"
+            "vfmac.s    %[c2], ft0, ft1 \n"
+            "vfmac.s    %[c3], ft0, ft1 \n"
+            : [ c0 ] "=&f"(c0), [ c1 ] "=&f"(c1), [ c2 ] "=&f"(c2),
+              [ c3 ] "=&f"(c3)
+            : [ zero ] "f"(zero), [ n_frep ] "r"(blocks - 1)
+            : "ft0", "ft1", "ft2");
+
+        snrt_fpu_fence();
+        snrt_ssr_disable();
+
+        sum = ((double)c0[0] + c0[1]) + ((double)c1[0] + c1[1]) +
+              ((double)c2[0] + c2[1]) + ((double)c3[0] + c3[1]);
+    }
+
+    for (uint32_t i = blocks * 2 * BLAS_UNROLL; i < n; i++)
+        sum += x[i] * y[i];
+
+    return sum;
+}
+
+static inline double dot_fp16(uint32_t n, const __fp16 *x, const __fp16 *y) {
+    const uint32_t blocks = n / (4 * BLAS_UNROLL);
+    double sum = 0;
+
+    if (blocks) {
+        const register float zero = 0.0;
+        v2f32 c0, c1, c2, c3;
+
+        snrt_ssr_loop_1d(SNRT_SSR_DM0, blocks * BLAS_UNROLL, sizeof(v4f16));
+        snrt_ssr_loop_1d(SNRT_SSR_DM1, blocks * BLAS_UNROLL, sizeof(v4f16));
+        snrt_ssr_repeat(SNRT_SSR_DM0, 1);
+        snrt_ssr_repeat(SNRT_SSR_DM1, 1);
+        snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_1D, (void *)x);
+        snrt_ssr_read(SNRT_SSR_DM1, SNRT_SSR_1D, (void *)y);
+        snrt_ssr_enable();
+
+        asm volatile(
+            "vfcpka.s.s   %[c0], %[zero], %[zero] \n"
+            "vfcpka.s.s   %[c1], %[zero], %[zero] \n"
+            "vfcpka.s.s   %[c2], %[zero], %[zero] \n"
+            "vfcpka.s.s   %[c3], %[zero], %[zero] \n"
+            "frep.o       %[n_frep], 4, 0, 0 \n"
+            "vfdotpex.s.h %[c0], ft0, ft1 \n"
+            "vfdotpex.s.h %[c1], ft0, ft1 \n"
+            "vfdotpex.s.h %[c2], ft0, ft1 \n"
+            "vfdotpex.s.h %[c3], ft0, ft1 \n"
+            : [ c0 ] "=&f"(c0), [ c1 ] "=&f"(c1), [ c2 ] "=&f"(c2),
+              [ c3 ] "=&f"(c3)
+            : [ zero ] "f"(zero), [ n_frep ] "r"(blocks - 1)
+            : "ft0", "ft1", "ft2");
+
+        snrt_fpu_fence();
+        snrt_ssr_disable();
+
+        sum = ((double)c0[0] + c0[1]) + ((double)c1[0] + c1[1]) +
+              ((double)c2[0] + c2[1]) + ((double)c3[0] + c3[1]);
+    }
+
+    for (uint32_t i = blocks * 4 * BLAS_UNROLL; i < n; i++)
+        sum += (float)x[i] * (float)y[i];
+
+    return sum;
+}
+
+/**
+ * @brief Dot product of the elements of the calling core
+ *
+ * The vectors are split across the compute cores in whole blocks of
+ * BLAS_UNROLL words.
+ *
+ * @return the partial dot product of the core
+ */
+static inline double dot_core(precision_t prec, uint32_t n, const void *x,
+                              const void *y) {
+    uint32_t first;
+    uint32_t len = blas_split(n, BLAS_UNROLL * blas_lanes(prec),
+                              snrt_cluster_core_idx(),
+                              snrt_cluster_compute_core_num(), &first);
+
+    switch (prec) {
+        case FP64:
+            return dot_fp64(len, (const double *)x + first,
+                            (const double *)y + first);
+        case FP32:
+            return dot_fp32(len, (const float *)x + first,
+                            (const float *)y + first);
+        default:
+            return dot_fp16(len, (const __fp16 *)x + first,
+                            (const __fp16 *)y + first);
+    }
+}
+
+/**
+ * @brief Dot product on all compute cores of the cluster
+ *
+ * Must be called by all cores of the cluster.
+ *
+ * @param prec precision of the vectors: FP64, FP32 or FP16
+ * @param n number of elements
+ * @param x, y 8-byte aligned vectors in TCDM
+ * @param partial TCDM buffer of one double per compute core
+ * @return the dot product on all cores
+ */
+static inline double dot(precision_t prec, uint32_t n, const void *x,
+                         const void *y, double *partial) {
+    double sum = 0;
+    if (snrt_is_compute_core()) sum = dot_core(prec, n, x, y);
+    return blas_cluster_sum(sum, partial);
+}
@@ -50,6 +50,10 @@ def golden_model(alpha, a, b, beta, c):
 
 def emit_header(**kwargs):
 
+    alpha = kwargs.get('alpha', 1)
+    # FP8 operands can produce an FP32 result
+    c_prec = 32 if kwargs['prec'] == 8 and kwargs['expand'] else kwargs['prec']
+
     # Generate random input matrices
     dtype = NUMPY_TYPES[str(kwargs['prec'])]
     if (kwargs['prec']) == 8:
@@ -77,15 +81,18 @@ def emit_header(**kwargs):
             * (1.0 + mantissa_b.astype(np.double) / (2**2))
         _c = ((-1.0)**sign_c.astype(np.double))*(2.0**(exponent_c.astype(np.double)-15.0)) \
             * (1.0 + mantissa_c.astype(np.double) / (2**2))
-        result = golden_model(1, _a, _b, kwargs['beta'], _c)
+        result = golden_model(alpha, _a, _b, kwargs['beta'], _c)
         a = sign_a << 7 | exponent_a << FP8_FORMATS['fp8']['mant'] | mantissa_a
         b = sign_b << 7 | exponent_b << FP8_FORMATS['fp8']['mant'] | mantissa_b
-        c = sign_c << 7 | exponent_c << FP8_FORMATS['fp8']['mant'] | mantissa_c
+        if c_prec == 32:
+            c = _c.astype(np.single)
+        else:
+            c = sign_c << 7 | exponent_c << FP8_FORMATS['fp8']['mant'] | mantissa_c
     else:
         a = np.random.rand(kwargs['M'], kwargs['K']).astype(dtype)
         b = np.random.rand(kwargs['K'], kwargs['N']).astype(dtype)
         c = np.random.rand(kwargs['M'], kwargs['N']).astype(dtype)
-        result = golden_model(1, a, b, kwargs['beta'], c)
+        result = golden_model(alpha, a, b, kwargs['beta'], c)
 
     # Store matrices in transposed form if requested
     a = a.T if kwargs['ta'] else a
@@ -97,14 +104,15 @@ def emit_header(**kwargs):
     data_str += [format_scalar_definition('uint32_t', 'K', kwargs['K'])]
     data_str += [format_scalar_definition('uint32_t', 'TA', int(kwargs['ta']))]
     data_str += [format_scalar_definition('uint32_t', 'TB', int(kwargs['tb']))]
-    data_str += [format_scalar_definition('uint32_t', 'BETA', kwargs['beta'])]
+    data_str += [format_scalar_definition('double', 'ALPHA', alpha)]
+    data_str += [format_scalar_definition('double', 'BETA', kwargs['beta'])]
     data_str += [format_scalar_definition('uint32_t', 'dtype_size', kwargs['prec']//8)]
     data_str += [format_scalar_definition('uint32_t', 'expand', kwargs['expand'])]
     data_str += [format_vector_definition(C_TYPES[str(kwargs['prec'])], 'a', a.flatten(),
                  alignment=BURST_ALIGNMENT, section=kwargs['section'])]
     data_str += [format_vector_definition(C_TYPES[str(kwargs['prec'])], 'b', b.flatten(),
                  alignment=BURST_ALIGNMENT, section=kwargs['section'])]
-    data_str += [format_vector_definition(C_TYPES[str(kwargs['prec'])], 'c', c.flatten(),
+    data_str += [format_vector_definition(C_TYPES[str(c_prec)], 'c', c.flatten(),
                  alignment=BURST_ALIGNMENT, section=kwargs['section'])]
     if kwargs['prec'] == 8:
         result_def = format_vector_definition(C_TYPES['64'], 'result', result.flatten())
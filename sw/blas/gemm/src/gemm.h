@@ -81,7 +81,7 @@ void gemm_fp64_opt(uint32_t M, uint32_t N, uint32_t K, double* A, uint32_t ldA,
         // First matrix is stored in transposed format
         if (ta) {
             const uint32_t ssr0_b[4] = {unroll, K, N / unroll, M};
-            const uint32_t ssr0_i[4] = {0, 8 * ldA, 0, 8 * 8};
+            const uint32_t ssr0_i[4] = {0, 8 * ldA, 0, 8};
 
             snrt_ssr_loop_3d(SNRT_SSR_DM0, ssr0_b[1], ssr0_b[2], ssr0_b[3],
                              ssr0_i[1], ssr0_i[2], ssr0_i[3]);
@@ -183,7 +183,9 @@ void gemm_fp64_opt(uint32_t M, uint32_t N, uint32_t K, double* A, uint32_t ldA,
                 c = 0.0;
             }
             for (uint32_t k = 0; k < K; k++) {
-                c += A[k + m * ldA] * B[k + n * ldB];
+                double a = ta ? A[k * ldA + m] : A[m * ldA + k];
+                double b = tb ? B[n * ldB + k] : B[k * ldB + n];
+                c += a * b;
             }
             C[m * ldC + n] = c;
         }
@@ -883,55 +885,1407 @@ void gemm_fp8_ex_opt(uint32_t M, uint32_t N, uint32_t K, char* A, uint32_t ldA,
     snrt_ssr_disable();
 }
 
+void gemm_fp8_ex_fp32_opt(uint32_t M, uint32_t N, uint32_t K, char* A,
+                          uint32_t ldA, char* B, uint32_t ldB, float* C,
+                          uint32_t ldC, const uint32_t* BETA,
+                          uint32_t setup_SSR) {
+    // Unrolling factor of most inner loop.
+    // Every step takes three instructions per column, so at most four
+    // columns fit into the FREP body
+    const uint32_t unroll = 4;
+
+    // SSR strides and bounds only have to be configured
+    // once in the beginning
+    if (setup_SSR) {
+        uint32_t ssr0_b[4] = {unroll, K / 8, N / unroll, M};
+        uint32_t ssr0_i[4] = {0, sizeof(char) * 8, 0, sizeof(char) * ldA};
+
+        uint32_t ssr1_b[4] = {unroll, K / 8, N / unroll, M};
+        uint32_t ssr1_i[4] = {sizeof(char) * ldB, sizeof(char) * 8,
+                              sizeof(char) * unroll * ldB, 0};
+
+        snrt_ssr_loop_3d(SNRT_SSR_DM0, ssr0_b[1], ssr0_b[2], ssr0_b[3],
+                         ssr0_i[1], ssr0_i[2], ssr0_i[3]);
+        snrt_ssr_repeat(SNRT_SSR_DM0, unroll);
+
+        snrt_ssr_loop_4d(SNRT_SSR_DM1, ssr1_b[0], ssr1_b[1], ssr1_b[2],
+                         ssr1_b[3], ssr1_i[0], ssr1_i[1], ssr1_i[2], ssr1_i[3]);
+    }
+
+    // SSR start address need to be configured each time
+    snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_4D, A);
+    snrt_ssr_read(SNRT_SSR_DM1, SNRT_SSR_4D, B);
+    snrt_ssr_enable();
+
+    // Kernel progresses by 8 values each step
+    const uint32_t n_frep = K / 8 - 1;
+
+    for (uint32_t m = 0; m < M; m++) {
+        uint32_t n = 0;
+        for (uint32_t n0 = 0; n0 < N / unroll; n0++) {
+            float* _C = &C[m * ldC + n];
+            const register float zero = 0.0;
+            // Holds the FP16 dot products of a single step, and the final
+            // FP32 result in its lower half at the end
+            v2f32 c[unroll];
+            // FP32 accumulators
+            v2f32 reduce_reg[unroll];
+            uint32_t beta;
+
+            asm volatile(
+                "lw      %[beta], 0(%[BETA]) \n"
+                "beqz    %[beta], 1f \n"
+                // Load intermediate results
+                "flw %[reduce_reg0], 0(%[C]) \n"
+                "flw %[reduce_reg1], 4(%[C]) \n"
+                "flw %[reduce_reg2], 8(%[C]) \n"
+                "flw %[reduce_reg3], 12(%[C]) \n"
+                // Pack intermediate results into SIMD vector
+                "vfcpka.s.s %[reduce_reg0], %[reduce_reg0], %[zero]\n"
+                "vfcpka.s.s %[reduce_reg1], %[reduce_reg1], %[zero]\n"
+                "vfcpka.s.s %[reduce_reg2], %[reduce_reg2], %[zero]\n"
+                "vfcpka.s.s %[reduce_reg3], %[reduce_reg3], %[zero]\n"
+                "j 2f \n"
+                "1: \n"
+                // Initialize FP32 accumulators with zeros
+                "vfcpka.s.s %[reduce_reg0], %[zero], %[zero]\n"
+                "vfcpka.s.s %[reduce_reg1], %[zero], %[zero]\n"
+                "vfcpka.s.s %[reduce_reg2], %[zero], %[zero]\n"
+                "vfcpka.s.s %[reduce_reg3], %[zero], %[zero]\n"
+                "2: \n"
+                // Every step computes two products per FP16 lane with the
+                // expanding dot product, and sums the lanes into the FP32
+                // accumulators right away. No partial sum along K is thus
+                // rounded to FP16.
+                "frep.o  %[n_frep], 12, 0, 0 \n"
+                "vfcpka.s.s %[c0], %[zero], %[zero]\n"
+                "vfcpka.s.s %[c1], %[zero], %[zero]\n"
+                "vfcpka.s.s %[c2], %[zero], %[zero]\n"
+                "vfcpka.s.s %[c3], %[zero], %[zero]\n"
+                "vfdotpex.h.b %[c0], ft1, ft0 \n"
+                "vfdotpex.h.b %[c1], ft1, ft0 \n"
+                "vfdotpex.h.b %[c2], ft1, ft0 \n"
+                "vfdotpex.h.b %[c3], ft1, ft0 \n"
+                "vfsumex.s.h %[reduce_reg0], %[c0] \n"
+                "vfsumex.s.h %[reduce_reg1], %[c1] \n"
+                "vfsumex.s.h %[reduce_reg2], %[c2] \n"
+                "vfsumex.s.h %[reduce_reg3], %[c3] \n"
+                // Initialize reduce register to zero
+                "vfcpka.s.s %[c0], %[zero], %[zero] \n"
+                "vfcpka.s.s %[c1], %[zero], %[zero] \n"
+                "vfcpka.s.s %[c2], %[zero], %[zero] \n"
+                "vfcpka.s.s %[c3], %[zero], %[zero] \n"
+                // Sum-reduce FP32 vector
+                "vfsum.s %[c0], %[reduce_reg0] \n"
+                "vfsum.s %[c1], %[reduce_reg1] \n"
+                "vfsum.s %[c2], %[reduce_reg2] \n"
+                "vfsum.s %[c3], %[reduce_reg3] \n"
+                : [ c0 ] "+f"(c[0]), [ c1 ] "+f"(c[1]), [ c2 ] "+f"(c[2]),
+                  [ c3 ] "+f"(c[3]), [ beta ] "=r"(beta),
+                  [ reduce_reg0 ] "+f"(reduce_reg[0]),
+                  [ reduce_reg1 ] "+f"(reduce_reg[1]),
+                  [ reduce_reg2 ] "+f"(reduce_reg[2]),
+                  [ reduce_reg3 ] "+f"(reduce_reg[3])
+                : [ C ] "r"(_C), [ n_frep ] "r"(n_frep), [ BETA ] "r"(BETA),
+                  [ zero ] "f"(zero)
+                : "ft0", "ft1", "ft2");
+
+            // Store results back
+            _C[0] = c[0][0];
+            _C[1] = c[1][0];
+            _C[2] = c[2][0];
+            _C[3] = c[3][0];
+            n += unroll;
+        }
+    }
+
+    snrt_ssr_disable();
+}
+
+// FP32 kernel for a row-major B, which packs consecutive elements of B and C
+// along N instead of K, so that B does not have to be transposed. Each element
+// of A is loaded into one of eight consecutive registers and broadcast to all
+// SIMD lanes by vfmac.r.s. The FREP sequencer staggers the source register
+// across the iterations of a block of eight K steps, so A can be stored in
+// either layout and K has no granularity. N must be a multiple of
+// 2 * unroll, and the rows of B and C must be 64-bit aligned.
+void gemm_fp32_bcast_opt(uint32_t M, uint32_t N, uint32_t K, float* A,
+                         uint32_t ldA, uint32_t ta, float* B, uint32_t ldB,
+                         float* C, uint32_t ldC, const uint32_t* BETA,
+                         uint32_t setup_SSR) {
+    // Unrolling factor of most inner loop.
+    // Should be at least as high as the FMA delay
+    // for maximum utilization
+    const uint32_t unroll = 8;
+
+    // SSR strides and bounds only have to be configured
+    // once in the beginning
+    if (setup_SSR) {
+        const uint32_t ssr1_b[4] = {unroll, K, N / (2 * unroll), M};
+        const uint32_t ssr1_i[4] = {8, sizeof(float) * ldB, 8 * unroll, 0};
+
+        snrt_ssr_loop_4d(SNRT_SSR_DM1, ssr1_b[0], ssr1_b[1], ssr1_b[2],
+                         ssr1_b[3], ssr1_i[0], ssr1_i[1], ssr1_i[2], ssr1_i[3]);
+    }
+
+    // SSR start address need to be configured each time
+    snrt_ssr_read(SNRT_SSR_DM1, SNRT_SSR_4D, B);
+    snrt_ssr_enable();
+
+    // Distance between consecutive elements of a row of A, and between rows
+    const uint32_t a_step = ta ? sizeof(float) * ldA : sizeof(float);
+    const uint32_t a_row = ta ? 1 : ldA;
+
+    for (uint32_t m = 0; m < M; m++) {
+        for (uint32_t n = 0; n < N; n += 2 * unroll) {
+            float* _A = &A[m * a_row];
+            float* _C = &C[m * ldC + n];
+            v2f32 c[unroll];
+
+            asm volatile(
+                "beqz %[beta], 1f \n"
+                // Load intermediate results
+                "fld %[c0], 0(%[C]) \n"
+                "fld %[c1], 8(%[C]) \n"
+                "fld %[c2], 16(%[C]) \n"
+                "fld %[c3], 24(%[C]) \n"
+                "fld %[c4], 32(%[C]) \n"
+                "fld %[c5], 40(%[C]) \n"
+                "fld %[c6], 48(%[C]) \n"
+                "fld %[c7], 56(%[C]) \n"
+                "j 2f \n"
+                "1: \n"
+                // Initialize SIMD vectors with zeros
+                "fcvt.d.w %[c0], zero \n"
+                "fcvt.d.w %[c1], zero \n"
+                "fcvt.d.w %[c2], zero \n"
+                "fcvt.d.w %[c3], zero \n"
+                "fcvt.d.w %[c4], zero \n"
+                "fcvt.d.w %[c5], zero \n"
+                "fcvt.d.w %[c6], zero \n"
+                "fcvt.d.w %[c7], zero \n"
+                "2: \n"
+                : [ c0 ] "=&f"(c[0]), [ c1 ] "=&f"(c[1]), [ c2 ] "=&f"(c[2]),
+                  [ c3 ] "=&f"(c[3]), [ c4 ] "=&f"(c[4]), [ c5 ] "=&f"(c[5]),
+                  [ c6 ] "=&f"(c[6]), [ c7 ] "=&f"(c[7])
+                : [ C ] "r"(_C), [ beta ] "r"(*BETA)
+                : "memory");
+
+            uint32_t k = 0;
+            for (; k + unroll <= K; k += unroll) {
+                asm volatile(
+                    // Load the next eight elements of A
+                    "flw fa0, 0(%[A]) \n"
+                    "add %[A], %[A], %[a_step] \n"
+                    "flw fa1, 0(%[A]) \n"
+                    "add %[A], %[A], %[a_step] \n"
+                    "flw fa2, 0(%[A]) \n"
+                    "add %[A], %[A], %[a_step] \n"
+                    "flw fa3, 0(%[A]) \n"
+                    "add %[A], %[A], %[a_step] \n"
+                    "flw fa4, 0(%[A]) \n"
+                    "add %[A], %[A], %[a_step] \n"
+                    "flw fa5, 0(%[A]) \n"
+                    "add %[A], %[A], %[a_step] \n"
+                    "flw fa6, 0(%[A]) \n"
+                    "add %[A], %[A], %[a_step] \n"
+                    "flw fa7, 0(%[A]) \n"
+                    "add %[A], %[A], %[a_step] \n"
+                    // frep over MACs, staggering rs2 from fa0 to fa7
+                    "frep.o  %[n_frep], 8, 7, 4 \n"
+                    "vfmac.r.s %[c0], ft1, fa0 \n"
+                    "vfmac.r.s %[c1], ft1, fa0 \n"
+                    "vfmac.r.s %[c2], ft1, fa0 \n"
+                    "vfmac.r.s %[c3], ft1, fa0 \n"
+                    "vfmac.r.s %[c4], ft1, fa0 \n"
+                    "vfmac.r.s %[c5], ft1, fa0 \n"
+                    "vfmac.r.s %[c6], ft1, fa0 \n"
+                    "vfmac.r.s %[c7], ft1, fa0 \n"
+                    : [ c0 ] "+f"(c[0]), [ c1 ] "+f"(c[1]), [ c2 ] "+f"(c[2]),
+                      [ c3 ] "+f"(c[3]), [ c4 ] "+f"(c[4]), [ c5 ] "+f"(c[5]),
+                      [ c6 ] "+f"(c[6]), [ c7 ] "+f"(c[7]), [ A ] "+r"(_A)
+                    : [ a_step ] "r"(a_step), [ n_frep ] "r"(unroll - 1)
+                    : "ft0", "ft1", "ft2", "fa0", "fa1", "fa2", "fa3", "fa4",
+                      "fa5", "fa6", "fa7", "memory");
+            }
+
+            // Leftover K steps, one at a time
+            for (; k < K; k++) {
+                asm volatile(
+                    "flw fa0, 0(%[A]) \n"
+                    "add %[A], %[A], %[a_step] \n"
+                    "vfmac.r.s %[c0], ft1, fa0 \n"
+                    "vfmac.r.s %[c1], ft1, fa0 \n"
+                    "vfmac.r.s %[c2], ft1, fa0 \n"
+                    "vfmac.r.s %[c3], ft1, fa0 \n"
+                    "vfmac.r.s %[c4], ft1, fa0 \n"
+                    "vfmac.r.s %[c5], ft1, fa0 \n"
+                    "vfmac.r.s %[c6], ft1, fa0 \n"
+                    "vfmac.r.s %[c7], ft1, fa0 \n"
+                    : [ c0 ] "+f"(c[0]), [ c1 ] "+f"(c[1]), [ c2 ] "+f"(c[2]),
+                      [ c3 ] "+f"(c[3]), [ c4 ] "+f"(c[4]), [ c5 ] "+f"(c[5]),
+                      [ c6 ] "+f"(c[6]), [ c7 ] "+f"(c[7]), [ A ] "+r"(_A)
+                    : [ a_step ] "r"(a_step)
+                    : "ft0", "ft1", "ft2", "fa0", "memory");
+            }
+
+            // Store results
+            ((v2f32*)_C)[0] = c[0];
+            ((v2f32*)_C)[1] = c[1];
+            ((v2f32*)_C)[2] = c[2];
+            ((v2f32*)_C)[3] = c[3];
+            ((v2f32*)_C)[4] = c[4];
+            ((v2f32*)_C)[5] = c[5];
+            ((v2f32*)_C)[6] = c[6];
+            ((v2f32*)_C)[7] = c[7];
+        }
+    }
+
+    snrt_fpu_fence();
+    snrt_ssr_disable();
+}
+
+// FP16 variant of gemm_fp32_bcast_opt(). N must be a multiple of 4 * unroll.
+void gemm_fp16_bcast_opt(uint32_t M, uint32_t N, uint32_t K, __fp16* A,
+                         uint32_t ldA, uint32_t ta, __fp16* B, uint32_t ldB,
+                         __fp16* C, uint32_t ldC, const uint32_t* BETA,
+                         uint32_t setup_SSR) {
+    // Unrolling factor of most inner loop.
+    // Should be at least as high as the FMA delay
+    // for maximum utilization
+    const uint32_t unroll = 8;
+
+    // SSR strides and bounds only have to be configured
+    // once in the beginning
+    if (setup_SSR) {
+        const uint32_t ssr1_b[4] = {unroll, K, N / (4 * unroll), M};
+        const uint32_t ssr1_i[4] = {8, sizeof(__fp16) * ldB, 8 * unroll, 0};
+
+        snrt_ssr_loop_4d(SNRT_SSR_DM1, ssr1_b[0], ssr1_b[1], ssr1_b[2],
+                         ssr1_b[3], ssr1_i[0], ssr1_i[1], ssr1_i[2], ssr1_i[3]);
+    }
+
+    // SSR start address need to be configured each time
+    snrt_ssr_read(SNRT_SSR_DM1, SNRT_SSR_4D, B);
+    snrt_ssr_enable();
+
+    // Distance between consecutive elements of a row of A, and between rows
+    const uint32_t a_step = ta ? sizeof(__fp16) * ldA : sizeof(__fp16);
+    const uint32_t a_row = ta ? 1 : ldA;
+
+    for (uint32_t m = 0; m < M; m++) {
+        for (uint32_t n = 0; n < N; n += 4 * unroll) {
+            __fp16* _A = &A[m * a_row];
+            __fp16* _C = &C[m * ldC + n];
+            v4f16 c[unroll];
+
+            asm volatile(
+                "beqz %[beta], 1f \n"
+                // Load intermediate results
+                "fld %[c0], 0(%[C]) \n"
+                "fld %[c1], 8(%[C]) \n"
+                "fld %[c2], 16(%[C]) \n"
+                "fld %[c3], 24(%[C]) \n"
+                "fld %[c4], 32(%[C]) \n"
+                "fld %[c5], 40(%[C]) \n"
+                "fld %[c6], 48(%[C]) \n"
+                "fld %[c7], 56(%[C]) \n"
+                "j 2f \n"
+                "1: \n"
+                // Initialize SIMD vectors with zeros
+                "fcvt.d.w %[c0], zero \n"
+                "fcvt.d.w %[c1], zero \n"
+                "fcvt.d.w %[c2], zero \n"
+                "fcvt.d.w %[c3], zero \n"
+                "fcvt.d.w %[c4], zero \n"
+                "fcvt.d.w %[c5], zero \n"
+                "fcvt.d.w %[c6], zero \n"
+                "fcvt.d.w %[c7], zero \n"
+                "2: \n"
+                : [ c0 ] "=&f"(c[0]), [ c1 ] "=&f"(c[1]), [ c2 ] "=&f"(c[2]),
+                  [ c3 ] "=&f"(c[3]), [ c4 ] "=&f"(c[4]), [ c5 ] "=&f"(c[5]),
+                  [ c6 ] "=&f"(c[6]), [ c7 ] "=&f"(c[7])
+                : [ C ] "r"(_C), [ beta ] "r"(*BETA)
+                : "memory");
+
+            uint32_t k = 0;
+            for (; k + unroll <= K; k += unroll) {
+                asm volatile(
+                    // Load the next eight elements of A
+                    "flh fa0, 0(%[A]) \n"
+                    "add %[A], %[A], %[a_step] \n"
+                    "flh fa1, 0(%[A]) \n"
+                    "add %[A], %[A], %[a_step] \n"
+                    "flh fa2, 0(%[A]) \n"
+                    "add %[A], %[A], %[a_step] \n"
+                    "flh fa3, 0(%[A]) \n"
+                    "add %[A], %[A], %[a_step] \n"
+                    "flh fa4, 0(%[A]) \n"
+                    "add %[A], %[A], %[a_step] \n"
+                    "flh fa5, 0(%[A]) \n"
+                    "add %[A], %[A], %[a_step] \n"
+                    "flh fa6, 0(%[A]) \n"
+                    "add %[A], %[A], %[a_step] \n"
+                    "flh fa7, 0(%[A]) \n"
+                    "add %[A], %[A], %[a_step] \n"
+                    // frep over MACs, staggering rs2 from fa0 to fa7
+                    "frep.o  %[n_frep], 8, 7, 4 \n"
+                    "vfmac.r.h %[c0], ft1, fa0 \n"
+                    "vfmac.r.h %[c1], ft1, fa0 \n"
+                    "vfmac.r.h %[c2], ft1, fa0 \n"
+                    "vfmac.r.h %[c3], ft1, fa0 \n"
+                    "vfmac.r.h %[c4], ft1, fa0 \n"
+                    "vfmac.r.h %[c5], ft1, fa0 \n"
+                    "vfmac.r.h %[c6], ft1, fa0 \n"
+                    "vfmac.r.h %[c7], ft1, fa0 \n"
+                    : [ c0 ] "+f"(c[0]), [ c1 ] "+f"(c[1]), [ c2 ] "+f"(c[2]),
+                      [ c3 ] "+f"(c[3]), [ c4 ] "+f"(c[4]), [ c5 ] "+f"(c[5]),
+                      [ c6 ] "+f"(c[6]), [ c7 ] "+f"(c[7]), [ A ] "+r"(_A)
+                    : [ a_step ] "r"(a_step), [ n_frep ] "r"(unroll - 1)
+                    : "ft0", "ft1", "ft2", "fa0", "fa1", "fa2", "fa3", "fa4",
+                      "fa5", "fa6", "fa7", "memory");
+            }
+
+            // Leftover K steps, one at a time
+            for (; k < K; k++) {
+                asm volatile(
+                    "flh fa0, 0(%[A]) \n"
+                    "add %[A], %[A], %[a_step] \n"
+                    "vfmac.r.h %[c0], ft1, fa0 \n"
+                    "vfmac.r.h %[c1], ft1, fa0 \n"
+                    "vfmac.r.h %[c2], ft1, fa0 \n"
+                    "vfmac.r.h %[c3], ft1, fa0 \n"
+                    "vfmac.r.h %[c4], ft1, fa0 \n"
+                    "vfmac.r.h %[c5], ft1, fa0 \n"
+                    "vfmac.r.h %[c6], ft1, fa0 \n"
+                    "vfmac.r.h %[c7], ft1, fa0 \n"
+                    : [ c0 ] "+f"(c[0]), [ c1 ] "+f"(c[1]), [ c2 ] "+f"(c[2]),
+                      [ c3 ] "+f"(c[3]), [ c4 ] "+f"(c[4]), [ c5 ] "+f"(c[5]),
+                      [ c6 ] "+f"(c[6]), [ c7 ] "+f"(c[7]), [ A ] "+r"(_A)
+                    : [ a_step ] "r"(a_step)
+                    : "ft0", "ft1", "ft2", "fa0", "memory");
+            }
+
+            // Store results
+            ((v4f16*)_C)[0] = c[0];
+            ((v4f16*)_C)[1] = c[1];
+            ((v4f16*)_C)[2] = c[2];
+            ((v4f16*)_C)[3] = c[3];
+            ((v4f16*)_C)[4] = c[4];
+            ((v4f16*)_C)[5] = c[5];
+            ((v4f16*)_C)[6] = c[6];
+            ((v4f16*)_C)[7] = c[7];
+        }
+    }
+
+    snrt_fpu_fence();
+    snrt_ssr_disable();
+}
+
+// Scalar conversions between FP8 in memory and FP32
+static inline float gemm_fp8_load(const char* p) {
+    float r;
+    asm volatile(
+        "flb      %[r], 0(%[p]) \n"
+        "fcvt.s.b %[r], %[r] \n"
+        : [ r ] "=f"(r)
+        : [ p ] "r"(p)
+        : "memory");
+    return r;
+}
+
+static inline void gemm_fp8_store(char* p, float v) {
+    asm volatile(
+        "fcvt.b.s %[v], %[v] \n"
+        "fsb      %[v], 0(%[p]) \n"
+        : [ v ] "+f"(v)
+        : [ p ] "r"(p)
+        : "memory");
+}
+
+// Scalar access to the i-th element of a matrix of the given precision
+static inline double gemm_load(precision_t prec, const void* p, uint32_t i) {
+    switch (prec) {
+        case FP64:
+            return ((const double*)p)[i];
+        case FP32:
+            return ((const float*)p)[i];
+        case FP16:
+            return ((const __fp16*)p)[i];
+        default:
+            return gemm_fp8_load((const char*)p + i);
+    }
+}
+
+static inline void gemm_store(precision_t prec, void* p, uint32_t i,
+                              double v) {
+    switch (prec) {
+        case FP64:
+            ((double*)p)[i] = v;
+            break;
+        case FP32:
+            ((float*)p)[i] = v;
+            break;
+        case FP16:
+            ((__fp16*)p)[i] = v;
+            break;
+        default:
+            gemm_fp8_store((char*)p + i, v);
+            break;
+    }
+}
+
+// Precision of the C matrix. FP8 operands can be expanded to an FP32 result.
+static inline precision_t gemm_c_prec(precision_t prec, uint32_t expand) {
+    return (prec == FP8 && expand) ? FP32 : prec;
+}
+
+// Scale an M x N matrix in its own precision. A zero factor clears the
+// matrix, so that uninitialized contents do not propagate.
+void gemm_scale(precision_t prec, uint32_t M, uint32_t N, void* C,
+                uint32_t ldC, double factor) {
+    switch (prec) {
+        case FP64: {
+            double* _C = (double*)C;
+            for (uint32_t m = 0; m < M; m++)
+                for (uint32_t n = 0; n < N; n++)
+                    _C[m * ldC + n] = factor ? _C[m * ldC + n] * factor : 0;
+            break;
+        }
+        case FP32: {
+            float* _C = (float*)C;
+            const float f = factor;
+            for (uint32_t m = 0; m < M; m++)
+                for (uint32_t n = 0; n < N; n++)
+                    _C[m * ldC + n] = f ? _C[m * ldC + n] * f : 0;
+            break;
+        }
+        case FP16: {
+            __fp16* _C = (__fp16*)C;
+            const __fp16 f = factor;
+            for (uint32_t m = 0; m < M; m++)
+                for (uint32_t n = 0; n < N; n++)
+                    _C[m * ldC + n] = f ? _C[m * ldC + n] * f : 0;
+            break;
+        }
+        case FP8: {
+            char* _C = (char*)C;
+            const float f = factor;
+            for (uint32_t m = 0; m < M; m++)
+                for (uint32_t n = 0; n < N; n++)
+                    gemm_fp8_store(&_C[m * ldC + n],
+                                   f ? gemm_fp8_load(&_C[m * ldC + n]) * f
+                                     : 0);
+            break;
+        }
+    }
+}
+
+// Scalar GEMM for any precision, operand layout and scaling factors. Used for
+// the configurations which the optimized kernels do not cover.
+void gemm_baseline(precision_t prec, precision_t c_prec, uint32_t M,
+                   uint32_t N, uint32_t K, void* A, uint32_t ldA, uint32_t ta,
+                   void* B, uint32_t ldB, uint32_t tb, void* C, uint32_t ldC,
+                   double alpha, double beta) {
+    for (uint32_t m = 0; m < M; m++) {
+        for (uint32_t n = 0; n < N; n++) {
+            double c = 0.0;
+            for (uint32_t k = 0; k < K; k++) {
+                double a = gemm_load(prec, A, ta ? k * ldA + m : m * ldA + k);
+                double b = gemm_load(prec, B, tb ? n * ldB + k : k * ldB + n);
+                c += a * b;
+            }
+            c *= alpha;
+            if (beta) c += beta * gemm_load(c_prec, C, m * ldC + n);
+            gemm_store(c_prec, C, m * ldC + n, c);
+        }
+    }
+}
+
+// Unrolling factor along N of the optimized kernels
+#define GEMM_UNROLL 8
+
+// Granularity of K in the optimized kernels, which consume one 64-bit SSR
+// word per operand and step
+static inline uint32_t gemm_kernel_k_align(precision_t prec) {
+    return 8 / prec;
+}
+
+// Smallest K supported by the optimized kernels. The FP32 kernel peels off
+// its first step, so it needs at least two.
+static inline uint32_t gemm_kernel_k_min(precision_t prec) {
+    return (prec == FP32) ? 4 : gemm_kernel_k_align(prec);
+}
+
+// The FP32 and the non-expanding FP16 kernels read a row-major B as is,
+// packing consecutive elements along N instead of K
+static inline uint32_t gemm_kernel_packs_n(precision_t prec, uint32_t expand,
+                                           uint32_t transb) {
+    return !transb && (prec == FP32 || (prec == FP16 && !expand));
+}
+
+// Granularity of N in the optimized kernels, i.e. their unrolling factor
+// times the number of elements they pack along N into one SSR word
+static inline uint32_t gemm_kernel_n_align(precision_t prec,
+                                           uint32_t packs_n) {
+    return packs_n ? GEMM_UNROLL * (8 / prec) : GEMM_UNROLL;
+}
+
+// Whether the rows of a matrix, or its columns if stored transposed, start
+// at 64-bit word boundaries, as required by the SIMD kernels
+static inline uint32_t gemm_aligned(const void* p, uint32_t ld,
+                                    precision_t prec) {
+    return !((uintptr_t)p % 8) && !((ld * prec) % 8);
+}
+
+// Dot product of k_words pairs of SSR words from ft0 and ft1, for the
+// remainder kernel below. The products are spread over four accumulators,
+// which the FREP sequencer staggers to hide the FMA latency. The SIMD lanes
+// of the result are summed in double precision.
+static inline double gemm_dot_words(precision_t prec, uint32_t expand,
+                                    uint32_t k_words) {
+    const uint32_t n_frep = k_words - 1;
+    double sum = 0;
+
+    switch (prec) {
+        case FP64:
+            asm volatile(
+                "fcvt.d.w fa0, zero \n"
+                "fcvt.d.w fa1, zero \n"
+                "fcvt.d.w fa2, zero \n"
+                "fcvt.d.w fa3, zero \n"
+                // Stagger rd and rs3 from fa0 to fa3
+                "frep.o  %[n_frep], 1, 3, 9 \n"
+                "fmadd.d fa0, ft0, ft1, fa0 \n"
+                "fadd.d fa0, fa0, fa1 \n"
+                "fadd.d fa2, fa2, fa3 \n"
+                "fadd.d %[sum], fa0, fa2 \n"
+                : [ sum ] "=f"(sum)
+                : [ n_frep ] "r"(n_frep)
+                : "ft0", "ft1", "ft2", "fa0", "fa1", "fa2", "fa3");
+            break;
+        case FP32: {
+            v2f32 r;
+            asm volatile(
+                "fcvt.d.w fa0, zero \n"
+                "fcvt.d.w fa1, zero \n"
+                "fcvt.d.w fa2, zero \n"
+                "fcvt.d.w fa3, zero \n"
+                // Stagger rd from fa0 to fa3
+                "frep.o  %[n_frep], 1, 3, 1 \n"
+                "vfmac.s fa0, ft0, ft1 \n"
+                "vfadd.s fa0, fa0, fa1 \n"
+                "vfadd.s fa2, fa2, fa3 \n"
+                "vfadd.s %[r], fa0, fa2 \n"
+                : [ r ] "=f"(r)
+                : [ n_frep ] "r"(n_frep)
+                : "ft0", "ft1", "ft2", "fa0", "fa1", "fa2", "fa3");
+            sum = (double)r[0] + r[1];
+            break;
+        }
+        case FP16:
+            if (expand) {
+                v2f32 r;
+                asm volatile(
+                    "fcvt.d.w fa0, zero \n"
+                    "fcvt.d.w fa1, zero \n"
+                    "fcvt.d.w fa2, zero \n"
+                    "fcvt.d.w fa3, zero \n"
+                    // Stagger rd from fa0 to fa3
+                    "frep.o  %[n_frep], 1, 3, 1 \n"
+                    "vfdotpex.s.h fa0, ft0, ft1 \n"
+                    "vfadd.s fa0, fa0, fa1 \n"
+                    "vfadd.s fa2, fa2, fa3 \n"
+                    "vfadd.s %[r], fa0, fa2 \n"
+                    : [ r ] "=f"(r)
+                    : [ n_frep ] "r"(n_frep)
+                    : "ft0", "ft1", "ft2", "fa0", "fa1", "fa2", "fa3");
+                sum = (double)r[0] + r[1];
+            } else {
+                v4f16 r;
+                asm volatile(
+                    "fcvt.d.w fa0, zero \n"
+                    "fcvt.d.w fa1, zero \n"
+                    "fcvt.d.w fa2, zero \n"
+                    "fcvt.d.w fa3, zero \n"
+                    // Stagger rd from fa0 to fa3
+                    "frep.o  %[n_frep], 1, 3, 1 \n"
+                    "vfmac.h fa0, ft0, ft1 \n"
+                    "vfadd.h fa0, fa0, fa1 \n"
+                    "vfadd.h fa2, fa2, fa3 \n"
+                    "vfadd.h %[r], fa0, fa2 \n"
+                    : [ r ] "=f"(r)
+                    : [ n_frep ] "r"(n_frep)
+                    : "ft0", "ft1", "ft2", "fa0", "fa1", "fa2", "fa3");
+                sum = (double)r[0] + r[1] + r[2] + r[3];
+            }
+            break;
+        case FP8: {
+            if (expand) {
+                // Like gemm_fp8_ex_fp32_opt(), sum the FP16 dot products of
+                // every step into an FP32 accumulator in fa0
+                v2f32 r;
+                asm volatile(
+                    "fcvt.d.w fa0, zero \n"
+                    "fcvt.d.w fa1, zero \n"
+                    "frep.o  %[n_frep], 3, 0, 0 \n"
+                    "vfcpka.s.s fa2, fa1, fa1 \n"
+                    "vfdotpex.h.b fa2, ft0, ft1 \n"
+                    "vfsumex.s.h fa0, fa2 \n"
+                    "vfadd.s %[r], fa0, fa1 \n"
+                    : [ r ] "=f"(r)
+                    : [ n_frep ] "r"(n_frep)
+                    : "ft0", "ft1", "ft2", "fa0", "fa1", "fa2");
+                sum = (double)r[0] + r[1];
+                break;
+            }
+            // Like gemm_fp8_ex_opt(), accumulate in FP16
+            v4f16 r;
+            asm volatile(
+                "fcvt.d.w fa0, zero \n"
+                "fcvt.d.w fa1, zero \n"
+                "fcvt.d.w fa2, zero \n"
+                "fcvt.d.w fa3, zero \n"
+                // Stagger rd from fa0 to fa3
+                "frep.o  %[n_frep], 1, 3, 1 \n"
+                "vfdotpex.h.b fa0, ft0, ft1 \n"
+                "vfadd.h fa0, fa0, fa1 \n"
+                "vfadd.h fa2, fa2, fa3 \n"
+                "vfadd.h %[r], fa0, fa2 \n"
+                : [ r ] "=f"(r)
+                : [ n_frep ] "r"(n_frep)
+                : "ft0", "ft1", "ft2", "fa0", "fa1", "fa2", "fa3");
+            sum = (double)r[0] + r[1] + r[2] + r[3];
+            break;
+        }
+    }
+    return sum;
+}
+
+/**
+ * @brief Remainder kernel for the columns of C which the optimized kernels
+ * leave over, when these pack along K.
+ * @details Computes C = A * B + beta * C for an M x N block with a single
+ * column per step, every element as a dot product along K streamed through
+ * SSR 0 and 1. FP64 supports all layouts through the SSR strides, the SIMD
+ * precisions require a row-major A and a column-major B, whose rows and
+ * columns are 64-bit aligned. The K elements which do not fill a whole SSR
+ * word are added with scalar operations.
+ */
+void gemm_dot_opt(precision_t prec, uint32_t expand, uint32_t M, uint32_t N,
+                  uint32_t K, void* A, uint32_t ldA, uint32_t ta, void* B,
+                  uint32_t ldB, uint32_t tb, void* C, uint32_t ldC,
+                  uint32_t beta) {
+    const precision_t c_prec = gemm_c_prec(prec, expand);
+    const uint32_t k_words = K / gemm_kernel_k_align(prec);
+    const uint32_t k_main = k_words * gemm_kernel_k_align(prec);
+
+    if (k_words) {
+        const uint32_t ssr0_i[3] = {ta ? 8 * ldA : 8, 0, ta ? 8 : prec * ldA};
+        const uint32_t ssr1_i[3] = {tb ? 8 : 8 * ldB, tb ? prec * ldB : 8, 0};
+
+        snrt_ssr_loop_3d(SNRT_SSR_DM0, k_words, N, M, ssr0_i[0], ssr0_i[1],
+                         ssr0_i[2]);
+        snrt_ssr_loop_3d(SNRT_SSR_DM1, k_words, N, M, ssr1_i[0], ssr1_i[1],
+                         ssr1_i[2]);
+        snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_3D, A);
+        snrt_ssr_read(SNRT_SSR_DM1, SNRT_SSR_3D, B);
+        snrt_ssr_enable();
+    }
+
+    for (uint32_t m = 0; m < M; m++) {
+        for (uint32_t n = 0; n < N; n++) {
+            double c = k_words ? gemm_dot_words(prec, expand, k_words) : 0;
+            for (uint32_t k = k_main; k < K; k++) {
+                double a = gemm_load(prec, A, ta ? k * ldA + m : m * ldA + k);
+                double b = gemm_load(prec, B, tb ? n * ldB + k : k * ldB + n);
+                c += a * b;
+            }
+            if (beta) c += gemm_load(c_prec, C, m * ldC + n);
+            gemm_store(c_prec, C, m * ldC + n, c);
+        }
+    }
+
+    if (k_words) {
+        snrt_fpu_fence();
+        snrt_ssr_disable();
+    }
+}
+
+/**
+ * @brief Remainder kernel for the columns of C which gemm_fp32_bcast_opt()
+ * and gemm_fp16_bcast_opt() leave over.
+ * @details Computes C = A * B + beta * C for an M x N block with a row-major
+ * B, one SSR word of C per step instead of eight. Four elements of A at a
+ * time are broadcast from fa0-fa3, and the FREP sequencer staggers them
+ * together with four accumulators in fa4-fa7. N must be a multiple of the
+ * SIMD width, and the rows of B and C must be 64-bit aligned.
+ */
+void gemm_bcast_narrow_opt(precision_t prec, uint32_t M, uint32_t N,
+                           uint32_t K, void* A, uint32_t ldA, uint32_t ta,
+                           void* B, uint32_t ldB, void* C, uint32_t ldC,
+                           uint32_t beta) {
+    const uint32_t lanes = 8 / prec;
+    const uint32_t a_step = ta ? prec * ldA : prec;
+    const uint32_t a_row = ta ? prec : prec * ldA;
+
+    snrt_ssr_loop_3d(SNRT_SSR_DM1, K, N / lanes, M, prec * ldB, 8, 0);
+    snrt_ssr_read(SNRT_SSR_DM1, SNRT_SSR_3D, B);
+    snrt_ssr_enable();
+
+    for (uint32_t m = 0; m < M; m++) {
+        for (uint32_t n = 0; n < N; n += lanes) {
+            void* _A = A + m * a_row;
+            void* _C = C + (m * ldC + n) * prec;
+            uint32_t n_blocks = K / 4;
+            uint32_t n_left = K % 4;
+
+            if (prec == FP32) {
+                asm volatile(
+                    "fcvt.d.w fa4, zero \n"
+                    "fcvt.d.w fa5, zero \n"
+                    "fcvt.d.w fa6, zero \n"
+                    "fcvt.d.w fa7, zero \n"
+                    "beqz %[n_blocks], 2f \n"
+                    "1: \n"
+                    "flw fa0, 0(%[A]) \n"
+                    "add %[A], %[A], %[a_step] \n"
+                    "flw fa1, 0(%[A]) \n"
+                    "add %[A], %[A], %[a_step] \n"
+                    "flw fa2, 0(%[A]) \n"
+                    "add %[A], %[A], %[a_step] \n"
+                    "flw fa3, 0(%[A]) \n"
+                    "add %[A], %[A], %[a_step] \n"
+                    // Stagger rd and rs2 from fa4 and fa0 to fa7 and fa3
+                    "frep.o  %[n_frep], 1, 3, 5 \n"
+                    "vfmac.r.s fa4, ft1, fa0 \n"
+                    "addi %[n_blocks], %[n_blocks], -1 \n"
+                    "bnez %[n_blocks], 1b \n"
+                    "2: \n"
+                    "beqz %[n_left], 4f \n"
+                    "3: \n"
+                    "flw fa0, 0(%[A]) \n"
+                    "add %[A], %[A], %[a_step] \n"
+                    "vfmac.r.s fa4, ft1, fa0 \n"
+                    "addi %[n_left], %[n_left], -1 \n"
+                    "bnez %[n_left], 3b \n"
+                    "4: \n"
+                    "vfadd.s fa4, fa4, fa5 \n"
+                    "vfadd.s fa6, fa6, fa7 \n"
+                    "vfadd.s fa4, fa4, fa6 \n"
+                    "beqz %[beta], 5f \n"
+                    "fld fa5, 0(%[C]) \n"
+                    "vfadd.s fa4, fa4, fa5 \n"
+                    "5: \n"
+                    "fsd fa4, 0(%[C]) \n"
+                    : [ A ] "+r"(_A), [ n_blocks ] "+r"(n_blocks),
+                      [ n_left ] "+r"(n_left)
+                    : [ a_step ] "r"(a_step), [ n_frep ] "r"(3),
+                      [ beta ] "r"(beta), [ C ] "r"(_C)
+                    : "ft0", "ft1", "ft2", "fa0", "fa1", "fa2", "fa3", "fa4",
+                      "fa5", "fa6", "fa7", "memory");
+            } else {
+                asm volatile(
+                    "fcvt.d.w fa4, zero \n"
+                    "fcvt.d.w fa5, zero \n"
+                    "fcvt.d.w fa6, zero \n"
+                    "fcvt.d.w fa7, zero \n"
+                    "beqz %[n_blocks], 2f \n"
+                    "1: \n"
+                    "flh fa0, 0(%[A]) \n"
+                    "add %[A], %[A], %[a_step] \n"
+                    "flh fa1, 0(%[A]) \n"
+                    "add %[A], %[A], %[a_step] \n"
+                    "flh fa2, 0(%[A]) \n"
+                    "add %[A], %[A], %[a_step] \n"
+                    "flh fa3, 0(%[A]) \n"
+                    "add %[A], %[A], %[a_step] \n"
+                    // Stagger rd and rs2 from fa4 and fa0 to fa7 and fa3
+                    "frep.o  %[n_frep], 1, 3, 5 \n"
+                    "vfmac.r.h fa4, ft1, fa0 \n"
+                    "addi %[n_blocks], %[n_blocks], -1 \n"
+                    "bnez %[n_blocks], 1b \n"
+                    "2: \n"
+                    "beqz %[n_left], 4f \n"
+                    "3: \n"
+                    "flh fa0, 0(%[A]) \n"
+                    "add %[A], %[A], %[a_step] \n"
+                    "vfmac.r.h fa4, ft1, fa0 \n"
+                    "addi %[n_left], %[n_left], -1 \n"
+                    "bnez %[n_left], 3b \n"
+                    "4: \n"
+                    "vfadd.h fa4, fa4, fa5 \n"
+                    "vfadd.h fa6, fa6, fa7 \n"
+                    "vfadd.h fa4, fa4, fa6 \n"
+                    "beqz %[beta], 5f \n"
+                    "fld fa5, 0(%[C]) \n"
+                    "vfadd.h fa4, fa4, fa5 \n"
+                    "5: \n"
+                    "fsd fa4, 0(%[C]) \n"
+                    : [ A ] "+r"(_A), [ n_blocks ] "+r"(n_blocks),
+                      [ n_left ] "+r"(n_left)
+                    : [ a_step ] "r"(a_step), [ n_frep ] "r"(3),
+                      [ beta ] "r"(beta), [ C ] "r"(_C)
+                    : "ft0", "ft1", "ft2", "fa0", "fa1", "fa2", "fa3", "fa4",
+                      "fa5", "fa6", "fa7", "memory");
+            }
+        }
+    }
+
+    snrt_fpu_fence();
+    snrt_ssr_disable();
+}
+
+// Dispatch to the optimized kernel of the given precision. N must be a
+// multiple of gemm_kernel_n_align(). The SIMD kernels which pack along K
+// require K to be a multiple of gemm_kernel_k_align(), a row-major A and a
+// column-major B. Those which pack along N support either layout of A.
+void gemm_opt(precision_t prec, uint32_t expand, uint32_t setup_ssr,
+              uint32_t transa, uint32_t transb, uint32_t m, uint32_t n,
+              uint32_t k, void* a, uint32_t lda, void* b, uint32_t ldb,
+              uint32_t beta, void* c, uint32_t ldc) {
+    switch (prec) {
+        case FP64:
+            gemm_fp64_opt(m, n, k, (double*)a, lda, transa, (double*)b, ldb,
+                          transb, (double*)c, ldc, &beta, setup_ssr);
+            break;
+        case FP32:
+            if (!transb) {
+                gemm_fp32_bcast_opt(m, n, k, (float*)a, lda, transa,
+                                    (float*)b, ldb, (float*)c, ldc, &beta,
+                                    setup_ssr);
+            } else {
+                gemm_fp32_opt(m, n, k, (float*)a, lda, (float*)b, ldb,
+                              (float*)c, ldc, &beta, setup_ssr);
+            }
+            break;
+        case FP16:
+            if (!expand && !transb) {
+                gemm_fp16_bcast_opt(m, n, k, (__fp16*)a, lda, transa,
+                                    (__fp16*)b, ldb, (__fp16*)c, ldc, &beta,
+                                    setup_ssr);
+            } else if (expand) {
+                gemm_fp16_ex_opt(m, n, k, (__fp16*)a, lda, (__fp16*)b, ldb,
+                                 (__fp16*)c, ldc, &beta, setup_ssr);
+            } else {
+                gemm_fp16_opt(m, n, k, (__fp16*)a, lda, (__fp16*)b, ldb,
+                              (__fp16*)c, ldc, &beta, setup_ssr);
+            }
+            break;
+        case FP8:
+            if (expand) {
+                gemm_fp8_ex_fp32_opt(m, n, k, (char*)a, lda, (char*)b, ldb,
+                                     (float*)c, ldc, &beta, setup_ssr);
+            } else {
+                gemm_fp8_ex_opt(m, n, k, (char*)a, lda, (char*)b, ldb,
+                                (char*)c, ldc, &beta, setup_ssr);
+            }
+            break;
+    }
+}
+
+// Single-core part of the BLAS compliant GEMM kernel below. Computes the
+// whole of C = alpha * op(A) * op(B) + beta * C on the calling core, with the
+// optimized kernels on the largest supported block and the remainder kernels
+// on the leftover columns. These configure the SSRs themselves, so a
+// following call with setup_ssr cleared only works if this one had no
+// leftover columns.
+void gemm_core(precision_t prec, uint32_t expand, uint32_t setup_ssr,
+               uint32_t transa, uint32_t transb, uint32_t m_core, uint32_t n,
+               uint32_t k, double alpha, void* a_core, uint32_t lda_core,
+               void* b, uint32_t ldb, double beta, void* c_core,
+               uint32_t ldc_core) {
+    const precision_t c_prec = gemm_c_prec(prec, expand);
+
+    if (m_core == 0) return;
+
+    // FP64 supports all layouts through the SSR strides. The SIMD kernels
+    // which pack consecutive elements along K into one SSR word require a
+    // row-major A and a column-major B, those which pack along N a row-major
+    // B. Accumulation into an FP8 C is not implemented in the optimized
+    // kernels.
+    const uint32_t packs_n = gemm_kernel_packs_n(prec, expand, transb);
+    uint32_t supported = (prec == FP64) || packs_n || (!transa && transb);
+    if (c_prec == FP8 && beta != 0) supported = 0;
+    // The SIMD kernels stream whole 64-bit words of B and C, and of A if they
+    // pack along K
+    if (prec != FP64) {
+        if (!gemm_aligned(b, ldb, prec)) supported = 0;
+        if (!gemm_aligned(c_core, ldc_core, c_prec)) supported = 0;
+        if (!packs_n && !gemm_aligned(a_core, lda_core, prec)) supported = 0;
+    }
+    if (!supported) {
+        gemm_baseline(prec, c_prec, m_core, n, k, a_core, lda_core, transa, b,
+                      ldb, transb, c_core, ldc_core, alpha, beta);
+        return;
+    }
+
+    // The kernels compute C = A * B + beta * C with beta either 0 or 1, other
+    // factors are applied to C before and after the kernel
+    if (alpha == 0) {
+        gemm_scale(c_prec, m_core, n, c_core, ldc_core, beta);
+        return;
+    }
+    uint32_t beta_flag = (beta != 0);
+    if (beta_flag && beta != alpha)
+        gemm_scale(c_prec, m_core, n, c_core, ldc_core, beta / alpha);
+
+    // The optimized kernels cover the largest block of C whose N is a
+    // multiple of their granularity, and the part of K which fills whole SSR
+    // words. The leftover columns are computed by the remainder kernels.
+    uint32_t n_main = n - n % gemm_kernel_n_align(prec, packs_n);
+    uint32_t k_main = k;
+    if (!packs_n) {
+        k_main -= k % gemm_kernel_k_align(prec);
+        if (k_main < gemm_kernel_k_min(prec)) n_main = 0;
+    }
+
+    if (n_main) {
+        gemm_opt(prec, expand, setup_ssr, transa, transb, m_core, n_main,
+                 k_main, a_core, lda_core, b, ldb, beta_flag, c_core,
+                 ldc_core);
+
+        // Add the contribution of the K remainder. It does not fill an SSR
+        // word, and its elements are not aligned to one either, so it is
+        // added with scalar operations.
+        if (k_main < k) {
+            uint32_t a_off = transa ? k_main * lda_core : k_main;
+            void* a_rem = a_core + a_off * prec;
+            void* b_rem = b + (transb ? k_main : k_main * ldb) * prec;
+            gemm_baseline(prec, c_prec, m_core, n_main, k - k_main, a_rem,
+                          lda_core, transa, b_rem, ldb, transb, c_core,
+                          ldc_core, 1, 1);
+        }
+    }
+
+    // Compute the N remainder. With a row-major B, the columns which do not
+    // fill an SSR word are not aligned to one, and use the scalar kernel.
+    if (n_main < n) {
+        void* b_rem = b + (transb ? n_main * ldb : n_main) * prec;
+        void* c_rem = c_core + n_main * c_prec;
+        uint32_t n_rem = n - n_main;
+        if (packs_n) {
+            uint32_t n_words = n_rem - n_rem % (8 / prec);
+            if (n_words)
+                gemm_bcast_narrow_opt(prec, m_core, n_words, k, a_core,
+                                      lda_core, transa, b_rem, ldb, c_rem,
+                                      ldc_core, beta_flag);
+            if (n_words < n_rem)
+                gemm_baseline(prec, c_prec, m_core, n_rem - n_words, k,
+                              a_core, lda_core, transa, b_rem + n_words * prec,
+                              ldb, transb, c_rem + n_words * c_prec, ldc_core,
+                              1, beta_flag);
+        } else {
+            gemm_dot_opt(prec, expand, m_core, n_rem, k, a_core, lda_core,
+                         transa, b_rem, ldb, transb, c_rem, ldc_core,
+                         beta_flag);
+        }
+    }
+
+    if (alpha != 1) gemm_scale(c_prec, m_core, n, c_core, ldc_core, alpha);
+}
+
 // BLAS compliant GEMM kernel, with some additional arguments at the beginning
 // to specify Snitch implementation details. Matrix sizes and pointers are for
-// the whole cluster computation
-// TODO: beta (and alpha) should be of floating-point type (same precision as
-// operands)
+// the whole cluster computation. For FP16, expand selects the kernel which
+// accumulates in FP32. For FP8, expand selects an FP32 result matrix C.
+// alpha and beta are applied in the precision of C.
 void gemm(precision_t prec, uint32_t expand, uint32_t setup_ssr,
           uint32_t transa, uint32_t transb, uint32_t m, uint32_t n, uint32_t k,
           double alpha, void* a, uint32_t lda, void* b, uint32_t ldb,
-          uint32_t beta, void* c, uint32_t ldc) {
+          double beta, void* c, uint32_t ldc) {
     const uint32_t compute_num = snrt_cluster_compute_core_num();
     const uint32_t compute_id = snrt_cluster_core_idx();
+    const precision_t c_prec = gemm_c_prec(prec, expand);
 
-    // Compute cores work not on contiguous blocks but on strided rows
-    uint32_t lda_strided = compute_num * lda;
-    uint32_t ldc_strided = compute_num * ldc;
+    // Compute fraction of C rows every core computes. Remainder rows are
+    // given to the first cores, one each.
+    uint32_t frac_m = m / compute_num;
+    uint32_t rem_m = m % compute_num;
+    uint32_t m_core = frac_m + (compute_id < rem_m);
+    if (m_core == 0) return;
+
+    void *a_core, *c_core;
+    uint32_t lda_core, ldc_core;
+    if (transa) {
+        // Consecutive rows of a transposed A are adjacent elements, so every
+        // core works on a contiguous block of rows
+        uint32_t m0 =
+            compute_id * frac_m + (compute_id < rem_m ? compute_id : rem_m);
+        a_core = a + m0 * prec;
+        lda_core = lda;
+        c_core = c + m0 * ldc * c_prec;
+        ldc_core = ldc;
+    } else {
+        // Compute cores work not on contiguous blocks but on strided rows
+        a_core = a + compute_id * lda * prec;
+        lda_core = compute_num * lda;
+        c_core = c + compute_id * ldc * c_prec;
+        ldc_core = compute_num * ldc;
+    }
 
-    // Compute cores access A and C at offsets of one row from each other
-    uint32_t offsetA = compute_id * lda;
-    uint32_t offsetC = compute_id * ldc;
+    gemm_core(prec, expand, setup_ssr, transa, transb, m_core, n, k, alpha,
+              a_core, lda_core, b, ldb, beta, c_core, ldc_core);
+}
 
-    // Compute fraction of C rows every core computes
-    uint32_t frac_m = m / compute_num;
+// Amount of TCDM at the top of L1 which is reserved for the stacks, TLS and
+// CLS and therefore not available to the tiled GEMM buffers
+#ifndef GEMM_TILED_L1_RESERVE
+#define GEMM_TILED_L1_RESERVE \
+    (snrt_cluster_core_num() * ((1 << SNRT_LOG2_STACK_SIZE) + 8) + 1024)
+#endif
+
+// Tile sizes selected by the tiled GEMM driver
+typedef struct {
+    uint32_t tm;
+    uint32_t tn;
+    uint32_t tk;
+    precision_t prec;     // Precision of A and B
+    precision_t c_prec;   // Precision of C
+    uint32_t packs_n;     // The kernel packs consecutive elements along N
+    uint32_t relayout_a;  // A tiles are transposed in TCDM before use
+    uint32_t relayout_b;  // B tiles are transposed in TCDM before use
+} gemm_tiling_t;
+
+static inline uint32_t gemm_round_up(uint32_t x, uint32_t align) {
+    return ((x + align - 1) / align) * align;
+}
+
+// Granularity of a tile along K. The SIMD kernels which pack along K
+// consume one 64-bit word per operand and step, and the FP32 one requires at
+// least two steps.
+static inline uint32_t gemm_tile_k_align(const gemm_tiling_t* t) {
+    if (t->packs_n) return 1;
+    return (t->prec == FP8) ? 8 : 4;
+}
 
+// Granularity of a tile along N, i.e. that of the kernels
+static inline uint32_t gemm_tile_n_align(const gemm_tiling_t* t) {
+    return gemm_kernel_n_align(t->prec, t->packs_n);
+}
+
+// Granularity of a tile along M, so that every compute core gets as many rows
+static inline uint32_t gemm_tile_m_align() {
+    return snrt_cluster_compute_core_num();
+}
+
+// TCDM footprint of a double-buffered A, B and C tile set, plus the
+// single-buffered tiles which transposed operands are relaid into
+static inline uint32_t gemm_tiling_size(const gemm_tiling_t* t) {
+    uint32_t size_a = t->tm * t->tk * t->prec;
+    uint32_t size_b = t->tk * t->tn * t->prec;
+    uint32_t size_c = t->tm * t->tn * t->c_prec;
+    return (2 + t->relayout_a) * size_a + (2 + t->relayout_b) * size_b +
+           2 * size_c;
+}
+
+// Halve a tile dimension, respecting its granularity. Returns 0 if the
+// dimension cannot be reduced further.
+static inline uint32_t gemm_tile_shrink(uint32_t* t, uint32_t align) {
+    uint32_t halved = gemm_round_up(*t / 2, align);
+    if (halved >= *t) return 0;
+    *t = halved;
+    return 1;
+}
+
+/**
+ * @brief Choose the largest tile sizes for which double-buffered A, B and C
+ * tiles fit into the given TCDM budget.
+ * @details Starts from the (aligned) full problem and repeatedly halves the
+ * largest tile dimension. The optimized kernels cannot accumulate into an
+ * FP8 C, so K is never tiled in that case. The precisions, packing and
+ * relayout flags in `t` must be set by the caller.
+ * @return 0 on success, -1 if not even the minimal tiles fit into the budget.
+ */
+static inline int gemm_tiling_init(uint32_t m, uint32_t n, uint32_t k,
+                                   uint32_t budget, gemm_tiling_t* t) {
+    const uint32_t m_align = gemm_tile_m_align();
+    const uint32_t n_align = gemm_tile_n_align(t);
+    const uint32_t k_align = gemm_tile_k_align(t);
+
+    t->tm = gemm_round_up(m, m_align);
+    t->tn = gemm_round_up(n, n_align);
+    t->tk = gemm_round_up(k, k_align);
+
+    while (gemm_tiling_size(t) > budget) {
+        uint32_t shrunk = 0;
+        // Shrink the largest dimension first
+        if (t->tm >= t->tn && t->tm >= t->tk)
+            shrunk = gemm_tile_shrink(&t->tm, m_align);
+        else if (t->tn >= t->tk)
+            shrunk = gemm_tile_shrink(&t->tn, n_align);
+        if (!shrunk && t->c_prec != FP8)
+            shrunk = gemm_tile_shrink(&t->tk, k_align);
+        if (!shrunk) shrunk = gemm_tile_shrink(&t->tm, m_align);
+        if (!shrunk) shrunk = gemm_tile_shrink(&t->tn, n_align);
+        if (!shrunk) return -1;
+    }
+    return 0;
+}
+
+// Iteration of the tiled GEMM, i.e. one K tile of one C tile
+typedef struct {
+    uint32_t m0, n0, k0;  // Offsets of the tile in the full matrices
+    uint32_t em, en, ek;  // Valid extent of the tile
+    uint32_t pm, pn, pk;  // Extent rounded up to the kernel granularity
+    uint32_t first_k;     // First K tile of a C tile
+    uint32_t last_k;      // Last K tile of a C tile
+} gemm_tile_iter_t;
+
+static inline void gemm_tile_iter(uint32_t m, uint32_t n, uint32_t k,
+                                  const gemm_tiling_t* t, uint32_t i,
+                                  gemm_tile_iter_t* it) {
+    const uint32_t n_tiles_n = (n + t->tn - 1) / t->tn;
+    const uint32_t n_tiles_k = (k + t->tk - 1) / t->tk;
+
+    // C tiles are distributed round-robin across clusters
+    uint32_t c_tile = snrt_cluster_idx() + (i / n_tiles_k) * snrt_cluster_num();
+    uint32_t ki = i % n_tiles_k;
+
+    it->m0 = (c_tile / n_tiles_n) * t->tm;
+    it->n0 = (c_tile % n_tiles_n) * t->tn;
+    it->k0 = ki * t->tk;
+    it->em = (m - it->m0 < t->tm) ? m - it->m0 : t->tm;
+    it->en = (n - it->n0 < t->tn) ? n - it->n0 : t->tn;
+    it->ek = (k - it->k0 < t->tk) ? k - it->k0 : t->tk;
+    it->pm = gemm_round_up(it->em, gemm_tile_m_align());
+    it->pn = gemm_round_up(it->en, gemm_tile_n_align(t));
+    it->pk = gemm_round_up(it->ek, gemm_tile_k_align(t));
+    it->first_k = (ki == 0);
+    it->last_k = (ki == n_tiles_k - 1);
+}
+
+// Number of iterations the current cluster performs
+static inline uint32_t gemm_tiled_n_iters(uint32_t m, uint32_t n, uint32_t k,
+                                          const gemm_tiling_t* t) {
+    const uint32_t n_tiles_m = (m + t->tm - 1) / t->tm;
+    const uint32_t n_tiles_n = (n + t->tn - 1) / t->tn;
+    const uint32_t n_tiles_k = (k + t->tk - 1) / t->tk;
+    const uint32_t n_c_tiles = n_tiles_m * n_tiles_n;
+    const uint32_t cluster_idx = snrt_cluster_idx();
+    const uint32_t cluster_num = snrt_cluster_num();
+
+    if (cluster_idx >= n_c_tiles) return 0;
+    return ((n_c_tiles - cluster_idx + cluster_num - 1) / cluster_num) *
+           n_tiles_k;
+}
+
+// Load the A and B tiles of an iteration into TCDM. Tiles are stored densely
+// with their padded extent as leading dimension. Tiles which are padded along
+// K are zeroed first, so the padding does not contribute to the result.
+static inline void gemm_tile_load_ab(precision_t prec, uint32_t transa,
+                                     uint32_t transb,
+                                     const gemm_tile_iter_t* it, void* a,
+                                     uint32_t lda, void* b, uint32_t ldb,
+                                     void* local_a, void* local_b) {
+    if (it->ek != it->pk) {
+        snrt_dma_zero_async(local_a, it->pm * it->pk * prec);
+        snrt_dma_zero_async(local_b, it->pk * it->pn * prec);
+        snrt_dma_wait_all();
+    }
+
+    if (transa) {
+        snrt_dma_start_2d(local_a, a + (it->k0 * lda + it->m0) * prec,
+                          it->em * prec, it->pm * prec, lda * prec, it->ek);
+    } else {
+        snrt_dma_start_2d(local_a, a + (it->m0 * lda + it->k0) * prec,
+                          it->ek * prec, it->pk * prec, lda * prec, it->em);
+    }
+
+    if (transb) {
+        snrt_dma_start_2d(local_b, b + (it->n0 * ldb + it->k0) * prec,
+                          it->ek * prec, it->pk * prec, ldb * prec, it->en);
+    } else {
+        snrt_dma_start_2d(local_b, b + (it->k0 * ldb + it->n0) * prec,
+                          it->en * prec, it->pn * prec, ldb * prec, it->ek);
+    }
+}
+
+// Transfer the valid region of a C tile between DRAM and TCDM
+static inline void gemm_tile_load_c(precision_t prec,
+                                    const gemm_tile_iter_t* it, void* c,
+                                    uint32_t ldc, void* local_c) {
+    snrt_dma_start_2d(local_c, c + (it->m0 * ldc + it->n0) * prec,
+                      it->en * prec, it->pn * prec, ldc * prec, it->em);
+}
+
+static inline void gemm_tile_store_c(precision_t prec,
+                                     const gemm_tile_iter_t* it, void* c,
+                                     uint32_t ldc, void* local_c) {
+    snrt_dma_start_2d(c + (it->m0 * ldc + it->n0) * prec, local_c,
+                      it->en * prec, ldc * prec, it->pn * prec, it->em);
+}
+
+// Transpose a rows x cols tile from src into dst, distributing the rows of
+// dst across the compute cores
+#define GEMM_TILE_TRANSPOSE(type, src, dst, rows, cols)    \
+    for (uint32_t j = snrt_cluster_core_idx(); j < (cols); \
+         j += snrt_cluster_compute_core_num())             \
+        for (uint32_t i = 0; i < (rows); i++)              \
+            ((type*)(dst))[j * (rows) + i] = ((type*)(src))[i * (cols) + j]
+
+static inline void gemm_tile_transpose(precision_t prec, void* src, void* dst,
+                                       uint32_t rows, uint32_t cols) {
     switch (prec) {
         case FP64:
-            gemm_fp64_opt(frac_m, n, k, (double*)a + offsetA, lda_strided,
-                          transa, (double*)b, ldb, transb, (double*)c + offsetC,
-                          ldc_strided, &beta, setup_ssr);
+            GEMM_TILE_TRANSPOSE(uint64_t, src, dst, rows, cols);
             break;
         case FP32:
-            gemm_fp32_opt(frac_m, n, k, (float*)a + offsetA, lda_strided,
-                          (float*)b, ldb, (float*)c + offsetC, ldc_strided,
-                          &beta, setup_ssr);
+            GEMM_TILE_TRANSPOSE(uint32_t, src, dst, rows, cols);
             break;
         case FP16:
-            if (expand) {
-                gemm_fp16_ex_opt(
-                    frac_m, n, k, (__fp16*)a + offsetA, lda_strided, (__fp16*)b,
-                    ldb, (__fp16*)c + offsetC, ldc_strided, &beta, setup_ssr);
-            } else {
-                gemm_fp16_opt(frac_m, n, k, (__fp16*)a + offsetA, lda_strided,
-                              (__fp16*)b, ldb, (__fp16*)c + offsetC,
-                              ldc_strided, &beta, setup_ssr);
-            }
+            GEMM_TILE_TRANSPOSE(uint16_t, src, dst, rows, cols);
             break;
         case FP8:
-            gemm_fp8_ex_opt(frac_m, n, k, (char*)a + offsetA, lda, (char*)b,
-                            ldb, (char*)c + offsetC, ldc_strided, &beta,
-                            setup_ssr);
+            GEMM_TILE_TRANSPOSE(uint8_t, src, dst, rows, cols);
             break;
     }
 }
+
+/**
+ * @brief Tiled GEMM on operands which reside outside of the TCDM.
+ * @details Must be called by all cores of all participating clusters. The
+ * C matrix is split into tiles which are distributed across clusters. For
+ * every C tile, the DM core streams the A and B tiles along K into TCDM,
+ * double-buffering them so that the transfer of the next K tile overlaps
+ * with the computation of the current one. The compute cores accumulate into
+ * the C tile in place, which is written back while the next C tile is being
+ * computed. Tile sizes are chosen from the free TCDM space above
+ * `snrt_l1_next()`, and edge tiles of arbitrary size are padded in TCDM to
+ * the granularity required by the optimized kernels.
+ *
+ * The FP32 and FP16 kernels read a row-major B and either layout of A as
+ * they are. The SIMD kernels which pack along K, i.e. those of the expanding
+ * FP16 and FP8 GEMMs and those for a column-major B, need A and B contiguous
+ * along K. Only if an operand is stored the other way around in memory for
+ * them, its tiles are transposed by the compute cores in TCDM, so no
+ * transposed copy is ever required in main memory.
+ *
+ * @return 0 on success, -1 if the tiles do not fit into the TCDM.
+ */
+int gemm_tiled(precision_t prec, uint32_t expand, uint32_t transa,
+               uint32_t transb, uint32_t m, uint32_t n, uint32_t k,
+               double alpha, void* a, uint32_t lda, void* b, uint32_t ldb,
+               double beta, void* c, uint32_t ldc) {
+    gemm_tiling_t tiling;
+    gemm_tile_iter_t it;
+
+    tiling.prec = prec;
+    tiling.c_prec = gemm_c_prec(prec, expand);
+    tiling.packs_n = gemm_kernel_packs_n(prec, expand, transb);
+    tiling.relayout_a = (prec != FP64) && !tiling.packs_n && transa;
+    tiling.relayout_b = (prec != FP64) && !tiling.packs_n && !transb;
+    const uint32_t relayout = tiling.relayout_a || tiling.relayout_b;
+
+    // Carve the double buffers out of the free TCDM space
+    uint32_t l1_base = ALIGN_UP((uint32_t)snrt_l1_next(), 8);
+    uint32_t l1_end = snrt_l1_end_addr() - GEMM_TILED_L1_RESERVE;
+    if (l1_base >= l1_end) return -1;
+    if (gemm_tiling_init(m, n, k, l1_end - l1_base, &tiling)) return -1;
+
+    uint32_t size_a = tiling.tm * tiling.tk * prec;
+    uint32_t size_b = tiling.tk * tiling.tn * prec;
+    uint32_t size_c = tiling.tm * tiling.tn * tiling.c_prec;
+    void* local_a[2];
+    void* local_b[2];
+    void* local_c[2];
+    local_a[0] = (void*)l1_base;
+    local_a[1] = local_a[0] + size_a;
+    local_b[0] = local_a[1] + size_a;
+    local_b[1] = local_b[0] + size_b;
+    local_c[0] = local_b[1] + size_b;
+    local_c[1] = local_c[0] + size_c;
+    void* packed_a = local_c[1] + size_c;
+    void* packed_b = packed_a + (tiling.relayout_a ? size_a : 0);
+
+    uint32_t n_iters = gemm_tiled_n_iters(m, n, k, &tiling);
+    if (n_iters == 0) return 0;
+
+    if (snrt_is_dm_core()) {
+        gemm_tile_iter_t prev, pre;
+        uint32_t c_buf = 0;
+
+        // Prologue: bring in the operands of the first iteration
+        gemm_tile_iter(m, n, k, &tiling, 0, &it);
+        gemm_tile_load_ab(prec, transa, transb, &it, a, lda, b, ldb,
+                          local_a[0], local_b[0]);
+        if (beta) gemm_tile_load_c(tiling.c_prec, &it, c, ldc, local_c[0]);
+        snrt_dma_wait_all();
+        snrt_cluster_hw_barrier();
+
+        for (uint32_t i = 0; i < n_iters; i++) {
+            // The buffers of the current iteration are in use until the
+            // compute cores have relaid the operands
+            if (relayout) snrt_cluster_hw_barrier();
+
+            // Write back the C tile completed in the previous iteration. This
+            // has to finish before its buffer is refilled below.
+            if (i > 0 && prev.last_k) {
+                gemm_tile_store_c(tiling.c_prec, &prev, c, ldc,
+                                  local_c[!c_buf]);
+                snrt_dma_wait_all();
+            }
+
+            // Prefetch the operands of the next iteration
+            if (i + 1 < n_iters) {
+                gemm_tile_iter(m, n, k, &tiling, i + 1, &pre);
+                gemm_tile_load_ab(prec, transa, transb, &pre, a, lda, b, ldb,
+                                  local_a[(i + 1) % 2], local_b[(i + 1) % 2]);
+                if (pre.first_k && beta)
+                    gemm_tile_load_c(tiling.c_prec, &pre, c, ldc,
+                                     local_c[!c_buf]);
+                snrt_dma_wait_all();
+            }
+
+            // Wait for the compute cores to finish the current iteration
+            snrt_cluster_hw_barrier();
+
+            if (i + 1 < n_iters) {
+                prev = it;
+                it = pre;
+                if (it.first_k) c_buf = !c_buf;
+            }
+        }
+
+        // Epilogue: write back the last C tile
+        gemm_tile_store_c(tiling.c_prec, &it, c, ldc, local_c[c_buf]);
+        snrt_dma_wait_all();
+    } else {
+        uint32_t c_buf = 1;
+
+        // Wait for the operands of the first iteration
+        snrt_cluster_hw_barrier();
+
+        for (uint32_t i = 0; i < n_iters; i++) {
+            gemm_tile_iter(m, n, k, &tiling, i, &it);
+            if (it.first_k) c_buf = !c_buf;
+
+            void* tile_a = local_a[i % 2];
+            void* tile_b = local_b[i % 2];
+            uint32_t ta = transa;
+            uint32_t tb = transb;
+            if (tiling.relayout_a) {
+                gemm_tile_transpose(prec, tile_a, packed_a, it.pk, it.pm);
+                tile_a = packed_a;
+                ta = 0;
+            }
+            if (tiling.relayout_b) {
+                gemm_tile_transpose(prec, tile_b, packed_b, it.pk, it.pn);
+                tile_b = packed_b;
+                tb = 1;
+            }
+            if (relayout) snrt_cluster_hw_barrier();
+
+            // Accumulate in place after the first K tile
+            double beta_tile = it.first_k ? beta : 1;
+            uint32_t lda_tile = ta ? it.pm : it.pk;
+            uint32_t ldb_tile = tb ? it.pk : it.pn;
+            gemm(prec, expand, 1, ta, tb, it.pm, it.pn, it.pk, alpha, tile_a,
+                 lda_tile, tile_b, ldb_tile, beta_tile, local_c[c_buf], it.pn);
+
+            snrt_cluster_hw_barrier();
+        }
+    }
+
+    return 0;
+}
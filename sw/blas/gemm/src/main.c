@@ -13,68 +13,23 @@
 #include "snrt.h"
 
 int main() {
-    void *local_a, *local_b, *local_c;
-    void *remote_a, *remote_b, *remote_c;
+    // Transposed operands are stored as K x M and N x K matrices
+    uint32_t lda = TA ? M : K;
+    uint32_t ldb = TB ? K : N;
+    uint32_t ldc = N;
 
-    // Calculate size and pointers for each cluster
-    uint32_t frac_m = M / snrt_cluster_num();
-    uint32_t frac_a = frac_m * K;
-    uint32_t frac_c = frac_m * N;
-    uint32_t size_frac_a = frac_a * dtype_size;
-    uint32_t size_b = K * N * dtype_size;
-    uint32_t size_frac_c = frac_c * dtype_size;
-    uint32_t offset_a = frac_a * snrt_cluster_idx();
-    uint32_t offset_c = frac_c * snrt_cluster_idx();
-    remote_a = a + offset_a;
-    remote_b = b;
-    remote_c = c + offset_c;
+    // Operands are streamed tile by tile from main memory, so the problem
+    // size is not bounded by the TCDM capacity
+    uint32_t start_cycle = snrt_mcycle();
 
-    // Allocate space in TCDM
-    local_a = (void *)snrt_l1_next();
-    local_b = local_a + size_frac_a;
-    local_c = local_b + size_b;
+    if (gemm_tiled(dtype_size, expand, TA, TB, M, N, K, ALPHA, a, lda, b, ldb,
+                   BETA, c, ldc))
+        return -1;
 
-    // Copy data in TCDM
-    if (snrt_is_dm_core()) {
-        snrt_dma_start_1d(local_a, remote_a, size_frac_a);
-        snrt_dma_start_1d(local_b, remote_b, size_b);
-        snrt_dma_start_1d(local_c, remote_c, size_frac_c);
-        snrt_dma_wait_all();
-    }
+    uint32_t end_cycle = snrt_mcycle();
 
     snrt_cluster_hw_barrier();
 
-    // Compute
-    if (!snrt_is_dm_core()) {
-        const uint32_t setup_ssr = 1;
-        uint32_t start_cycle = snrt_mcycle();
-
-        volatile uint32_t lda = K;
-        volatile uint32_t ldb = N;
-        volatile uint32_t ldc = N;
-
-        // Transpose of A unsopported
-        if (TA) return -1;
-        if (TB) {
-            // Transpose of B supported only in FP64
-            if (dtype_size != FP64) return -1;
-            ldb = K;
-        }
-
-        gemm(dtype_size, expand, setup_ssr, TA, TB, frac_m, N, K, 1, local_a,
-             lda, local_b, ldb, BETA, local_c, ldc);
-
-        uint32_t end_cycle = snrt_mcycle();
-    }
-
-    snrt_cluster_hw_barrier();
-
-    // Copy data out of TCDM
-    if (snrt_is_dm_core()) {
-        snrt_dma_start_1d(remote_c, local_c, size_frac_c);
-        snrt_dma_wait_all();
-    }
-
 // TODO: currently only works for single cluster otherwise need to
 //       synchronize all cores here
 #ifdef BIST
@@ -86,22 +41,25 @@ int main() {
                 uint32_t idx = m * N + n;
                 switch (dtype_size) {
                     case FP64:
-                        if (fabs(result[idx] - ((double *)local_c)[idx]) >
-                            0.001)
+                        if (fabs(result[idx] - ((double *)c)[idx]) > 0.001)
                             errors--;
                         break;
                     case FP32:
-                        if (fabs(result[idx] - ((float *)local_c)[idx]) > 0.001)
+                        if (fabs(result[idx] - ((float *)c)[idx]) > 0.001)
                             errors--;
                         break;
                     case FP16:
-                        if (fabs(result[idx] - ((__fp16 *)local_c)[idx]) >
-                            0.001)
+                        if (fabs(result[idx] - ((__fp16 *)c)[idx]) > 0.001)
                             errors--;
                         break;
                     case FP8:
-                        printf("No golden model yet for fp8!\n");
-                        return -1;
+                        // Only the FP32 result of FP8 operands is checked
+                        if (!expand) {
+                            printf("No golden model yet for fp8!\n");
+                            return -1;
+                        }
+                        if (fabs(result[idx] - ((float *)c)[idx]) > 0.001)
+                            errors--;
                         break;
                 }
             }
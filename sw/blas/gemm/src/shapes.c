@@ -0,0 +1,175 @@
+// Copyright 2023 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+// Sweep the cluster-level GEMM over shapes which are not multiples of the
+// kernel unrolling factors, SIMD widths or number of compute cores, over all
+// precisions, operand layouts and a few scaling factors. Every result is
+// checked against a reference which is computed independently of the GEMM
+// kernels, from the formula which generates the operands. Operands are small
+// integers and the scaling factors powers of two, so all precisions must
+// match the reference exactly, after rounding it to the precision of C.
+//
+// Every case is run through gemm() on operands in TCDM, and through
+// gemm_tiled() on operands in main memory. The tiled GEMM is given a small
+// TCDM budget, such that the larger shapes are split into several, ragged
+// tiles along every dimension, including K.
+
+#include <stdint.h>
+
+#include "snrt.h"
+
+// TCDM available to the buffers of the tiled GEMM
+#define SHAPES_TILED_BUDGET 4096
+#define GEMM_TILED_L1_RESERVE                                   \
+    (snrt_l1_end_addr() - ALIGN_UP((uint32_t)snrt_l1_next(), 8) - \
+     SHAPES_TILED_BUDGET)
+
+#include "gemm.h"
+
+typedef struct {
+    uint32_t m;
+    uint32_t n;
+    uint32_t k;
+} gemm_shape_t;
+
+static const gemm_shape_t shapes[] = {
+    {1, 1, 1},
+    {3, 5, 7},
+    {7, 8, 4},
+    {8, 9, 3},
+    {9, 17, 13},
+    {15, 8, 4},
+    {16, 16, 5},
+    {17, 31, 33},
+    {5, 24, 16},
+    {13, 7, 64},
+    {8, 40, 24},
+};
+
+// Precision of A and B, and whether the GEMM expands
+typedef struct {
+    precision_t prec;
+    uint32_t expand;
+} gemm_config_t;
+
+static const gemm_config_t configs[] = {
+    {FP64, 0}, {FP32, 0}, {FP16, 0}, {FP16, 1}, {FP8, 0}, {FP8, 1},
+};
+
+typedef struct {
+    double alpha;
+    double beta;
+} gemm_scaling_t;
+
+static const gemm_scaling_t scalings[] = {
+    {1, 0},
+    {1, 1},
+    {2, 0},
+    {-0.5, 1},
+};
+
+#define N_SHAPES (sizeof(shapes) / sizeof(shapes[0]))
+#define N_CONFIGS (sizeof(configs) / sizeof(configs[0]))
+#define N_SCALINGS (sizeof(scalings) / sizeof(scalings[0]))
+
+// Operands of the tiled GEMM in main memory, large enough for every shape
+#define SHAPES_MAX_SIZE 1024
+static double dram_a[SHAPES_MAX_SIZE];
+static double dram_b[SHAPES_MAX_SIZE];
+static double dram_c[SHAPES_MAX_SIZE];
+static double dram_ref[SHAPES_MAX_SIZE];
+
+// Deterministic operand values in [-2, 2]
+static inline double operand(uint32_t i, uint32_t salt) {
+    return (double)((int32_t)((i * 7 + salt * 3) % 5) - 2);
+}
+
+int main() {
+    uint32_t errors = 0;
+
+    for (uint32_t p = 0; p < N_CONFIGS; p++) {
+        for (uint32_t s = 0; s < N_SHAPES; s++) {
+            // Cover all layouts of A and B with every scaling, untiled and
+            // tiled
+            for (uint32_t variant = 0; variant < 8 * N_SCALINGS; variant++) {
+                precision_t prec = configs[p].prec;
+                uint32_t expand = configs[p].expand;
+                precision_t c_prec = gemm_c_prec(prec, expand);
+                uint32_t m = shapes[s].m;
+                uint32_t n = shapes[s].n;
+                uint32_t k = shapes[s].k;
+                uint32_t ta = variant & 1;
+                uint32_t tb = (variant >> 1) & 1;
+                uint32_t tiled = (variant >> 2) & 1;
+                double alpha = scalings[variant / 8].alpha;
+                double beta = scalings[variant / 8].beta;
+                uint32_t lda = ta ? m : k;
+                uint32_t ldb = tb ? k : n;
+                uint32_t ldc = n;
+
+                void* a = (void*)ALIGN_UP((uint32_t)snrt_l1_next(), 8);
+                void* b = (void*)ALIGN_UP((uint32_t)a + m * k * prec, 8);
+                void* c = (void*)ALIGN_UP((uint32_t)b + k * n * prec, 8);
+                void* ref = (void*)ALIGN_UP((uint32_t)c + m * n * c_prec, 8);
+                if (tiled) {
+                    a = dram_a;
+                    b = dram_b;
+                    c = dram_c;
+                    ref = dram_ref;
+                }
+
+                if (snrt_cluster_core_idx() == 0) {
+                    for (uint32_t i = 0; i < m * k; i++)
+                        gemm_store(prec, a, i, operand(i, 1));
+                    for (uint32_t i = 0; i < k * n; i++)
+                        gemm_store(prec, b, i, operand(i, 2));
+                    for (uint32_t i = 0; i < m * n; i++)
+                        gemm_store(c_prec, c, i, operand(i, 3));
+
+                    // Reference from the operand values, in double
+                    for (uint32_t i = 0; i < m; i++) {
+                        for (uint32_t j = 0; j < n; j++) {
+                            double acc = 0;
+                            for (uint32_t l = 0; l < k; l++) {
+                                uint32_t ia = ta ? l * lda + i : i * lda + l;
+                                uint32_t ib = tb ? j * ldb + l : l * ldb + j;
+                                acc += operand(ia, 1) * operand(ib, 2);
+                            }
+                            acc = alpha * acc + beta * operand(i * ldc + j, 3);
+                            gemm_store(c_prec, ref, i * ldc + j, acc);
+                        }
+                    }
+
+                    // The DMA reads the operands in main memory
+                    asm volatile("fence" ::: "memory");
+                }
+
+                snrt_cluster_hw_barrier();
+
+                uint32_t ret = 0;
+                if (tiled)
+                    ret = gemm_tiled(prec, expand, ta, tb, m, n, k, alpha, a,
+                                     lda, b, ldb, beta, c, ldc);
+                else if (snrt_is_compute_core())
+                    gemm(prec, expand, 1, ta, tb, m, n, k, alpha, a, lda, b,
+                         ldb, beta, c, ldc);
+
+                snrt_cluster_hw_barrier();
+
+                if (snrt_cluster_core_idx() == 0) {
+                    if (ret) errors += m * n;
+                    for (uint32_t i = 0; i < m * n; i++) {
+                        if (gemm_load(c_prec, c, i) !=
+                            gemm_load(c_prec, ref, i))
+                            errors++;
+                    }
+                }
+
+                snrt_cluster_hw_barrier();
+            }
+        }
+    }
+
+    return errors;
+}
@@ -0,0 +1,373 @@
+// Copyright 2023 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "blas_utils.h"
+
+/**
+ * Matrix-vector product y = alpha * A * x + beta * y, or y = alpha * A^T * x
+ * + beta * y in transposed mode, for an M x N row-major matrix A. The leading
+ * dimension of A must be a multiple of the SIMD lanes, so that all rows are
+ * 8-byte aligned. If beta is zero, y is not read.
+ *
+ * Both modes accumulate BLAS_UNROLL outputs at a time: SSR 0 streams a word
+ * of A for every accumulator and SSR 1 repeats the matching word of x over
+ * them. In normal mode the accumulators are consecutive rows and FREP
+ * iterates over the words of a row, in transposed mode they are consecutive
+ * words of a row and FREP iterates over the rows. The transposed FP32 and
+ * FP16 modes stream x from a copy in which every element is broadcast to the
+ * lanes of a word, see gemv_work_size. FP16 products are accumulated in FP32.
+ */
+
+// Broadcast words of x per element in transposed mode. FP16 uses two words,
+// which place the element in the even and the odd lanes respectively.
+static inline uint32_t gemv_xb_words(precision_t prec) {
+    return prec == FP16 ? 2 : 1;
+}
+
+/**
+ * @brief Size of the TCDM work buffer of gemv
+ *
+ * @param prec precision of the operands
+ * @param trans whether A is transposed
+ * @param m number of rows of A
+ * @return size in bytes, zero if no buffer is required
+ */
+static inline uint32_t gemv_work_size(precision_t prec, uint32_t trans,
+                                      uint32_t m) {
+    if (!trans || prec == FP64) return 0;
+    return m * gemv_xb_words(prec) * sizeof(double);
+}
+
+// Runs n_frep + 1 iterations of BLAS_UNROLL MACs from SSR 0 and SSR 1 into
+// zeroed accumulators. FP32 and FP16 accumulators are packed FP32 pairs.
+static inline void gemv_accumulate(precision_t prec, uint32_t n_frep,
+                                   double *acc) {
+    const register float zero = 0.0;
+
+    if (prec == FP64) {
+        double c0, c1, c2, c3;
+
+        asm volatile(
+            "fcvt.d.w %[c0], zero \n"
+            "fcvt.d.w %[c1], zero \n"
+            "fcvt.d.w %[c2], zero \n"
+            "fcvt.d.w %[c3], zero \n"
+            "frep.o   %[n_frep], 4, 0, 0 \n"
+            "fmadd.d  %[c0], ft0, ft1, %[c0] \n"
+            "fmadd.d  %[c1], ft0, ft1, %[c1] \n"
+            "fmadd.d  %[c2], ft0, ft1, %[c2] \n"
+            "fmadd.d  %[c3], ft0, ft1, %[c3] \n"
+            : [ c0 ] "=&f"(c0), [ c1 ] "=&f"(c1), [ c2 ] "=&f"(c2),
+              [ c3 ] "=&f"(c3)
+            : [ n_frep ] "r"(n_frep)
+            : "ft0", "ft1", "ft2");
+
+        acc[0] = c0;
+        acc[1] = c1;
+        acc[2] = c2;
+        acc[3] = c3;
+    } else {
+        v2f32 c0, c1, c2, c3;
+
+        if (prec == FP32) {
+            asm volatile(
+                "vfcpka.s.s %[c0], %[zero], %[zero] \n"
+                "vfcpka.s.s %[c1], %[zero], %[zero] \n"
+                "vfcpka.s.s %[c2], %[zero], %[zero] \n"
+                "vfcpka.s.s %[c3], %[zero], %[zero] \n"
+                "frep.o     %[n_frep], 4, 0, 0 \n"
+                "vfmac.s    %[c0], ft0, ft1 \n"
+                "vfmac.s    %[c1], ft0, ft1 \n"
+                "vfmac.s    %[c2], ft0, ft1 \n"
+                "vfmac.s    %[c3], ft0, ft1 \n"
+                : [ c0 ] "=&f"(c0), [ c1 ] "=&f"(c1), [ c2 ] "=&f"(c2),
+                  [ c3 ] "=&f"(c3)
+                : [ zero ] "f"(zero), [ n_frep ] "r"(n_frep)
+                : "ft0", "ft1", "ft2");
+        } else {
+            asm volatile(
+                "vfcpka.s.s   %[c0], %[zero], %[zero] \n"
+                "vfcpka.s.s   %[c1], %[zero], %[zero] \n"
+                "vfcpka.s.s   %[c2], %[zero], %[zero] \n"
+                "vfcpka.s.s   %[c3], %[zero], %[zero] \n"
+                "frep.o       %[n_frep], 4, 0, 0 \n"
+                "vfdotpex.s.h %[c0], ft0, ft1 \n"
+                "vfdotpex.s.h %[c1], ft0, ft1 \n"
+                "vfdotpex.s.h %[c2], ft0, ft1 \n"
+                "vfdotpex.s.h %[c3], ft0, ft1 \n"
+                : [ c0 ] "=&f"(c0), [ c1 ] "=&f"(c1), [ c2 ] "=&f"(c2),
+                  [ c3 ] "=&f"(c3)
+                : [ zero ] "f"(zero), [ n_frep ] "r"(n_frep)
+                : "ft0", "ft1", "ft2");
+        }
+
+        ((v2f32 *)acc)[0] = c0;
+        ((v2f32 *)acc)[1] = c1;
+        ((v2f32 *)acc)[2] = c2;
+        ((v2f32 *)acc)[3] = c3;
+    }
+}
+
+// Transposed FP16 variant of gemv_accumulate. Every word of A is repeated
+// twice and multiplied with the even and the odd broadcast word of x, so
+// accumulator 2 * u holds columns 4 * u and 4 * u + 2 of word u, accumulator
+// 2 * u + 1 columns 4 * u + 1 and 4 * u + 3.
+static inline void gemv_t_accumulate_fp16(uint32_t n_frep, double *acc) {
+    const register float zero = 0.0;
+    v2f32 c0, c1, c2, c3, c4, c5, c6, c7;
+
+    asm volatile(
+        "vfcpka.s.s   %[c0], %[zero], %[zero] \n"
+        "vfcpka.s.s   %[c1], %[zero], %[zero] \n"
+        "vfcpka.s.s   %[c2], %[zero], %[zero] \n"
+        "vfcpka.s.s   %[c3], %[zero], %[zero] \n"
+        "vfcpka.s.s   %[c4], %[zero], %[zero] \n"
+        "vfcpka.s.s   %[c5], %[zero], %[zero] \n"
+        "vfcpka.s.s   %[c6], %[zero], %[zero] \n"
+        "vfcpka.s.s   %[c7], %[zero], %[zero] \n"
+        "frep.o       %[n_frep], 8, 0, 0 \n"
+        "vfdotpex.s.h %[c0], ft0, ft1 \n"
+        "vfdotpex.s.h %[c1], ft0, ft1 \n"
+        "vfdotpex.s.h %[c2], ft0, ft1 \n"
+        "vfdotpex.s.h %[c3], ft0, ft1 \n"
+        "vfdotpex.s.h %[c4], ft0, ft1 \n"
+        "vfdotpex.s.h %[c5], ft0, ft1 \n"
+        "vfdotpex.s.h %[c6], ft0, ft1 \n"
+        "vfdotpex.s.h %[c7], ft0, ft1 \n"
+        : [ c0 ] "=&f"(c0), [ c1 ] "=&f"(c1), [ c2 ] "=&f"(c2),
+          [ c3 ] "=&f"(c3), [ c4 ] "=&f"(c4), [ c5 ] "=&f"(c5),
+          [ c6 ] "=&f"(c6), [ c7 ] "=&f"(c7)
+        : [ zero ] "f"(zero), [ n_frep ] "r"(n_frep)
+        : "ft0", "ft1", "ft2");
+
+    ((v2f32 *)acc)[0] = c0;
+    ((v2f32 *)acc)[1] = c1;
+    ((v2f32 *)acc)[2] = c2;
+    ((v2f32 *)acc)[3] = c3;
+    ((v2f32 *)acc)[4] = c4;
+    ((v2f32 *)acc)[5] = c5;
+    ((v2f32 *)acc)[6] = c6;
+    ((v2f32 *)acc)[7] = c7;
+}
+
+// y[i] = alpha * s + beta * y[i]
+static inline void gemv_update(precision_t prec, void *y, uint32_t i,
+                               double alpha, double s, double beta) {
+    double v = alpha * s;
+    if (beta != 0) v += beta * blas_load(prec, y, i);
+    blas_store(prec, y, i, v);
+}
+
+/**
+ * @brief Normal-mode product on the calling core
+ *
+ * Blocks of BLAS_UNROLL rows are accumulated with SSRs, the words of every
+ * block in one FREP loop. Columns beyond the last whole word and rows beyond
+ * the last whole block are computed in scalar code.
+ */
+static inline void gemv_n_core(precision_t prec, uint32_t m, uint32_t n,
+                               double alpha, const void *A, uint32_t lda,
+                               const void *x, double beta, void *y) {
+    const uint32_t lanes = blas_lanes(prec);
+    const uint32_t words = n / lanes;
+    const uint32_t blocks = words ? m / BLAS_UNROLL : 0;
+    const uint32_t n0 = words * lanes;
+    uint32_t r = 0;
+
+    if (blocks) {
+        snrt_ssr_loop_3d(SNRT_SSR_DM0, BLAS_UNROLL, words, blocks,
+                         lda * prec, sizeof(double),
+                         BLAS_UNROLL * lda * prec);
+        snrt_ssr_repeat(SNRT_SSR_DM0, 1);
+        snrt_ssr_loop_2d(SNRT_SSR_DM1, words, blocks, sizeof(double), 0);
+        snrt_ssr_repeat(SNRT_SSR_DM1, BLAS_UNROLL);
+
+        snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_3D, (void *)A);
+        snrt_ssr_read(SNRT_SSR_DM1, SNRT_SSR_2D, (void *)x);
+        snrt_ssr_enable();
+
+        for (uint32_t b = 0; b < blocks; b++) {
+            double acc[BLAS_UNROLL];
+
+            gemv_accumulate(prec, words - 1, acc);
+
+            // Clean up of leftover columns
+            snrt_fpu_fence();
+            snrt_ssr_disable();
+
+            for (uint32_t k = 0; k < BLAS_UNROLL; k++, r++) {
+                double s = prec == FP64 ? acc[k]
+                                        : (double)((v2f32 *)acc)[k][0] +
+                                              ((v2f32 *)acc)[k][1];
+                for (uint32_t j = n0; j < n; j++)
+                    s += blas_load(prec, A, r * lda + j) *
+                         blas_load(prec, x, j);
+                gemv_update(prec, y, r, alpha, s, beta);
+            }
+
+            snrt_ssr_enable();
+        }
+
+        snrt_ssr_disable();
+
+        // Other kernels expect streams without repetition
+        snrt_ssr_repeat(SNRT_SSR_DM1, 1);
+    }
+
+    // Rows beyond the last whole block
+    for (; r < m; r++) {
+        double s = 0;
+        for (uint32_t j = 0; j < n; j++)
+            s += blas_load(prec, A, r * lda + j) * blas_load(prec, x, j);
+        gemv_update(prec, y, r, alpha, s, beta);
+    }
+}
+
+/**
+ * @brief Transposed-mode product on the calling core
+ *
+ * Blocks of BLAS_UNROLL words of y are accumulated with SSRs over all rows in
+ * one FREP loop. x is streamed from its broadcast copy xb, except in FP64.
+ * Columns beyond the last whole block are computed in scalar code.
+ */
+static inline void gemv_t_core(precision_t prec, uint32_t m, uint32_t n,
+                               double alpha, const void *A, uint32_t lda,
+                               const void *x, const void *xb, double beta,
+                               void *y) {
+    const uint32_t lanes = blas_lanes(prec);
+    const uint32_t blocks = n / (BLAS_UNROLL * lanes);
+    const uint32_t n0 = blocks * BLAS_UNROLL * lanes;
+
+    if (blocks && m) {
+        snrt_ssr_loop_3d(SNRT_SSR_DM0, BLAS_UNROLL, m, blocks, sizeof(double),
+                         lda * prec, BLAS_UNROLL * sizeof(double));
+        snrt_ssr_repeat(SNRT_SSR_DM0, gemv_xb_words(prec));
+        if (prec == FP16) {
+            snrt_ssr_loop_4d(SNRT_SSR_DM1, 2, BLAS_UNROLL, m, blocks,
+                             sizeof(double), 0, 2 * sizeof(double), 0);
+            snrt_ssr_repeat(SNRT_SSR_DM1, 1);
+        } else {
+            snrt_ssr_loop_2d(SNRT_SSR_DM1, m, blocks, sizeof(double), 0);
+            snrt_ssr_repeat(SNRT_SSR_DM1, BLAS_UNROLL);
+        }
+
+        snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_3D, (void *)A);
+        snrt_ssr_read(SNRT_SSR_DM1, prec == FP16 ? SNRT_SSR_4D : SNRT_SSR_2D,
+                      (void *)xb);
+        snrt_ssr_enable();
+
+        for (uint32_t b = 0; b < blocks; b++) {
+            double acc[2 * BLAS_UNROLL];
+
+            if (prec == FP16)
+                gemv_t_accumulate_fp16(m - 1, acc);
+            else
+                gemv_accumulate(prec, m - 1, acc);
+
+            snrt_fpu_fence();
+            snrt_ssr_disable();
+
+            for (uint32_t q = 0; q < BLAS_UNROLL * lanes; q++) {
+                double s;
+                switch (prec) {
+                    case FP64:
+                        s = acc[q];
+                        break;
+                    case FP32:
+                        s = ((v2f32 *)acc)[q / 2][q % 2];
+                        break;
+                    default:
+                        s = ((v2f32 *)acc)[q / 4 * 2 + q % 2][q % 4 / 2];
+                        break;
+                }
+                gemv_update(prec, y, b * BLAS_UNROLL * lanes + q, alpha, s,
+                            beta);
+            }
+
+            snrt_ssr_enable();
+        }
+
+        snrt_ssr_disable();
+
+        // Other kernels expect streams without repetition
+        snrt_ssr_repeat(SNRT_SSR_DM0, 1);
+        snrt_ssr_repeat(SNRT_SSR_DM1, 1);
+    }
+
+    // Columns beyond the last whole block
+    for (uint32_t j = n0; j < n; j++) {
+        double s = 0;
+        for (uint32_t i = 0; i < m; i++)
+            s += blas_load(prec, A, i * lda + j) * blas_load(prec, x, i);
+        gemv_update(prec, y, j, alpha, s, beta);
+    }
+}
+
+// Broadcast copy of x for the transposed FP32 and FP16 modes, filled by all
+// compute cores
+static inline void gemv_broadcast(precision_t prec, uint32_t m, const void *x,
+                                  void *xb) {
+    const uint32_t cores = snrt_cluster_compute_core_num();
+
+    for (uint32_t i = snrt_cluster_core_idx(); i < m; i += cores) {
+        if (prec == FP32) {
+            float v = ((const float *)x)[i];
+            ((v2f32 *)xb)[i] = (v2f32){v, v};
+        } else {
+            __fp16 v = ((const __fp16 *)x)[i];
+            ((v4f16 *)xb)[2 * i] = (v4f16){v, 0, v, 0};
+            ((v4f16 *)xb)[2 * i + 1] = (v4f16){0, v, 0, v};
+        }
+    }
+}
+
+/**
+ * @brief Matrix-vector product on all compute cores of the cluster
+ *
+ * Must be called by all cores of the cluster. The outputs are split across
+ * the compute cores, rows in normal mode and columns in transposed mode. The
+ * DM core returns without computing, the caller synchronizes before using y.
+ *
+ * @param prec precision of the operands: FP64, FP32 or FP16
+ * @param trans whether A is transposed
+ * @param m number of rows of A
+ * @param n number of columns of A
+ * @param alpha scaling factor of the product
+ * @param A matrix in TCDM, row-major with leading dimension lda
+ * @param x input vector in TCDM, n elements in normal mode and m in
+ *          transposed mode
+ * @param beta scaling factor of y
+ * @param y 8-byte aligned output vector in TCDM, m elements in normal mode
+ *          and n in transposed mode
+ * @param work TCDM buffer of gemv_work_size bytes
+ */
+static inline void gemv(precision_t prec, uint32_t trans, uint32_t m,
+                        uint32_t n, double alpha, const void *A, uint32_t lda,
+                        const void *x, double beta, void *y, void *work) {
+    const uint32_t core = snrt_cluster_core_idx();
+    const uint32_t cores = snrt_cluster_compute_core_num();
+    const void *xb = x;
+    uint32_t first, len;
+
+    if (gemv_work_size(prec, trans, m)) {
+        if (snrt_is_compute_core()) gemv_broadcast(prec, m, x, work);
+        snrt_cluster_hw_barrier();
+        xb = work;
+    }
+
+    if (!snrt_is_compute_core()) return;
+
+    if (!trans) {
+        len = blas_split(m, BLAS_UNROLL, core, cores, &first);
+        gemv_n_core(prec, len, n, alpha, (const char *)A + first * lda * prec,
+                    lda, x, beta, (char *)y + first * prec);
+    } else {
+        len = blas_split(n, BLAS_UNROLL * blas_lanes(prec), core, cores,
+                         &first);
+        gemv_t_core(prec, m, len, alpha, (const char *)A + first * prec, lda,
+                    x, xb, beta, (char *)y + first * prec);
+    }
+}
@@ -0,0 +1,83 @@
+// Copyright 2023 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <math.h>
+#include <stdint.h>
+
+#include "data.h"
+#include "gemv.h"
+#include "snrt.h"
+
+int main() {
+    const precision_t prec = dtype_size;
+    const uint32_t lanes = blas_lanes(prec);
+
+    // Every cluster computes a slice of y: a block of rows of A in normal
+    // mode and a block of columns in transposed mode
+    uint32_t first, len, m, n, ld;
+    if (!TRANS) {
+        len = blas_split(M, BLAS_UNROLL, snrt_cluster_idx(), snrt_cluster_num(),
+                         &first);
+        m = len;
+        n = N;
+        ld = N;
+    } else {
+        len = blas_split(N, BLAS_UNROLL * lanes, snrt_cluster_idx(),
+                         snrt_cluster_num(), &first);
+        m = M;
+        n = len;
+        ld = ALIGN_UP(len, lanes);
+    }
+    uint32_t x_len = TRANS ? M : N;
+    char *remote_y = (char *)y + first * prec;
+
+    // Allocate space in TCDM
+    char *local_a = (char *)snrt_l1_next();
+    char *local_x = local_a + ALIGN_UP(m * ld * prec, sizeof(double));
+    char *local_y = local_x + ALIGN_UP(x_len * prec, sizeof(double));
+    char *work = local_y + ALIGN_UP(len * prec, sizeof(double));
+
+    // Copy data in TCDM
+    if (snrt_is_dm_core()) {
+        if (!TRANS)
+            snrt_dma_start_1d(local_a, (char *)a + first * N * prec,
+                              m * N * prec);
+        else
+            snrt_dma_start_2d(local_a, (char *)a + first * prec, n * prec,
+                              ld * prec, N * prec, M);
+        snrt_dma_start_1d(local_x, x, x_len * prec);
+        snrt_dma_start_1d(local_y, remote_y, len * prec);
+        snrt_dma_wait_all();
+    }
+
+    snrt_cluster_hw_barrier();
+
+    // Compute
+    uint32_t start_cycle = snrt_mcycle();
+    gemv(prec, TRANS, m, n, ALPHA, local_a, ld, local_x, BETA, local_y, work);
+    snrt_cluster_hw_barrier();
+    uint32_t end_cycle = snrt_mcycle();
+
+    // Copy data out of TCDM
+    if (snrt_is_dm_core()) {
+        snrt_dma_start_1d(remote_y, local_y, len * prec);
+        snrt_dma_wait_all();
+    }
+
+    snrt_global_barrier();
+
+    // Check computation is correct
+    if (snrt_global_core_idx() != 0) return 0;
+
+    uint32_t y_len = TRANS ? N : M;
+    uint32_t errors = 0;
+    for (uint32_t i = 0; i < y_len; i++) {
+        double scale = fabs(result[i]) > 1 ? fabs(result[i]) : 1;
+        if (fabs(blas_load(prec, y, i) - result[i]) > tolerance * scale)
+            errors++;
+    }
+    printf("gemv: %u/%u errors, %u cycles on cluster 0\n", errors, y_len,
+           end_cycle - start_cycle);
+    return errors;
+}
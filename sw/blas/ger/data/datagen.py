@@ -0,0 +1,47 @@
+#!/usr/bin/env python3
+# Copyright 2023 ETH Zurich and University of Bologna.
+# Licensed under the Apache License, Version 2.0, see LICENSE for details.
+# SPDX-License-Identifier: Apache-2.0
+
+import numpy as np
+import sys
+import os
+
+sys.path.append(os.path.join(os.path.dirname(__file__), "../../../../util/sim/"))
+from data_utils import format_scalar_definition, \
+                       format_vector_definition  # noqa: E402
+from blas_data_utils import random_operand, format_operand, format_check, \
+                            main  # noqa: E402
+
+
+def golden_model(alpha, x, y, a):
+    return alpha * np.outer(x, y) + a
+
+
+def emit_header(**kwargs):
+    prec = kwargs['prec']
+    section = kwargs['section']
+    m, n = kwargs['M'], kwargs['N']
+
+    # Rows of A are streamed as 64-bit words
+    assert n % (64 // prec) == 0, 'N must be a multiple of the SIMD lanes'
+
+    x = random_operand(prec, m)
+    y = random_operand(prec, n)
+    a = random_operand(prec, (m, n))
+    result = golden_model(kwargs['alpha'], x.astype(np.double), y.astype(np.double),
+                          a.astype(np.double))
+
+    data_str = [format_scalar_definition('uint32_t', 'M', m)]
+    data_str += [format_scalar_definition('uint32_t', 'N', n)]
+    data_str += [format_scalar_definition('double', 'ALPHA', kwargs['alpha'])]
+    data_str += format_check('ger', prec)
+    data_str += [format_operand(prec, 'x', x, section)]
+    data_str += [format_operand(prec, 'y', y, section)]
+    data_str += [format_operand(prec, 'a', a, section)]
+    data_str += [format_vector_definition('double', 'result', result.flatten())]
+    return data_str
+
+
+if __name__ == '__main__':
+    main(emit_header, section_help='Section to store matrices in')
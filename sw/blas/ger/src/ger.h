@@ -0,0 +1,204 @@
+// Copyright 2023 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "blas_utils.h"
+
+/**
+ * Rank-1 update A = alpha * x * y^T + A of an M x N row-major matrix A. The
+ * leading dimension of A must be a multiple of the SIMD lanes, so that all
+ * rows are 8-byte aligned.
+ *
+ * SSR 0 reads the words of a row of A, SSR 1 the words of y and SSR 2 writes
+ * the row back. For every row, alpha * x[i] is broadcast to the lanes of a
+ * word and FREP updates the row. Xfvec has no packed FMA with a separate
+ * addend, so FP32 and FP16 words are multiplied and added in two
+ * instructions, BLAS_UNROLL words at a time. Columns beyond the last whole
+ * block are updated in scalar code.
+ */
+
+static inline void ger_fp64(uint32_t m, uint32_t n, double alpha,
+                            const double *x, const double *y, double *A,
+                            uint32_t lda) {
+    if (!m || !n) return;
+
+    snrt_ssr_loop_2d(SNRT_SSR_DM0, n, m, sizeof(double), lda * sizeof(double));
+    snrt_ssr_loop_2d(SNRT_SSR_DM1, n, m, sizeof(double), 0);
+    snrt_ssr_loop_2d(SNRT_SSR_DM2, n, m, sizeof(double), lda * sizeof(double));
+    snrt_ssr_repeat(SNRT_SSR_DM0, 1);
+    snrt_ssr_repeat(SNRT_SSR_DM1, 1);
+    snrt_ssr_repeat(SNRT_SSR_DM2, 1);
+    snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_2D, A);
+    snrt_ssr_read(SNRT_SSR_DM1, SNRT_SSR_2D, (void *)y);
+    snrt_ssr_write(SNRT_SSR_DM2, SNRT_SSR_2D, A);
+    snrt_ssr_enable();
+
+    for (uint32_t i = 0; i < m; i++) {
+        double s;
+
+        asm volatile(
+            "fld     %[s], 0(%[x]) \n"
+            "fmul.d  %[s], %[alpha], %[s] \n"
+            "frep.o  %[n_frep], 1, 0, 0 \n"
+            "fmadd.d ft2, %[s], ft1, ft0 \n"
+            : [ s ] "=&f"(s)
+            : [ x ] "r"(x + i), [ alpha ] "f"(alpha), [ n_frep ] "r"(n - 1)
+            : "ft0", "ft1", "ft2", "memory");
+    }
+
+    snrt_fpu_fence();
+    __builtin_ssr_barrier(SNRT_SSR_DM2);
+    snrt_ssr_disable();
+}
+
+static inline void ger_fp32(uint32_t m, uint32_t n, float alpha,
+                            const float *x, const float *y, float *A,
+                            uint32_t lda) {
+    const uint32_t blocks = n / (2 * BLAS_UNROLL);
+    const uint32_t words = blocks * BLAS_UNROLL;
+
+    if (m && blocks) {
+        snrt_ssr_loop_2d(SNRT_SSR_DM0, words, m, sizeof(v2f32),
+                         lda * sizeof(float));
+        snrt_ssr_loop_2d(SNRT_SSR_DM1, words, m, sizeof(v2f32), 0);
+        snrt_ssr_loop_2d(SNRT_SSR_DM2, words, m, sizeof(v2f32),
+                         lda * sizeof(float));
+        snrt_ssr_repeat(SNRT_SSR_DM0, 1);
+        snrt_ssr_repeat(SNRT_SSR_DM1, 1);
+        snrt_ssr_repeat(SNRT_SSR_DM2, 1);
+        snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_2D, A);
+        snrt_ssr_read(SNRT_SSR_DM1, SNRT_SSR_2D, (void *)y);
+        snrt_ssr_write(SNRT_SSR_DM2, SNRT_SSR_2D, A);
+        snrt_ssr_enable();
+
+        for (uint32_t i = 0; i < m; i++) {
+            float s;
+            v2f32 s2, t0, t1, t2, t3;
+
+            asm volatile(
+                "flw        %[s], 0(%[x]) \n"
+                "fmul.s     %[s], %[alpha], %[s] \n"
+                "vfcpka.s.s %[s2], %[s], %[s] \n"
+                "frep.o     %[n_frep], 8, 0, 0 \n"
+                "vfmul.s    %[t0], %[s2], ft1 \n"
+                "vfmul.s    %[t1], %[s2], ft1 \n"
+                "vfmul.s    %[t2], %[s2], ft1 \n"
+                "vfmul.s    %[t3], %[s2], ft1 \n"
+                "vfadd.s    ft2, %[t0], ft0 \n"
+                "vfadd.s    ft2, %[t1], ft0 \n"
+                "vfadd.s    ft2, %[t2], ft0 \n"
+                "vfadd.s    ft2, %[t3], ft0 \n"
+                : [ s ] "=&f"(s), [ s2 ] "=&f"(s2), [ t0 ] "=&f"(t0),
+                  [ t1 ] "=&f"(t1), [ t2 ] "=&f"(t2), [ t3 ] "=&f"(t3)
+                : [ x ] "r"(x + i), [ alpha ] "f"(alpha),
+                  [ n_frep ] "r"(blocks - 1)
+                : "ft0", "ft1", "ft2", "memory");
+        }
+
+        snrt_fpu_fence();
+        __builtin_ssr_barrier(SNRT_SSR_DM2);
+        snrt_ssr_disable();
+    }
+
+    for (uint32_t i = 0; i < m; i++)
+        for (uint32_t j = 2 * words; j < n; j++)
+            A[i * lda + j] += alpha * x[i] * y[j];
+}
+
+static inline void ger_fp16(uint32_t m, uint32_t n, float alpha,
+                            const __fp16 *x, const __fp16 *y, __fp16 *A,
+                            uint32_t lda) {
+    const uint32_t blocks = n / (4 * BLAS_UNROLL);
+    const uint32_t words = blocks * BLAS_UNROLL;
+
+    if (m && blocks) {
+        snrt_ssr_loop_2d(SNRT_SSR_DM0, words, m, sizeof(v4f16),
+                         lda * sizeof(__fp16));
+        snrt_ssr_loop_2d(SNRT_SSR_DM1, words, m, sizeof(v4f16), 0);
+        snrt_ssr_loop_2d(SNRT_SSR_DM2, words, m, sizeof(v4f16),
+                         lda * sizeof(__fp16));
+        snrt_ssr_repeat(SNRT_SSR_DM0, 1);
+        snrt_ssr_repeat(SNRT_SSR_DM1, 1);
+        snrt_ssr_repeat(SNRT_SSR_DM2, 1);
+        snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_2D, A);
+        snrt_ssr_read(SNRT_SSR_DM1, SNRT_SSR_2D, (void *)y);
+        snrt_ssr_write(SNRT_SSR_DM2, SNRT_SSR_2D, A);
+        snrt_ssr_enable();
+
+        for (uint32_t i = 0; i < m; i++) {
+            float s;
+            v4f16 s4, t0, t1, t2, t3;
+
+            asm volatile(
+                "flh        %[s], 0(%[x]) \n"
+                "fcvt.s.h   %[s], %[s] \n"
+                "fmul.s     %[s], %[alpha], %[s] \n"
+                "vfcpka.h.s %[s4], %[s], %[s] \n"
+                "vfcpkb.h.s %[s4], %[s], %[s] \n"
+                "frep.o     %[n_frep], 8, 0, 0 \n"
+                "vfmul.h    %[t0], %[s4], ft1 \n"
+                "vfmul.h    %[t1], %[s4], ft1 \n"
+                "vfmul.h    %[t2], %[s4], ft1 \n"
+                "vfmul.h    %[t3], %[s4], ft1 \n"
+                "vfadd.h    ft2, %[t0], ft0 \n"
+                "vfadd.h    ft2, %[t1], ft0 \n"
+                "vfadd.h    ft2, %[t2], ft0 \n"
+                "vfadd.h    ft2, %[t3], ft0 \n"
+                : [ s ] "=&f"(s), [ s4 ] "=&f"(s4), [ t0 ] "=&f"(t0),
+                  [ t1 ] "=&f"(t1), [ t2 ] "=&f"(t2), [ t3 ] "=&f"(t3)
+                : [ x ] "r"(x + i), [ alpha ] "f"(alpha),
+                  [ n_frep ] "r"(blocks - 1)
+                : "ft0", "ft1", "ft2", "memory");
+        }
+
+        snrt_fpu_fence();
+        __builtin_ssr_barrier(SNRT_SSR_DM2);
+        snrt_ssr_disable();
+    }
+
+    for (uint32_t i = 0; i < m; i++)
+        for (uint32_t j = 4 * words; j < n; j++)
+            A[i * lda + j] = (float)A[i * lda + j] +
+                             alpha * (float)x[i] * (float)y[j];
+}
+
+/**
+ * @brief Rank-1 update on all compute cores of the cluster
+ *
+ * Must be called by all cores of the cluster. The rows of A are split across
+ * the compute cores. The DM core returns without computing, the caller
+ * synchronizes before using A.
+ *
+ * @param prec precision of the operands: FP64, FP32 or FP16
+ * @param m number of rows of A
+ * @param n number of columns of A
+ * @param alpha scaling factor of the update
+ * @param x vector of m elements in TCDM
+ * @param y 8-byte aligned vector of n elements in TCDM
+ * @param A matrix in TCDM, row-major with leading dimension lda
+ */
+static inline void ger(precision_t prec, uint32_t m, uint32_t n, double alpha,
+                       const void *x, const void *y, void *A, uint32_t lda) {
+    if (!snrt_is_compute_core()) return;
+
+    uint32_t first;
+    uint32_t len = blas_split(m, 1, snrt_cluster_core_idx(),
+                              snrt_cluster_compute_core_num(), &first);
+
+    switch (prec) {
+        case FP64:
+            ger_fp64(len, n, alpha, (const double *)x + first, y,
+                     (double *)A + first * lda, lda);
+            break;
+        case FP32:
+            ger_fp32(len, n, alpha, (const float *)x + first, y,
+                     (float *)A + first * lda, lda);
+            break;
+        default:
+            ger_fp16(len, n, alpha, (const __fp16 *)x + first, y,
+                     (__fp16 *)A + first * lda, lda);
+            break;
+    }
+}
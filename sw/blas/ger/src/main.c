@@ -0,0 +1,63 @@
+// Copyright 2023 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <math.h>
+#include <stdint.h>
+
+#include "data.h"
+#include "ger.h"
+#include "snrt.h"
+
+int main() {
+    const precision_t prec = dtype_size;
+
+    // Every cluster updates a block of rows of A
+    uint32_t first;
+    uint32_t m =
+        blas_split(M, 1, snrt_cluster_idx(), snrt_cluster_num(), &first);
+    size_t size = m * N * prec;
+    char *remote_a = (char *)a + first * N * prec;
+
+    // Allocate space in TCDM
+    char *local_a = (char *)snrt_l1_next();
+    char *local_x = local_a + ALIGN_UP(size, sizeof(double));
+    char *local_y = local_x + ALIGN_UP(m * prec, sizeof(double));
+
+    // Copy data in TCDM
+    if (snrt_is_dm_core()) {
+        snrt_dma_start_1d(local_a, remote_a, size);
+        snrt_dma_start_1d(local_x, (char *)x + first * prec, m * prec);
+        snrt_dma_start_1d(local_y, y, N * prec);
+        snrt_dma_wait_all();
+    }
+
+    snrt_cluster_hw_barrier();
+
+    // Compute
+    uint32_t start_cycle = snrt_mcycle();
+    ger(prec, m, N, ALPHA, local_x, local_y, local_a, N);
+    snrt_cluster_hw_barrier();
+    uint32_t end_cycle = snrt_mcycle();
+
+    // Copy data out of TCDM
+    if (snrt_is_dm_core()) {
+        snrt_dma_start_1d(remote_a, local_a, size);
+        snrt_dma_wait_all();
+    }
+
+    snrt_global_barrier();
+
+    // Check computation is correct
+    if (snrt_global_core_idx() != 0) return 0;
+
+    uint32_t errors = 0;
+    for (uint32_t i = 0; i < M * N; i++) {
+        double scale = fabs(result[i]) > 1 ? fabs(result[i]) : 1;
+        if (fabs(blas_load(prec, a, i) - result[i]) > tolerance * scale)
+            errors++;
+    }
+    printf("ger: %u/%u errors, %u cycles on cluster 0\n", errors, M * N,
+           end_cycle - start_cycle);
+    return errors;
+}
@@ -0,0 +1,54 @@
+// Copyright 2023 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <math.h>
+
+#include "blas_utils.h"
+#include "dot/src/dot.h"
+
+/**
+ * Euclidean norm of a vector
+ *
+ * The sum of squares is the dot product of the vector with itself, streamed
+ * through both SSRs: an instruction reading the same SSR twice would get a
+ * single element. FP32 squares are accumulated in FP32 and FP16 squares are
+ * expanded to FP32.
+ *
+ * The squares are accumulated without the scaling of the reference BLAS, as
+ * the sums of squares of different clusters are added. Hence, the sum of
+ * squares overflows to infinity once it exceeds the largest finite value,
+ * i.e. for FP32 elements from about 1e19 and FP64 elements from about 1e154,
+ * and squares underflow to zero or lose precision as subnormals, i.e. for
+ * FP32 elements below about 1e-19 and FP64 elements below about 1e-154.
+ * FP16 elements cannot overflow or underflow the FP32 accumulation. Callers
+ * whose data may leave this range must scale the vector beforehand, e.g.
+ * with scal() by the inverse of its largest magnitude, and scale the norm
+ * back.
+ */
+
+/**
+ * @brief Sum of squares on all compute cores of the cluster
+ *
+ * Must be called by all cores of the cluster. Sums of squares of different
+ * clusters can be added, unlike their norms.
+ *
+ * @param prec precision of the vector: FP64, FP32 or FP16
+ * @param n number of elements
+ * @param x 8-byte aligned vector in TCDM
+ * @param partial TCDM buffer of one double per compute core
+ * @return the sum of squares on all cores
+ */
+static inline double nrm2_ssq(precision_t prec, uint32_t n, const void *x,
+                              double *partial) {
+    return dot(prec, n, x, x, partial);
+}
+
+// Euclidean norm on all compute cores of the cluster, see nrm2_ssq. Infinite
+// or zero if the sum of squares overflows or underflows.
+static inline double nrm2(precision_t prec, uint32_t n, const void *x,
+                          double *partial) {
+    return sqrt(nrm2_ssq(prec, n, x, partial));
+}
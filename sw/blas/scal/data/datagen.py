@@ -0,0 +1,36 @@
+#!/usr/bin/env python3
+# Copyright 2023 ETH Zurich and University of Bologna.
+# Licensed under the Apache License, Version 2.0, see LICENSE for details.
+# SPDX-License-Identifier: Apache-2.0
+
+import numpy as np
+import sys
+import os
+
+sys.path.append(os.path.join(os.path.dirname(__file__), "../../../../util/sim/"))
+from data_utils import format_scalar_definition, \
+                       format_vector_definition  # noqa: E402
+from blas_data_utils import random_operand, format_operand, format_check, \
+                            main  # noqa: E402
+
+
+def golden_model(alpha, x):
+    return alpha * x.astype(np.double)
+
+
+def emit_header(**kwargs):
+    prec = kwargs['prec']
+
+    x = random_operand(prec, kwargs['n'])
+    result = golden_model(kwargs['alpha'], x)
+
+    data_str = [format_scalar_definition('uint32_t', 'N', kwargs['n'])]
+    data_str += [format_scalar_definition('double', 'ALPHA', kwargs['alpha'])]
+    data_str += format_check('scal', prec)
+    data_str += [format_operand(prec, 'x', x, kwargs['section'])]
+    data_str += [format_vector_definition('double', 'result', result)]
+    return data_str
+
+
+if __name__ == '__main__':
+    main(emit_header)
@@ -0,0 +1,59 @@
+// Copyright 2023 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <math.h>
+#include <stdint.h>
+
+#include "data.h"
+#include "scal.h"
+#include "snrt.h"
+
+int main() {
+    const precision_t prec = dtype_size;
+
+    // Calculate size and pointers for each cluster
+    uint32_t first;
+    uint32_t len = blas_split(N, BLAS_UNROLL * blas_lanes(prec),
+                              snrt_cluster_idx(), snrt_cluster_num(), &first);
+    size_t size = len * prec;
+    char *remote_x = (char *)x + first * prec;
+
+    // Allocate space in TCDM
+    char *local_x = (char *)snrt_l1_next();
+
+    // Copy data in TCDM
+    if (snrt_is_dm_core()) {
+        snrt_dma_start_1d(local_x, remote_x, size);
+        snrt_dma_wait_all();
+    }
+
+    snrt_cluster_hw_barrier();
+
+    // Compute
+    uint32_t start_cycle = snrt_mcycle();
+    scal(prec, len, ALPHA, local_x);
+    snrt_cluster_hw_barrier();
+    uint32_t end_cycle = snrt_mcycle();
+
+    // Copy data out of TCDM
+    if (snrt_is_dm_core()) {
+        snrt_dma_start_1d(remote_x, local_x, size);
+        snrt_dma_wait_all();
+    }
+
+    snrt_global_barrier();
+
+    // Check computation is correct
+    if (snrt_global_core_idx() != 0) return 0;
+
+    uint32_t errors = 0;
+    for (uint32_t i = 0; i < N; i++) {
+        double scale = fabs(result[i]) > 1 ? fabs(result[i]) : 1;
+        if (fabs(blas_load(prec, x, i) - result[i]) > tolerance * scale)
+            errors++;
+    }
+    printf("scal: %u/%u errors, %u cycles on cluster 0\n", errors, N,
+           end_cycle - start_cycle);
+    return errors;
+}
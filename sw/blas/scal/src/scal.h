@@ -0,0 +1,133 @@
+// Copyright 2023 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "blas_utils.h"
+
+/**
+ * In-place scaling of a vector on the calling core
+ *
+ * SSR 0 reads the words of x and SSR 1 writes them back, one packed-SIMD
+ * multiplication per word. Reads run ahead of the writes to the same
+ * addresses, so the vector can be scaled in place. Elements beyond the last
+ * whole word are scaled in scalar code. The vector must be 8-byte aligned.
+ */
+
+static inline void scal_fp64(uint32_t n, double a, double *x) {
+    if (n) {
+        snrt_ssr_loop_1d(SNRT_SSR_DM0, n, sizeof(double));
+        snrt_ssr_loop_1d(SNRT_SSR_DM1, n, sizeof(double));
+        snrt_ssr_repeat(SNRT_SSR_DM0, 1);
+        snrt_ssr_repeat(SNRT_SSR_DM1, 1);
+        snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_1D, x);
+        snrt_ssr_write(SNRT_SSR_DM1, SNRT_SSR_1D, x);
+        snrt_ssr_enable();
+
+        asm volatile(
+            "frep.o %[n_frep], 1, 0, 0 \n"
+            "fmul.d ft1, %[a], ft0 \n"
+            :
+            : [ n_frep ] "r"(n - 1), [ a ] "f"(a)
+            : "ft0", "ft1", "ft2", "memory");
+
+        snrt_fpu_fence();
+        __builtin_ssr_barrier(SNRT_SSR_DM1);
+        snrt_ssr_disable();
+    }
+}
+
+static inline void scal_fp32(uint32_t n, float a, float *x) {
+    const uint32_t words = n / 2;
+
+    if (words) {
+        v2f32 a2;
+
+        snrt_ssr_loop_1d(SNRT_SSR_DM0, words, sizeof(v2f32));
+        snrt_ssr_loop_1d(SNRT_SSR_DM1, words, sizeof(v2f32));
+        snrt_ssr_repeat(SNRT_SSR_DM0, 1);
+        snrt_ssr_repeat(SNRT_SSR_DM1, 1);
+        snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_1D, x);
+        snrt_ssr_write(SNRT_SSR_DM1, SNRT_SSR_1D, x);
+        snrt_ssr_enable();
+
+        asm volatile(
+            "vfcpka.s.s %[a2], %[a], %[a] \n"
+            "frep.o     %[n_frep], 1, 0, 0 \n"
+            "vfmul.s    ft1, ft0, %[a2] \n"
+            : [ a2 ] "=&f"(a2)
+            : [ n_frep ] "r"(words - 1), [ a ] "f"(a)
+            : "ft0", "ft1", "ft2", "memory");
+
+        snrt_fpu_fence();
+        __builtin_ssr_barrier(SNRT_SSR_DM1);
+        snrt_ssr_disable();
+    }
+
+    for (uint32_t i = 2 * words; i < n; i++) x[i] *= a;
+}
+
+static inline void scal_fp16(uint32_t n, float a, __fp16 *x) {
+    const uint32_t words = n / 4;
+
+    if (words) {
+        v4f16 a4;
+
+        snrt_ssr_loop_1d(SNRT_SSR_DM0, words, sizeof(v4f16));
+        snrt_ssr_loop_1d(SNRT_SSR_DM1, words, sizeof(v4f16));
+        snrt_ssr_repeat(SNRT_SSR_DM0, 1);
+        snrt_ssr_repeat(SNRT_SSR_DM1, 1);
+        snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_1D, x);
+        snrt_ssr_write(SNRT_SSR_DM1, SNRT_SSR_1D, x);
+        snrt_ssr_enable();
+
+        asm volatile(
+            "vfcpka.h.s %[a4], %[a], %[a] \n"
+            "vfcpkb.h.s %[a4], %[a], %[a] \n"
+            "frep.o     %[n_frep], 1, 0, 0 \n"
+            "vfmul.h    ft1, ft0, %[a4] \n"
+            : [ a4 ] "=&f"(a4)
+            : [ n_frep ] "r"(words - 1), [ a ] "f"(a)
+            : "ft0", "ft1", "ft2", "memory");
+
+        snrt_fpu_fence();
+        __builtin_ssr_barrier(SNRT_SSR_DM1);
+        snrt_ssr_disable();
+    }
+
+    for (uint32_t i = 4 * words; i < n; i++) x[i] = (float)x[i] * a;
+}
+
+/**
+ * @brief In-place scaling on all compute cores of the cluster
+ *
+ * Must be called by all cores of the cluster. The vector is split across the
+ * compute cores in whole blocks of BLAS_UNROLL words. The DM core returns
+ * immediately, the caller synchronizes before using the result.
+ *
+ * @param prec precision of the vector: FP64, FP32 or FP16
+ * @param n number of elements
+ * @param a scaling factor
+ * @param x 8-byte aligned vector in TCDM
+ */
+static inline void scal(precision_t prec, uint32_t n, double a, void *x) {
+    if (!snrt_is_compute_core()) return;
+
+    uint32_t first;
+    uint32_t len =
+        blas_split(n, BLAS_UNROLL * blas_lanes(prec), snrt_cluster_core_idx(),
+                   snrt_cluster_compute_core_num(), &first);
+
+    switch (prec) {
+        case FP64:
+            scal_fp64(len, a, (double *)x + first);
+            break;
+        case FP32:
+            scal_fp32(len, a, (float *)x + first);
+            break;
+        default:
+            scal_fp16(len, a, (__fp16 *)x + first);
+            break;
+    }
+}
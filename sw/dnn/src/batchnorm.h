@@ -3,6 +3,7 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #include "snrt.h"
+#include "utils.h"
 
 /**
  * @brief implementation of a FP64 batchnorm as a linear combination
@@ -50,7 +51,13 @@ static inline void batchnorm_fp64(double *ifmap, double *gamma, double *beta,
     snrt_ssr_disable();
 }
 
-static inline void batchnorm_layer(const conv_layer *l) {
+/**
+ * @brief FP64 batchnorm inference on a conv_layer, with precomputed gamma and
+ * beta, see batchnorm_fp64()
+ *
+ * @param l conv_layer struct that holds addresses and parameters
+ */
+static inline void batchnorm_conv_layer(const conv_layer *l) {
     const uint32_t cluster_num = snrt_cluster_num();
     const uint32_t cluster_id = snrt_cluster_idx();
     const uint32_t compute_num = snrt_cluster_compute_core_num();
@@ -177,3 +184,510 @@ static inline void batchnorm_layer(const conv_layer *l) {
         snrt_dma_wait_all();
     }
 }
+
+/**
+ * @struct batchnorm_layer_struct
+ * @brief This structure contains all parameters necessary for computing a
+ *        BatchNorm layer on rows of channels, e.g. the pixels of a HWC
+ *        feature map or the samples of a batch
+ * @var batchnorm_layer_struct::ROWS
+ * Number of rows, i.e. batch size times pixels per sample
+ * @var batchnorm_layer_struct::CHANNELS
+ * Number of channels per row
+ * @var batchnorm_layer_struct::TRAIN
+ * Normalize with the statistics of the batch and update the running
+ * statistics if set, normalize with the running statistics otherwise
+ * @var batchnorm_layer_struct::EPS
+ * Value added to the variance for numerical stability
+ * @var batchnorm_layer_struct::MOMENTUM
+ * Weight of the batch statistics in the update of the running statistics
+ * @var batchnorm_layer_struct::ifmap
+ * Pointer to the ROWS x CHANNELS input
+ * @var batchnorm_layer_struct::ofmap
+ * Pointer to the ROWS x CHANNELS output
+ * @var batchnorm_layer_struct::gamma
+ * Pointer to the CHANNELS scale factors
+ * @var batchnorm_layer_struct::beta
+ * Pointer to the CHANNELS offsets
+ * @var batchnorm_layer_struct::running_mean
+ * Pointer to the CHANNELS running means, in FP32
+ * @var batchnorm_layer_struct::running_var
+ * Pointer to the CHANNELS unbiased running variances, in FP32
+ * @var batchnorm_layer_struct::dtype
+ * Precision of the feature maps, gamma and beta (FP32 or FP16)
+ */
+typedef struct batchnorm_layer_struct {
+    uint32_t ROWS;
+    uint32_t CHANNELS;
+    uint32_t TRAIN;
+    float EPS;
+    float MOMENTUM;
+
+    void *ifmap;
+    void *ofmap;
+    void *gamma;
+    void *beta;
+    float *running_mean;
+    float *running_var;
+
+    precision_t dtype;
+} batchnorm_layer_t;
+
+/**
+ * @brief Accumulate the channel sums and sums of squares of the deviations of
+ * FP32 rows from a shift
+ *
+ * SSR0 streams one word of two channels of all rows at a time. Two rows are
+ * accumulated per iteration into independent registers. Shifting the data
+ * keeps the variance accurate when the mean is large compared to the spread.
+ *
+ * @param x first row
+ * @param ldx distance between rows in bytes
+ * @param rows number of rows
+ * @param words number of words per row
+ * @param shift shift of every channel
+ * @param sum sums of the channels, updated
+ * @param sumsq sums of squares of the channels, updated
+ */
+static inline void batchnorm_stats_fp32(float *x, uint32_t ldx, uint32_t rows,
+                                        uint32_t words, float *shift,
+                                        float *sum, float *sumsq) {
+    snrt_ssr_loop_1d(SNRT_SSR_DM0, rows, ldx);
+    snrt_ssr_repeat(SNRT_SSR_DM0, 1);
+
+    for (uint32_t w = 0; w < words; w++) {
+        v2f32 shift_vec = ((v2f32 *)shift)[w];
+        v2f32 sum0 = ((v2f32 *)sum)[w], sumsq0 = ((v2f32 *)sumsq)[w];
+        v2f32 sum1 = {0, 0}, sumsq1 = {0, 0}, tmp0, tmp1;
+
+        snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_1D, (v2f32 *)x + w);
+        snrt_ssr_enable();
+
+        if (rows / 2)
+            asm volatile(
+                "frep.o %[n_frep], 6, 0, 0 \n"
+                "vfsub.s %[tmp0], ft0, %[shift_vec] \n"
+                "vfsub.s %[tmp1], ft0, %[shift_vec] \n"
+                "vfadd.s %[sum0], %[tmp0], %[sum0] \n"
+                "vfadd.s %[sum1], %[tmp1], %[sum1] \n"
+                "vfmac.s %[sumsq0], %[tmp0], %[tmp0] \n"
+                "vfmac.s %[sumsq1], %[tmp1], %[tmp1] \n"
+                : [ sum0 ] "+f"(sum0), [ sum1 ] "+f"(sum1),
+                  [ sumsq0 ] "+f"(sumsq0), [ sumsq1 ] "+f"(sumsq1),
+                  [ tmp0 ] "=&f"(tmp0), [ tmp1 ] "=&f"(tmp1)
+                : [ shift_vec ] "f"(shift_vec), [ n_frep ] "r"(rows / 2 - 1)
+                : "ft0", "ft1", "ft2");
+
+        if (rows % 2)
+            asm volatile(
+                "vfsub.s %[tmp0], ft0, %[shift_vec] \n"
+                "vfadd.s %[sum0], %[tmp0], %[sum0] \n"
+                "vfmac.s %[sumsq0], %[tmp0], %[tmp0] \n"
+                : [ sum0 ] "+f"(sum0), [ sumsq0 ] "+f"(sumsq0),
+                  [ tmp0 ] "=&f"(tmp0)
+                : [ shift_vec ] "f"(shift_vec)
+                : "ft0", "ft1", "ft2");
+
+        asm volatile(
+            "vfadd.s %[sum0], %[sum0], %[sum1] \n"
+            "vfadd.s %[sumsq0], %[sumsq0], %[sumsq1] \n"
+            : [ sum0 ] "+f"(sum0), [ sumsq0 ] "+f"(sumsq0)
+            : [ sum1 ] "f"(sum1), [ sumsq1 ] "f"(sumsq1)
+            : "ft0", "ft1", "ft2");
+
+        snrt_fpu_fence();
+        snrt_ssr_disable();
+
+        ((v2f32 *)sum)[w] = sum0;
+        ((v2f32 *)sumsq)[w] = sumsq0;
+    }
+}
+
+/**
+ * @brief Accumulate the channel sums and sums of squares of the deviations of
+ * FP16 rows from a shift
+ *
+ * Same as batchnorm_stats_fp32, with four channels per word and one row per
+ * iteration. The sums are accumulated in FP32 with expanding dot products,
+ * which add up pairs of adjacent lanes. Masking either the odd or the even
+ * lanes keeps the channels apart, such that the sums of the channels
+ * 4w, 4w + 2, 4w + 1 and 4w + 3 are stored in this order in the sums of
+ * word w, see batchnorm_partial_idx().
+ */
+static inline void batchnorm_stats_fp16(__fp16 *x, uint32_t ldx,
+                                        uint32_t rows, uint32_t words,
+                                        __fp16 *shift, float *sum,
+                                        float *sumsq) {
+    const v4s even = {.vec = {1, 0, 1, 0}};
+    const v4s odd = {.vec = {0, 1, 0, 1}};
+
+    snrt_ssr_loop_1d(SNRT_SSR_DM0, rows, ldx);
+    snrt_ssr_repeat(SNRT_SSR_DM0, 1);
+
+    for (uint32_t w = 0; w < words; w++) {
+        v4f16 shift_vec = ((v4f16 *)shift)[w], tmp, tmp_even, tmp_odd;
+        v2f32 sum_even = ((v2f32 *)sum)[2 * w];
+        v2f32 sum_odd = ((v2f32 *)sum)[2 * w + 1];
+        v2f32 sumsq_even = ((v2f32 *)sumsq)[2 * w];
+        v2f32 sumsq_odd = ((v2f32 *)sumsq)[2 * w + 1];
+
+        snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_1D, (v4f16 *)x + w);
+        snrt_ssr_enable();
+
+        asm volatile(
+            "frep.o %[n_frep], 7, 0, 0 \n"
+            "vfsub.h %[tmp], ft0, %[shift_vec] \n"
+            "vfmul.h %[tmp_even], %[tmp], %[even] \n"
+            "vfmul.h %[tmp_odd], %[tmp], %[odd] \n"
+            "vfdotpex.s.h %[sum_even], %[tmp], %[even] \n"
+            "vfdotpex.s.h %[sum_odd], %[tmp], %[odd] \n"
+            "vfdotpex.s.h %[sumsq_even], %[tmp], %[tmp_even] \n"
+            "vfdotpex.s.h %[sumsq_odd], %[tmp], %[tmp_odd] \n"
+            : [ sum_even ] "+f"(sum_even), [ sum_odd ] "+f"(sum_odd),
+              [ sumsq_even ] "+f"(sumsq_even), [ sumsq_odd ] "+f"(sumsq_odd),
+              [ tmp ] "=&f"(tmp), [ tmp_even ] "=&f"(tmp_even),
+              [ tmp_odd ] "=&f"(tmp_odd)
+            : [ shift_vec ] "f"(shift_vec), [ even ] "f"(even.f64),
+              [ odd ] "f"(odd.f64), [ n_frep ] "r"(rows - 1)
+            : "ft0", "ft1", "ft2");
+
+        snrt_fpu_fence();
+        snrt_ssr_disable();
+
+        ((v2f32 *)sum)[2 * w] = sum_even;
+        ((v2f32 *)sum)[2 * w + 1] = sum_odd;
+        ((v2f32 *)sumsq)[2 * w] = sumsq_even;
+        ((v2f32 *)sumsq)[2 * w + 1] = sumsq_odd;
+    }
+}
+
+/**
+ * @brief Scale and shift FP32 or FP16 rows channel by channel,
+ * y = x * scale + bias
+ *
+ * SSR0 streams the rows and SSR2 writes the results. Two rows are processed
+ * per iteration, SSR1 alternates between the scale and the bias of a word,
+ * repeating both for the two rows. An odd last row is processed on its own.
+ *
+ * @param prec precision of the rows and factors
+ * @param x first input row
+ * @param y first output row
+ * @param ld distance between rows in bytes, for both x and y
+ * @param rows number of rows
+ * @param words number of words per row
+ * @param scale scale of every channel
+ * @param bias bias of every channel, at a higher address than scale
+ */
+static inline void batchnorm_apply(precision_t prec, void *x, void *y,
+                                   uint32_t ld, uint32_t rows, uint32_t words,
+                                   void *scale, void *bias) {
+    const uint32_t word = sizeof(double);
+    const uint32_t offset = bias - scale;
+    uint32_t pairs = rows / 2;
+    double tmp0, tmp1;
+
+    if (pairs) {
+        snrt_ssr_loop_3d(SNRT_SSR_DM0, 2, words, pairs, ld, word, 2 * ld);
+        snrt_ssr_repeat(SNRT_SSR_DM0, 1);
+        snrt_ssr_loop_3d(SNRT_SSR_DM1, 2, words, pairs, offset, word, 0);
+        snrt_ssr_repeat(SNRT_SSR_DM1, 2);
+        snrt_ssr_loop_3d(SNRT_SSR_DM2, 2, words, pairs, ld, word, 2 * ld);
+        snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_3D, x);
+        snrt_ssr_read(SNRT_SSR_DM1, SNRT_SSR_3D, scale);
+        snrt_ssr_write(SNRT_SSR_DM2, SNRT_SSR_3D, y);
+        snrt_ssr_enable();
+
+        if (prec == FP32)
+            asm volatile(
+                "frep.o %[n_frep], 4, 0, 0 \n"
+                "vfmul.s %[tmp0], ft0, ft1 \n"
+                "vfmul.s %[tmp1], ft0, ft1 \n"
+                "vfadd.s ft2, %[tmp0], ft1 \n"
+                "vfadd.s ft2, %[tmp1], ft1 \n"
+                : [ tmp0 ] "=&f"(tmp0), [ tmp1 ] "=&f"(tmp1)
+                : [ n_frep ] "r"(pairs * words - 1)
+                : "ft0", "ft1", "ft2", "memory");
+        else
+            asm volatile(
+                "frep.o %[n_frep], 4, 0, 0 \n"
+                "vfmul.h %[tmp0], ft0, ft1 \n"
+                "vfmul.h %[tmp1], ft0, ft1 \n"
+                "vfadd.h ft2, %[tmp0], ft1 \n"
+                "vfadd.h ft2, %[tmp1], ft1 \n"
+                : [ tmp0 ] "=&f"(tmp0), [ tmp1 ] "=&f"(tmp1)
+                : [ n_frep ] "r"(pairs * words - 1)
+                : "ft0", "ft1", "ft2", "memory");
+
+        snrt_fpu_fence();
+        __builtin_ssr_barrier(SNRT_SSR_DM2);
+        snrt_ssr_disable();
+    }
+
+    if (rows % 2) {
+        snrt_ssr_loop_1d(SNRT_SSR_DM0, words, word);
+        snrt_ssr_repeat(SNRT_SSR_DM0, 1);
+        snrt_ssr_loop_2d(SNRT_SSR_DM1, 2, words, offset, word);
+        snrt_ssr_repeat(SNRT_SSR_DM1, 1);
+        snrt_ssr_loop_1d(SNRT_SSR_DM2, words, word);
+        snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_1D, x + 2 * pairs * ld);
+        snrt_ssr_read(SNRT_SSR_DM1, SNRT_SSR_2D, scale);
+        snrt_ssr_write(SNRT_SSR_DM2, SNRT_SSR_1D, y + 2 * pairs * ld);
+        snrt_ssr_enable();
+
+        if (prec == FP32)
+            asm volatile(
+                "frep.o %[n_frep], 2, 0, 0 \n"
+                "vfmul.s %[tmp0], ft0, ft1 \n"
+                "vfadd.s ft2, %[tmp0], ft1 \n"
+                : [ tmp0 ] "=&f"(tmp0)
+                : [ n_frep ] "r"(words - 1)
+                : "ft0", "ft1", "ft2", "memory");
+        else
+            asm volatile(
+                "frep.o %[n_frep], 2, 0, 0 \n"
+                "vfmul.h %[tmp0], ft0, ft1 \n"
+                "vfadd.h ft2, %[tmp0], ft1 \n"
+                : [ tmp0 ] "=&f"(tmp0)
+                : [ n_frep ] "r"(words - 1)
+                : "ft0", "ft1", "ft2", "memory");
+
+        snrt_fpu_fence();
+        __builtin_ssr_barrier(SNRT_SSR_DM2);
+        snrt_ssr_disable();
+    }
+}
+
+// Arguments of the per-core parts of the BatchNorm layer
+typedef struct {
+    const batchnorm_layer_t *l;
+    uint32_t ssr;  // Rows fill whole SSR words
+    void *shift;   // TCDM copy of the first row, shift of the statistics
+    float *sum;    // Per-core sums of the channels
+    float *sumsq;  // Per-core sums of squares of the channels
+    void *scale;   // Scale of every channel
+    void *bias;    // Bias of every channel, after the scales
+} batchnorm_args_t;
+
+// Position of a channel in the per-core sums, see batchnorm_stats_fp16()
+static inline uint32_t batchnorm_partial_idx(const batchnorm_args_t *a,
+                                             uint32_t c) {
+    if (!a->ssr || a->l->dtype != FP16) return c;
+    return (c & ~3) | ((c & 1) << 1) | ((c >> 1) & 1);
+}
+
+// Per-core accumulation of the statistics of a tile of rows
+static inline void batchnorm_stats_rows(const void *args, void *input,
+                                        void *output, uint32_t rows,
+                                        uint32_t core, uint32_t cores) {
+    const batchnorm_args_t *a = args;
+    const precision_t prec = a->l->dtype;
+    const uint32_t C = a->l->CHANNELS;
+    const uint32_t ld = cores * C * prec;
+    const uint32_t n = (rows + cores - 1 - core) / cores;
+    void *x = input + core * C * prec;
+    float *sum = a->sum + core * C;
+    float *sumsq = a->sumsq + core * C;
+
+    if (!n) return;
+
+    if (a->ssr) {
+        const uint32_t words = C * prec / sizeof(double);
+        if (prec == FP32)
+            batchnorm_stats_fp32(x, ld, n, words, a->shift, sum, sumsq);
+        else
+            batchnorm_stats_fp16(x, ld, n, words, a->shift, sum, sumsq);
+        return;
+    }
+
+    for (uint32_t r = 0; r < n; r++) {
+        for (uint32_t c = 0; c < C; c++) {
+            float d = blas_load(prec, x + r * ld, c) -
+                      blas_load(prec, a->shift, c);
+            sum[c] += d;
+            sumsq[c] += d * d;
+        }
+    }
+}
+
+// Per-core normalization of a tile of rows
+static inline void batchnorm_apply_rows(const void *args, void *input,
+                                        void *output, uint32_t rows,
+                                        uint32_t core, uint32_t cores) {
+    const batchnorm_args_t *a = args;
+    const precision_t prec = a->l->dtype;
+    const uint32_t C = a->l->CHANNELS;
+    const uint32_t ld = cores * C * prec;
+    const uint32_t n = (rows + cores - 1 - core) / cores;
+    void *x = input + core * C * prec;
+    void *y = output + core * C * prec;
+
+    if (!n) return;
+
+    if (a->ssr) {
+        batchnorm_apply(prec, x, y, ld, n, C * prec / sizeof(double),
+                        a->scale, a->bias);
+        return;
+    }
+
+    for (uint32_t r = 0; r < n; r++) {
+        for (uint32_t c = 0; c < C; c++) {
+            float v = blas_load(prec, x + r * ld, c) *
+                          blas_load(prec, a->scale, c) +
+                      blas_load(prec, a->bias, c);
+            blas_store(prec, y + r * ld, c, v);
+        }
+    }
+}
+
+// Fold the statistics and the affine transformation of a channel into a
+// scale and a bias
+static inline void batchnorm_factors(const batchnorm_args_t *a, uint32_t c,
+                                     float mean, float var) {
+    const batchnorm_layer_t *l = a->l;
+    float scale = blas_load(l->dtype, l->gamma, c) * fast_rsqrtf(var + l->EPS);
+    float bias = blas_load(l->dtype, l->beta, c) - mean * scale;
+    blas_store(l->dtype, a->scale, c, scale);
+    blas_store(l->dtype, a->bias, c, bias);
+}
+
+/**
+ * @brief  BatchNorm layer on rows of channels
+ *
+ * In training mode, every compute core first accumulates the statistics of
+ * its rows in FP32, with the rows distributed across clusters and cores as
+ * in dnn_rows_run(). The partial sums are reduced over the cores of a
+ * cluster and, in double precision, over the clusters: every cluster
+ * gathers the partial sums of all clusters from their TCDMs, such that all
+ * of them compute the same statistics. Cluster 0 updates the running
+ * statistics. In inference mode the running statistics are used instead.
+ *
+ * The statistics, gamma and beta are folded into a scale and a bias per
+ * channel, which are applied in a second pass over the rows with SSR
+ * streams. Rows which do not fill whole SSR words are processed without
+ * SSRs.
+ *
+ * Must be called by all cores of all clusters.
+ *
+ * @param l batchnorm_layer struct that holds addresses and parameters
+ * @return 0 on success, -1 if the layer is not supported or does not fit
+ * into TCDM
+ */
+static inline int batchnorm_layer(const batchnorm_layer_t *l) {
+    const precision_t prec = l->dtype;
+    const uint32_t C = l->CHANNELS;
+    const uint32_t row_size = C * prec;
+    const uint32_t compute_num = snrt_cluster_compute_core_num();
+    const uint32_t compute_id = snrt_cluster_core_idx();
+    const uint32_t cluster_num = snrt_cluster_num();
+    const uint32_t cluster_id = snrt_cluster_idx();
+
+    if (prec != FP32 && prec != FP16) return -1;
+
+    int ret = 0;
+    batchnorm_args_t a = {.l = l, .ssr = row_size % sizeof(double) == 0};
+    void *ptr = (void *)ALIGN_UP((uint32_t)snrt_l1_next(), sizeof(double));
+    a.scale = ptr;
+    ptr += ALIGN_UP(row_size, sizeof(double));
+    a.bias = ptr;
+    ptr += ALIGN_UP(row_size, sizeof(double));
+
+    if (l->TRAIN) {
+        // The sums of this cluster are read by all clusters, they are not
+        // overwritten by the tiles of the second pass
+        double *local = ptr;
+        ptr += 2 * C * sizeof(double);
+        void *tiles = ptr;
+        a.shift = ptr;
+        ptr += ALIGN_UP(row_size, sizeof(double));
+        a.sum = ptr;
+        ptr += ALIGN_UP(compute_num * C * sizeof(float), sizeof(double));
+        a.sumsq = ptr;
+        ptr += ALIGN_UP(compute_num * C * sizeof(float), sizeof(double));
+        double *gather = ptr;
+        ptr += cluster_num * 2 * C * sizeof(double);
+
+        // Clear the partial sums of all cores, which are contiguous. The tile
+        // loop waits for the transfers before its first barrier.
+        if (snrt_is_dm_core()) {
+            snrt_dma_start_1d(a.shift, l->ifmap, row_size);
+            snrt_dma_zero_async(a.sum, (char *)gather - (char *)a.sum);
+        }
+
+        // Keep going on failure, all clusters have to reach the barriers
+        ret = dnn_rows_run(batchnorm_stats_rows, &a, l->ifmap, NULL, l->ROWS,
+                           row_size, 0, ptr);
+
+        // Clusters without rows have not waited for the transfer
+        if (snrt_is_dm_core()) snrt_dma_wait_all();
+        snrt_cluster_hw_barrier();
+
+        // Reduce the sums over the cores
+        if (snrt_is_compute_core()) {
+            for (uint32_t c = compute_id; c < C; c += compute_num) {
+                uint32_t i = batchnorm_partial_idx(&a, c);
+                double sum = 0, sumsq = 0;
+                for (uint32_t k = 0; k < compute_num; k++) {
+                    sum += a.sum[k * C + i];
+                    sumsq += a.sumsq[k * C + i];
+                }
+                local[c] = sum;
+                local[C + c] = sumsq;
+            }
+        }
+
+        snrt_global_barrier();
+
+        // Gather the sums of all clusters, at the same offset in their TCDMs
+        if (snrt_is_dm_core()) {
+            for (uint32_t k = 0; k < cluster_num; k++) {
+                void *remote = (void *)local +
+                               ((int32_t)k - (int32_t)cluster_id) *
+                                   (int32_t)SNRT_CLUSTER_OFFSET;
+                snrt_dma_start_1d(gather + k * 2 * C, remote,
+                                  2 * C * sizeof(double));
+            }
+            snrt_dma_wait_all();
+        }
+
+        snrt_cluster_hw_barrier();
+
+        if (snrt_is_compute_core()) {
+            for (uint32_t c = compute_id; c < C; c += compute_num) {
+                double sum = 0, sumsq = 0;
+                for (uint32_t k = 0; k < cluster_num; k++) {
+                    sum += gather[k * 2 * C + c];
+                    sumsq += gather[k * 2 * C + C + c];
+                }
+                double m = sum / l->ROWS;
+                double var = sumsq / l->ROWS - m * m;
+                double mean = blas_load(prec, a.shift, c) + m;
+                var = var > 0 ? var : 0;
+                batchnorm_factors(&a, c, mean, var);
+
+                if (cluster_id == 0) {
+                    double unbiased =
+                        l->ROWS > 1 ? var * l->ROWS / (l->ROWS - 1) : var;
+                    l->running_mean[c] = (1 - l->MOMENTUM) *
+                                             l->running_mean[c] +
+                                         l->MOMENTUM * mean;
+                    l->running_var[c] = (1 - l->MOMENTUM) * l->running_var[c] +
+                                        l->MOMENTUM * unbiased;
+                }
+            }
+        }
+
+        ptr = tiles;
+    } else if (snrt_is_compute_core()) {
+        for (uint32_t c = compute_id; c < C; c += compute_num)
+            batchnorm_factors(&a, c, l->running_mean[c], l->running_var[c]);
+    }
+
+    snrt_cluster_hw_barrier();
+
+    if (dnn_rows_run(batchnorm_apply_rows, &a, l->ifmap, l->ofmap, l->ROWS,
+                     row_size, row_size, ptr))
+        ret = -1;
+
+    snrt_global_barrier();
+    return ret;
+}
@@ -32,6 +32,16 @@
  * Width of filter
  * @var conv_layer_struct::pad
  * Padding on all sides
+ * @var conv_layer_struct::stride
+ * Stride in both directions, 0 is treated as 1
+ * @var conv_layer_struct::dilation
+ * Spacing between the filter taps in both directions, 0 is treated as 1
+ * @var conv_layer_struct::groups
+ * Number of groups the input and output channels are split into, 0 is
+ * treated as 1. Group g connects the input channels [g * CI / groups,
+ * (g + 1) * CI / groups) to the corresponding output channels, weights are
+ * in CO x FH x FW x (CI / groups) format. groups == CI == CO is a depthwise
+ * convolution.
  * @var conv_layer_struct::ifmap
  * Pointer to input feature map
  * @var conv_layer_struct::weights
@@ -43,7 +53,8 @@
  * @var conv_layer_struct::cluster2cluster
  * Flag for enabling cluster 2 cluster communication
  * @var conv_layer_struct::im2col
- * Flag for enabling im2col + GEMM
+ * Flag for enabling the explicit im2col + GEMM path (FP64 only) instead of
+ * the implicit GEMM
  * @var conv_layer_struct::gamma
  * Pointer to gamma for BatchNorm
  * @var conv_layer_struct::beta
@@ -62,6 +73,9 @@ typedef struct conv_layer_struct {
     uint32_t FH;
     uint32_t FW;
     uint32_t pad;
+    uint32_t stride;
+    uint32_t dilation;
+    uint32_t groups;
 
     double *ifmap;
     double *weights;
@@ -78,6 +92,44 @@ typedef struct conv_layer_struct {
     precision_t dtype;
 } conv_layer;
 
+static inline uint32_t conv2d_stride(const conv_layer *l) {
+    return l->stride ? l->stride : 1;
+}
+
+static inline uint32_t conv2d_dilation(const conv_layer *l) {
+    return l->dilation ? l->dilation : 1;
+}
+
+static inline uint32_t conv2d_groups(const conv_layer *l) {
+    return l->groups ? l->groups : 1;
+}
+
+// Output size along one dimension, 0 if the filter does not fit
+static inline uint32_t conv2d_out_dim(uint32_t in, uint32_t filter,
+                                      uint32_t pad, uint32_t stride,
+                                      uint32_t dilation) {
+    uint32_t span = (filter - 1) * dilation + 1;
+    if (in + 2 * pad < span) return 0;
+    return (in + 2 * pad - span) / stride + 1;
+}
+
+// Check the output dimensions of a layer against its other parameters
+static inline uint32_t conv2d_valid(const conv_layer *l) {
+    const uint32_t groups = conv2d_groups(l);
+    const uint32_t s = conv2d_stride(l);
+    const uint32_t d = conv2d_dilation(l);
+
+    if (l->CI % groups || l->CO % groups) return 0;
+    if (l->OH != conv2d_out_dim(l->IH, l->FH, l->pad, s, d)) return 0;
+    if (l->OW != conv2d_out_dim(l->IW, l->FW, l->pad, s, d)) return 0;
+    return l->OH && l->OW;
+}
+
+static inline uint32_t conv2d_is_depthwise(const conv_layer *l) {
+    return conv2d_groups(l) > 1 && conv2d_groups(l) == l->CI &&
+           l->CI == l->CO;
+}
+
 /**
  * @struct kernel_fp32
  * @brief parameters for single-precision fusedconv kernel
@@ -284,7 +336,7 @@ void bn_relu(const float *pBuffer, const uint16_t dim_x, const uint16_t dim_y,
              const uint16_t ch, float *kappa, float *lambda, int flag_relu,
              int flag_batch_norm) {
     // Parallelization/Pipelining parameters
-    const uint32_t compute_id = snrt_cluster_compute_core_num();
+    const uint32_t compute_id = snrt_cluster_core_idx();
     const uint32_t compute_num =
         (snrt_cluster_compute_core_num()) ? snrt_cluster_compute_core_num() : 1;
     // BN & ReLU require 3 instructions. Unrolling by 4 gives as 12 instruction
@@ -559,7 +611,7 @@ void bn_relu(const float *pBuffer, const uint16_t dim_x, const uint16_t dim_y,
  */
 static inline void conv2d_fp64(kernel_fp64 *k) {
     // Parallelization/Pipelining parameters
-    const uint32_t compute_id = snrt_cluster_compute_core_num();
+    const uint32_t compute_id = snrt_cluster_core_idx();
     const uint32_t compute_num =
         (snrt_cluster_compute_core_num()) ? snrt_cluster_compute_core_num() : 1;
     const uint32_t max_unroll = 8;  // Maximum number of unrolling
@@ -915,7 +967,7 @@ static inline void conv2d_fp64(kernel_fp64 *k) {
  */
 static inline void conv2d_fp32(kernel_fp32 *k) {
     // Parallelization/Pipelining parameters
-    const uint32_t compute_id = snrt_cluster_compute_core_num();
+    const uint32_t compute_id = snrt_cluster_core_idx();
     const uint32_t compute_num =
         (snrt_cluster_compute_core_num()) ? snrt_cluster_compute_core_num() : 1;
     const uint32_t max_unroll = 8;  // Maximum number of unrolling
@@ -1342,7 +1394,7 @@ static inline void conv2d_fp32(kernel_fp32 *k) {
  */
 static inline void conv2d_dw_fp32(kernel_fp32 *k) {
     // Parallelization/Pipelining parameters
-    const uint32_t compute_id = snrt_cluster_compute_core_num();
+    const uint32_t compute_id = snrt_cluster_core_idx();
     const uint32_t compute_num =
         (snrt_cluster_compute_core_num()) ? snrt_cluster_compute_core_num() : 1;
     const uint32_t max_unroll = 8;  // Maximum number of unrolling
@@ -1674,7 +1726,7 @@ static inline void conv2d_dw_fp32(kernel_fp32 *k) {
  */
 static inline void conv2d_chw_fp32(kernel_fp32 *k) {
     // Parallelization/Pipelining parameters
-    const uint32_t compute_id = snrt_cluster_compute_core_num();
+    const uint32_t compute_id = snrt_cluster_core_idx();
     const uint32_t compute_num =
         (snrt_cluster_compute_core_num()) ? snrt_cluster_compute_core_num() : 1;
     const uint32_t max_unroll = 8;  // Maximum number of unrolling
@@ -2103,15 +2155,16 @@ static inline void conv2d_chw_fp32(kernel_fp32 *k) {
 }
 
 /**
- * @brief conv2d layer that handles data transfers in a double buffered fashion
+ * @brief FP64 conv2d layer that builds an explicit im2col buffer with the DMA
+ * and handles data transfers in a double buffered fashion
  *
  * @param l conv_layer struct that holds addresses and parameters
  */
-void conv2d_layer(const conv_layer *l) {
+void conv2d_im2col_layer(const conv_layer *l) {
     uint32_t cluster_num = snrt_cluster_num();
     uint32_t cluster_id = snrt_cluster_idx();
     uint32_t compute_num = snrt_cluster_compute_core_num();
-    uint32_t compute_id = snrt_cluster_compute_core_num();
+    uint32_t compute_id = snrt_cluster_core_idx();
 
     const uint32_t cluster_per_quadrant = min(4, cluster_num);
 
@@ -2490,3 +2543,970 @@ void conv2d_layer(const conv_layer *l) {
 
     // snrt_global_barrier();
 }
+
+/**
+ * @struct conv2d_implicit_gemm_t
+ * @brief Geometry of the implicit GEMM convolution in TCDM
+ *
+ * @var conv2d_implicit_gemm_t::CI
+ * Input channels of a group, padded such that every pixel fills whole SSR
+ * words
+ * @var conv2d_implicit_gemm_t::CO
+ * Output channels of a group
+ * @var conv2d_implicit_gemm_t::G
+ * Number of groups
+ * @var conv2d_implicit_gemm_t::K
+ * Reduction dimension FH * FW * CI
+ * @var conv2d_implicit_gemm_t::IW
+ * Width of the zero-padded input rows
+ * @var conv2d_implicit_gemm_t::OH
+ * Computed output rows, a multiple of PH
+ * @var conv2d_implicit_gemm_t::OW
+ * Computed output columns, a multiple of PW
+ * @var conv2d_implicit_gemm_t::TOH
+ * Output rows per block, a multiple of PH
+ * @var conv2d_implicit_gemm_t::TCO
+ * Output channels per weight tile, a multiple of the GEMM unrolling
+ * @var conv2d_implicit_gemm_t::S
+ * Stride in both directions
+ * @var conv2d_implicit_gemm_t::D
+ * Dilation in both directions
+ * @var conv2d_implicit_gemm_t::PH
+ * Height of the max pooling window, 1 if pooling is disabled
+ * @var conv2d_implicit_gemm_t::PW
+ * Width of the max pooling window, 1 if pooling is disabled
+ * @var conv2d_implicit_gemm_t::kappa
+ * Folded BatchNorm scale of all output channels in TCDM, NULL if disabled
+ * @var conv2d_implicit_gemm_t::lambda
+ * Folded BatchNorm shift of all output channels in TCDM
+ */
+typedef struct {
+    precision_t prec;
+    uint32_t CI;
+    uint32_t CO;
+    uint32_t G;
+    uint32_t K;
+    uint32_t IW;
+    uint32_t OH;
+    uint32_t OW;
+    uint32_t FH;
+    uint32_t FW;
+    uint32_t TOH;
+    uint32_t TCO;
+    uint32_t S;
+    uint32_t D;
+    uint32_t PH;
+    uint32_t PW;
+    uint32_t relu;
+    void *kappa;
+    void *lambda;
+} conv2d_implicit_gemm_t;
+
+/**
+ * @struct conv2d_epilogue_t
+ * @brief Operations applied to the output of the implicit GEMM convolution
+ * while it is resident in TCDM, in this order
+ *
+ * @var conv2d_epilogue_t::kappa
+ * Folded BatchNorm y = kappa * x + lambda, one scale per output channel in
+ * the layer precision. NULL disables the BatchNorm.
+ * @var conv2d_epilogue_t::lambda
+ * Folded BatchNorm shift, one per output channel in the layer precision
+ * @var conv2d_epilogue_t::relu
+ * Flag for enabling ReLU
+ * @var conv2d_epilogue_t::PH
+ * Height of the max pooling window, equal to its vertical stride. 0 or 1
+ * disables the pooling.
+ * @var conv2d_epilogue_t::PW
+ * Width of the max pooling window, equal to its horizontal stride
+ */
+typedef struct {
+    void *kappa;
+    void *lambda;
+    uint32_t relu;
+    uint32_t PH;
+    uint32_t PW;
+} conv2d_epilogue_t;
+
+// Step of the implicit GEMM convolution, i.e. one weight tile of a group
+// applied to one block of output rows
+typedef struct {
+    uint32_t slice;  // Index of the input slice, i.e. the group of a block
+    uint32_t group;  // Index of the group
+    uint32_t tile;   // Index of the weight tile within the group
+    uint32_t oh0;    // First output row of the block
+    uint32_t rows;   // Valid output rows of the block
+    uint32_t co0;    // First output channel of the tile in the layer
+    uint32_t cos;    // Valid output channels of the tile
+} conv2d_implicit_gemm_step_t;
+
+// Input rows needed by a block of output rows
+static inline uint32_t conv2d_implicit_gemm_in_rows(
+    const conv2d_implicit_gemm_t *g, uint32_t rows) {
+    return (rows - 1) * g->S + (g->FH - 1) * g->D + 1;
+}
+
+static inline uint32_t conv2d_implicit_gemm_size(
+    const conv2d_implicit_gemm_t *g) {
+    uint32_t ifmap = conv2d_implicit_gemm_in_rows(g, g->TOH) * g->IW * g->CI;
+    uint32_t weights = g->TCO * g->K;
+    uint32_t ofmap = g->TOH * g->OW * g->TCO;
+    uint32_t pooled = 0;
+    if (g->PH * g->PW > 1) pooled = ofmap / (g->PH * g->PW);
+    return 2 * g->prec * (ifmap + weights + ofmap + pooled);
+}
+
+static inline void conv2d_implicit_gemm_step(const conv_layer *l,
+                                             const conv2d_implicit_gemm_t *g,
+                                             uint32_t i, uint32_t n_tiles,
+                                             conv2d_implicit_gemm_step_t *s) {
+    uint32_t block = i / (g->G * n_tiles);
+    s->slice = i / n_tiles;
+    s->group = s->slice % g->G;
+    s->tile = i % n_tiles;
+    s->oh0 = (snrt_cluster_idx() + block * snrt_cluster_num()) * g->TOH;
+    s->rows = min(g->TOH, g->OH - s->oh0);
+    s->co0 = s->group * g->CO + s->tile * g->TCO;
+    s->cos = min(g->TCO, g->CO - s->tile * g->TCO);
+}
+
+/**
+ * @brief Load the input channels of a group in the input rows needed by a
+ * block of output rows into a zero-padded TCDM buffer. Rows in the vertical
+ * padding are cleared, the horizontal and channel padding is never written.
+ */
+static inline void conv2d_implicit_gemm_load_ifmap(
+    const conv_layer *l, const conv2d_implicit_gemm_t *g,
+    const conv2d_implicit_gemm_step_t *s, void *ifmap) {
+    const uint32_t p = g->prec;
+    const uint32_t row_size = g->IW * g->CI * p;
+    const uint32_t ci = l->CI / g->G;
+
+    for (uint32_t r = 0; r < conv2d_implicit_gemm_in_rows(g, s->rows); r++) {
+        int32_t ih = (int32_t)(s->oh0 * g->S + r) - (int32_t)l->pad;
+        void *dst = ifmap + r * row_size;
+
+        if (ih < 0 || ih >= (int32_t)l->IH) {
+            snrt_dma_memset(dst, 0, row_size);
+            continue;
+        }
+
+        dst += l->pad * g->CI * p;
+        void *src =
+            (void *)l->ifmap + (ih * l->IW * l->CI + s->group * ci) * p;
+        if (g->CI == ci && ci == l->CI) {
+            snrt_dma_start_1d(dst, src, l->IW * l->CI * p);
+        } else {
+            snrt_dma_start_2d(dst,       /* dst */
+                              src,       /* src */
+                              ci * p,    /* size */
+                              g->CI * p, /* dst_stride */
+                              l->CI * p, /* src_stride */
+                              l->IW);    /* repetitions */
+        }
+    }
+}
+
+/**
+ * @brief Load a tile of weights in CO x FH x FW x (CI / groups) format. Every
+ * output channel is a column of the column-major B operand of the GEMM
+ * kernels.
+ */
+static inline void conv2d_implicit_gemm_load_weights(
+    const conv_layer *l, const conv2d_implicit_gemm_t *g,
+    const conv2d_implicit_gemm_step_t *s, void *weights) {
+    const uint32_t p = g->prec;
+    const uint32_t ci = l->CI / g->G;
+    void *src = (void *)l->weights + s->co0 * l->FH * l->FW * ci * p;
+
+    if (g->CI == ci) {
+        snrt_dma_start_1d(weights, src, s->cos * g->K * p);
+    } else {
+        snrt_dma_start_2d(weights,                 /* dst */
+                          src,                     /* src */
+                          ci * p,                  /* size */
+                          g->CI * p,               /* dst_stride */
+                          ci * p,                  /* src_stride */
+                          s->cos * l->FH * l->FW); /* repetitions */
+    }
+}
+
+/**
+ * @brief Write back an output tile. With pooling, the tile holds the pooled
+ * pixels and the output feature map is (OH / PH) x (OW / PW) x CO.
+ */
+static inline void conv2d_implicit_gemm_store_ofmap(
+    const conv_layer *l, const conv2d_implicit_gemm_t *g,
+    const conv2d_implicit_gemm_step_t *s, void *ofmap) {
+    const uint32_t p = g->prec;
+    const uint32_t ow = g->OW / g->PW;
+    const uint32_t oh0 = s->oh0 / g->PH;
+    void *dst = (void *)l->ofmap + (oh0 * ow * l->CO + s->co0) * p;
+
+    snrt_dma_start_2d(dst,                        /* dst */
+                      ofmap,                      /* src */
+                      s->cos * p,                 /* size */
+                      l->CO * p,                  /* dst_stride */
+                      g->TCO * p,                 /* src_stride */
+                      (s->rows / g->PH) * ow);    /* repetitions */
+}
+
+// Apply the folded BatchNorm, ReLU and max pooling to the pixels
+// [ow0, ow0 + m) of the rows [r0, r0 + PH) of an output tile. Every output
+// channel is scaled before the ReLU and the maximum, as kappa can be negative.
+#define CONV2D_EPILOGUE(type, acc_t, g, s, tile, out, r0, ow0, m)             \
+    do {                                                                      \
+        type *_in = (type *)(tile);                                           \
+        type *_out = (type *)(out);                                           \
+        type *_kappa = (type *)(g)->kappa + (s)->co0;                         \
+        type *_lambda = (type *)(g)->lambda + (s)->co0;                       \
+        uint32_t _ow = (g)->OW / (g)->PW;                                     \
+        uint32_t _oh = (r0) / (g)->PH;                                        \
+        for (uint32_t x = (ow0) / (g)->PW; x < ((ow0) + (m)) / (g)->PW;      \
+             x++) {                                                           \
+            for (uint32_t co = 0; co < (s)->cos; co++) {                      \
+                acc_t res = 0;                                                \
+                for (uint32_t ph = 0; ph < (g)->PH; ph++) {                   \
+                    for (uint32_t pw = 0; pw < (g)->PW; pw++) {               \
+                        uint32_t pix =                                        \
+                            ((r0) + ph) * (g)->OW + x * (g)->PW + pw;         \
+                        acc_t v = _in[pix * (g)->TCO + co];                   \
+                        if ((g)->kappa) v = v * _kappa[co] + _lambda[co];     \
+                        if ((g)->relu && v < 0) v = 0;                        \
+                        if ((ph | pw) == 0 || v > res) res = v;               \
+                    }                                                         \
+                }                                                             \
+                _out[(_oh * _ow + x) * (g)->TCO + co] = res;                  \
+            }                                                                 \
+        }                                                                     \
+    } while (0)
+
+static inline void conv2d_implicit_gemm_epilogue(
+    const conv2d_implicit_gemm_t *g, const conv2d_implicit_gemm_step_t *s,
+    void *tile, void *out, uint32_t r0, uint32_t ow0, uint32_t m) {
+    switch (g->prec) {
+        case FP64:
+            CONV2D_EPILOGUE(double, double, g, s, tile, out, r0, ow0, m);
+            break;
+        case FP32:
+            CONV2D_EPILOGUE(float, float, g, s, tile, out, r0, ow0, m);
+            break;
+        case FP16:
+            CONV2D_EPILOGUE(__fp16, float, g, s, tile, out, r0, ow0, m);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Configure the SSRs of the optimized GEMM kernels for M output pixels
+ * of a row. Instead of reading an im2col matrix, SSR0 walks the patch of every
+ * pixel directly in the input feature map: FH runs of FW * CI contiguous
+ * elements, D padded input rows apart. Consecutive pixels are S * CI elements
+ * apart. SSR1 reads the weights like the column-major B of the kernels.
+ *
+ * With dilation, the FW taps of a run are not contiguous and SSR0 needs a
+ * loop over them, which leaves no loop for the N / GEMM_UNROLL blocks of
+ * output channels. The kernels are then called once per block, so N must be
+ * GEMM_UNROLL.
+ */
+static inline void conv2d_implicit_gemm_ssr(const conv2d_implicit_gemm_t *g,
+                                            uint32_t M, uint32_t N) {
+    const uint32_t unroll = GEMM_UNROLL;
+    const uint32_t p = g->prec;
+    const uint32_t align = gemm_kernel_k_align(p);
+    const uint32_t words = g->K / align;
+
+    if (g->D == 1 || g->FW == 1) {
+        snrt_ssr_loop_4d(SNRT_SSR_DM0, g->FW * g->CI / align, g->FH,
+                         N / unroll, M, sizeof(double),
+                         g->D * g->IW * g->CI * p, 0, g->S * g->CI * p);
+    } else {
+        snrt_ssr_loop_4d(SNRT_SSR_DM0, g->CI / align, g->FW, g->FH, M,
+                         sizeof(double), g->D * g->CI * p,
+                         g->D * g->IW * g->CI * p, g->S * g->CI * p);
+    }
+    snrt_ssr_repeat(SNRT_SSR_DM0, unroll);
+
+    snrt_ssr_loop_4d(SNRT_SSR_DM1, unroll, words, N / unroll, M, g->K * p,
+                     sizeof(double), unroll * g->K * p, 0);
+    snrt_ssr_repeat(SNRT_SSR_DM1, 1);
+}
+
+/**
+ * @brief Compute one step on the compute cores. Groups of PH output rows are
+ * distributed across cores, groups are split into chunks of pixels if there
+ * are fewer groups than cores. Every core applies the epilogue to the pixels
+ * it computed, so no synchronization is needed in between.
+ */
+static inline void conv2d_implicit_gemm_compute(
+    const conv2d_implicit_gemm_t *g, const conv2d_implicit_gemm_step_t *s,
+    void *ifmap, void *weights, void *ofmap, void *pooled) {
+    const uint32_t compute_num = snrt_cluster_compute_core_num();
+    const uint32_t compute_id = snrt_cluster_core_idx();
+    const uint32_t p = g->prec;
+    const uint32_t epilogue = g->kappa || g->relu || pooled;
+
+    const uint32_t groups = s->rows / g->PH;
+    const uint32_t chunks = max(1, compute_num / groups);
+    const uint32_t chunk_ow =
+        gemm_round_up((g->OW + chunks - 1) / chunks, g->PW);
+    const uint32_t n = gemm_round_up(s->cos, GEMM_UNROLL);
+
+    for (uint32_t j = compute_id; j < groups * chunks; j += compute_num) {
+        uint32_t r0 = (j / chunks) * g->PH;
+        uint32_t ow0 = (j % chunks) * chunk_ow;
+        if (ow0 >= g->OW) continue;
+        uint32_t m = min(chunk_ow, g->OW - ow0);
+
+        for (uint32_t r = r0; r < r0 + g->PH; r++) {
+            void *a = ifmap + (r * g->IW + ow0) * g->S * g->CI * p;
+            void *c = ofmap + (r * g->OW + ow0) * g->TCO * p;
+
+            // FP16 accumulates in FP32 to keep long reductions accurate
+            if (g->D == 1 || g->FW == 1) {
+                conv2d_implicit_gemm_ssr(g, m, n);
+                gemm_opt(p, p == FP16, 0, 0, 1, m, n, g->K, a, g->CI,
+                         weights, g->K, 0, c, g->TCO);
+                continue;
+            }
+
+            conv2d_implicit_gemm_ssr(g, m, GEMM_UNROLL);
+            for (uint32_t n0 = 0; n0 < n; n0 += GEMM_UNROLL) {
+                gemm_opt(p, p == FP16, 0, 0, 1, m, GEMM_UNROLL, g->K, a,
+                         g->CI, weights + n0 * g->K * p, g->K, 0,
+                         c + n0 * p, g->TCO);
+            }
+        }
+
+        if (epilogue)
+            conv2d_implicit_gemm_epilogue(g, s, ofmap,
+                                          pooled ? pooled : ofmap, r0, ow0, m);
+    }
+}
+
+/**
+ * @brief conv2d layer computed as an implicit GEMM with the optimized GEMM
+ * kernels, optionally followed by an epilogue. No im2col matrix is built: the
+ * SSRs stream the patches straight out of a zero-padded block of input rows
+ * in TCDM. Blocks of output rows are distributed across clusters. Within a
+ * cluster, the DMA core prefetches the next input block and weight tile and
+ * writes back the previous output tile while the compute cores work on the
+ * current one. The epilogue is applied before the write back, so the feature
+ * map between the fused operations never leaves TCDM.
+ *
+ * Supports FP64, FP32 and FP16 layers with any stride, dilation and number of
+ * groups, in HWC layout with weights in CO x FH x FW x (CI / groups) format.
+ * Groups are computed one after the other, each with its own slice of the
+ * input channels, so the weight tiles stay dense. Depthwise layers are better
+ * served by conv2d_dw_layer().
+ *
+ * @param l conv_layer struct that holds addresses and parameters
+ * @param e epilogue, or NULL for a plain convolution
+ * @return 0 on success, -1 if the layer is not supported or a single group
+ * of output rows does not fit into TCDM
+ */
+static inline int conv2d_implicit_gemm_run(const conv_layer *l,
+                                           const conv2d_epilogue_t *e) {
+    const precision_t prec = l->dtype;
+    conv2d_implicit_gemm_t g;
+
+    if (prec != FP64 && prec != FP32 && prec != FP16) return -1;
+    if (!conv2d_valid(l)) return -1;
+
+    // Pad the input channels such that every pixel starts on an SSR word, and
+    // such that K reaches the minimum supported by the kernels
+    const uint32_t align = gemm_kernel_k_align(prec);
+    g.prec = prec;
+    g.G = conv2d_groups(l);
+    g.CI = gemm_round_up(l->CI / g.G, align);
+    while (l->FH * l->FW * g.CI < gemm_kernel_k_min(prec)) g.CI += align;
+    g.CO = l->CO / g.G;
+    g.K = l->FH * l->FW * g.CI;
+    g.IW = l->IW + 2 * l->pad;
+    g.FH = l->FH;
+    g.FW = l->FW;
+    g.S = conv2d_stride(l);
+    g.D = conv2d_dilation(l);
+    g.PH = (e && e->PH > 1) ? e->PH : 1;
+    g.PW = (e && e->PW > 1) ? e->PW : 1;
+    g.relu = e && e->relu;
+    g.kappa = NULL;
+    g.lambda = NULL;
+
+    // Pixels which are not covered by a pooling window are not computed
+    g.OH = l->OH - l->OH % g.PH;
+    g.OW = l->OW - l->OW % g.PW;
+    if (g.OH == 0 || g.OW == 0) return 0;
+    g.TOH = g.OH;
+    g.TCO = gemm_round_up(g.CO, GEMM_UNROLL);
+
+    // Carve the buffers out of the free TCDM space, shrinking the larger of
+    // the two output tile dimensions first
+    const uint32_t size_bn = (e && e->kappa) ? ALIGN_UP(l->CO * prec, 8) : 0;
+    uint32_t l1_base = ALIGN_UP((uint32_t)snrt_l1_next(), 8);
+    uint32_t l1_end = snrt_l1_end_addr() - GEMM_TILED_L1_RESERVE;
+    if (l1_base + 2 * size_bn >= l1_end) return -1;
+    while (conv2d_implicit_gemm_size(&g) > l1_end - l1_base - 2 * size_bn) {
+        if (g.TOH > g.PH && (g.TOH * g.OW >= g.TCO || g.TCO == GEMM_UNROLL))
+            g.TOH = gemm_round_up((g.TOH + 1) / 2, g.PH);
+        else if (g.TCO > GEMM_UNROLL)
+            g.TCO = gemm_round_up(g.TCO / 2, GEMM_UNROLL);
+        else
+            return -1;
+    }
+
+    uint32_t size_ifmap =
+        conv2d_implicit_gemm_in_rows(&g, g.TOH) * g.IW * g.CI * prec;
+    uint32_t size_weights = g.TCO * g.K * prec;
+    uint32_t size_ofmap = g.TOH * g.OW * g.TCO * prec;
+    uint32_t size_pooled = size_ofmap / (g.PH * g.PW);
+    void *ifmap[2], *weights[2], *ofmap[2], *pooled[2] = {NULL, NULL};
+    ifmap[0] = (void *)l1_base;
+    ifmap[1] = ifmap[0] + size_ifmap;
+    weights[0] = ifmap[1] + size_ifmap;
+    weights[1] = weights[0] + size_weights;
+    ofmap[0] = weights[1] + size_weights;
+    ofmap[1] = ofmap[0] + size_ofmap;
+    void *ptr = ofmap[1] + size_ofmap;
+    if (g.PH * g.PW > 1) {
+        pooled[0] = ptr;
+        pooled[1] = pooled[0] + size_pooled;
+        ptr = pooled[1] + size_pooled;
+    }
+    if (size_bn) {
+        g.kappa = ptr;
+        g.lambda = g.kappa + size_bn;
+    }
+
+    // Blocks of output rows are distributed across clusters, every cluster
+    // computes all groups of its blocks. A single weight tile stays resident
+    // in its buffer for the whole layer.
+    const uint32_t cluster_num = snrt_cluster_num();
+    const uint32_t cluster_id = snrt_cluster_idx();
+    const uint32_t n_blocks = (g.OH + g.TOH - 1) / g.TOH;
+    const uint32_t n_tiles = (g.CO + g.TCO - 1) / g.TCO;
+    const uint32_t n_weights = g.G * n_tiles;
+    if (n_blocks <= cluster_id) return 0;
+    const uint32_t n_steps =
+        ((n_blocks - cluster_id + cluster_num - 1) / cluster_num) * n_weights;
+
+    conv2d_implicit_gemm_step_t s, next;
+
+    if (snrt_is_dm_core()) {
+        // Clear the padding once, input transfers never overwrite it
+        snrt_dma_memset(ifmap[0], 0, 2 * (size_ifmap + size_weights));
+
+        if (size_bn) {
+            snrt_dma_start_1d(g.kappa, e->kappa, l->CO * prec);
+            snrt_dma_start_1d(g.lambda, e->lambda, l->CO * prec);
+        }
+
+        conv2d_implicit_gemm_step(l, &g, 0, n_tiles, &s);
+        conv2d_implicit_gemm_load_ifmap(l, &g, &s, ifmap[0]);
+        conv2d_implicit_gemm_load_weights(l, &g, &s, weights[0]);
+        snrt_dma_wait_all();
+    }
+
+    snrt_cluster_hw_barrier();
+
+    // Output tiles are written back from the pooled buffers if pooling is
+    // enabled
+    void **out = pooled[0] ? pooled : ofmap;
+
+    for (uint32_t i = 0; i < n_steps; i++) {
+        conv2d_implicit_gemm_step(l, &g, i, n_tiles, &s);
+
+        if (snrt_is_dm_core()) {
+            // Prefetch the inputs of the next step
+            if (i + 1 < n_steps) {
+                conv2d_implicit_gemm_step(l, &g, i + 1, n_tiles, &next);
+                if (next.tile == 0)
+                    conv2d_implicit_gemm_load_ifmap(l, &g, &next,
+                                                    ifmap[next.slice % 2]);
+                if (n_weights > 1)
+                    conv2d_implicit_gemm_load_weights(l, &g, &next,
+                                                      weights[(i + 1) % 2]);
+            }
+
+            // Write back the output tile of the previous step
+            if (i > 0) {
+                conv2d_implicit_gemm_step(l, &g, i - 1, n_tiles, &next);
+                conv2d_implicit_gemm_store_ofmap(l, &g, &next,
+                                                 out[(i - 1) % 2]);
+            }
+
+            snrt_dma_wait_all();
+        } else {
+            conv2d_implicit_gemm_compute(&g, &s, ifmap[s.slice % 2],
+                                         weights[n_weights > 1 ? i % 2 : 0],
+                                         ofmap[i % 2], pooled[i % 2]);
+        }
+
+        snrt_cluster_hw_barrier();
+    }
+
+    // Write back the last output tile
+    if (snrt_is_dm_core()) {
+        conv2d_implicit_gemm_store_ofmap(l, &g, &s, out[(n_steps - 1) % 2]);
+        snrt_dma_wait_all();
+    }
+
+    return 0;
+}
+
+/**
+ * @brief conv2d layer computed as an implicit GEMM, see
+ * conv2d_implicit_gemm_run()
+ *
+ * @param l conv_layer struct that holds addresses and parameters
+ * @return 0 on success, -1 if the layer is not supported or a single output
+ * row does not fit into TCDM
+ */
+int conv2d_implicit_gemm_layer(const conv_layer *l) {
+    return conv2d_implicit_gemm_run(l, NULL);
+}
+
+/**
+ * @struct conv2d_dw_t
+ * @brief Geometry of the depthwise convolution in TCDM
+ *
+ * @var conv2d_dw_t::IW
+ * Width of the zero-padded input rows
+ * @var conv2d_dw_t::OW
+ * Computed output columns, a multiple of CONV2D_DW_UNROLL
+ * @var conv2d_dw_t::TOH
+ * Output rows per block
+ * @var conv2d_dw_t::TC
+ * Channels per tile, such that every pixel fills whole SSR words
+ * @var conv2d_dw_t::S
+ * Stride in both directions
+ * @var conv2d_dw_t::D
+ * Dilation in both directions
+ * @var conv2d_dw_t::fp32_kernel
+ * Flag for computing the tiles with conv2d_dw_fp32()
+ */
+typedef struct {
+    precision_t prec;
+    uint32_t IW;
+    uint32_t OW;
+    uint32_t FH;
+    uint32_t FW;
+    uint32_t TOH;
+    uint32_t TC;
+    uint32_t S;
+    uint32_t D;
+    uint32_t fp32_kernel;
+} conv2d_dw_t;
+
+// Step of the depthwise convolution, i.e. one tile of channels of one block
+// of output rows
+typedef struct {
+    uint32_t oh0;   // First output row of the block
+    uint32_t rows;  // Valid output rows of the block
+    uint32_t c0;    // First channel of the tile
+    uint32_t cs;    // Valid channels of the tile
+} conv2d_dw_step_t;
+
+// Output pixels computed at once by conv2d_dw_ssr()
+#define CONV2D_DW_UNROLL 4
+
+// Input rows needed by a block of output rows
+static inline uint32_t conv2d_dw_in_rows(const conv2d_dw_t *d, uint32_t rows) {
+    return (rows - 1) * d->S + (d->FH - 1) * d->D + 1;
+}
+
+static inline uint32_t conv2d_dw_size(const conv2d_dw_t *d) {
+    uint32_t ifmap = conv2d_dw_in_rows(d, d->TOH) * d->IW * d->TC;
+    uint32_t weights = d->FH * d->FW * d->TC;
+    uint32_t ofmap = d->TOH * d->OW * d->TC;
+    // A single staging buffer for the weights as stored in memory
+    return d->prec * (2 * (ifmap + weights + ofmap) + weights);
+}
+
+// The tiles of all blocks are distributed across clusters, consecutive
+// units of work share the channel tile
+static inline void conv2d_dw_step(const conv_layer *l, const conv2d_dw_t *d,
+                                  uint32_t i, uint32_t n_blocks,
+                                  conv2d_dw_step_t *s) {
+    uint32_t u = snrt_cluster_idx() + i * snrt_cluster_num();
+    s->oh0 = (u % n_blocks) * d->TOH;
+    s->rows = min(d->TOH, l->OH - s->oh0);
+    s->c0 = (u / n_blocks) * d->TC;
+    s->cs = min(d->TC, l->CO - s->c0);
+}
+
+/**
+ * @brief Load the channels of a tile in the input rows needed by a block of
+ * output rows into a zero-padded TCDM buffer. Rows in the vertical padding
+ * are cleared, the horizontal padding is never written.
+ */
+static inline void conv2d_dw_load_ifmap(const conv_layer *l,
+                                        const conv2d_dw_t *d,
+                                        const conv2d_dw_step_t *s,
+                                        void *ifmap) {
+    const uint32_t p = d->prec;
+    const uint32_t row_size = d->IW * d->TC * p;
+
+    for (uint32_t r = 0; r < conv2d_dw_in_rows(d, s->rows); r++) {
+        int32_t ih = (int32_t)(s->oh0 * d->S + r) - (int32_t)l->pad;
+        void *dst = ifmap + r * row_size;
+
+        if (ih < 0 || ih >= (int32_t)l->IH) {
+            snrt_dma_memset(dst, 0, row_size);
+            continue;
+        }
+
+        dst += l->pad * d->TC * p;
+        void *src = (void *)l->ifmap + (ih * l->IW * l->CI + s->c0) * p;
+        if (d->TC == l->CI) {
+            snrt_dma_start_1d(dst, src, l->IW * l->CI * p);
+        } else {
+            snrt_dma_start_2d(dst,       /* dst */
+                              src,       /* src */
+                              s->cs * p, /* size */
+                              d->TC * p, /* dst_stride */
+                              l->CI * p, /* src_stride */
+                              l->IW);    /* repetitions */
+        }
+    }
+}
+
+/**
+ * @brief Load the channels of a tile of the weights, which are stored in
+ * C x FH x FW format, with a single transfer into a staging buffer, and
+ * transpose them to FH x FW x C on the DMA core, such that the channels of a
+ * tap fill whole SSR words. Channels beyond the layer are not written.
+ */
+static inline void conv2d_dw_load_weights(const conv_layer *l,
+                                          const conv2d_dw_t *d,
+                                          const conv2d_dw_step_t *s,
+                                          void *staging, void *weights) {
+    const uint32_t p = d->prec;
+    const uint32_t taps = d->FH * d->FW;
+
+    snrt_dma_txid_t txid =
+        snrt_dma_start_1d(staging, (void *)l->weights + s->c0 * taps * p,
+                          s->cs * taps * p);
+    snrt_dma_wait(txid);
+
+    for (uint32_t c = 0; c < s->cs; c++) {
+        for (uint32_t t = 0; t < taps; t++) {
+            uint32_t src = c * taps + t;
+            uint32_t dst = t * d->TC + c;
+            switch (p) {
+                case FP64:
+                    ((uint64_t *)weights)[dst] = ((uint64_t *)staging)[src];
+                    break;
+                case FP32:
+                    ((uint32_t *)weights)[dst] = ((uint32_t *)staging)[src];
+                    break;
+                default:
+                    ((uint16_t *)weights)[dst] = ((uint16_t *)staging)[src];
+                    break;
+            }
+        }
+    }
+}
+
+// Write back an output tile, row by row as the tile may hold more columns
+static inline void conv2d_dw_store_ofmap(const conv_layer *l,
+                                         const conv2d_dw_t *d,
+                                         const conv2d_dw_step_t *s,
+                                         void *ofmap) {
+    const uint32_t p = d->prec;
+
+    for (uint32_t r = 0; r < s->rows; r++) {
+        void *dst =
+            (void *)l->ofmap + ((s->oh0 + r) * l->OW * l->CO + s->c0) * p;
+        snrt_dma_start_2d(dst,                         /* dst */
+                          ofmap + r * d->OW * d->TC * p, /* src */
+                          s->cs * p,                   /* size */
+                          l->CO * p,                   /* dst_stride */
+                          d->TC * p,                   /* src_stride */
+                          l->OW);                      /* repetitions */
+    }
+}
+
+/**
+ * @brief Depthwise convolution of a tile in TCDM for any precision, stride
+ * and dilation. Every SSR word holds 8 / prec channels, which are computed
+ * together with the SIMD FMAs. Rows of words are distributed across the
+ * compute cores. SSR0 streams the taps of CONV2D_DW_UNROLL consecutive output
+ * pixels, SSR1 repeats every weight once per pixel, such that the FMAs of an
+ * iteration are independent.
+ */
+static inline void conv2d_dw_ssr(const conv2d_dw_t *d, uint32_t rows,
+                                 void *ifmap, void *weights, void *ofmap) {
+    const uint32_t compute_num = snrt_cluster_compute_core_num();
+    const uint32_t compute_id = snrt_cluster_core_idx();
+    const uint32_t unroll = CONV2D_DW_UNROLL;
+    const uint32_t pixel = d->TC * d->prec;
+    const uint32_t words = pixel / sizeof(double);
+    const uint32_t n_frep = d->FH * d->FW - 1;
+
+    snrt_ssr_loop_4d(SNRT_SSR_DM0, unroll, d->FW, d->FH, d->OW / unroll,
+                     d->S * pixel, d->D * pixel, d->D * d->IW * pixel,
+                     unroll * d->S * pixel);
+    snrt_ssr_repeat(SNRT_SSR_DM0, 1);
+    snrt_ssr_loop_3d(SNRT_SSR_DM1, d->FW, d->FH, d->OW / unroll, pixel,
+                     d->FW * pixel, 0);
+    snrt_ssr_repeat(SNRT_SSR_DM1, unroll);
+
+    for (uint32_t j = compute_id; j < rows * words; j += compute_num) {
+        uint32_t r = j / words;
+        uint32_t w = j % words;
+        double *out = (double *)(ofmap + r * d->OW * pixel) + w;
+
+        snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_4D,
+                      ifmap + r * d->S * d->IW * pixel + w * sizeof(double));
+        snrt_ssr_read(SNRT_SSR_DM1, SNRT_SSR_3D,
+                      weights + w * sizeof(double));
+
+        for (uint32_t x = 0; x < d->OW; x += unroll) {
+            // The all-zero pattern is a zero in every SIMD lane
+            double c[CONV2D_DW_UNROLL] = {0.0, 0.0, 0.0, 0.0};
+
+            snrt_ssr_enable();
+
+            switch (d->prec) {
+                case FP64:
+                    asm volatile(
+                        "frep.o %[n_frep], 4, 0, 0 \n"
+                        "fmadd.d %[c0], ft0, ft1, %[c0] \n"
+                        "fmadd.d %[c1], ft0, ft1, %[c1] \n"
+                        "fmadd.d %[c2], ft0, ft1, %[c2] \n"
+                        "fmadd.d %[c3], ft0, ft1, %[c3] \n"
+                        : [ c0 ] "+f"(c[0]), [ c1 ] "+f"(c[1]),
+                          [ c2 ] "+f"(c[2]), [ c3 ] "+f"(c[3])
+                        : [ n_frep ] "r"(n_frep)
+                        : "ft0", "ft1", "ft2");
+                    break;
+                case FP32:
+                    asm volatile(
+                        "frep.o %[n_frep], 4, 0, 0 \n"
+                        "vfmac.s %[c0], ft0, ft1 \n"
+                        "vfmac.s %[c1], ft0, ft1 \n"
+                        "vfmac.s %[c2], ft0, ft1 \n"
+                        "vfmac.s %[c3], ft0, ft1 \n"
+                        : [ c0 ] "+f"(c[0]), [ c1 ] "+f"(c[1]),
+                          [ c2 ] "+f"(c[2]), [ c3 ] "+f"(c[3])
+                        : [ n_frep ] "r"(n_frep)
+                        : "ft0", "ft1", "ft2");
+                    break;
+                case FP16:
+                    asm volatile(
+                        "frep.o %[n_frep], 4, 0, 0 \n"
+                        "vfmac.h %[c0], ft0, ft1 \n"
+                        "vfmac.h %[c1], ft0, ft1 \n"
+                        "vfmac.h %[c2], ft0, ft1 \n"
+                        "vfmac.h %[c3], ft0, ft1 \n"
+                        : [ c0 ] "+f"(c[0]), [ c1 ] "+f"(c[1]),
+                          [ c2 ] "+f"(c[2]), [ c3 ] "+f"(c[3])
+                        : [ n_frep ] "r"(n_frep)
+                        : "ft0", "ft1", "ft2");
+                    break;
+                default:
+                    break;
+            }
+
+            snrt_fpu_fence();
+            snrt_ssr_disable();
+
+            for (uint32_t u = 0; u < unroll; u++) out[(x + u) * words] = c[u];
+        }
+    }
+}
+
+/**
+ * @brief Compute one step on the compute cores. FP32 layers without dilation
+ * use conv2d_dw_fp32(), which synchronizes the compute cores once.
+ */
+static inline void conv2d_dw_compute(const conv2d_dw_t *d,
+                                     const conv2d_dw_step_t *s, void *ifmap,
+                                     void *weights, void *ofmap) {
+    if (!d->fp32_kernel) {
+        conv2d_dw_ssr(d, s->rows, ifmap, weights, ofmap);
+        return;
+    }
+
+    // The kernel relies on the default repetition of SSR0
+    snrt_ssr_repeat(SNRT_SSR_DM0, 1);
+
+    kernel_fp32 k = {0};
+    k.pInBuffer = (float *)ifmap;
+    k.dim_in_x = d->IW;
+    k.dim_in_y = conv2d_dw_in_rows(d, s->rows);
+    k.ch_in = d->TC;
+    k.pWeight = (float *)weights;
+    k.ch_out = d->TC;
+    k.dim_kernel_x = d->FW;
+    k.dim_kernel_y = d->FH;
+    k.stride_x = d->S;
+    k.stride_y = d->S;
+    k.pOutBuffer = (float *)ofmap;
+    k.dim_out_x = d->OW;
+    k.dim_out_y = s->rows;
+    k.flag_y_accumulate_start = 1;
+    conv2d_dw_fp32(&k);
+}
+
+/**
+ * @brief Depthwise conv2d layer, i.e. groups == CI == CO, in HWC layout with
+ * weights in C x FH x FW format. The layer is split into tiles of channels of
+ * blocks of output rows, which are distributed across clusters. Within a
+ * cluster, the DMA core prefetches the zero-padded input rows of the next
+ * tile and writes back the previous output tile while the compute cores work
+ * on the current one. The weights are only loaded and transposed when the
+ * channel tile changes, into the buffer the compute cores do not read.
+ *
+ * Supports FP64, FP32 and FP16 layers with any stride and dilation.
+ *
+ * @param l conv_layer struct that holds addresses and parameters
+ * @return 0 on success, -1 if the layer is not supported or a single output
+ * row of a tile does not fit into TCDM
+ */
+int conv2d_dw_layer(const conv_layer *l) {
+    const precision_t prec = l->dtype;
+    conv2d_dw_t d;
+
+    if (prec != FP64 && prec != FP32 && prec != FP16) return -1;
+    if (!conv2d_is_depthwise(l) || !conv2d_valid(l)) return -1;
+
+    // Pad the channels such that every pixel fills whole SSR words, and the
+    // rows such that every row is a multiple of the unrolling
+    const uint32_t lanes = sizeof(double) / prec;
+    const uint32_t cluster_num = snrt_cluster_num();
+    d.prec = prec;
+    d.FH = l->FH;
+    d.FW = l->FW;
+    d.S = conv2d_stride(l);
+    d.D = conv2d_dilation(l);
+    d.OW = gemm_round_up(l->OW, CONV2D_DW_UNROLL);
+    d.IW = max(l->IW + 2 * l->pad, (d.OW - 1) * d.S + (d.FW - 1) * d.D + 1);
+    d.TOH = (l->OH + cluster_num - 1) / cluster_num;
+    d.TC = gemm_round_up(l->CO, lanes);
+    d.fp32_kernel = prec == FP32 && d.D == 1;
+
+    // Carve the buffers out of the free TCDM space, shrinking the larger of
+    // the two tile dimensions first
+    uint32_t l1_base = ALIGN_UP((uint32_t)snrt_l1_next(), 8);
+    uint32_t l1_end = snrt_l1_end_addr() - GEMM_TILED_L1_RESERVE;
+    if (l1_base >= l1_end) return -1;
+    while (conv2d_dw_size(&d) > l1_end - l1_base) {
+        if (d.TOH > 1 && (d.TOH * d.OW >= d.TC || d.TC == lanes))
+            d.TOH = (d.TOH + 1) / 2;
+        else if (d.TC > lanes)
+            d.TC = gemm_round_up(d.TC / 2, lanes);
+        else
+            return -1;
+    }
+
+    uint32_t size_ifmap = conv2d_dw_in_rows(&d, d.TOH) * d.IW * d.TC * prec;
+    uint32_t size_weights = d.FH * d.FW * d.TC * prec;
+    uint32_t size_ofmap = d.TOH * d.OW * d.TC * prec;
+    void *ifmap[2], *weights[2], *ofmap[2];
+    ifmap[0] = (void *)l1_base;
+    ifmap[1] = ifmap[0] + size_ifmap;
+    weights[0] = ifmap[1] + size_ifmap;
+    weights[1] = weights[0] + size_weights;
+    ofmap[0] = weights[1] + size_weights;
+    ofmap[1] = ofmap[0] + size_ofmap;
+    void *staging = ofmap[1] + size_ofmap;
+
+    const uint32_t cluster_id = snrt_cluster_idx();
+    const uint32_t n_blocks = (l->OH + d.TOH - 1) / d.TOH;
+    const uint32_t n_tiles = (l->CO + d.TC - 1) / d.TC;
+    const uint32_t n_units = n_blocks * n_tiles;
+    if (n_units <= cluster_id) return 0;
+    const uint32_t n_steps =
+        (n_units - cluster_id + cluster_num - 1) / cluster_num;
+
+    conv2d_dw_step_t s, next;
+
+    if (snrt_is_dm_core()) {
+        // Clear the padding once, input transfers never overwrite it
+        snrt_dma_memset(ifmap[0], 0, 2 * size_ifmap);
+
+        conv2d_dw_step(l, &d, 0, n_blocks, &s);
+        conv2d_dw_load_ifmap(l, &d, &s, ifmap[0]);
+        conv2d_dw_load_weights(l, &d, &s, staging, weights[0]);
+        snrt_dma_wait_all();
+    }
+
+    snrt_cluster_hw_barrier();
+
+    // Weight buffer of the current channel tile
+    uint32_t wb = 0;
+
+    for (uint32_t i = 0; i < n_steps; i++) {
+        conv2d_dw_step(l, &d, i, n_blocks, &s);
+
+        if (snrt_is_dm_core()) {
+            // Write back the output tile of the previous step
+            if (i > 0) {
+                conv2d_dw_step(l, &d, i - 1, n_blocks, &next);
+                conv2d_dw_store_ofmap(l, &d, &next, ofmap[(i - 1) % 2]);
+            }
+
+            // Prefetch the inputs of the next step, the weights last as
+            // they are transposed once they arrive
+            if (i + 1 < n_steps) {
+                conv2d_dw_step(l, &d, i + 1, n_blocks, &next);
+                conv2d_dw_load_ifmap(l, &d, &next, ifmap[(i + 1) % 2]);
+                if (next.c0 != s.c0)
+                    conv2d_dw_load_weights(l, &d, &next, staging,
+                                           weights[wb ^ 1]);
+            }
+
+            snrt_dma_wait_all();
+
+            // Match the synchronization within conv2d_dw_fp32()
+            if (d.fp32_kernel) snrt_cluster_hw_barrier();
+        } else {
+            conv2d_dw_compute(&d, &s, ifmap[i % 2], weights[wb],
+                              ofmap[i % 2]);
+        }
+
+        snrt_cluster_hw_barrier();
+
+        if (i + 1 < n_steps) {
+            conv2d_dw_step(l, &d, i + 1, n_blocks, &next);
+            if (next.c0 != s.c0) wb ^= 1;
+        }
+    }
+
+    // Write back the last output tile
+    if (snrt_is_dm_core()) {
+        conv2d_dw_store_ofmap(l, &d, &s, ofmap[(n_steps - 1) % 2]);
+        snrt_dma_wait_all();
+    }
+
+    return 0;
+}
+
+/**
+ * @brief conv2d layer. Depthwise layers are computed by conv2d_dw_layer(),
+ * all other layers, including grouped and pointwise ones, as an implicit
+ * GEMM. The explicit im2col path is used if requested, and serves as a
+ * fallback for FP64 layers the implicit GEMM does not support. It is limited
+ * to dense layers with unit stride and dilation.
+ *
+ * @param l conv_layer struct that holds addresses and parameters
+ * @return 0 on success, -1 if no implementation supports the layer, e.g.
+ * because a single group of output rows does not fit into TCDM
+ */
+int conv2d_layer(const conv_layer *l) {
+    const uint32_t im2col = l->dtype == FP64 && conv2d_groups(l) == 1 &&
+                            conv2d_stride(l) == 1 && conv2d_dilation(l) == 1;
+
+    if (conv2d_is_depthwise(l) && conv2d_dw_layer(l) == 0) return 0;
+
+    if (!(im2col && l->im2col) && conv2d_implicit_gemm_layer(l) == 0)
+        return 0;
+    if (!im2col) return -1;
+
+    conv2d_im2col_layer(l);
+    return 0;
+}
@@ -0,0 +1,110 @@
+// Copyright 2023 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "conv2d.h"
+#include "snrt.h"
+#include "utils.h"
+
+/**
+ * @struct conv2d_fused_layer_t
+ * @brief This structure contains all parameters necessary for a Conv2d layer
+ * which is fused with a BatchNorm, a ReLU and a max pooling layer. The output
+ * feature map of conv is the output of the whole block.
+ * @var conv2d_fused_layer_t::conv
+ * Parameters of the convolution
+ * @var conv2d_fused_layer_t::flag_batch_norm
+ * Flag for enabling the BatchNorm
+ * @var conv2d_fused_layer_t::flag_relu
+ * Flag for enabling ReLU
+ * @var conv2d_fused_layer_t::PH
+ * Height of the max pooling window and vertical stride, 0 or 1 disables
+ * pooling
+ * @var conv2d_fused_layer_t::PW
+ * Width of the max pooling window and horizontal stride
+ * @var conv2d_fused_layer_t::kappa
+ * Folded BatchNorm scale, CO elements in the layer precision
+ * @var conv2d_fused_layer_t::lambda
+ * Folded BatchNorm shift, CO elements in the layer precision
+ */
+typedef struct {
+    conv_layer conv;
+    uint32_t flag_batch_norm;
+    uint32_t flag_relu;
+    uint32_t PH;
+    uint32_t PW;
+    void *kappa;
+    void *lambda;
+} conv2d_fused_layer_t;
+
+/**
+ * @brief Fold the BatchNorm statistics into one scale and one shift per
+ * output channel, such that y = kappa * x + lambda. Has to be called once by
+ * a single core before the layer is run.
+ *
+ * @param l fused layer, kappa and lambda must point to CO elements each
+ * @param gamma BatchNorm scale
+ * @param beta BatchNorm shift
+ * @param mean running mean
+ * @param var running variance
+ * @param eps value added to the variance for numerical stability
+ */
+static inline void conv2d_fused_fold_bn(const conv2d_fused_layer_t *l,
+                                        const double *gamma,
+                                        const double *beta,
+                                        const double *mean, const double *var,
+                                        double eps) {
+    for (uint32_t co = 0; co < l->conv.CO; co++) {
+        // Refine the single precision estimate to double precision
+        double v = var[co] + eps;
+        double r = fast_rsqrtf(v);
+        r = r * (1.5 - 0.5 * v * r * r);
+        r = r * (1.5 - 0.5 * v * r * r);
+
+        double kappa = gamma[co] * r;
+        double lambda = beta[co] - mean[co] * kappa;
+
+        switch (l->conv.dtype) {
+            case FP64:
+                ((double *)l->kappa)[co] = kappa;
+                ((double *)l->lambda)[co] = lambda;
+                break;
+            case FP32:
+                ((float *)l->kappa)[co] = kappa;
+                ((float *)l->lambda)[co] = lambda;
+                break;
+            case FP16:
+                ((__fp16 *)l->kappa)[co] = kappa;
+                ((__fp16 *)l->lambda)[co] = lambda;
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+/**
+ * @brief Conv2d -> BatchNorm -> ReLU -> max pooling block. The convolution is
+ * computed with the implicit GEMM and the other operations are applied to
+ * every output tile while it is still resident in TCDM. The only DRAM
+ * traffic is one read of the input feature map and the weights, and one
+ * write of the pooled output feature map of size
+ * (OH / PH) x (OW / PW) x CO.
+ *
+ * @param l conv2d_fused_layer_t struct that holds addresses and parameters
+ * @return 0 on success, -1 if the layer is not supported or does not fit
+ * into TCDM
+ */
+static inline int conv2d_fused_layer(const conv2d_fused_layer_t *l) {
+    conv2d_epilogue_t e;
+
+    e.kappa = l->flag_batch_norm ? l->kappa : NULL;
+    e.lambda = l->flag_batch_norm ? l->lambda : NULL;
+    e.relu = l->flag_relu;
+    e.PH = l->PH;
+    e.PW = l->PW;
+
+    return conv2d_implicit_gemm_run(&l->conv, &e);
+}
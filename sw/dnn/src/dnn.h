@@ -200,10 +200,14 @@ typedef struct network_single_cluster_t_ {
 #include "conv2d.h"
 
 #include "batchnorm.h"
+#include "conv2d_fused.h"
 #include "gelu.h"
 #include "gemm.h"
 #include "layernorm.h"
 #include "linear.h"
 #include "maxpool.h"
+#include "pool.h"
+#include "quant.h"
 #include "softmax.h"
+#include "transformer.h"
 #include "utils.h"
@@ -7,6 +7,24 @@
 #include "math.h"
 #include "snrt.h"
 #include "utils.h"
+#include "vmath.h"
+
+/**
+ * @brief Available GELU implementations
+ *
+ * All implementations are streamed through the SSRs with packed SIMD.
+ *
+ * GELU_TANH: tanh formulation, with tanh from the vmath library
+ * GELU_SIGMOID: x * sigmoid(1.702 * x), as 0.5 * x * (1 + tanh(0.851 * x))
+ * GELU_LUT: linear interpolation in a table of the normal CDF
+ * GELU_POLY: clamped odd polynomial fit of the normal CDF
+ */
+typedef enum {
+    GELU_TANH = 0,
+    GELU_SIGMOID = 1,
+    GELU_LUT = 2,
+    GELU_POLY = 3
+} gelu_impl_t;
 
 /**
  * @struct gelu_layer_struct
@@ -18,115 +36,571 @@
  * Size of each output sample
  * @var gelu_layer_struct::HIDDEN_NODES
  * Number of hidden dimensions
+ * @var gelu_layer_struct::IMPL
+ * GELU implementation
  * @var gelu_layer_struct::ifmap
  * Pointer to input feature map
  * @var gelu_layer_struct::ofmap
- * Pointer to output feature map
+ * Pointer to output feature map, written back if not NULL
  * @var gelu_layer_struct::result
  * Pointer to the golden model output
+ * @var gelu_layer_struct::dtype
+ * Precision of the feature maps (FP32 or FP16)
  */
 typedef struct gelu_layer_struct {
     uint32_t BATCH_SIZE;
     uint32_t SEQ_LEN;
     uint32_t HIDDEN_NODES;
+    gelu_impl_t IMPL;
 
-    float *ifmap;
-    float *ofmap;
-    float *result;
+    void *ifmap;
+    void *ofmap;
+    void *result;
 
     precision_t dtype;
 } gelu_layer_t;
 
+// Sampling step of the GELU_LUT table is 1 / GELU_LUT_SCALE
+#define GELU_LUT_SCALE 16
+#define GELU_LUT_SIZE 65
+
+// Phi(x) - 0.5 for x = i / GELU_LUT_SCALE
+static const float gelu_lut[GELU_LUT_SIZE] = {
+    0.00000000f, 0.02491767f, 0.04973822f, 0.07436569f, 0.09870633f,
+    0.12266972f, 0.14616977f, 0.16912561f, 0.19146246f, 0.21311230f,
+    0.23401447f, 0.25411615f, 0.27337265f, 0.29174761f, 0.30921305f,
+    0.32574929f, 0.34134475f, 0.35599562f, 0.36970548f, 0.38248477f,
+    0.39435023f, 0.40532426f, 0.41543428f, 0.42471201f, 0.43319280f,
+    0.44091488f, 0.44791872f, 0.45424638f, 0.45994084f, 0.46504551f,
+    0.46960364f, 0.47365787f, 0.47724987f, 0.48041992f, 0.48320669f,
+    0.48564698f, 0.48777553f, 0.48962493f, 0.49122552f, 0.49260539f,
+    0.49379033f, 0.49480392f, 0.49566755f, 0.49640054f, 0.49702024f,
+    0.49754210f, 0.49797986f, 0.49834565f, 0.49865010f, 0.49890252f,
+    0.49911097f, 0.49928246f, 0.49942297f, 0.49953767f, 0.49963092f,
+    0.49970644f, 0.49976737f, 0.49981633f, 0.49985552f, 0.49988677f,
+    0.49991158f, 0.49993122f, 0.49994669f, 0.49995883f, 0.49996833f};
+
+// GELU_POLY clamps x / GELU_POLY_RANGE to [-1, 1] and evaluates
+// x * Phi(x) = z * (GELU_POLY_RANGE / 2 + z * p(z^2)), z = x / GELU_POLY_RANGE
+#define GELU_POLY_RANGE 3.4f
+static const float gelu_poly_coeffs[5] = {4.558304726e+00f, -8.004456821e+00f,
+                                          1.042387245e+01f, -7.497032450e+00f,
+                                          2.219312152e+00f};
+
+// Scalar GELU_POLY, evaluated like in the streamed kernels
+static inline float gelu_poly_scalar(float x) {
+    float z = x * (1.0f / GELU_POLY_RANGE);
+    float zc = z < -1.0f ? -1.0f : (z > 1.0f ? 1.0f : z);
+    float z2 = zc * zc;
+    float p = gelu_poly_coeffs[4];
+    p = p * z2 + gelu_poly_coeffs[3];
+    p = p * z2 + gelu_poly_coeffs[2];
+    p = p * z2 + gelu_poly_coeffs[1];
+    p = p * z2 + gelu_poly_coeffs[0];
+    return z * (p * zc + 0.5f * GELU_POLY_RANGE);
+}
+
 /**
- * Implementation of the GELU layer
+ * @brief GELU_POLY of a FP32 row
+ *
+ * Streams the row through SSR0 and writes the result through SSR1, two values
+ * per packed operation. The tail and unaligned rows fall back to
+ * gelu_poly_scalar.
  */
-static inline void gelu_fp32(float *input, float *output, int32_t ldI,
-                             uint32_t batch_size, uint32_t seq_len,
-                             uint32_t hidden_nodes) {
-    // uint32_t compute_id = snrt_cluster_compute_core_num();
-
-    for (int s = 0; s < seq_len; s++) {
-        for (int h = 0; h < hidden_nodes; h++) {
-            // if (compute_id == 1) {
-            //     printf("compute id: %d, input[%d][%d] = %f\n", compute_id, s,
-            //     h,
-            //         input[s * hidden_nodes + h]);
-            // }
-            float x = input[s * hidden_nodes + h];
-            float y =
-                0.5 * x *
-                (1.0 + tanh(sqrt(2.0 / M_PI) * (x + 0.044715 * x * x * x)));
-            output[s * hidden_nodes + h] = y;
-
-            // if (compute_id == 1) {
-            //     printf("compute id: %d, output[%d][%d] = %f\n", compute_id,
-            //     s, h,
-            //         output[s * hidden_nodes + h]);
-            // }
-        }
+static inline void gelu_poly_fp32(float *x, float *y, uint32_t len) {
+    uint32_t i = 0;
+    uint32_t n_vec =
+        (((uintptr_t)x | (uintptr_t)y) % sizeof(v2f32)) ? 0 : len / 2;
+
+    if (n_vec) {
+        const register float inv_range = 1.0f / GELU_POLY_RANGE;
+        const register float half_range = 0.5f * GELU_POLY_RANGE;
+        const register float one = 1.0f;
+        const register float minus_one = -1.0f;
+        v2f32 c[5], k[4], z, zc, z2, p;
+
+        snrt_ssr_loop_1d(SNRT_SSR_DM0, n_vec, sizeof(v2f32));
+        snrt_ssr_loop_1d(SNRT_SSR_DM1, n_vec, sizeof(v2f32));
+        snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_1D, x);
+        snrt_ssr_write(SNRT_SSR_DM1, SNRT_SSR_1D, y);
+        snrt_ssr_enable();
+
+        asm volatile(
+            "vfcpka.s.s %[c0], %[coeff0], %[coeff0] \n"
+            "vfcpka.s.s %[c1], %[coeff1], %[coeff1] \n"
+            "vfcpka.s.s %[c2], %[coeff2], %[coeff2] \n"
+            "vfcpka.s.s %[c3], %[coeff3], %[coeff3] \n"
+            "vfcpka.s.s %[c4], %[coeff4], %[coeff4] \n"
+            "vfcpka.s.s %[k0], %[inv_range], %[inv_range] \n"
+            "vfcpka.s.s %[k1], %[half_range], %[half_range] \n"
+            "vfcpka.s.s %[k2], %[one], %[one] \n"
+            "vfcpka.s.s %[k3], %[minus_one], %[minus_one] \n"
+            // 15 instructions, fits in the FREP sequencer buffer
+            "frep.o %[n_frep], 15, 0, 0 \n"
+            "vfmul.s %[z], ft0, %[k0] \n"
+            "vfmin.s %[zc], %[z], %[k2] \n"
+            "vfmax.s %[zc], %[zc], %[k3] \n"
+            "vfmul.s %[z2], %[zc], %[zc] \n"
+            "vfmul.s %[p], %[z2], %[c4] \n"
+            "vfadd.s %[p], %[p], %[c3] \n"
+            "vfmul.s %[p], %[p], %[z2] \n"
+            "vfadd.s %[p], %[p], %[c2] \n"
+            "vfmul.s %[p], %[p], %[z2] \n"
+            "vfadd.s %[p], %[p], %[c1] \n"
+            "vfmul.s %[p], %[p], %[z2] \n"
+            "vfadd.s %[p], %[p], %[c0] \n"
+            "vfmul.s %[p], %[p], %[zc] \n"
+            "vfadd.s %[p], %[p], %[k1] \n"
+            "vfmul.s ft1, %[p], %[z] \n"
+            : [ c0 ] "=&f"(c[0]), [ c1 ] "=&f"(c[1]), [ c2 ] "=&f"(c[2]),
+              [ c3 ] "=&f"(c[3]), [ c4 ] "=&f"(c[4]), [ k0 ] "=&f"(k[0]),
+              [ k1 ] "=&f"(k[1]), [ k2 ] "=&f"(k[2]), [ k3 ] "=&f"(k[3]),
+              [ z ] "=&f"(z), [ zc ] "=&f"(zc), [ z2 ] "=&f"(z2),
+              [ p ] "=&f"(p)
+            : [ coeff0 ] "f"(gelu_poly_coeffs[0]),
+              [ coeff1 ] "f"(gelu_poly_coeffs[1]),
+              [ coeff2 ] "f"(gelu_poly_coeffs[2]),
+              [ coeff3 ] "f"(gelu_poly_coeffs[3]),
+              [ coeff4 ] "f"(gelu_poly_coeffs[4]),
+              [ inv_range ] "f"(inv_range), [ half_range ] "f"(half_range),
+              [ one ] "f"(one), [ minus_one ] "f"(minus_one),
+              [ n_frep ] "r"(n_vec - 1)
+            : "ft0", "ft1", "ft2", "memory");
+
+        snrt_fpu_fence();
+        __builtin_ssr_barrier(SNRT_SSR_DM1);
+        snrt_ssr_disable();
+
+        i = n_vec * 2;
     }
+
+    for (; i < len; i++) y[i] = gelu_poly_scalar(x[i]);
 }
 
 /**
- * @brief  GELU layer
+ * @brief GELU_POLY of a FP16 row
  *
- * @param l gelu_layer struct that holds addresses and parameters
+ * Same as gelu_poly_fp32, with four values per packed operation.
+ */
+static inline void gelu_poly_fp16(__fp16 *x, __fp16 *y, uint32_t len) {
+    uint32_t i = 0;
+    uint32_t n_vec =
+        (((uintptr_t)x | (uintptr_t)y) % sizeof(v4f16)) ? 0 : len / 4;
+
+    if (n_vec) {
+        const register float inv_range = 1.0f / GELU_POLY_RANGE;
+        const register float half_range = 0.5f * GELU_POLY_RANGE;
+        const register float one = 1.0f;
+        const register float minus_one = -1.0f;
+        v4f16 c[5], k[4], z, zc, z2, p;
+
+        snrt_ssr_loop_1d(SNRT_SSR_DM0, n_vec, sizeof(v4f16));
+        snrt_ssr_loop_1d(SNRT_SSR_DM1, n_vec, sizeof(v4f16));
+        snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_1D, x);
+        snrt_ssr_write(SNRT_SSR_DM1, SNRT_SSR_1D, y);
+        snrt_ssr_enable();
+
+        asm volatile(
+            "vfcpka.h.s %[c0], %[coeff0], %[coeff0] \n"
+            "vfcpkb.h.s %[c0], %[coeff0], %[coeff0] \n"
+            "vfcpka.h.s %[c1], %[coeff1], %[coeff1] \n"
+            "vfcpkb.h.s %[c1], %[coeff1], %[coeff1] \n"
+            "vfcpka.h.s %[c2], %[coeff2], %[coeff2] \n"
+            "vfcpkb.h.s %[c2], %[coeff2], %[coeff2] \n"
+            "vfcpka.h.s %[c3], %[coeff3], %[coeff3] \n"
+            "vfcpkb.h.s %[c3], %[coeff3], %[coeff3] \n"
+            "vfcpka.h.s %[c4], %[coeff4], %[coeff4] \n"
+            "vfcpkb.h.s %[c4], %[coeff4], %[coeff4] \n"
+            "vfcpka.h.s %[k0], %[inv_range], %[inv_range] \n"
+            "vfcpkb.h.s %[k0], %[inv_range], %[inv_range] \n"
+            "vfcpka.h.s %[k1], %[half_range], %[half_range] \n"
+            "vfcpkb.h.s %[k1], %[half_range], %[half_range] \n"
+            "vfcpka.h.s %[k2], %[one], %[one] \n"
+            "vfcpkb.h.s %[k2], %[one], %[one] \n"
+            "vfcpka.h.s %[k3], %[minus_one], %[minus_one] \n"
+            "vfcpkb.h.s %[k3], %[minus_one], %[minus_one] \n"
+            "frep.o %[n_frep], 15, 0, 0 \n"
+            "vfmul.h %[z], ft0, %[k0] \n"
+            "vfmin.h %[zc], %[z], %[k2] \n"
+            "vfmax.h %[zc], %[zc], %[k3] \n"
+            "vfmul.h %[z2], %[zc], %[zc] \n"
+            "vfmul.h %[p], %[z2], %[c4] \n"
+            "vfadd.h %[p], %[p], %[c3] \n"
+            "vfmul.h %[p], %[p], %[z2] \n"
+            "vfadd.h %[p], %[p], %[c2] \n"
+            "vfmul.h %[p], %[p], %[z2] \n"
+            "vfadd.h %[p], %[p], %[c1] \n"
+            "vfmul.h %[p], %[p], %[z2] \n"
+            "vfadd.h %[p], %[p], %[c0] \n"
+            "vfmul.h %[p], %[p], %[zc] \n"
+            "vfadd.h %[p], %[p], %[k1] \n"
+            "vfmul.h ft1, %[p], %[z] \n"
+            : [ c0 ] "=&f"(c[0]), [ c1 ] "=&f"(c[1]), [ c2 ] "=&f"(c[2]),
+              [ c3 ] "=&f"(c[3]), [ c4 ] "=&f"(c[4]), [ k0 ] "=&f"(k[0]),
+              [ k1 ] "=&f"(k[1]), [ k2 ] "=&f"(k[2]), [ k3 ] "=&f"(k[3]),
+              [ z ] "=&f"(z), [ zc ] "=&f"(zc), [ z2 ] "=&f"(z2),
+              [ p ] "=&f"(p)
+            : [ coeff0 ] "f"(gelu_poly_coeffs[0]),
+              [ coeff1 ] "f"(gelu_poly_coeffs[1]),
+              [ coeff2 ] "f"(gelu_poly_coeffs[2]),
+              [ coeff3 ] "f"(gelu_poly_coeffs[3]),
+              [ coeff4 ] "f"(gelu_poly_coeffs[4]),
+              [ inv_range ] "f"(inv_range), [ half_range ] "f"(half_range),
+              [ one ] "f"(one), [ minus_one ] "f"(minus_one),
+              [ n_frep ] "r"(n_vec - 1)
+            : "ft0", "ft1", "ft2", "memory");
+
+        snrt_fpu_fence();
+        __builtin_ssr_barrier(SNRT_SSR_DM1);
+        snrt_ssr_disable();
+
+        i = n_vec * 4;
+    }
+
+    for (; i < len; i++) y[i] = gelu_poly_scalar(x[i]);
+}
+
+// sqrt(2 / pi), scale of the tanh argument of GELU_TANH
+#define GELU_TANH_SCALE 0.7978845608f
+// Half the scale of GELU_SIGMOID, sigmoid(2u) = 0.5 * (1 + tanh(u))
+#define GELU_SIGMOID_SCALE 0.851f
+
+/// Tanh argument u = x * (a + b * x^2) over n_vec packed vectors.
+static inline void gelu_tanh_arg(const float *x, float *u, float a, float b,
+                                 uint32_t n_vec) {
+    const register float one = 1.0f;
+    v2f32 k[3], xv, p;
+
+    vmath_stream(SNRT_SSR_DM0, 0, (void *)x, n_vec);
+    vmath_stream(SNRT_SSR_DM1, 1, u, n_vec);
+    snrt_ssr_enable();
+
+    asm volatile(
+        "vfcpka.s.s %[k0], %[a], %[a] \n"
+        "vfcpka.s.s %[k1], %[b], %[b] \n"
+        "vfcpka.s.s %[k2], %[one], %[one] \n"
+        "frep.o %[n_frep], 5, 0, 0 \n"
+        "vfmul.s %[xv], ft0, %[k2] \n"
+        "vfmul.s %[p], %[xv], %[xv] \n"
+        "vfmul.s %[p], %[p], %[k1] \n"
+        "vfadd.s %[p], %[p], %[k0] \n"
+        "vfmul.s ft1, %[p], %[xv] \n"
+        : [ k0 ] "=&f"(k[0]), [ k1 ] "=&f"(k[1]), [ k2 ] "=&f"(k[2]),
+          [ xv ] "=&f"(xv), [ p ] "=&f"(p)
+        : [ a ] "f"(a), [ b ] "f"(b), [ one ] "f"(one),
+          [ n_frep ] "r"(n_vec - 1)
+        : "ft0", "ft1", "ft2", "memory");
+
+    snrt_fpu_fence();
+    __builtin_ssr_barrier(SNRT_SSR_DM1);
+    snrt_ssr_disable();
+}
+
+/// y = x / 2 * (1 + t) over n_vec packed vectors, with t = tanh(u).
+static inline void gelu_tanh_out(const float *x, const float *t, float *y,
+                                 uint32_t n_vec) {
+    const register float half = 0.5f;
+    v2f32 k, h, p;
+
+    vmath_stream(SNRT_SSR_DM0, 0, (void *)x, n_vec);
+    vmath_stream(SNRT_SSR_DM1, 0, (void *)t, n_vec);
+    vmath_stream(SNRT_SSR_DM2, 1, y, n_vec);
+    snrt_ssr_enable();
+
+    asm volatile(
+        "vfcpka.s.s %[k], %[half], %[half] \n"
+        "frep.o %[n_frep], 3, 0, 0 \n"
+        "vfmul.s %[h], ft0, %[k] \n"
+        "vfmul.s %[p], %[h], ft1 \n"
+        "vfadd.s ft2, %[h], %[p] \n"
+        : [ k ] "=&f"(k), [ h ] "=&f"(h), [ p ] "=&f"(p)
+        : [ half ] "f"(half), [ n_frep ] "r"(n_vec - 1)
+        : "ft0", "ft1", "ft2", "memory");
+
+    snrt_fpu_fence();
+    __builtin_ssr_barrier(SNRT_SSR_DM2);
+    snrt_ssr_disable();
+}
+
+/**
+ * @brief Table positions of GELU_LUT
  *
+ * p = min(|x| * GELU_LUT_SCALE, GELU_LUT_SIZE - 1) is rounded down by adding
+ * VMATH_ROUND_SHIFT to p - 1/2, which leaves the index in the low mantissa
+ * bits of the result.
  */
-static inline void gelu_layer(const gelu_layer_t *l) {
-    uint32_t cluster_num = snrt_cluster_num();
-    uint32_t cluster_id = snrt_cluster_idx();
-    uint32_t compute_num = snrt_cluster_compute_core_num();
-    uint32_t compute_id = snrt_cluster_compute_core_num();
-
-    uint32_t ifmap_size =
-        l->BATCH_SIZE * l->SEQ_LEN * l->HIDDEN_NODES * sizeof(float);
-    uint32_t ofmap_size = ifmap_size;
-
-    void *ptr = (float *)snrt_l1_next();
-    float *ifmap = ptr;
-    ptr += ifmap_size;
-    float *ofmap = ptr;
-    ptr += ofmap_size;
-
-    // DMA transfer the ifmap into the cluster TCDM
-    if (snrt_is_dm_core()) {
-        snrt_dma_txid_t txid_ifmap = snrt_dma_start_2d(
-            ifmap, l->ifmap, l->BATCH_SIZE * sizeof(float),
-            l->BATCH_SIZE * sizeof(float), l->BATCH_SIZE * sizeof(float),
-            l->SEQ_LEN * l->HIDDEN_NODES * sizeof(float));
-
-        snrt_dma_wait_all();
+static inline void gelu_lut_index(const float *x, float *bits,
+                                  uint32_t n_vec) {
+    const register float scale = GELU_LUT_SCALE;
+    const register float p_max = GELU_LUT_SIZE - 1;
+    const register float half = 0.5f;
+    const register float shift = VMATH_ROUND_SHIFT;
+    v2f32 k[4], p;
+
+    vmath_stream(SNRT_SSR_DM0, 0, (void *)x, n_vec);
+    vmath_stream(SNRT_SSR_DM1, 1, bits, n_vec);
+    snrt_ssr_enable();
+
+    asm volatile(
+        "vfcpka.s.s %[k0], %[scale], %[scale] \n"
+        "vfcpka.s.s %[k1], %[p_max], %[p_max] \n"
+        "vfcpka.s.s %[k2], %[half], %[half] \n"
+        "vfcpka.s.s %[k3], %[shift], %[shift] \n"
+        "frep.o %[n_frep], 5, 0, 0 \n"
+        "vfmul.s %[p], ft0, %[k0] \n"
+        "vfsgnjx.s %[p], %[p], %[p] \n"
+        "vfmin.s %[p], %[p], %[k1] \n"
+        "vfsub.s %[p], %[p], %[k2] \n"
+        "vfadd.s ft1, %[p], %[k3] \n"
+        : [ k0 ] "=&f"(k[0]), [ k1 ] "=&f"(k[1]), [ k2 ] "=&f"(k[2]),
+          [ k3 ] "=&f"(k[3]), [ p ] "=&f"(p)
+        : [ scale ] "f"(scale), [ p_max ] "f"(p_max), [ half ] "f"(half),
+          [ shift ] "f"(shift), [ n_frep ] "r"(n_vec - 1)
+        : "ft0", "ft1", "ft2", "memory");
+
+    snrt_fpu_fence();
+    __builtin_ssr_barrier(SNRT_SSR_DM1);
+    snrt_ssr_disable();
+}
+
+/**
+ * @brief Gather the interpolation nodes of GELU_LUT
+ *
+ * The SSRs of the cluster are configured without the optional indirection
+ * extension, and the runtime has no interface for it, so the table lookup is
+ * the one step which runs on the integer core, on the bit patterns of the
+ * nodes. Every vector of lower nodes is followed by the vector of the upper
+ * nodes, so that both stream through a single SSR. Positions at the end of the
+ * table saturate to Phi(x) - 0.5 = 0.5.
+ */
+static inline void gelu_lut_gather(const uint32_t *bits, uint32_t *nodes,
+                                   uint32_t n_vec) {
+    const uint32_t *lut = (const uint32_t *)gelu_lut;
+    const uint32_t half = 0x3f000000;
+
+    for (uint32_t i = 0; i < 2 * n_vec; i++) {
+        uint32_t idx = bits[i] & 0x3fffff;
+        uint32_t *node = &nodes[2 * i - i % 2];
+        node[0] = idx < GELU_LUT_SIZE - 1 ? lut[idx] : half;
+        node[2] = idx < GELU_LUT_SIZE - 1 ? lut[idx + 1] : half;
     }
+}
 
-    snrt_cluster_hw_barrier();
+/**
+ * @brief Interpolation of GELU_LUT
+ *
+ * Recomputes the table positions like gelu_lut_index and interpolates
+ * h = Phi(|x|) - 0.5 between the gathered nodes, y = x / 2 + |x| * h.
+ */
+static inline void gelu_lut_interp(const float *x, const float *nodes,
+                                   float *y, uint32_t n_vec) {
+    const register float one = 1.0f;
+    const register float scale = GELU_LUT_SCALE;
+    const register float p_max = GELU_LUT_SIZE - 1;
+    const register float half = 0.5f;
+    const register float shift = VMATH_ROUND_SHIFT;
+    v2f32 k[5], xv, ax, p, n, f, a, d;
 
-    if (snrt_is_compute_core()) {
-        // determine the row offset for each core
-        int32_t row_offset = compute_id * l->HIDDEN_NODES;
+    vmath_stream(SNRT_SSR_DM0, 0, (void *)x, n_vec);
+    vmath_stream(SNRT_SSR_DM1, 0, (void *)nodes, 2 * n_vec);
+    vmath_stream(SNRT_SSR_DM2, 1, y, n_vec);
+    snrt_ssr_enable();
 
-        // determine the row stride of each matrix
-        int32_t ldI = compute_num * l->HIDDEN_NODES;
+    asm volatile(
+        "vfcpka.s.s %[k0], %[one], %[one] \n"
+        "vfcpka.s.s %[k1], %[scale], %[scale] \n"
+        "vfcpka.s.s %[k2], %[p_max], %[p_max] \n"
+        "vfcpka.s.s %[k3], %[half], %[half] \n"
+        "vfcpka.s.s %[k4], %[shift], %[shift] \n"
+        "frep.o %[n_frep], 14, 0, 0 \n"
+        "vfmul.s %[xv], ft0, %[k0] \n"
+        "vfsgnjx.s %[ax], %[xv], %[xv] \n"
+        "vfmul.s %[p], %[ax], %[k1] \n"
+        "vfmin.s %[p], %[p], %[k2] \n"
+        "vfsub.s %[n], %[p], %[k3] \n"
+        "vfadd.s %[n], %[n], %[k4] \n"
+        "vfsub.s %[n], %[n], %[k4] \n"
+        "vfsub.s %[f], %[p], %[n] \n"
+        "vfmul.s %[a], ft1, %[k0] \n"
+        "vfsub.s %[d], ft1, %[a] \n"
+        "vfmac.s %[a], %[f], %[d] \n"
+        "vfmul.s %[a], %[a], %[ax] \n"
+        "vfmul.s %[xv], %[xv], %[k3] \n"
+        "vfadd.s ft2, %[xv], %[a] \n"
+        : [ k0 ] "=&f"(k[0]), [ k1 ] "=&f"(k[1]), [ k2 ] "=&f"(k[2]),
+          [ k3 ] "=&f"(k[3]), [ k4 ] "=&f"(k[4]), [ xv ] "=&f"(xv),
+          [ ax ] "=&f"(ax), [ p ] "=&f"(p), [ n ] "=&f"(n), [ f ] "=&f"(f),
+          [ a ] "=&f"(a), [ d ] "=&f"(d)
+        : [ one ] "f"(one), [ scale ] "f"(scale), [ p_max ] "f"(p_max),
+          [ half ] "f"(half), [ shift ] "f"(shift), [ n_frep ] "r"(n_vec - 1)
+        : "ft0", "ft1", "ft2", "memory");
 
-        // determine the batch offset for each core
-        int32_t batch_offset = l->SEQ_LEN * l->HIDDEN_NODES;
+    snrt_fpu_fence();
+    __builtin_ssr_barrier(SNRT_SSR_DM2);
+    snrt_ssr_disable();
+}
+
+/**
+ * @brief GELU_TANH, GELU_SIGMOID or GELU_LUT over n_vec packed vectors
+ *
+ * @param u Scratch of SNRT_VMATH_CHUNK floats
+ * @param tmp Scratch of 2 * SNRT_VMATH_CHUNK floats
+ */
+static inline void gelu_kernel(gelu_impl_t impl, const float *x, float *y,
+                               float *u, float *tmp, uint32_t n_vec) {
+    switch (impl) {
+        case GELU_LUT:
+            gelu_lut_index(x, u, n_vec);
+            gelu_lut_gather((uint32_t *)u, (uint32_t *)tmp, n_vec);
+            gelu_lut_interp(x, tmp, y, n_vec);
+            break;
+        case GELU_SIGMOID:
+            gelu_tanh_arg(x, u, GELU_SIGMOID_SCALE, 0.0f, n_vec);
+            vmath_tanhf_kernel(u, u, tmp, n_vec);
+            gelu_tanh_out(x, u, y, n_vec);
+            break;
+        default:
+            gelu_tanh_arg(x, u, GELU_TANH_SCALE, GELU_TANH_SCALE * 0.044715f,
+                          n_vec);
+            vmath_tanhf_kernel(u, u, tmp, n_vec);
+            gelu_tanh_out(x, u, y, n_vec);
+            break;
+    }
+}
+
+/**
+ * @brief GELU_TANH, GELU_SIGMOID or GELU_LUT of a FP32 row
+ *
+ * Processed in chunks like snrt_vmath_map: aligned chunks are streamed in
+ * place, unaligned rows and an odd last chunk are staged through an aligned
+ * buffer, padding the last vector with zero.
+ */
+static inline void gelu_vec_fp32(gelu_impl_t impl, const float *x, float *y,
+                                 uint32_t len) {
+    float u[SNRT_VMATH_CHUNK] __attribute__((aligned(8)));
+    float tmp[2 * SNRT_VMATH_CHUNK] __attribute__((aligned(8)));
+    float buf[SNRT_VMATH_CHUNK + 1] __attribute__((aligned(8)));
+    uint32_t aligned = !(((uintptr_t)x | (uintptr_t)y) % sizeof(v2f32));
 
-        // printf("row_offset: %d, ldI: %d\n", row_offset, ldI);
+    for (uint32_t i = 0; i < len; i += SNRT_VMATH_CHUNK) {
+        uint32_t n = len - i < SNRT_VMATH_CHUNK ? len - i : SNRT_VMATH_CHUNK;
 
-        for (int b = 0; b < l->BATCH_SIZE; b++) {
-            // if (compute_id == 1) {
-            //     printf("BATCH: %d\n", b);
-            // }
-            gelu_fp32(&ifmap[row_offset + b * batch_offset],
-                      &ofmap[row_offset + b * batch_offset], ldI, l->BATCH_SIZE,
-                      l->SEQ_LEN / 8, l->HIDDEN_NODES);
+        if (aligned && !(n % 2)) {
+            gelu_kernel(impl, x + i, y + i, u, tmp, n / 2);
+        } else {
+            for (uint32_t j = 0; j < n; j++) buf[j] = x[i + j];
+            if (n % 2) buf[n] = 0.0f;
+            gelu_kernel(impl, buf, buf, u, tmp, (n + 1) / 2);
+            for (uint32_t j = 0; j < n; j++) y[i + j] = buf[j];
         }
+    }
+}
+
+/**
+ * @brief GELU_TANH, GELU_SIGMOID or GELU_LUT of a FP16 row
+ *
+ * Chunks are widened to FP32, processed by gelu_kernel and narrowed back to
+ * FP16 with packed conversions. Only the elements past the last full FP16
+ * vector, or all elements of an unaligned row, are converted one by one.
+ */
+static inline void gelu_vec_fp16(gelu_impl_t impl, const __fp16 *x,
+                                 __fp16 *y, uint32_t len) {
+    float u[SNRT_VMATH_CHUNK] __attribute__((aligned(8)));
+    float tmp[2 * SNRT_VMATH_CHUNK] __attribute__((aligned(8)));
+    float buf[SNRT_VMATH_CHUNK + 1] __attribute__((aligned(8)));
+    uint32_t aligned = !(((uintptr_t)x | (uintptr_t)y) % sizeof(v4f16));
+
+    for (uint32_t i = 0; i < len; i += SNRT_VMATH_CHUNK) {
+        uint32_t n = len - i < SNRT_VMATH_CHUNK ? len - i : SNRT_VMATH_CHUNK;
+        uint32_t n_wide = aligned ? n / 4 : 0;
+
+        if (n_wide) vmath_widen_fp16(x + i, buf, n_wide);
+        for (uint32_t j = n_wide * 4; j < n; j++) buf[j] = x[i + j];
+        if (n % 2) buf[n] = 0.0f;
+
+        gelu_kernel(impl, buf, buf, u, tmp, (n + 1) / 2);
+
+        if (n_wide) vmath_narrow_fp16(buf, y + i, n_wide);
+        for (uint32_t j = n_wide * 4; j < n; j++) y[i + j] = buf[j];
+    }
+}
+
+/**
+ * Implementation of the GELU layer
+ */
+static inline void gelu_fp32(float *input, float *output, int32_t ldI,
+                             uint32_t seq_len, uint32_t hidden_nodes,
+                             gelu_impl_t impl) {
+    for (uint32_t s = 0; s < seq_len; s++) {
+        float *in = &input[s * ldI];
+        float *out = &output[s * ldI];
+
+        if (impl == GELU_POLY)
+            gelu_poly_fp32(in, out, hidden_nodes);
+        else
+            gelu_vec_fp32(impl, in, out, hidden_nodes);
+    }
+}
+
+/**
+ * Implementation of the GELU layer in FP16. GELU_POLY is evaluated in FP16,
+ * the other implementations in FP32.
+ */
+static inline void gelu_fp16(__fp16 *input, __fp16 *output, int32_t ldI,
+                             uint32_t seq_len, uint32_t hidden_nodes,
+                             gelu_impl_t impl) {
+    for (uint32_t s = 0; s < seq_len; s++) {
+        __fp16 *in = &input[s * ldI];
+        __fp16 *out = &output[s * ldI];
+
+        if (impl == GELU_POLY)
+            gelu_poly_fp16(in, out, hidden_nodes);
+        else
+            gelu_vec_fp16(impl, in, out, hidden_nodes);
+    }
+}
 
-        snrt_cluster_hw_barrier();
+// Per-core part of the GELU layer on a tile of rows
+static inline void gelu_rows(const void *args, void *input, void *output,
+                             uint32_t rows, uint32_t core, uint32_t cores) {
+    const gelu_layer_t *l = args;
 
-    } else {
-        snrt_cluster_hw_barrier();
+    int32_t row_offset = core * l->HIDDEN_NODES;
+    int32_t ldI = cores * l->HIDDEN_NODES;
+    uint32_t seq_len = (rows + cores - 1 - core) / cores;
+
+    switch (l->dtype) {
+        case FP32:
+            gelu_fp32((float *)input + row_offset,
+                      (float *)output + row_offset, ldI, seq_len,
+                      l->HIDDEN_NODES, l->IMPL);
+            break;
+        case FP16:
+            gelu_fp16((__fp16 *)input + row_offset,
+                      (__fp16 *)output + row_offset, ldI, seq_len,
+                      l->HIDDEN_NODES, l->IMPL);
+            break;
+        default:
+            break;
     }
+}
+
+/**
+ * @brief  GELU layer
+ *
+ * The rows of all batches are distributed across the clusters and their
+ * compute cores, see dnn_rows_run().
+ *
+ * @param l gelu_layer struct that holds addresses and parameters
+ * @return 0 on success, -1 if a row does not fit into TCDM
+ */
+static inline int gelu_layer(const gelu_layer_t *l) {
+    uint32_t row_size = l->HIDDEN_NODES * l->dtype;
+
+    int ret = dnn_rows_run(gelu_rows, l, l->ifmap, l->ofmap,
+                           l->BATCH_SIZE * l->SEQ_LEN, row_size, row_size,
+                           snrt_l1_next());
 
     snrt_global_barrier();
-}
\ No newline at end of file
+    return ret;
+}
@@ -19,126 +19,392 @@
  * Size of each output sample
  * @var layernorm_layer_struct::EMBEDDINGS
  * Number of hidden dimensions
+ * @var layernorm_layer_struct::EPS
+ * Value added to the variance for numerical stability
  * @var layernorm_layer_struct::ifmap
  * Pointer to input feature map
  * @var layernorm_layer_struct::ofmap
- * Pointer to output feature map
+ * Pointer to output feature map, written back if not NULL
+ * @var layernorm_layer_struct::gamma
+ * Pointer to the EMBEDDINGS scale factors
+ * @var layernorm_layer_struct::beta
+ * Pointer to the EMBEDDINGS offsets
  * @var layernorm_layer_struct::result
  * Pointer to the golden model output
+ * @var layernorm_layer_struct::dtype
+ * Precision of the feature maps and parameters (FP32 or FP16)
  */
 typedef struct layernorm_layer_struct {
     uint32_t BATCH_SIZE;
     uint32_t SEQ_LEN;
     uint32_t EMBEDDINGS;
-    uint32_t EPS;
+    float EPS;
 
-    float *ifmap;
-    float *ofmap;
-    float *result;
+    void *ifmap;
+    void *ofmap;
+    void *gamma;
+    void *beta;
+    void *result;
 
     precision_t dtype;
 } layernorm_layer_t;
 
+/**
+ * @brief Mean and variance of a FP32 row in a single pass
+ *
+ * The row is streamed through SSR0 once, accumulating the sum and the sum of
+ * squares of its deviations from the first element. Shifting the data keeps
+ * the variance accurate when the mean is large compared to the spread.
+ */
+static inline void layernorm_stats_fp32(float *x, uint32_t len, float *mean,
+                                        float *var) {
+    float shift = x[0];
+    float sum = 0.0;
+    float sumsq = 0.0;
+    uint32_t i = 0;
+    uint32_t n_vec = ((uintptr_t)x % sizeof(v2f32)) ? 0 : len / 4;
+
+    if (n_vec) {
+        const register float zero = 0.0;
+        v2f32 shift_vec, sum0, sum1, sumsq0, sumsq1, tmp0, tmp1;
+
+        snrt_ssr_loop_1d(SNRT_SSR_DM0, n_vec * 2, sizeof(v2f32));
+        snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_1D, x);
+        snrt_ssr_enable();
+
+        asm volatile(
+            "vfcpka.s.s %[shift_vec], %[shift], %[shift] \n"
+            "vfcpka.s.s %[sum0], %[zero], %[zero] \n"
+            "vfcpka.s.s %[sum1], %[zero], %[zero] \n"
+            "vfcpka.s.s %[sumsq0], %[zero], %[zero] \n"
+            "vfcpka.s.s %[sumsq1], %[zero], %[zero] \n"
+            "frep.o %[n_frep], 6, 0, 0 \n"
+            "vfsub.s %[tmp0], ft0, %[shift_vec] \n"
+            "vfsub.s %[tmp1], ft0, %[shift_vec] \n"
+            "vfadd.s %[sum0], %[tmp0], %[sum0] \n"
+            "vfadd.s %[sum1], %[tmp1], %[sum1] \n"
+            "vfmac.s %[sumsq0], %[tmp0], %[tmp0] \n"
+            "vfmac.s %[sumsq1], %[tmp1], %[tmp1] \n"
+            "vfadd.s %[sum0], %[sum0], %[sum1] \n"
+            "vfadd.s %[sumsq0], %[sumsq0], %[sumsq1] \n"
+            : [ shift_vec ] "=&f"(shift_vec), [ sum0 ] "=&f"(sum0),
+              [ sum1 ] "=&f"(sum1), [ sumsq0 ] "=&f"(sumsq0),
+              [ sumsq1 ] "=&f"(sumsq1), [ tmp0 ] "=&f"(tmp0),
+              [ tmp1 ] "=&f"(tmp1)
+            : [ shift ] "f"(shift), [ zero ] "f"(zero),
+              [ n_frep ] "r"(n_vec - 1)
+            : "ft0", "ft1", "ft2");
+
+        snrt_ssr_disable();
+
+        sum = sum0[0] + sum0[1];
+        sumsq = sumsq0[0] + sumsq0[1];
+        i = n_vec * 4;
+    }
+
+    for (; i < len; i++) {
+        float d = x[i] - shift;
+        sum += d;
+        sumsq += d * d;
+    }
+
+    float inv_len = fast_recipf(len);
+    float m = sum * inv_len;
+    float v = sumsq * inv_len - m * m;
+    *mean = shift + m;
+    *var = v > 0.0f ? v : 0.0f;
+}
+
+/**
+ * @brief Mean and variance of a FP16 row in a single pass
+ *
+ * Same as layernorm_stats_fp32, with 8 values per step. The sums are
+ * accumulated in FP32 with expanding dot products.
+ */
+static inline void layernorm_stats_fp16(__fp16 *x, uint32_t len, float *mean,
+                                        float *var) {
+    float shift = x[0];
+    float sum = 0.0;
+    float sumsq = 0.0;
+    uint32_t i = 0;
+    uint32_t n_vec = ((uintptr_t)x % sizeof(v4f16)) ? 0 : len / 8;
+
+    if (n_vec) {
+        const register float zero = 0.0;
+        const register float one = 1.0;
+        v4f16 shift_vec, one_vec, tmp0, tmp1;
+        v2f32 sum0, sum1, sumsq0, sumsq1;
+
+        snrt_ssr_loop_1d(SNRT_SSR_DM0, n_vec * 2, sizeof(v4f16));
+        snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_1D, x);
+        snrt_ssr_enable();
+
+        asm volatile(
+            "vfcpka.h.s %[shift_vec], %[shift], %[shift] \n"
+            "vfcpkb.h.s %[shift_vec], %[shift], %[shift] \n"
+            "vfcpka.h.s %[one_vec], %[one], %[one] \n"
+            "vfcpkb.h.s %[one_vec], %[one], %[one] \n"
+            "vfcpka.s.s %[sum0], %[zero], %[zero] \n"
+            "vfcpka.s.s %[sum1], %[zero], %[zero] \n"
+            "vfcpka.s.s %[sumsq0], %[zero], %[zero] \n"
+            "vfcpka.s.s %[sumsq1], %[zero], %[zero] \n"
+            "frep.o %[n_frep], 6, 0, 0 \n"
+            "vfsub.h %[tmp0], ft0, %[shift_vec] \n"
+            "vfsub.h %[tmp1], ft0, %[shift_vec] \n"
+            "vfdotpex.s.h %[sum0], %[tmp0], %[one_vec] \n"
+            "vfdotpex.s.h %[sum1], %[tmp1], %[one_vec] \n"
+            "vfdotpex.s.h %[sumsq0], %[tmp0], %[tmp0] \n"
+            "vfdotpex.s.h %[sumsq1], %[tmp1], %[tmp1] \n"
+            "vfadd.s %[sum0], %[sum0], %[sum1] \n"
+            "vfadd.s %[sumsq0], %[sumsq0], %[sumsq1] \n"
+            : [ shift_vec ] "=&f"(shift_vec), [ one_vec ] "=&f"(one_vec),
+              [ sum0 ] "=&f"(sum0), [ sum1 ] "=&f"(sum1),
+              [ sumsq0 ] "=&f"(sumsq0), [ sumsq1 ] "=&f"(sumsq1),
+              [ tmp0 ] "=&f"(tmp0), [ tmp1 ] "=&f"(tmp1)
+            : [ shift ] "f"(shift), [ zero ] "f"(zero), [ one ] "f"(one),
+              [ n_frep ] "r"(n_vec - 1)
+            : "ft0", "ft1", "ft2");
+
+        snrt_ssr_disable();
+
+        sum = sum0[0] + sum0[1];
+        sumsq = sumsq0[0] + sumsq0[1];
+        i = n_vec * 8;
+    }
+
+    for (; i < len; i++) {
+        float d = (float)x[i] - shift;
+        sum += d;
+        sumsq += d * d;
+    }
+
+    float inv_len = fast_recipf(len);
+    float m = sum * inv_len;
+    float v = sumsq * inv_len - m * m;
+    *mean = shift + m;
+    *var = v > 0.0f ? v : 0.0f;
+}
+
+/**
+ * @brief Normalize a FP32 row and apply the affine transformation
+ *
+ * The row is streamed through SSR0 and the result written through SSR2. SSR1
+ * alternates between gamma and beta, so they can live anywhere in TCDM.
+ */
+static inline void layernorm_apply_fp32(float *x, float *y, float *gamma,
+                                        float *beta, uint32_t len, float mean,
+                                        float rstd) {
+    uint32_t i = 0;
+    uintptr_t addr = (uintptr_t)x | (uintptr_t)y | (uintptr_t)gamma |
+                     (uintptr_t)beta;
+    uint32_t n_vec = (addr % sizeof(v2f32)) ? 0 : len / 4;
+
+    if (n_vec) {
+        v2f32 mean_vec, rstd_vec, tmp0, tmp1;
+
+        snrt_ssr_loop_1d(SNRT_SSR_DM0, n_vec * 2, sizeof(v2f32));
+        snrt_ssr_loop_3d(SNRT_SSR_DM1, 2, 2, n_vec, sizeof(v2f32),
+                         (uintptr_t)beta - (uintptr_t)gamma,
+                         2 * sizeof(v2f32));
+        snrt_ssr_loop_1d(SNRT_SSR_DM2, n_vec * 2, sizeof(v2f32));
+        snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_1D, x);
+        snrt_ssr_read(SNRT_SSR_DM1, SNRT_SSR_3D, gamma);
+        snrt_ssr_write(SNRT_SSR_DM2, SNRT_SSR_1D, y);
+        snrt_ssr_enable();
+
+        asm volatile(
+            "vfcpka.s.s %[mean_vec], %[mean], %[mean] \n"
+            "vfcpka.s.s %[rstd_vec], %[rstd], %[rstd] \n"
+            "frep.o %[n_frep], 8, 0, 0 \n"
+            "vfsub.s %[tmp0], ft0, %[mean_vec] \n"
+            "vfsub.s %[tmp1], ft0, %[mean_vec] \n"
+            "vfmul.s %[tmp0], %[tmp0], %[rstd_vec] \n"
+            "vfmul.s %[tmp1], %[tmp1], %[rstd_vec] \n"
+            "vfmul.s %[tmp0], %[tmp0], ft1 \n"
+            "vfmul.s %[tmp1], %[tmp1], ft1 \n"
+            "vfadd.s ft2, %[tmp0], ft1 \n"
+            "vfadd.s ft2, %[tmp1], ft1 \n"
+            : [ mean_vec ] "=&f"(mean_vec), [ rstd_vec ] "=&f"(rstd_vec),
+              [ tmp0 ] "=&f"(tmp0), [ tmp1 ] "=&f"(tmp1)
+            : [ mean ] "f"(mean), [ rstd ] "f"(rstd),
+              [ n_frep ] "r"(n_vec - 1)
+            : "ft0", "ft1", "ft2", "memory");
+
+        snrt_fpu_fence();
+        __builtin_ssr_barrier(SNRT_SSR_DM2);
+        snrt_ssr_disable();
+
+        i = n_vec * 4;
+    }
+
+    for (; i < len; i++) y[i] = (x[i] - mean) * rstd * gamma[i] + beta[i];
+}
+
+/**
+ * @brief Normalize a FP16 row and apply the affine transformation
+ *
+ * Same as layernorm_apply_fp32, with 8 values per step.
+ */
+static inline void layernorm_apply_fp16(__fp16 *x, __fp16 *y, __fp16 *gamma,
+                                        __fp16 *beta, uint32_t len,
+                                        float mean, float rstd) {
+    uint32_t i = 0;
+    uintptr_t addr = (uintptr_t)x | (uintptr_t)y | (uintptr_t)gamma |
+                     (uintptr_t)beta;
+    uint32_t n_vec = (addr % sizeof(v4f16)) ? 0 : len / 8;
+
+    if (n_vec) {
+        v4f16 mean_vec, rstd_vec, tmp0, tmp1;
+
+        snrt_ssr_loop_1d(SNRT_SSR_DM0, n_vec * 2, sizeof(v4f16));
+        snrt_ssr_loop_3d(SNRT_SSR_DM1, 2, 2, n_vec, sizeof(v4f16),
+                         (uintptr_t)beta - (uintptr_t)gamma,
+                         2 * sizeof(v4f16));
+        snrt_ssr_loop_1d(SNRT_SSR_DM2, n_vec * 2, sizeof(v4f16));
+        snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_1D, x);
+        snrt_ssr_read(SNRT_SSR_DM1, SNRT_SSR_3D, gamma);
+        snrt_ssr_write(SNRT_SSR_DM2, SNRT_SSR_1D, y);
+        snrt_ssr_enable();
+
+        asm volatile(
+            "vfcpka.h.s %[mean_vec], %[mean], %[mean] \n"
+            "vfcpkb.h.s %[mean_vec], %[mean], %[mean] \n"
+            "vfcpka.h.s %[rstd_vec], %[rstd], %[rstd] \n"
+            "vfcpkb.h.s %[rstd_vec], %[rstd], %[rstd] \n"
+            "frep.o %[n_frep], 8, 0, 0 \n"
+            "vfsub.h %[tmp0], ft0, %[mean_vec] \n"
+            "vfsub.h %[tmp1], ft0, %[mean_vec] \n"
+            "vfmul.h %[tmp0], %[tmp0], %[rstd_vec] \n"
+            "vfmul.h %[tmp1], %[tmp1], %[rstd_vec] \n"
+            "vfmul.h %[tmp0], %[tmp0], ft1 \n"
+            "vfmul.h %[tmp1], %[tmp1], ft1 \n"
+            "vfadd.h ft2, %[tmp0], ft1 \n"
+            "vfadd.h ft2, %[tmp1], ft1 \n"
+            : [ mean_vec ] "=&f"(mean_vec), [ rstd_vec ] "=&f"(rstd_vec),
+              [ tmp0 ] "=&f"(tmp0), [ tmp1 ] "=&f"(tmp1)
+            : [ mean ] "f"(mean), [ rstd ] "f"(rstd),
+              [ n_frep ] "r"(n_vec - 1)
+            : "ft0", "ft1", "ft2", "memory");
+
+        snrt_fpu_fence();
+        __builtin_ssr_barrier(SNRT_SSR_DM2);
+        snrt_ssr_disable();
+
+        i = n_vec * 8;
+    }
+
+    for (; i < len; i++)
+        y[i] = ((float)x[i] - mean) * rstd * (float)gamma[i] + (float)beta[i];
+}
+
 /**
  * Implementation of the LayerNorm layer.
+ *
+ * Mean and variance of every row are computed in a single streaming pass,
+ * followed by a second pass which normalizes the row and applies gamma and
+ * beta. The reciprocal standard deviation is computed once per row.
  */
-static inline void layernorm_fp32(float *input, float *output, int32_t ldI,
+static inline void layernorm_fp32(float *input, float *output, float *gamma,
+                                  float *beta, int32_t ldI,
                                   int32_t batch_offset, int32_t batch_size,
                                   int32_t seq_len, int32_t embeddings,
-                                  int32_t eps) {
-    float mean = 0.0;  // max value of the current core
-    float var = 0.0;   // sum of the exp values of the current core
-
-    uint32_t compute_id = snrt_global_core_idx();
-    uint32_t num_cores = snrt_cluster_compute_core_num();
-
-    // compute the mean and variance along the last dimension
+                                  float eps) {
     for (int32_t b = 0; b < batch_size; b++) {
         for (int32_t s = 0; s < seq_len; s++) {
-            mean = 0.0;
-            var = 0.0;
-
-            for (int32_t i = 0; i < embeddings; i++) {
-                mean += input[b * batch_offset + s * ldI + i];
-            }
-            mean /= embeddings;
-
-            // printf("mean[%d] = %f\n", b, mean);
-
-            for (int32_t i = 0; i < embeddings; i++) {
-                var += (input[b * batch_offset + s * ldI + i] - mean) *
-                       (input[b * batch_offset + s * ldI + i] - mean);
-            }
-            var /= embeddings;
-
-            // printf("var[%d] = %f\n", b, var);
-
-            // compute the shifted value of the current row
-            for (int32_t i = 0; i < embeddings; i++) {
-                output[b * batch_offset + s * ldI + i] =
-                    (input[b * batch_offset + s * ldI + i] - mean) /
-                    sqrtf(var + eps);
-                // printf("output[%d][%d][%d] = %f\n", b, s + compute_id, i,
-                //        output[b * batch_offset + s * ldI + i]);
-            }
+            float *in = &input[b * batch_offset + s * ldI];
+            float *out = &output[b * batch_offset + s * ldI];
+            float mean, var;
+
+            layernorm_stats_fp32(in, embeddings, &mean, &var);
+            layernorm_apply_fp32(in, out, gamma, beta, embeddings, mean,
+                                 fast_rsqrtf(var + eps));
         }
     }
-
-    snrt_cluster_hw_barrier();
 }
 
 /**
- * @brief  layernorm layer
- *
- * @param l layernorm_layer struct that holds addresses and parameters
- *
+ * Implementation of the LayerNorm layer in FP16. The statistics are
+ * accumulated in FP32.
  */
-static inline void layernorm_layer(const layernorm_layer_t *l) {
-    uint32_t cluster_num = snrt_cluster_num();
-    uint32_t cluster_id = snrt_cluster_idx();
-    uint32_t compute_num = snrt_cluster_compute_core_num();
-    uint32_t compute_id = snrt_global_core_idx();
-
-    uint32_t ifmap_size =
-        l->BATCH_SIZE * l->SEQ_LEN * l->EMBEDDINGS * sizeof(float);
-    uint32_t ofmap_size = ifmap_size;
-
-    void *ptr = (float *)snrt_l1_next();
-    float *ifmap = ptr;
-    ptr += ifmap_size;
-    float *ofmap = ptr;
-    ptr += ofmap_size;
-
-    // DMA transfer the ifmap into the cluster TCDM
-    if (snrt_is_dm_core()) {
-        snrt_dma_txid_t txid_ifmap = snrt_dma_start_2d(
-            ifmap, l->ifmap, l->BATCH_SIZE * sizeof(float),
-            l->BATCH_SIZE * sizeof(float), l->BATCH_SIZE * sizeof(float),
-            l->SEQ_LEN * l->EMBEDDINGS * sizeof(float));
+static inline void layernorm_fp16(__fp16 *input, __fp16 *output,
+                                  __fp16 *gamma, __fp16 *beta, int32_t ldI,
+                                  int32_t batch_offset, int32_t batch_size,
+                                  int32_t seq_len, int32_t embeddings,
+                                  float eps) {
+    for (int32_t b = 0; b < batch_size; b++) {
+        for (int32_t s = 0; s < seq_len; s++) {
+            __fp16 *in = &input[b * batch_offset + s * ldI];
+            __fp16 *out = &output[b * batch_offset + s * ldI];
+            float mean, var;
 
-        snrt_dma_wait_all();
+            layernorm_stats_fp16(in, embeddings, &mean, &var);
+            layernorm_apply_fp16(in, out, gamma, beta, embeddings, mean,
+                                 fast_rsqrtf(var + eps));
+        }
     }
+}
 
-    snrt_cluster_hw_barrier();
+// Arguments of the per-core part of the LayerNorm layer
+typedef struct {
+    const layernorm_layer_t *l;
+    void *gamma;  // TCDM copy of the scaling factors
+    void *beta;   // TCDM copy of the offsets
+} layernorm_rows_args_t;
 
-    if (snrt_is_compute_core()) {
-        // determine the row offset for each core
-        int32_t row_offset = compute_id * l->EMBEDDINGS;
+// Per-core part of the LayerNorm layer on a tile of rows
+static inline void layernorm_rows(const void *args, void *input, void *output,
+                                  uint32_t rows, uint32_t core,
+                                  uint32_t cores) {
+    const layernorm_rows_args_t *a = args;
+    const layernorm_layer_t *l = a->l;
 
-        // determine the row stride of each matrix
-        int32_t ldI = compute_num * l->EMBEDDINGS;
+    int32_t row_offset = core * l->EMBEDDINGS;
+    int32_t ldI = cores * l->EMBEDDINGS;
+    int32_t seq_len = (rows + cores - 1 - core) / cores;
+
+    switch (l->dtype) {
+        case FP32:
+            layernorm_fp32((float *)input + row_offset,
+                           (float *)output + row_offset, a->gamma, a->beta,
+                           ldI, 0, 1, seq_len, l->EMBEDDINGS, l->EPS);
+            break;
+        case FP16:
+            layernorm_fp16((__fp16 *)input + row_offset,
+                           (__fp16 *)output + row_offset, a->gamma, a->beta,
+                           ldI, 0, 1, seq_len, l->EMBEDDINGS, l->EPS);
+            break;
+        default:
+            break;
+    }
+}
 
-        // determine the batch offset for each core
-        int32_t batch_offset = l->SEQ_LEN * l->EMBEDDINGS;
+/**
+ * @brief  layernorm layer
+ *
+ * Gamma and beta stay resident in the TCDM of every cluster, while the rows
+ * of all batches are distributed across the clusters and their compute
+ * cores, see dnn_rows_run().
+ *
+ * @param l layernorm_layer struct that holds addresses and parameters
+ * @return 0 on success, -1 if a row does not fit into TCDM
+ */
+static inline int layernorm_layer(const layernorm_layer_t *l) {
+    uint32_t row_size = l->EMBEDDINGS * l->dtype;
 
-        // printf("row_offset: %d, ldI: %d\n", row_offset, ldI);
-        layernorm_fp32(&ifmap[row_offset], &ofmap[row_offset], ldI,
-                       batch_offset, l->BATCH_SIZE, l->SEQ_LEN / 8,
-                       l->EMBEDDINGS, l->EPS);
+    void *ptr = snrt_l1_next();
+    layernorm_rows_args_t args = {l, ptr, ptr + ALIGN_UP(row_size, 8)};
+    ptr += 2 * ALIGN_UP(row_size, 8);
 
-    } else {
-        snrt_cluster_hw_barrier();
+    // The tile loop waits for these transfers before its first barrier
+    if (snrt_is_dm_core()) {
+        snrt_dma_start_1d(args.gamma, l->gamma, row_size);
+        snrt_dma_start_1d(args.beta, l->beta, row_size);
     }
 
+    int ret = dnn_rows_run(layernorm_rows, &args, l->ifmap, l->ofmap,
+                           l->BATCH_SIZE * l->SEQ_LEN, row_size, row_size,
+                           ptr);
+
     snrt_global_barrier();
-}
\ No newline at end of file
+    return ret;
+}
@@ -4,7 +4,9 @@
 
 #pragma once
 
+#include "blas.h"
 #include "snrt.h"
+#include "utils.h"
 
 /**
  * @struct linear_layer_struct
@@ -14,17 +16,21 @@
  * @var linear_layer_struct::CI
  * Size of each input sample
  * @var linear_layer_struct::CH
- * Height of input feature map
+ * Height of input feature map, i.e. number of samples
  * @var linear_layer_struct::CW
  * Width of input feature map
  * @var linear_layer_struct::ifmap
- * Pointer to input feature map
+ * Pointer to input feature map, CH x CI
  * @var linear_layer_struct::weights
- * Pointer to weights
+ * Pointer to weights, CO x CI
  * @var linear_layer_struct::bias
  * Pointer to bias
  * @var linear_layer_struct::ofmap
- * Pointer to output feature map
+ * Pointer to output feature map, CH x CO, written back if not NULL
+ * @var linear_layer_struct::result
+ * Pointer to the golden model output
+ * @var linear_layer_struct::dtype
+ * Precision of the feature maps and parameters (FP64, FP32 or FP16)
  */
 typedef struct linear_layer_struct {
     uint32_t CO;
@@ -32,128 +38,73 @@ typedef struct linear_layer_struct {
     uint32_t CH;
     uint32_t CW;
 
-    float *ifmap;
-    float *weights;
-    float *bias;
-    float *ofmap;
-    float *result;
+    void *ifmap;
+    void *weights;
+    void *bias;
+    void *ofmap;
+    void *result;
 
     precision_t dtype;
 } linear_layer_t;
 
+// Arguments of the per-core part of the linear layer
+typedef struct {
+    const linear_layer_t *l;
+    void *weights;  // TCDM copy of the weights
+    void *bias;     // TCDM copy of the bias
+} linear_rows_args_t;
+
+// Per-core part of the linear layer on a tile of samples. Every core
+// initializes its output rows with the bias and accumulates the product of
+// its input rows with the transposed weights.
+static inline void linear_rows(const void *args, void *input, void *output,
+                               uint32_t rows, uint32_t core, uint32_t cores) {
+    const linear_rows_args_t *a = args;
+    const linear_layer_t *l = a->l;
+    const precision_t prec = l->dtype;
+
+    uint32_t m_core = (rows + cores - 1 - core) / cores;
+    void *in = input + core * l->CI * prec;
+    void *out = output + core * l->CO * prec;
+
+    for (uint32_t r = 0; r < m_core; r++)
+        for (uint32_t o = 0; o < l->CO; o++)
+            gemm_store(prec, out + r * cores * l->CO * prec, o,
+                       gemm_load(prec, a->bias, o));
+
+    gemm_core(prec, 0, 1, 0, 1, m_core, l->CO, l->CI, 1, in, cores * l->CI,
+              a->weights, l->CI, 1, out, cores * l->CO);
+}
+
 /**
- * Implementation of the linear layer
+ * @brief  Linear layer
+ *
+ * Computes ofmap = ifmap * weights^T + bias. Weights and bias stay resident
+ * in the TCDM of every cluster, while the samples are distributed across the
+ * clusters and their compute cores, see dnn_rows_run().
+ *
+ * @param l linear_layer struct that holds addresses and parameters
+ * @return 0 on success, -1 if the weights do not fit into TCDM
  */
-static inline void linear_fp32(float *input, int32_t ldI, float *weights,
-                               int32_t ldW, float *bias, int32_t ldB,
-                               float *output, int32_t ldO, int in_ch,
-                               int out_ch, int ch) {
-    uint32_t compute_id = snrt_cluster_compute_core_num();
-    for (int c = 0; c < ch; c++) {
-        for (int o = 0; o < out_ch; o++) {
-            float sum = 0;
-            for (int i = 0; i < in_ch; i++) {
-                sum += input[c * in_ch + i] * weights[o * in_ch * ldB + i];
-            }
-            output[c * out_ch + o * ldB] = sum + bias[o * ldB];
-            printf("output[%d][%d] = %f\n", c, compute_id + o * ldB,
-                   output[c * out_ch + o * ldB]);
-        }
-    }
+static inline int linear_layer(const linear_layer_t *l) {
+    uint32_t weights_size = l->CO * l->CI * l->dtype;
+    uint32_t bias_size = l->CO * l->dtype;
 
-    snrt_cluster_hw_barrier();
-}
+    void *ptr = snrt_l1_next();
+    linear_rows_args_t args = {l, ptr, ptr + ALIGN_UP(weights_size, 8)};
+    ptr += ALIGN_UP(weights_size, 8) + ALIGN_UP(bias_size, 8);
+    if ((uint32_t)ptr > snrt_l1_end_addr() - DNN_L1_RESERVE) return -1;
 
-static inline void linear_layer(const linear_layer_t *l) {
-    uint32_t cluster_num = snrt_cluster_num();
-    uint32_t cluster_id = snrt_cluster_idx();
-    uint32_t compute_num = snrt_cluster_compute_core_num();
-    uint32_t compute_id = snrt_cluster_compute_core_num();
-
-    uint32_t ifmap_size = l->CH * l->CW * sizeof(float);
-    uint32_t weights_size = l->CO * l->CI * sizeof(float);
-    uint32_t bias_size = l->CO * sizeof(float);
-    uint32_t ofmap_size = l->CH * l->CO * sizeof(float);
-
-    void *ptr = (float *)snrt_l1_next();
-    float *ifmap = ptr;
-    ptr += ifmap_size;
-    float *weights = ptr;
-    ptr += weights_size;
-    float *bias = ptr;
-    ptr += bias_size;
-    float *ofmap = ptr;
-    ptr += ofmap_size;
-    float *result = ptr;
-    ptr += ofmap_size;
-
-    // now we DMA transfer the weights and bias into the cluster TCDM
+    // The tile loop waits for these transfers before its first barrier
     if (snrt_is_dm_core()) {
-        snrt_dma_txid_t txid_bias = snrt_dma_start_1d(bias, l->bias, bias_size);
-        snrt_dma_txid_t txid_weights = snrt_dma_start_2d(
-            weights, l->weights, l->CO * sizeof(float), l->CO * sizeof(float),
-            l->CO * sizeof(float), l->CI * sizeof(float));
-
-        snrt_dma_txid_t txid_ifmap = snrt_dma_start_2d(
-            ifmap, l->ifmap, l->CH * sizeof(float), l->CH * sizeof(float),
-            l->CH * sizeof(float), l->CW * sizeof(float));
-
-        snrt_dma_wait_all();
-    }
-
-    snrt_cluster_hw_barrier();
-
-    if (snrt_is_compute_core() &&
-        snrt_cluster_compute_core_num() < compute_num) {
-        // determine the row stride of each matrix
-        int32_t ldI = l->CH * l->CW;
-        int32_t ldW = compute_num * l->CO;
-        int32_t ldB = compute_num;
-        int32_t ldO = ldB;
-
-        // determine the row offset of each matrix
-        int32_t offW = compute_id * l->CO;
-        int32_t offB = compute_id;
-        int32_t offO = compute_id;
-
-        // printf("compute_id = %d, offW = %d, offB = %d, offO = %d\n",
-        //         compute_id, offW, offB, offO);
-
-        linear_fp32(ifmap, ldI, &weights[offW], ldW, &bias[compute_id], ldB,
-                    ofmap, ldO, l->CI, l->CO / compute_num, l->CH);
-
-    } else {
-        snrt_cluster_hw_barrier();
+        snrt_dma_start_1d(args.weights, l->weights, weights_size);
+        snrt_dma_start_1d(args.bias, l->bias, bias_size);
     }
 
-    snrt_cluster_hw_barrier();
+    int ret = dnn_rows_run(linear_rows, &args, l->ifmap, l->ofmap, l->CH,
+                           l->CI * l->dtype, l->CO * l->dtype, ptr);
 
-    if (snrt_is_dm_core()) {
-        snrt_dma_txid_t txid_result = snrt_dma_start_2d(
-            result, l->result, l->CH * sizeof(float), l->CH * sizeof(float),
-            l->CH * sizeof(float), l->CO * sizeof(float));
-        snrt_dma_wait_all();
-    }
+    snrt_global_barrier();
 
-    snrt_cluster_hw_barrier();
-
-    // TODO: fix this, wrong values for ofmap printed
-    if (compute_id == 0) {
-        // compare result with ofmap
-        float tolerance = 1e-6;
-        int error = 0;
-        for (int i = 0; i < l->CH; i++) {
-            for (int j = 0; j < l->CO; j++) {
-                if (result[i * l->CO + j] - ofmap[i * l->CO + j] > tolerance) {
-                    printf(
-                        "MISMATCH: result[%d][%d] = %f, ofmap[%d][%d] = %f\n",
-                        i, j, result[i * l->CO + j], i, j,
-                        ofmap[i * l->CO + j]);
-                    error += 1;
-                }
-            }
-        }
-
-        printf("[%d/%d] mismatches\n", error, l->CH * l->CO);
-    }
+    return ret;
 }
@@ -0,0 +1,597 @@
+// Copyright 2023 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "blas.h"
+#include "snrt.h"
+
+/**
+ * Max and average pooling layers in HWC layout, with arbitrary window, stride
+ * and padding, and global pooling over the whole feature map, for FP64, FP32
+ * and FP16 data.
+ *
+ * Like the depthwise convolution, the layers are split into tiles of channels
+ * of blocks of rows, which are distributed across clusters and streamed
+ * through double-buffered TCDM buffers by the DMA core. Every SSR word holds
+ * 8 / prec channels, which are pooled together with the SIMD instructions.
+ *
+ * Windows are walked by 4D SSR streams, without any index arithmetic on the
+ * compute cores. The padding is materialized in TCDM with the identity of the
+ * reduction: zero for average pooling, which therefore divides by the window
+ * size also at the borders (count_include_pad in PyTorch), and the all-ones
+ * pattern for max pooling. The latter is a NaN in every precision, which is
+ * ignored by the RISC-V fmax instructions.
+ */
+
+typedef enum {
+    POOL_MAX = 0,
+    POOL_AVG = 1,
+    POOL_GLOBAL_MAX = 2,
+    POOL_GLOBAL_AVG = 3
+} pool_type_t;
+
+/**
+ * @struct pool_layer_t
+ * @brief Parameters and addresses of a pooling layer
+ *
+ * @var pool_layer_t::type
+ * Reduction and window of the layer. Global layers reduce every channel over
+ * the whole feature map into a 1 x 1 output, ignoring the window, stride and
+ * padding.
+ * @var pool_layer_t::C
+ * Number of channels of the input and output feature maps
+ * @var pool_layer_t::FH
+ * Height of the window
+ * @var pool_layer_t::FW
+ * Width of the window
+ * @var pool_layer_t::stride_h
+ * Vertical stride, 0 is treated as the window height
+ * @var pool_layer_t::stride_w
+ * Horizontal stride, 0 is treated as the window width
+ * @var pool_layer_t::pad_h
+ * Rows of padding at the top and bottom, at most FH / 2
+ * @var pool_layer_t::pad_w
+ * Columns of padding at the left and right, at most FW / 2
+ */
+typedef struct {
+    pool_type_t type;
+    uint32_t C;
+    uint32_t IH;
+    uint32_t IW;
+    uint32_t OH;
+    uint32_t OW;
+    uint32_t FH;
+    uint32_t FW;
+    uint32_t stride_h;
+    uint32_t stride_w;
+    uint32_t pad_h;
+    uint32_t pad_w;
+    void *ifmap;
+    void *ofmap;
+    precision_t dtype;
+} pool_layer_t;
+
+static inline uint32_t pool_is_global(const pool_layer_t *l) {
+    return l->type == POOL_GLOBAL_MAX || l->type == POOL_GLOBAL_AVG;
+}
+
+static inline uint32_t pool_is_max(const pool_layer_t *l) {
+    return l->type == POOL_MAX || l->type == POOL_GLOBAL_MAX;
+}
+
+static inline uint32_t pool_stride_h(const pool_layer_t *l) {
+    return l->stride_h ? l->stride_h : l->FH;
+}
+
+static inline uint32_t pool_stride_w(const pool_layer_t *l) {
+    return l->stride_w ? l->stride_w : l->FW;
+}
+
+// Output size of a pooling window along one dimension, rounding down
+static inline uint32_t pool_out_dim(uint32_t in, uint32_t filter, uint32_t pad,
+                                    uint32_t stride) {
+    return (in + 2 * pad - filter) / stride + 1;
+}
+
+// Check the consistency of the output size with the other parameters. The
+// padding is limited such that every window covers at least one input.
+static inline uint32_t pool_valid(const pool_layer_t *l) {
+    if (!l->C || !l->IH || !l->IW) return 0;
+    if (pool_is_global(l)) return l->OH == 1 && l->OW == 1;
+    if (!l->FH || !l->FW) return 0;
+    if (2 * l->pad_h > l->FH || 2 * l->pad_w > l->FW) return 0;
+    if (l->IH + 2 * l->pad_h < l->FH || l->IW + 2 * l->pad_w < l->FW) return 0;
+    return l->OH == pool_out_dim(l->IH, l->FH, l->pad_h, pool_stride_h(l)) &&
+           l->OW == pool_out_dim(l->IW, l->FW, l->pad_w, pool_stride_w(l));
+}
+
+/**
+ * @struct pool_t
+ * @brief Geometry of the pooling layer in TCDM
+ *
+ * @var pool_t::IW
+ * Width of the padded input rows
+ * @var pool_t::OW
+ * Computed output columns, a multiple of POOL_UNROLL
+ * @var pool_t::TOH
+ * Output rows per block, input rows per block for global layers
+ * @var pool_t::TC
+ * Channels per tile, such that every pixel fills whole SSR words
+ * @var pool_t::scale
+ * Reciprocal of the number of inputs per output in every SIMD lane
+ */
+typedef struct {
+    precision_t prec;
+    uint32_t global;
+    uint32_t max;
+    uint32_t IW;
+    uint32_t OW;
+    uint32_t FH;
+    uint32_t FW;
+    uint32_t SH;
+    uint32_t SW;
+    uint32_t TOH;
+    uint32_t TC;
+    double scale;
+} pool_t;
+
+// Step of the pooling layer, i.e. one tile of channels of one block of rows
+typedef struct {
+    uint32_t oh0;   // First row of the block
+    uint32_t rows;  // Valid rows of the block
+    uint32_t c0;    // First channel of the tile
+    uint32_t cs;    // Valid channels of the tile
+} pool_step_t;
+
+// Output pixels computed at once by pool_window_ssr()
+#define POOL_UNROLL 4
+
+// Input rows needed by a block of rows
+static inline uint32_t pool_in_rows(const pool_t *d, uint32_t rows) {
+    return d->global ? rows : (rows - 1) * d->SH + d->FH;
+}
+
+static inline uint32_t pool_size(const pool_t *d) {
+    uint32_t ifmap = pool_in_rows(d, d->TOH) * d->IW * d->TC;
+    uint32_t ofmap = d->global ? d->TC : d->TOH * d->OW * d->TC;
+    return 2 * d->prec * (ifmap + ofmap);
+}
+
+// Byte pattern of the padding, the identity of the reduction
+static inline uint8_t pool_identity(const pool_t *d) {
+    return d->max ? 0xff : 0;
+}
+
+// Replicate a value in every SIMD lane of an SSR word
+static inline double pool_splat(precision_t prec, double x) {
+    v2s v2;
+    v4s v4;
+
+    switch (prec) {
+        case FP32:
+            v2.vec = (v2f32){(float)x, (float)x};
+            return v2.f64;
+        case FP16:
+            v4.vec = (v4f16){(__fp16)x, (__fp16)x, (__fp16)x, (__fp16)x};
+            return v4.f64;
+        default:
+            return x;
+    }
+}
+
+// Units of work are distributed across clusters. For window pooling,
+// consecutive units share the channel tile. For global pooling, every
+// channel tile is owned by one cluster, which reduces all of its blocks in
+// consecutive steps.
+static inline void pool_step(const pool_layer_t *l, const pool_t *d,
+                             uint32_t i, uint32_t n_blocks, pool_step_t *s) {
+    uint32_t u, block, tile;
+    if (d->global) {
+        block = i % n_blocks;
+        tile = snrt_cluster_idx() + (i / n_blocks) * snrt_cluster_num();
+    } else {
+        u = snrt_cluster_idx() + i * snrt_cluster_num();
+        block = u % n_blocks;
+        tile = u / n_blocks;
+    }
+    uint32_t rows = d->global ? l->IH : l->OH;
+    s->oh0 = block * d->TOH;
+    s->rows = rows - s->oh0 < d->TOH ? rows - s->oh0 : d->TOH;
+    s->c0 = tile * d->TC;
+    s->cs = l->C - s->c0 < d->TC ? l->C - s->c0 : d->TC;
+}
+
+/**
+ * @brief Load the channels of a tile in the input rows needed by a block of
+ * rows into a padded TCDM buffer. Rows in the vertical padding are filled
+ * with the identity of the reduction, the horizontal padding is never
+ * written.
+ */
+static inline void pool_load_ifmap(const pool_layer_t *l, const pool_t *d,
+                                   const pool_step_t *s, void *ifmap) {
+    const uint32_t p = d->prec;
+    const uint32_t row_size = d->IW * d->TC * p;
+    const uint32_t pad_h = d->global ? 0 : l->pad_h;
+    const uint32_t pad_w = d->global ? 0 : l->pad_w;
+
+    for (uint32_t r = 0; r < pool_in_rows(d, s->rows); r++) {
+        uint32_t h = d->global ? s->oh0 : s->oh0 * d->SH;
+        int32_t ih = (int32_t)(h + r) - (int32_t)pad_h;
+        void *dst = ifmap + r * row_size;
+
+        if (ih < 0 || ih >= (int32_t)l->IH) {
+            snrt_dma_memset_async(dst, pool_identity(d), row_size);
+            continue;
+        }
+
+        dst += pad_w * d->TC * p;
+        void *src = l->ifmap + (ih * l->IW * l->C + s->c0) * p;
+        if (d->TC == l->C) {
+            snrt_dma_start_1d(dst, src, l->IW * l->C * p);
+        } else {
+            snrt_dma_start_2d(dst,       /* dst */
+                              src,       /* src */
+                              s->cs * p, /* size */
+                              d->TC * p, /* dst_stride */
+                              l->C * p,  /* src_stride */
+                              l->IW);    /* repetitions */
+        }
+    }
+}
+
+// Write back an output tile, row by row as the tile may hold more columns
+static inline void pool_store_ofmap(const pool_layer_t *l, const pool_t *d,
+                                    const pool_step_t *s, void *ofmap) {
+    const uint32_t p = d->prec;
+
+    if (d->global) {
+        snrt_dma_start_1d(l->ofmap + s->c0 * p, ofmap, s->cs * p);
+        return;
+    }
+
+    for (uint32_t r = 0; r < s->rows; r++) {
+        void *dst = l->ofmap + ((s->oh0 + r) * l->OW * l->C + s->c0) * p;
+        snrt_dma_start_2d(dst,                           /* dst */
+                          ofmap + r * d->OW * d->TC * p, /* src */
+                          s->cs * p,                     /* size */
+                          l->C * p,                      /* dst_stride */
+                          d->TC * p,                     /* src_stride */
+                          l->OW);                        /* repetitions */
+    }
+}
+
+// Reduction of operand x into accumulator c: maximum, or multiply-add with
+// the scale factor of the average
+#define POOL_FMAX_D(c, x) "fmax.d " c ", " c ", " x " \n"
+#define POOL_VFMAX_S(c, x) "vfmax.s " c ", " c ", " x " \n"
+#define POOL_VFMAX_H(c, x) "vfmax.h " c ", " c ", " x " \n"
+#define POOL_FMADD_D(c, x) "fmadd.d " c ", " x ", %[s], " c " \n"
+#define POOL_VFMAC_S(c, x) "vfmac.s " c ", " x ", %[s] \n"
+#define POOL_VFMAC_H(c, x) "vfmac.h " c ", " x ", %[s] \n"
+#define POOL_FADD_D(c, x) "fadd.d " c ", " c ", " x " \n"
+#define POOL_VFADD_S(c, x) "vfadd.s " c ", " c ", " x " \n"
+#define POOL_VFADD_H(c, x) "vfadd.h " c ", " c ", " x " \n"
+
+// Reduce the windows of POOL_UNROLL output pixels streamed by SSR0 and write
+// the results to SSR1
+#define POOL_WINDOW_ASM(OP)                                               \
+    asm volatile(                                                         \
+        "fsgnj.d %[c0], %[init], %[init] \n"                              \
+        "fsgnj.d %[c1], %[init], %[init] \n"                              \
+        "fsgnj.d %[c2], %[init], %[init] \n"                              \
+        "fsgnj.d %[c3], %[init], %[init] \n"                              \
+        "frep.o %[n_frep], 4, 0, 0 \n" OP("%[c0]", "ft0")                 \
+            OP("%[c1]", "ft0") OP("%[c2]", "ft0") OP("%[c3]", "ft0")      \
+        "fsgnj.d ft1, %[c0], %[c0] \n"                                    \
+        "fsgnj.d ft1, %[c1], %[c1] \n"                                    \
+        "fsgnj.d ft1, %[c2], %[c2] \n"                                    \
+        "fsgnj.d ft1, %[c3], %[c3] \n"                                    \
+        : [ c0 ] "=&f"(c[0]), [ c1 ] "=&f"(c[1]), [ c2 ] "=&f"(c[2]),     \
+          [ c3 ] "=&f"(c[3])                                              \
+        : [ n_frep ] "r"(n_frep), [ init ] "f"(init), [ s ] "f"(scale)    \
+        : "ft0", "ft1", "ft2", "memory")
+
+/**
+ * @brief Window pooling of a tile in TCDM. Rows of SSR words are distributed
+ * across the compute cores. SSR0 streams the windows of POOL_UNROLL
+ * consecutive output pixels, such that the reductions of an iteration are
+ * independent, and SSR1 writes the results back.
+ */
+static inline void pool_window_ssr(const pool_t *d, uint32_t rows, void *ifmap,
+                                   void *ofmap) {
+    const uint32_t compute_num = snrt_cluster_compute_core_num();
+    const uint32_t compute_id = snrt_cluster_core_idx();
+    const uint32_t unroll = POOL_UNROLL;
+    const uint32_t pixel = d->TC * d->prec;
+    const uint32_t words = pixel / sizeof(double);
+    const uint32_t n_frep = d->FH * d->FW - 1;
+    const union {
+        uint64_t u64;
+        double f64;
+    } nan = {.u64 = ~0ULL};
+    const double init = d->max ? nan.f64 : 0.0;
+    const double scale = d->scale;
+    double c[POOL_UNROLL];
+
+    snrt_ssr_loop_4d(SNRT_SSR_DM0, unroll, d->FW, d->FH, d->OW / unroll,
+                     d->SW * pixel, pixel, d->IW * pixel,
+                     unroll * d->SW * pixel);
+    snrt_ssr_repeat(SNRT_SSR_DM0, 1);
+    snrt_ssr_loop_1d(SNRT_SSR_DM1, d->OW, pixel);
+    snrt_ssr_repeat(SNRT_SSR_DM1, 1);
+
+    for (uint32_t j = compute_id; j < rows * words; j += compute_num) {
+        uint32_t r = j / words;
+        uint32_t w = j % words;
+
+        snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_4D,
+                      ifmap + r * d->SH * d->IW * pixel + w * sizeof(double));
+        snrt_ssr_write(SNRT_SSR_DM1, SNRT_SSR_1D,
+                       ofmap + r * d->OW * pixel + w * sizeof(double));
+        snrt_ssr_enable();
+
+        for (uint32_t x = 0; x < d->OW; x += unroll) {
+            switch (d->prec) {
+                case FP64:
+                    if (d->max)
+                        POOL_WINDOW_ASM(POOL_FMAX_D);
+                    else
+                        POOL_WINDOW_ASM(POOL_FMADD_D);
+                    break;
+                case FP32:
+                    if (d->max)
+                        POOL_WINDOW_ASM(POOL_VFMAX_S);
+                    else
+                        POOL_WINDOW_ASM(POOL_VFMAC_S);
+                    break;
+                case FP16:
+                    if (d->max)
+                        POOL_WINDOW_ASM(POOL_VFMAX_H);
+                    else
+                        POOL_WINDOW_ASM(POOL_VFMAC_H);
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        snrt_fpu_fence();
+        __builtin_ssr_barrier(SNRT_SSR_DM1);
+        snrt_ssr_disable();
+    }
+}
+
+// Reduce n4 groups of four and rem single operands streamed by SSR0 into the
+// accumulators, and combine these into c[0]
+#define POOL_GLOBAL_ASM(OP, COMBINE)                                        \
+    do {                                                                    \
+        if (n4)                                                             \
+            asm volatile("frep.o %[n_frep], 4, 0, 0 \n" OP("%[c0]", "ft0")  \
+                             OP("%[c1]", "ft0") OP("%[c2]", "ft0")          \
+                                 OP("%[c3]", "ft0")                         \
+                         : [ c0 ] "+f"(c[0]), [ c1 ] "+f"(c[1]),            \
+                           [ c2 ] "+f"(c[2]), [ c3 ] "+f"(c[3])             \
+                         : [ n_frep ] "r"(n4 - 1), [ s ] "f"(scale)         \
+                         : "ft0", "ft1", "ft2");                            \
+        if (rem)                                                            \
+            asm volatile("frep.o %[n_frep], 1, 0, 0 \n" OP("%[c0]", "ft0")  \
+                         : [ c0 ] "+f"(c[0])                                \
+                         : [ n_frep ] "r"(rem - 1), [ s ] "f"(scale)        \
+                         : "ft0", "ft1", "ft2");                            \
+        asm volatile(COMBINE("%[c0]", "%[c1]") COMBINE("%[c2]", "%[c3]")    \
+                         COMBINE("%[c0]", "%[c2]")                          \
+                     : [ c0 ] "+f"(c[0]), [ c2 ] "+f"(c[2])                 \
+                     : [ c1 ] "f"(c[1]), [ c3 ] "f"(c[3])                   \
+                     : "ft0", "ft1", "ft2");                                \
+    } while (0)
+
+/**
+ * @brief Global pooling of a block of input rows in TCDM into the partial
+ * results of its channel tile, which are initialized by the first block.
+ * SSR words are distributed across the compute cores, SSR0 streams all
+ * pixels of the block for a word. Average pooling accumulates the inputs
+ * scaled by the reciprocal of the map size.
+ */
+static inline void pool_global_ssr(const pool_t *d, uint32_t n_pixels,
+                                   uint32_t first, void *ifmap, void *acc) {
+    const uint32_t compute_num = snrt_cluster_compute_core_num();
+    const uint32_t compute_id = snrt_cluster_core_idx();
+    const uint32_t pixel = d->TC * d->prec;
+    const uint32_t words = pixel / sizeof(double);
+    const uint32_t n4 = n_pixels / 4;
+    const uint32_t rem = n_pixels % 4;
+    const union {
+        uint64_t u64;
+        double f64;
+    } nan = {.u64 = ~0ULL};
+    const double init = d->max ? nan.f64 : 0.0;
+    const double scale = d->scale;
+    double c[4];
+
+    snrt_ssr_loop_1d(SNRT_SSR_DM0, n_pixels, pixel);
+    snrt_ssr_repeat(SNRT_SSR_DM0, 1);
+
+    for (uint32_t w = compute_id; w < words; w += compute_num) {
+        c[0] = first ? init : ((double *)acc)[w];
+        c[1] = init;
+        c[2] = init;
+        c[3] = init;
+
+        snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_1D, ifmap + w * sizeof(double));
+        snrt_ssr_enable();
+
+        switch (d->prec) {
+            case FP64:
+                if (d->max)
+                    POOL_GLOBAL_ASM(POOL_FMAX_D, POOL_FMAX_D);
+                else
+                    POOL_GLOBAL_ASM(POOL_FMADD_D, POOL_FADD_D);
+                break;
+            case FP32:
+                if (d->max)
+                    POOL_GLOBAL_ASM(POOL_VFMAX_S, POOL_VFMAX_S);
+                else
+                    POOL_GLOBAL_ASM(POOL_VFMAC_S, POOL_VFADD_S);
+                break;
+            case FP16:
+                if (d->max)
+                    POOL_GLOBAL_ASM(POOL_VFMAX_H, POOL_VFMAX_H);
+                else
+                    POOL_GLOBAL_ASM(POOL_VFMAC_H, POOL_VFADD_H);
+                break;
+            default:
+                break;
+        }
+
+        snrt_fpu_fence();
+        snrt_ssr_disable();
+
+        ((double *)acc)[w] = c[0];
+    }
+}
+
+#undef POOL_WINDOW_ASM
+#undef POOL_GLOBAL_ASM
+
+/**
+ * @brief Pooling layer in HWC layout, see pool_layer_t. The layer is split
+ * into tiles of channels of blocks of rows, which are distributed across
+ * clusters. Within a cluster, the DMA core prefetches the padded input rows
+ * of the next tile and writes back the previous output tile while the
+ * compute cores work on the current one. Global layers reduce the blocks of
+ * a channel tile into partial results, which stay in TCDM until the last
+ * block.
+ *
+ * @param l pool_layer_t struct that holds addresses and parameters
+ * @return 0 on success, -1 if the layer is not supported or a single row of
+ * a tile does not fit into TCDM
+ */
+int pool_layer(const pool_layer_t *l) {
+    const precision_t prec = l->dtype;
+    pool_t d;
+
+    if (prec != FP64 && prec != FP32 && prec != FP16) return -1;
+    if (!pool_valid(l)) return -1;
+
+    // Pad the channels such that every pixel fills whole SSR words, and the
+    // rows such that every row is a multiple of the unrolling
+    const uint32_t lanes = sizeof(double) / prec;
+    const uint32_t cluster_num = snrt_cluster_num();
+    d.prec = prec;
+    d.global = pool_is_global(l);
+    d.max = pool_is_max(l);
+    if (d.global) {
+        d.FH = 1;
+        d.FW = 1;
+        d.SH = 1;
+        d.SW = 1;
+        d.IW = l->IW;
+        d.OW = 1;
+        d.TOH = l->IH;
+        d.TC = gemm_round_up((l->C + cluster_num - 1) / cluster_num, lanes);
+        d.scale = pool_splat(prec, 1.0 / (l->IH * l->IW));
+    } else {
+        d.FH = l->FH;
+        d.FW = l->FW;
+        d.SH = pool_stride_h(l);
+        d.SW = pool_stride_w(l);
+        d.OW = gemm_round_up(l->OW, POOL_UNROLL);
+        d.IW = l->IW + 2 * l->pad_w;
+        if (d.IW < (d.OW - 1) * d.SW + d.FW) d.IW = (d.OW - 1) * d.SW + d.FW;
+        d.TOH = (l->OH + cluster_num - 1) / cluster_num;
+        d.TC = gemm_round_up(l->C, lanes);
+        d.scale = pool_splat(prec, 1.0 / (l->FH * l->FW));
+    }
+
+    // Carve the buffers out of the free TCDM space, shrinking the larger of
+    // the two tile dimensions first
+    uint32_t l1_base = ALIGN_UP((uint32_t)snrt_l1_next(), 8);
+    uint32_t l1_end = snrt_l1_end_addr() - GEMM_TILED_L1_RESERVE;
+    if (l1_base >= l1_end) return -1;
+    const uint32_t width = d.global ? d.IW : d.OW;
+    while (pool_size(&d) > l1_end - l1_base) {
+        if (d.TOH > 1 && (d.TOH * width >= d.TC || d.TC == lanes))
+            d.TOH = (d.TOH + 1) / 2;
+        else if (d.TC > lanes)
+            d.TC = gemm_round_up(d.TC / 2, lanes);
+        else
+            return -1;
+    }
+
+    uint32_t size_ifmap = pool_in_rows(&d, d.TOH) * d.IW * d.TC * prec;
+    uint32_t size_ofmap = (d.global ? 1 : d.TOH * d.OW) * d.TC * prec;
+    void *ifmap[2], *ofmap[2];
+    ifmap[0] = (void *)l1_base;
+    ifmap[1] = ifmap[0] + size_ifmap;
+    ofmap[0] = ifmap[1] + size_ifmap;
+    ofmap[1] = ofmap[0] + size_ofmap;
+
+    const uint32_t cluster_id = snrt_cluster_idx();
+    const uint32_t n_blocks =
+        ((d.global ? l->IH : l->OH) + d.TOH - 1) / d.TOH;
+    const uint32_t n_tiles = (l->C + d.TC - 1) / d.TC;
+    uint32_t n_steps;
+    if (d.global) {
+        if (n_tiles <= cluster_id) return 0;
+        n_steps = (n_tiles - cluster_id + cluster_num - 1) / cluster_num *
+                  n_blocks;
+    } else {
+        const uint32_t n_units = n_blocks * n_tiles;
+        if (n_units <= cluster_id) return 0;
+        n_steps = (n_units - cluster_id + cluster_num - 1) / cluster_num;
+    }
+
+    // Global layers write back a tile of partial results after its last
+    // block, i.e. after every n_blocks steps
+    const uint32_t n_ofmap = d.global ? n_blocks : 1;
+    pool_step_t s, next;
+
+    if (snrt_is_dm_core()) {
+        // Fill the padding once, input transfers never overwrite it
+        if (!d.global)
+            snrt_dma_memset(ifmap[0], pool_identity(&d), 2 * size_ifmap);
+
+        pool_step(l, &d, 0, n_blocks, &s);
+        pool_load_ifmap(l, &d, &s, ifmap[0]);
+        snrt_dma_wait_all();
+    }
+
+    snrt_cluster_hw_barrier();
+
+    for (uint32_t i = 0; i < n_steps; i++) {
+        pool_step(l, &d, i, n_blocks, &s);
+
+        if (snrt_is_dm_core()) {
+            // Prefetch the inputs of the next step
+            if (i + 1 < n_steps) {
+                pool_step(l, &d, i + 1, n_blocks, &next);
+                pool_load_ifmap(l, &d, &next, ifmap[(i + 1) % 2]);
+            }
+
+            // Write back the output tile completed by the previous step
+            if (i > 0 && i % n_ofmap == 0) {
+                pool_step(l, &d, i - 1, n_blocks, &next);
+                pool_store_ofmap(l, &d, &next, ofmap[(i / n_ofmap - 1) % 2]);
+            }
+
+            snrt_dma_wait_all();
+        } else if (d.global) {
+            pool_global_ssr(&d, s.rows * d.IW, i % n_blocks == 0,
+                            ifmap[i % 2], ofmap[(i / n_blocks) % 2]);
+        } else {
+            pool_window_ssr(&d, s.rows, ifmap[i % 2], ofmap[i % 2]);
+        }
+
+        snrt_cluster_hw_barrier();
+    }
+
+    // Write back the last output tile
+    if (snrt_is_dm_core()) {
+        pool_store_ofmap(l, &d, &s, ofmap[((n_steps - 1) / n_ofmap) % 2]);
+        snrt_dma_wait_all();
+    }
+
+    return 0;
+}
@@ -0,0 +1,588 @@
+// Copyright 2023 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <stdint.h>
+
+#include "snrt.h"
+
+/**
+ * Quantized int8 x int8 -> int32 kernels for the Snitch cores, with the
+ * semantics of the GeMMX accelerator: zero points are subtracted from both
+ * operands, an int32 bias is added, and the int32 result is optionally
+ * requantized to int8 by the rescale SIMD stage. They serve as the on-device
+ * golden model and as the fallback for shapes the accelerator cannot map.
+ *
+ * Snitch has no packed integer SIMD, so the fast paths use the packed FP
+ * extensions instead. After subtracting the zero points, the int8 operands
+ * are converted to FP16 or FP32 in TCDM, where they are exact. Products are
+ * exact in FP32, and so are all partial sums as long as they stay below
+ * 2^24. Kernels whose worst-case partial sums could exceed this bound take
+ * the integer path, so the results are always bit-exact.
+ */
+
+// Magnitude up to which all integers are exact in FP32
+#define QNT_FP32_EXACT (1 << 24)
+
+/**
+ * @struct qnt_rescale_struct
+ * @brief Requantization parameters, as configured in the GeMMX rescale SIMD
+ * @var qnt_rescale_struct::input_zp
+ * Zero point subtracted from the int32 input
+ * @var qnt_rescale_struct::output_zp
+ * Zero point added to the int8 output
+ * @var qnt_rescale_struct::max_int
+ * Upper clamping bound
+ * @var qnt_rescale_struct::min_int
+ * Lower clamping bound
+ * @var qnt_rescale_struct::double_round
+ * Round half away from zero instead of half up
+ * @var qnt_rescale_struct::shift
+ * Right shifts of the groups, bitpacked four per word as in the
+ * shared_bitpacked_shift CSRs
+ * @var qnt_rescale_struct::multiplier
+ * Multipliers of the groups
+ * @var qnt_rescale_struct::groups
+ * Number of groups. Output channel c uses group c % groups.
+ */
+typedef struct qnt_rescale_struct {
+    int8_t input_zp;
+    int8_t output_zp;
+    int8_t max_int;
+    int8_t min_int;
+    uint32_t double_round;
+    const int32_t *shift;
+    const int32_t *multiplier;
+    uint32_t groups;
+} qnt_rescale_t;
+
+/**
+ * @brief Initialize the requantization parameters from the GeMMX CSR values
+ * @param csr0 value generated by gen_csr0_config()
+ * @param csr1 value generated by gen_csr1_config()
+ */
+static inline void qnt_rescale_init(qnt_rescale_t *r, uint32_t csr0,
+                                    uint32_t csr1, const int32_t *shift,
+                                    const int32_t *multiplier,
+                                    uint32_t groups) {
+    r->input_zp = (int8_t)(csr0 & 0xff);
+    r->output_zp = (int8_t)((csr0 >> 8) & 0xff);
+    r->max_int = (int8_t)((csr0 >> 16) & 0xff);
+    r->min_int = (int8_t)((csr0 >> 24) & 0xff);
+    r->double_round = csr1 & 1;
+    r->shift = shift;
+    r->multiplier = multiplier;
+    r->groups = groups;
+}
+
+/**
+ * @brief Requantize an int32 value of output channel c to int8
+ *
+ * Bit-exact model of a GeMMX rescale PE, including the wrap-around of its
+ * 64-bit product and 32-bit intermediate results.
+ */
+static inline int8_t qnt_rescale(int32_t x, const qnt_rescale_t *r,
+                                 uint32_t c) {
+    uint32_t g = c % r->groups;
+    uint32_t shift = (r->shift[g / 4] >> (8 * (g % 4))) & 0xff;
+    uint32_t s = (shift - 1) & 0xff;
+
+    // The zero point is subtracted in int32, with wrap-around as in the
+    // golden model, before the product is widened to 64 bits
+    int32_t xz = (int32_t)((uint32_t)x - (uint32_t)(int32_t)r->input_zp);
+    uint64_t prod =
+        (uint64_t)(int64_t)xz * (uint64_t)(int64_t)r->multiplier[g];
+    int64_t var0 = (int64_t)prod;
+    int32_t var1 = (s < 64) ? (int32_t)(var0 >> s) : (var0 < 0 ? -1 : 0);
+
+    uint32_t rounded = (uint32_t)var1;
+    if (r->double_round) rounded += (var1 >= 0) ? 1 : -1;
+    int32_t var2 =
+        (int32_t)((uint32_t)((int32_t)rounded >> 1) + (uint32_t)r->output_zp);
+
+    if (var2 > r->max_int) return r->max_int;
+    if (var2 < r->min_int) return r->min_int;
+    return (int8_t)var2;
+}
+
+// Largest magnitude of an int8 value after subtracting a zero point
+static inline uint32_t qnt_range(int8_t zp) {
+    return 128 + (zp < 0 ? -zp : zp);
+}
+
+// Store an int32 result and its requantized value, where requested
+static inline void qnt_store(int32_t d, uint32_t i, uint32_t c,
+                             int32_t *out32, int8_t *out8,
+                             const qnt_rescale_t *r) {
+    if (out32) out32[i] = d;
+    if (out8 && r) out8[i] = qnt_rescale(d, r, c);
+}
+
+/**
+ * @struct qgemm_layer_struct
+ * @brief Quantized GEMM D = (A - zp_a) * (B - zp_b) + C
+ * @var qgemm_layer_struct::M
+ * Number of rows of A and D
+ * @var qgemm_layer_struct::N
+ * Number of columns of B and D
+ * @var qgemm_layer_struct::K
+ * Number of columns of A and rows of B
+ * @var qgemm_layer_struct::A
+ * Row-major M x K int8 matrix with leading dimension lda
+ * @var qgemm_layer_struct::B
+ * K x N int8 matrix with leading dimension ldb, stored as N x K if transb
+ * @var qgemm_layer_struct::C
+ * Optional row-major M x N int32 bias with leading dimension ldc
+ * @var qgemm_layer_struct::D32
+ * Optional row-major M x N int32 result with leading dimension ldd
+ * @var qgemm_layer_struct::D8
+ * Optional row-major M x N requantized result with leading dimension ldd
+ * @var qgemm_layer_struct::rescale
+ * Requantization parameters, the columns of D are the output channels
+ */
+typedef struct qgemm_layer_struct {
+    uint32_t M;
+    uint32_t N;
+    uint32_t K;
+
+    const int8_t *A;
+    uint32_t lda;
+    int8_t zp_a;
+    const int8_t *B;
+    uint32_t ldb;
+    uint32_t transb;
+    int8_t zp_b;
+    const int32_t *C;
+    uint32_t ldc;
+
+    int32_t *D32;
+    int8_t *D8;
+    uint32_t ldd;
+    const qnt_rescale_t *rescale;
+} qgemm_layer_t;
+
+// Integer GEMM on the rows m0, m0 + step, ... of D
+static inline void qgemm_rows(const qgemm_layer_t *l, uint32_t m0,
+                              uint32_t step) {
+    for (uint32_t m = m0; m < l->M; m += step) {
+        for (uint32_t n = 0; n < l->N; n++) {
+            int32_t d = l->C ? l->C[m * l->ldc + n] : 0;
+            for (uint32_t k = 0; k < l->K; k++) {
+                int32_t a = l->A[m * l->lda + k] - l->zp_a;
+                int32_t b = l->transb ? l->B[n * l->ldb + k]
+                                      : l->B[k * l->ldb + n];
+                d += a * (b - l->zp_b);
+            }
+            qnt_store(d, m * l->ldd + n, n, l->D32, l->D8, l->rescale);
+        }
+    }
+}
+
+// Integer GEMM on the calling core, used as golden model
+static inline void qgemm_baseline(const qgemm_layer_t *l) {
+    qgemm_rows(l, 0, 1);
+}
+
+// Padded dimensions of the FP16 operands of the fast path. The kernel
+// consumes four elements along K per SSR word and eight columns of D at once.
+static inline uint32_t qgemm_k_pad(uint32_t k) { return (k + 3) & ~3; }
+static inline uint32_t qgemm_n_pad(uint32_t n) { return (n + 7) & ~7; }
+
+// The fast path is exact if no partial sum of an FP32 lane can reach 2^24.
+// Every lane accumulates half of the products.
+static inline uint32_t qgemm_exact(const qgemm_layer_t *l) {
+    uint64_t bound = (uint64_t)(qgemm_k_pad(l->K) / 2) * qnt_range(l->zp_a) *
+                     qnt_range(l->zp_b);
+    return l->K && bound < QNT_FP32_EXACT;
+}
+
+/**
+ * @brief Size of the TCDM work buffer of qgemm(), in bytes
+ */
+static inline uint32_t qgemm_work_size(const qgemm_layer_t *l) {
+    uint32_t kp = qgemm_k_pad(l->K);
+    uint32_t np = qgemm_n_pad(l->N);
+    return ALIGN_UP(l->M * kp * sizeof(__fp16), 8) +
+           ALIGN_UP(np * kp * sizeof(__fp16), 8) + l->M * np * sizeof(v2f32);
+}
+
+/**
+ * FP16 GEMM accumulating into pairs of FP32 lanes, C = A * B^T. A is M x K
+ * and B is N x K, both row-major with 8-byte aligned rows. N must be a
+ * multiple of 8 and K a multiple of 4. Every element of C is written as the
+ * two lanes of an expanding dot product, whose sum is the result.
+ */
+static inline void qgemm_fp16_kernel(uint32_t M, uint32_t N, uint32_t K,
+                                     const __fp16 *A, uint32_t ldA,
+                                     const __fp16 *B, uint32_t ldB, v2f32 *C,
+                                     uint32_t ldC) {
+    const uint32_t unroll = 8;
+
+    snrt_ssr_loop_3d(SNRT_SSR_DM0, K / 4, N / unroll, M, sizeof(v4f16), 0,
+                     ldA * sizeof(__fp16));
+    snrt_ssr_loop_4d(SNRT_SSR_DM1, unroll, K / 4, N / unroll, M,
+                     ldB * sizeof(__fp16), sizeof(v4f16),
+                     unroll * ldB * sizeof(__fp16), 0);
+    snrt_ssr_repeat(SNRT_SSR_DM0, unroll);
+    snrt_ssr_repeat(SNRT_SSR_DM1, 1);
+    snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_3D, (void *)A);
+    snrt_ssr_read(SNRT_SSR_DM1, SNRT_SSR_4D, (void *)B);
+    snrt_ssr_enable();
+
+    for (uint32_t m = 0; m < M; m++) {
+        for (uint32_t n = 0; n < N; n += unroll) {
+            v2f32 c0, c1, c2, c3, c4, c5, c6, c7;
+
+            asm volatile(
+                "fcvt.d.w     %[c0], zero \n"
+                "fcvt.d.w     %[c1], zero \n"
+                "fcvt.d.w     %[c2], zero \n"
+                "fcvt.d.w     %[c3], zero \n"
+                "fcvt.d.w     %[c4], zero \n"
+                "fcvt.d.w     %[c5], zero \n"
+                "fcvt.d.w     %[c6], zero \n"
+                "fcvt.d.w     %[c7], zero \n"
+                "frep.o       %[n_frep], 8, 0, 0 \n"
+                "vfdotpex.s.h %[c0], ft1, ft0 \n"
+                "vfdotpex.s.h %[c1], ft1, ft0 \n"
+                "vfdotpex.s.h %[c2], ft1, ft0 \n"
+                "vfdotpex.s.h %[c3], ft1, ft0 \n"
+                "vfdotpex.s.h %[c4], ft1, ft0 \n"
+                "vfdotpex.s.h %[c5], ft1, ft0 \n"
+                "vfdotpex.s.h %[c6], ft1, ft0 \n"
+                "vfdotpex.s.h %[c7], ft1, ft0 \n"
+                "fsd          %[c0], 0(%[c]) \n"
+                "fsd          %[c1], 8(%[c]) \n"
+                "fsd          %[c2], 16(%[c]) \n"
+                "fsd          %[c3], 24(%[c]) \n"
+                "fsd          %[c4], 32(%[c]) \n"
+                "fsd          %[c5], 40(%[c]) \n"
+                "fsd          %[c6], 48(%[c]) \n"
+                "fsd          %[c7], 56(%[c]) \n"
+                : [ c0 ] "=&f"(c0), [ c1 ] "=&f"(c1), [ c2 ] "=&f"(c2),
+                  [ c3 ] "=&f"(c3), [ c4 ] "=&f"(c4), [ c5 ] "=&f"(c5),
+                  [ c6 ] "=&f"(c6), [ c7 ] "=&f"(c7)
+                : [ n_frep ] "r"(K / 4 - 1), [ c ] "r"(C + m * ldC + n)
+                : "ft0", "ft1", "ft2", "memory");
+        }
+    }
+
+    snrt_fpu_fence();
+    snrt_ssr_disable();
+}
+
+/**
+ * @brief Quantized GEMM on all compute cores of the cluster
+ *
+ * Must be called by all cores of the cluster. The rows of D are distributed
+ * across the compute cores. If the FP16 fast path is exact for the zero
+ * points and K of the layer, the operands are converted into the work buffer
+ * of qgemm_work_size() bytes in TCDM, otherwise D is computed in integer
+ * arithmetic. Returns once the rows of the calling core are stored, the
+ * caller synchronizes before using D.
+ */
+static inline void qgemm(const qgemm_layer_t *l, void *work) {
+    const uint32_t core = snrt_cluster_core_idx();
+    const uint32_t cores = snrt_cluster_compute_core_num();
+    const uint32_t compute = snrt_is_compute_core();
+
+    if (!l->M || !l->N) return;
+
+    if (!qgemm_exact(l)) {
+        if (compute) qgemm_rows(l, core, cores);
+        return;
+    }
+
+    const uint32_t kp = qgemm_k_pad(l->K);
+    const uint32_t np = qgemm_n_pad(l->N);
+    __fp16 *a = (__fp16 *)work;
+    __fp16 *b = (__fp16 *)((char *)a + ALIGN_UP(l->M * kp * 2, 8));
+    v2f32 *acc = (v2f32 *)((char *)b + ALIGN_UP(np * kp * 2, 8));
+
+    // Subtract the zero points and convert the operands, transposing B. The
+    // padding is zero, so it does not contribute to the result.
+    if (compute) {
+        for (uint32_t m = core; m < l->M; m += cores)
+            for (uint32_t k = 0; k < kp; k++)
+                a[m * kp + k] =
+                    (k < l->K) ? (__fp16)(l->A[m * l->lda + k] - l->zp_a) : 0;
+        for (uint32_t n = core; n < np; n += cores) {
+            for (uint32_t k = 0; k < kp; k++) {
+                int32_t v = 0;
+                if (n < l->N && k < l->K)
+                    v = (l->transb ? l->B[n * l->ldb + k]
+                                   : l->B[k * l->ldb + n]) -
+                        l->zp_b;
+                b[n * kp + k] = (__fp16)v;
+            }
+        }
+    }
+
+    snrt_cluster_hw_barrier();
+
+    if (!compute || core >= l->M) return;
+
+    // Every core computes the rows core, core + cores, ...
+    uint32_t m_core = (l->M - core + cores - 1) / cores;
+    qgemm_fp16_kernel(m_core, np, kp, a + core * kp, cores * kp, b, kp,
+                      acc + core * np, cores * np);
+
+    for (uint32_t m = core; m < l->M; m += cores) {
+        for (uint32_t n = 0; n < l->N; n++) {
+            v2f32 c = acc[m * np + n];
+            int32_t d = (int32_t)c[0] + (int32_t)c[1];
+            if (l->C) d += l->C[m * l->ldc + n];
+            qnt_store(d, m * l->ldd + n, n, l->D32, l->D8, l->rescale);
+        }
+    }
+}
+
+/**
+ * @struct qdwconv_layer_struct
+ * @brief Quantized depthwise convolution on HWC feature maps
+ * @var qdwconv_layer_struct::H
+ * Height of the input feature map
+ * @var qdwconv_layer_struct::W
+ * Width of the input feature map
+ * @var qdwconv_layer_struct::C
+ * Number of channels
+ * @var qdwconv_layer_struct::KH
+ * Height of the kernel
+ * @var qdwconv_layer_struct::KW
+ * Width of the kernel
+ * @var qdwconv_layer_struct::stride
+ * Stride along both dimensions
+ * @var qdwconv_layer_struct::pad
+ * Padding on all sides. Padded pixels take the zero point of the input, so
+ * they do not contribute to the result.
+ * @var qdwconv_layer_struct::ifmap
+ * H x W x C int8 input feature map
+ * @var qdwconv_layer_struct::weights
+ * KH x KW x C int8 weights
+ * @var qdwconv_layer_struct::bias
+ * Optional int32 bias per channel
+ * @var qdwconv_layer_struct::ofmap32
+ * Optional OH x OW x C int32 output feature map
+ * @var qdwconv_layer_struct::ofmap8
+ * Optional OH x OW x C requantized output feature map
+ * @var qdwconv_layer_struct::rescale
+ * Requantization parameters
+ */
+typedef struct qdwconv_layer_struct {
+    uint32_t H;
+    uint32_t W;
+    uint32_t C;
+    uint32_t KH;
+    uint32_t KW;
+    uint32_t stride;
+    uint32_t pad;
+
+    const int8_t *ifmap;
+    int8_t zp_i;
+    const int8_t *weights;
+    int8_t zp_w;
+    const int32_t *bias;
+
+    int32_t *ofmap32;
+    int8_t *ofmap8;
+    const qnt_rescale_t *rescale;
+} qdwconv_layer_t;
+
+static inline uint32_t qdwconv_out_h(const qdwconv_layer_t *l) {
+    return (l->H + 2 * l->pad - l->KH) / l->stride + 1;
+}
+
+static inline uint32_t qdwconv_out_w(const qdwconv_layer_t *l) {
+    return (l->W + 2 * l->pad - l->KW) / l->stride + 1;
+}
+
+// Integer depthwise convolution on the output rows oh0, oh0 + step, ...
+static inline void qdwconv_rows(const qdwconv_layer_t *l, uint32_t oh0,
+                                uint32_t step) {
+    const uint32_t oh_num = qdwconv_out_h(l);
+    const uint32_t ow_num = qdwconv_out_w(l);
+
+    for (uint32_t oh = oh0; oh < oh_num; oh += step) {
+        for (uint32_t ow = 0; ow < ow_num; ow++) {
+            for (uint32_t c = 0; c < l->C; c++) {
+                int32_t d = l->bias ? l->bias[c] : 0;
+                for (uint32_t kh = 0; kh < l->KH; kh++) {
+                    for (uint32_t kw = 0; kw < l->KW; kw++) {
+                        int32_t h = oh * l->stride + kh - l->pad;
+                        int32_t w = ow * l->stride + kw - l->pad;
+                        if (h < 0 || h >= (int32_t)l->H || w < 0 ||
+                            w >= (int32_t)l->W)
+                            continue;
+                        int32_t x = l->ifmap[(h * l->W + w) * l->C + c];
+                        int32_t k = l->weights[(kh * l->KW + kw) * l->C + c];
+                        d += (x - l->zp_i) * (k - l->zp_w);
+                    }
+                }
+                uint32_t i = (oh * ow_num + ow) * l->C + c;
+                qnt_store(d, i, c, l->ofmap32, l->ofmap8, l->rescale);
+            }
+        }
+    }
+}
+
+// Integer depthwise convolution on the calling core, used as golden model
+static inline void qdwconv_baseline(const qdwconv_layer_t *l) {
+    qdwconv_rows(l, 0, 1);
+}
+
+// Channels of the FP32 buffers of the fast path, which processes four words
+// of two channels at once
+static inline uint32_t qdwconv_c_pad(uint32_t c) { return (c + 7) & ~7; }
+
+static inline uint32_t qdwconv_exact(const qdwconv_layer_t *l) {
+    uint64_t bound = (uint64_t)l->KH * l->KW * qnt_range(l->zp_i) *
+                     qnt_range(l->zp_w);
+    return bound < QNT_FP32_EXACT;
+}
+
+/**
+ * @brief Size of the TCDM work buffer of qdwconv(), in bytes
+ */
+static inline uint32_t qdwconv_work_size(const qdwconv_layer_t *l) {
+    uint32_t hp = l->H + 2 * l->pad;
+    uint32_t wp = l->W + 2 * l->pad;
+    uint32_t pixels =
+        hp * wp + l->KH * l->KW + qdwconv_out_h(l) * qdwconv_out_w(l);
+    return pixels * qdwconv_c_pad(l->C) * sizeof(float);
+}
+
+/**
+ * FP32 depthwise convolution of the output rows oh0, oh0 + step, ... on the
+ * calling core. The input is padded, and all buffers have cp channels, a
+ * multiple of 8. For every output pixel, SSR 0 streams the input window and
+ * SSR 1 the weights, four words of two channels per tap, and FREP
+ * accumulates them with packed FMAs into four independent accumulators.
+ */
+static inline void qdwconv_fp32_kernel(const qdwconv_layer_t *l, uint32_t cp,
+                                       const float *x, const float *w,
+                                       float *y, uint32_t oh0,
+                                       uint32_t step) {
+    const uint32_t wp = l->W + 2 * l->pad;
+    const uint32_t oh_num = qdwconv_out_h(l);
+    const uint32_t ow_num = qdwconv_out_w(l);
+    const uint32_t taps = l->KH * l->KW;
+
+    snrt_ssr_loop_4d(SNRT_SSR_DM0, 4, l->KW, l->KH, cp / 8, sizeof(v2f32),
+                     cp * sizeof(float), wp * cp * sizeof(float),
+                     4 * sizeof(v2f32));
+    snrt_ssr_loop_4d(SNRT_SSR_DM1, 4, l->KW, l->KH, cp / 8, sizeof(v2f32),
+                     cp * sizeof(float), l->KW * cp * sizeof(float),
+                     4 * sizeof(v2f32));
+    snrt_ssr_repeat(SNRT_SSR_DM0, 1);
+    snrt_ssr_repeat(SNRT_SSR_DM1, 1);
+
+    for (uint32_t oh = oh0; oh < oh_num; oh += step) {
+        for (uint32_t ow = 0; ow < ow_num; ow++) {
+            const float *window =
+                x + (oh * l->stride * wp + ow * l->stride) * cp;
+            float *out = y + (oh * ow_num + ow) * cp;
+
+            snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_4D, (void *)window);
+            snrt_ssr_read(SNRT_SSR_DM1, SNRT_SSR_4D, (void *)w);
+            snrt_ssr_enable();
+
+            for (uint32_t c = 0; c < cp; c += 8) {
+                v2f32 c0, c1, c2, c3;
+
+                asm volatile(
+                    "fcvt.d.w %[c0], zero \n"
+                    "fcvt.d.w %[c1], zero \n"
+                    "fcvt.d.w %[c2], zero \n"
+                    "fcvt.d.w %[c3], zero \n"
+                    "frep.o   %[n_frep], 4, 0, 0 \n"
+                    "vfmac.s  %[c0], ft0, ft1 \n"
+                    "vfmac.s  %[c1], ft0, ft1 \n"
+                    "vfmac.s  %[c2], ft0, ft1 \n"
+                    "vfmac.s  %[c3], ft0, ft1 \n"
+                    "fsd      %[c0], 0(%[out]) \n"
+                    "fsd      %[c1], 8(%[out]) \n"
+                    "fsd      %[c2], 16(%[out]) \n"
+                    "fsd      %[c3], 24(%[out]) \n"
+                    : [ c0 ] "=&f"(c0), [ c1 ] "=&f"(c1), [ c2 ] "=&f"(c2),
+                      [ c3 ] "=&f"(c3)
+                    : [ n_frep ] "r"(taps - 1), [ out ] "r"(out + c)
+                    : "ft0", "ft1", "ft2", "memory");
+            }
+
+            snrt_fpu_fence();
+            snrt_ssr_disable();
+        }
+    }
+}
+
+/**
+ * @brief Quantized depthwise convolution on all compute cores of the cluster
+ *
+ * Must be called by all cores of the cluster. The output rows are
+ * distributed across the compute cores. If the FP32 fast path is exact for
+ * the zero points and kernel size of the layer, the padded operands are
+ * converted into the work buffer of qdwconv_work_size() bytes in TCDM,
+ * otherwise the output is computed in integer arithmetic. Returns once the
+ * rows of the calling core are stored, the caller synchronizes before using
+ * the output.
+ */
+static inline void qdwconv(const qdwconv_layer_t *l, void *work) {
+    const uint32_t core = snrt_cluster_core_idx();
+    const uint32_t cores = snrt_cluster_compute_core_num();
+    const uint32_t compute = snrt_is_compute_core();
+
+    if (!qdwconv_exact(l)) {
+        if (compute) qdwconv_rows(l, core, cores);
+        return;
+    }
+
+    const uint32_t hp = l->H + 2 * l->pad;
+    const uint32_t wp = l->W + 2 * l->pad;
+    const uint32_t cp = qdwconv_c_pad(l->C);
+    const uint32_t taps = l->KH * l->KW;
+    const uint32_t ow_num = qdwconv_out_w(l);
+    float *x = (float *)work;
+    float *w = x + hp * wp * cp;
+    float *y = w + taps * cp;
+
+    // Subtract the zero points and convert the operands. The padding is zero,
+    // so it does not contribute to the result.
+    if (compute) {
+        for (uint32_t h = core; h < hp; h += cores) {
+            for (uint32_t i = 0; i < wp; i++) {
+                for (uint32_t c = 0; c < cp; c++) {
+                    int32_t v = 0;
+                    int32_t ih = h - l->pad;
+                    int32_t iw = i - l->pad;
+                    if (ih >= 0 && ih < (int32_t)l->H && iw >= 0 &&
+                        iw < (int32_t)l->W && c < l->C)
+                        v = l->ifmap[(ih * l->W + iw) * l->C + c] - l->zp_i;
+                    x[(h * wp + i) * cp + c] = v;
+                }
+            }
+        }
+        for (uint32_t t = core; t < taps; t += cores)
+            for (uint32_t c = 0; c < cp; c++)
+                w[t * cp + c] =
+                    (c < l->C) ? l->weights[t * l->C + c] - l->zp_w : 0;
+    }
+
+    snrt_cluster_hw_barrier();
+
+    if (!compute) return;
+
+    qdwconv_fp32_kernel(l, cp, x, w, y, core, cores);
+
+    for (uint32_t oh = core; oh < qdwconv_out_h(l); oh += cores) {
+        for (uint32_t ow = 0; ow < ow_num; ow++) {
+            for (uint32_t c = 0; c < l->C; c++) {
+                int32_t d = (int32_t)y[(oh * ow_num + ow) * cp + c];
+                if (l->bias) d += l->bias[c];
+                uint32_t i = (oh * ow_num + ow) * l->C + c;
+                qnt_store(d, i, c, l->ofmap32, l->ofmap8, l->rescale);
+            }
+        }
+    }
+}
@@ -8,6 +8,7 @@
 #include "snrt.h"
 // #include "printf.h"
 #include "utils.h"
+#include "vmath.h"
 
 /**
  * @struct softmax_layer_struct
@@ -24,9 +25,11 @@
  * @var softmax_layer_struct::ifmap
  * Pointer to input feature map
  * @var softmax_layer_struct::ofmap
- * Pointer to output feature map
+ * Pointer to output feature map, written back if not NULL
  * @var softmax_layer_struct::result
  * Pointer to the golden model output
+ * @var softmax_layer_struct::dtype
+ * Precision of the feature maps (FP32 or FP16)
  */
 typedef struct softmax_layer_struct {
     uint32_t BATCH_SIZE;
@@ -34,114 +37,278 @@ typedef struct softmax_layer_struct {
     uint32_t INPUT_SAMPLES;
     uint32_t REDUCE_DIM;
 
-    float *ifmap;
-    float *ofmap;
-    float *result;
+    void *ifmap;
+    void *ofmap;
+    void *result;
 
     precision_t dtype;
 } softmax_layer_t;
 
 /**
- * Implementation of the SoftMax layer.
+ * @brief Maximum of a FP32 row
+ *
+ * Groups of 8 values are streamed through SSR0 and reduced into four packed
+ * accumulators, the tail and unaligned rows are handled by the core.
  */
-static inline void softmax_fp32(float *input, float *output, int32_t ldI,
-                                int32_t batch_offset, int32_t batch_size,
-                                int32_t seq_len, int32_t input_samples) {
-    float max_core = 0.0;  // max value of the current core
-    float sum = 0.0;       // sum of the exp values of the current core
+static inline float softmax_max_fp32(float *x, uint32_t len) {
+    float max = -INFINITY;
+    uint32_t i = 0;
+    uint32_t n_vec = ((uintptr_t)x % sizeof(v2f32)) ? 0 : len / 8;
 
-    // uint32_t compute_id = snrt_global_core_idx();
-    // uint32_t num_cores = snrt_cluster_compute_core_num();
+    if (n_vec) {
+        v2f32 max0, max1, max2, max3;
 
-    for (int32_t b = 0; b < batch_size; b++) {
-        for (int32_t s = 0; s < seq_len; s++) {
-            max_core = -INFINITY;
-            sum = 0.0;
-
-            for (int32_t i = 0; i < input_samples; i++) {
-                if (input[b * batch_offset + s * ldI + i] > max_core) {
-                    max_core = input[b * batch_offset + s * ldI + i];
-                }
-            }
-
-            // compute the shifted value of the current row
-            for (int32_t i = 0; i < input_samples; i++) {
-                output[b * batch_offset + s * ldI + i] =
-                    // FIXME: Below code is erroring due to the standard math
-                    // lib conflict
-                    // TODO: Try out with musl lib
-                    // expf(input[b * batch_offset + s * ldI + i] - max_core);
-                    // FIXME: actually there should be an exponentiation
-                    input[b * batch_offset + s * ldI + i] - max_core;
-                sum += output[b * batch_offset + s * ldI + i];
-            }
-
-            // compute the softmax value of the current row
-            for (int32_t i = 0; i < input_samples; i++) {
-                // INFO: DIVSQRT unit MUST be activated in the cluster
-                // configuration
-                output[b * batch_offset + s * ldI + i] /= sum;
-                // printf("output[%d] = %f\n", compute_id * input_samples + b *
-                // batch_offset + s * ldI + i,
-                //        output[b * batch_offset + s * ldI + i]);
-            }
+        snrt_ssr_loop_1d(SNRT_SSR_DM0, n_vec * 4, sizeof(v2f32));
+        snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_1D, x);
+        snrt_ssr_enable();
+
+        asm volatile(
+            "vfcpka.s.s %[max0], %[init], %[init] \n"
+            "vfcpka.s.s %[max1], %[init], %[init] \n"
+            "vfcpka.s.s %[max2], %[init], %[init] \n"
+            "vfcpka.s.s %[max3], %[init], %[init] \n"
+            "frep.o %[n_frep], 4, 0, 0 \n"
+            "vfmax.s %[max0], ft0, %[max0] \n"
+            "vfmax.s %[max1], ft0, %[max1] \n"
+            "vfmax.s %[max2], ft0, %[max2] \n"
+            "vfmax.s %[max3], ft0, %[max3] \n"
+            "vfmax.s %[max0], %[max0], %[max1] \n"
+            "vfmax.s %[max2], %[max2], %[max3] \n"
+            "vfmax.s %[max0], %[max0], %[max2] \n"
+            : [ max0 ] "=&f"(max0), [ max1 ] "=&f"(max1),
+              [ max2 ] "=&f"(max2), [ max3 ] "=&f"(max3)
+            : [ init ] "f"(max), [ n_frep ] "r"(n_vec - 1)
+            : "ft0", "ft1", "ft2");
+
+        snrt_ssr_disable();
+
+        max = max0[0] > max0[1] ? max0[0] : max0[1];
+        i = n_vec * 8;
+    }
+
+    for (; i < len; i++) max = x[i] > max ? x[i] : max;
+
+    return max;
+}
+
+/**
+ * @brief Maximum of a FP16 row
+ *
+ * Same as softmax_max_fp32, with 16 values per group.
+ */
+static inline float softmax_max_fp16(__fp16 *x, uint32_t len) {
+    float max = -INFINITY;
+    uint32_t i = 0;
+    uint32_t n_vec = ((uintptr_t)x % sizeof(v4f16)) ? 0 : len / 16;
+
+    if (n_vec) {
+        v4f16 max0, max1, max2, max3;
+
+        snrt_ssr_loop_1d(SNRT_SSR_DM0, n_vec * 4, sizeof(v4f16));
+        snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_1D, x);
+        snrt_ssr_enable();
+
+        asm volatile(
+            "vfcpka.h.s %[max0], %[init], %[init] \n"
+            "vfcpkb.h.s %[max0], %[init], %[init] \n"
+            "vfcpka.h.s %[max1], %[init], %[init] \n"
+            "vfcpkb.h.s %[max1], %[init], %[init] \n"
+            "vfcpka.h.s %[max2], %[init], %[init] \n"
+            "vfcpkb.h.s %[max2], %[init], %[init] \n"
+            "vfcpka.h.s %[max3], %[init], %[init] \n"
+            "vfcpkb.h.s %[max3], %[init], %[init] \n"
+            "frep.o %[n_frep], 4, 0, 0 \n"
+            "vfmax.h %[max0], ft0, %[max0] \n"
+            "vfmax.h %[max1], ft0, %[max1] \n"
+            "vfmax.h %[max2], ft0, %[max2] \n"
+            "vfmax.h %[max3], ft0, %[max3] \n"
+            "vfmax.h %[max0], %[max0], %[max1] \n"
+            "vfmax.h %[max2], %[max2], %[max3] \n"
+            "vfmax.h %[max0], %[max0], %[max2] \n"
+            : [ max0 ] "=&f"(max0), [ max1 ] "=&f"(max1),
+              [ max2 ] "=&f"(max2), [ max3 ] "=&f"(max3)
+            : [ init ] "f"(max), [ n_frep ] "r"(n_vec - 1)
+            : "ft0", "ft1", "ft2");
+
+        snrt_ssr_disable();
+
+        for (uint32_t j = 0; j < 4; j++) {
+            float lane = max0[j];
+            max = lane > max ? lane : max;
         }
+        i = n_vec * 16;
     }
 
-    snrt_cluster_hw_barrier();
+    for (; i < len; i++) {
+        float val = x[i];
+        max = val > max ? val : max;
+    }
+
+    return max;
 }
 
 /**
- * @brief  SoftMax layer
+ * @brief In-place multiplication of a FP32 row by a scalar factor
  *
- * @param l softmax_layer struct that holds addresses and parameters
+ * The row is streamed through SSR0 and written back through SSR1.
+ */
+static inline void softmax_scale_fp32(float *x, uint32_t len, float factor) {
+    uint32_t i = 0;
+    uint32_t n_vec = ((uintptr_t)x % sizeof(v2f32)) ? 0 : len / 2;
+
+    if (n_vec) {
+        v2f32 factor_vec;
+
+        snrt_ssr_loop_1d(SNRT_SSR_DM0, n_vec, sizeof(v2f32));
+        snrt_ssr_loop_1d(SNRT_SSR_DM1, n_vec, sizeof(v2f32));
+        snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_1D, x);
+        snrt_ssr_write(SNRT_SSR_DM1, SNRT_SSR_1D, x);
+        snrt_ssr_enable();
+
+        asm volatile(
+            "vfcpka.s.s %[factor_vec], %[factor], %[factor] \n"
+            "frep.o %[n_frep], 1, 0, 0 \n"
+            "vfmul.s ft1, ft0, %[factor_vec] \n"
+            : [ factor_vec ] "=&f"(factor_vec)
+            : [ factor ] "f"(factor), [ n_frep ] "r"(n_vec - 1)
+            : "ft0", "ft1", "ft2", "memory");
+
+        snrt_fpu_fence();
+        __builtin_ssr_barrier(SNRT_SSR_DM1);
+        snrt_ssr_disable();
+
+        i = n_vec * 2;
+    }
+
+    for (; i < len; i++) x[i] *= factor;
+}
+
+/**
+ * @brief In-place multiplication of a FP16 row by a scalar factor
  *
+ * Same as softmax_scale_fp32, with 4 values per packed operation.
  */
-static inline void softmax_layer(softmax_layer_t *const l) {
-    uint32_t cluster_num = snrt_cluster_num();
-    uint32_t cluster_id = snrt_cluster_idx();
-    uint32_t compute_num = snrt_cluster_compute_core_num();
-    uint32_t compute_id = snrt_global_core_idx();
-
-    uint32_t ifmap_size =
-        l->BATCH_SIZE * l->SEQ_LEN * l->INPUT_SAMPLES * sizeof(float);
-    uint32_t ofmap_size = ifmap_size;
-
-    void *ptr = (float *)snrt_l1_next();
-    float *ifmap = ptr;
-    ptr += ifmap_size;
-    float *ofmap = ptr;
-    ptr += ofmap_size;
-
-    // DMA transfer the ifmap into the cluster TCDM
-    if (snrt_is_dm_core()) {
-        snrt_dma_txid_t txid_ifmap = snrt_dma_start_2d(
-            ifmap, l->ifmap, l->BATCH_SIZE * sizeof(float),
-            l->BATCH_SIZE * sizeof(float), l->BATCH_SIZE * sizeof(float),
-            l->SEQ_LEN * l->INPUT_SAMPLES * sizeof(float));
-
-        snrt_dma_wait_all();
+static inline void softmax_scale_fp16(__fp16 *x, uint32_t len, float factor) {
+    uint32_t i = 0;
+    uint32_t n_vec = ((uintptr_t)x % sizeof(v4f16)) ? 0 : len / 4;
+
+    if (n_vec) {
+        v4f16 factor_vec;
+
+        snrt_ssr_loop_1d(SNRT_SSR_DM0, n_vec, sizeof(v4f16));
+        snrt_ssr_loop_1d(SNRT_SSR_DM1, n_vec, sizeof(v4f16));
+        snrt_ssr_read(SNRT_SSR_DM0, SNRT_SSR_1D, x);
+        snrt_ssr_write(SNRT_SSR_DM1, SNRT_SSR_1D, x);
+        snrt_ssr_enable();
+
+        asm volatile(
+            "vfcpka.h.s %[factor_vec], %[factor], %[factor] \n"
+            "vfcpkb.h.s %[factor_vec], %[factor], %[factor] \n"
+            "frep.o %[n_frep], 1, 0, 0 \n"
+            "vfmul.h ft1, ft0, %[factor_vec] \n"
+            : [ factor_vec ] "=&f"(factor_vec)
+            : [ factor ] "f"(factor), [ n_frep ] "r"(n_vec - 1)
+            : "ft0", "ft1", "ft2", "memory");
+
+        snrt_fpu_fence();
+        __builtin_ssr_barrier(SNRT_SSR_DM1);
+        snrt_ssr_disable();
+
+        i = n_vec * 4;
+    }
+
+    for (; i < len; i++) x[i] = (float)x[i] * factor;
+}
+
+/**
+ * Implementation of the SoftMax layer.
+ *
+ * Every row is processed in three SSR/FREP passes over packed vectors: the
+ * maximum is reduced, the exponentials of the shifted inputs are computed
+ * and summed with snrt_vexpf_sum(), and the row is finally scaled by the
+ * reciprocal of the sum. Only an odd last element, or an unaligned row, is
+ * staged element by element. No FP division is required.
+ */
+static inline void softmax_fp32(float *input, float *output, int32_t ldI,
+                                int32_t batch_offset, int32_t batch_size,
+                                int32_t seq_len, int32_t input_samples) {
+    for (int32_t b = 0; b < batch_size; b++) {
+        for (int32_t s = 0; s < seq_len; s++) {
+            float *in = &input[b * batch_offset + s * ldI];
+            float *out = &output[b * batch_offset + s * ldI];
+
+            float max = softmax_max_fp32(in, input_samples);
+
+            float sum = snrt_vexpf_sum(in, out, max, input_samples);
+
+            softmax_scale_fp32(out, input_samples, fast_recipf(sum));
+        }
     }
+}
 
-    snrt_cluster_hw_barrier();
+/**
+ * Implementation of the SoftMax layer in FP16. Exponentials and their sum are
+ * computed in FP32, on packed vectors widened from and narrowed back to FP16
+ * by snrt_vexpf16_sum().
+ */
+static inline void softmax_fp16(__fp16 *input, __fp16 *output, int32_t ldI,
+                                int32_t batch_offset, int32_t batch_size,
+                                int32_t seq_len, int32_t input_samples) {
+    for (int32_t b = 0; b < batch_size; b++) {
+        for (int32_t s = 0; s < seq_len; s++) {
+            __fp16 *in = &input[b * batch_offset + s * ldI];
+            __fp16 *out = &output[b * batch_offset + s * ldI];
+
+            float max = softmax_max_fp16(in, input_samples);
 
-    if (snrt_is_compute_core()) {
-        // determine the row offset for each core
-        int32_t row_offset = compute_id * l->INPUT_SAMPLES;
+            float sum = snrt_vexpf16_sum(in, out, max, input_samples);
 
-        // determine the row stride of each matrix
-        int32_t ldI = compute_num * l->INPUT_SAMPLES;
+            softmax_scale_fp16(out, input_samples, fast_recipf(sum));
+        }
+    }
+}
 
-        // determine the batch offset for each core
-        int32_t batch_offset = l->SEQ_LEN * l->INPUT_SAMPLES;
+// Per-core part of the SoftMax layer on a tile of rows
+static inline void softmax_rows(const void *args, void *input, void *output,
+                                uint32_t rows, uint32_t core, uint32_t cores) {
+    const softmax_layer_t *l = args;
 
-        // printf("row_offset: %d, ldI: %d\n", row_offset, ldI);
-        softmax_fp32(&ifmap[row_offset], &ofmap[row_offset], ldI, batch_offset,
-                     l->BATCH_SIZE, l->SEQ_LEN / 8, l->INPUT_SAMPLES);
+    int32_t row_offset = core * l->INPUT_SAMPLES;
+    int32_t ldI = cores * l->INPUT_SAMPLES;
+    int32_t seq_len = (rows + cores - 1 - core) / cores;
 
-    } else {
-        snrt_cluster_hw_barrier();
+    switch (l->dtype) {
+        case FP32:
+            softmax_fp32((float *)input + row_offset,
+                         (float *)output + row_offset, ldI, 0, 1, seq_len,
+                         l->INPUT_SAMPLES);
+            break;
+        case FP16:
+            softmax_fp16((__fp16 *)input + row_offset,
+                         (__fp16 *)output + row_offset, ldI, 0, 1, seq_len,
+                         l->INPUT_SAMPLES);
+            break;
+        default:
+            break;
     }
+}
+
+/**
+ * @brief  SoftMax layer
+ *
+ * The rows of all batches are distributed across the clusters and their
+ * compute cores, see dnn_rows_run().
+ *
+ * @param l softmax_layer struct that holds addresses and parameters
+ * @return 0 on success, -1 if a row does not fit into TCDM
+ */
+static inline int softmax_layer(softmax_layer_t *const l) {
+    uint32_t row_size = l->INPUT_SAMPLES * l->dtype;
+
+    int ret = dnn_rows_run(softmax_rows, l, l->ifmap, l->ofmap,
+                           l->BATCH_SIZE * l->SEQ_LEN, row_size, row_size,
+                           snrt_l1_next());
 
     snrt_global_barrier();
-}
\ No newline at end of file
+    return ret;
+}
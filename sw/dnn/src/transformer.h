@@ -0,0 +1,403 @@
+// Copyright 2023 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "blas.h"
+#include "gelu.h"
+#include "layernorm.h"
+#include "snrt.h"
+#include "softmax.h"
+#include "utils.h"
+
+// Rows of the largest weight matrix streamed into one TCDM weight buffer.
+// Matrices with fewer input features use proportionally more rows.
+#ifndef TRANSFORMER_TILE_N
+#define TRANSFORMER_TILE_N 8
+#endif
+
+/**
+ * @struct transformer_layer_struct
+ * @brief This structure contains all parameters necessary for a transformer
+ * encoder block. All weights use the PyTorch nn.Linear layout, i.e. one row
+ * of input features per output feature.
+ * @var transformer_layer_struct::SEQ_LEN
+ * Number of tokens
+ * @var transformer_layer_struct::EMBEDDINGS
+ * Size of each token embedding
+ * @var transformer_layer_struct::HEADS
+ * Number of attention heads, must divide EMBEDDINGS
+ * @var transformer_layer_struct::FF
+ * Hidden size of the MLP
+ * @var transformer_layer_struct::EPS
+ * Epsilon of both LayerNorms
+ * @var transformer_layer_struct::GELU_IMPL
+ * GELU implementation of the MLP
+ * @var transformer_layer_struct::ifmap
+ * Pointer to the input tokens, SEQ_LEN x EMBEDDINGS
+ * @var transformer_layer_struct::ofmap
+ * Pointer to the output tokens, SEQ_LEN x EMBEDDINGS
+ * @var transformer_layer_struct::wq
+ * Pointers to the query, key, value and output projections and their biases
+ * @var transformer_layer_struct::gamma1
+ * Pointers to the parameters of the LayerNorm after the attention
+ * @var transformer_layer_struct::w1
+ * Pointers to the MLP weights, FF x EMBEDDINGS and EMBEDDINGS x FF, and
+ * their biases
+ * @var transformer_layer_struct::gamma2
+ * Pointers to the parameters of the LayerNorm after the MLP
+ * @var transformer_layer_struct::k
+ * Pointer to a SEQ_LEN x EMBEDDINGS scratch buffer in main memory for the
+ * keys, which are shared by all clusters
+ * @var transformer_layer_struct::vt
+ * Pointer to an EMBEDDINGS x SEQ_LEN scratch buffer in main memory for the
+ * transposed values, which are shared by all clusters
+ * @var transformer_layer_struct::result
+ * Pointer to the golden model output
+ * @var transformer_layer_struct::dtype
+ * Precision of the tokens and parameters (FP32 or FP16)
+ */
+typedef struct transformer_layer_struct {
+    uint32_t SEQ_LEN;
+    uint32_t EMBEDDINGS;
+    uint32_t HEADS;
+    uint32_t FF;
+    float EPS;
+    gelu_impl_t GELU_IMPL;
+
+    void *ifmap;
+    void *ofmap;
+    void *wq, *wk, *wv, *wo;
+    void *bq, *bk, *bv, *bo;
+    void *gamma1, *beta1;
+    void *w1, *b1, *w2, *b2;
+    void *gamma2, *beta2;
+    void *k;
+    void *vt;
+    void *result;
+
+    precision_t dtype;
+} transformer_layer_t;
+
+// TCDM copies of the bias vectors and LayerNorm parameters
+typedef struct {
+    void *bq, *bk, *bv, *bo, *b1, *b2;
+    void *gamma1, *beta1, *gamma2, *beta2;
+} transformer_params_t;
+
+// Allocate a TCDM copy of a vector at ptr and start loading it. Returns the
+// first free address after it.
+static inline void *transformer_load_vec(void **dst, const void *src,
+                                         uint32_t size, void *ptr) {
+    *dst = ptr;
+    if (snrt_is_dm_core()) snrt_dma_start_1d(ptr, src, size);
+    return ptr + ALIGN_UP(size, 8);
+}
+
+static inline void *transformer_load_params(const transformer_layer_t *l,
+                                            void *ptr,
+                                            transformer_params_t *prm) {
+    uint32_t e_size = l->EMBEDDINGS * l->dtype;
+    uint32_t f_size = l->FF * l->dtype;
+
+    ptr = transformer_load_vec(&prm->bq, l->bq, e_size, ptr);
+    ptr = transformer_load_vec(&prm->bk, l->bk, e_size, ptr);
+    ptr = transformer_load_vec(&prm->bv, l->bv, e_size, ptr);
+    ptr = transformer_load_vec(&prm->bo, l->bo, e_size, ptr);
+    ptr = transformer_load_vec(&prm->b1, l->b1, f_size, ptr);
+    ptr = transformer_load_vec(&prm->b2, l->b2, e_size, ptr);
+    ptr = transformer_load_vec(&prm->gamma1, l->gamma1, e_size, ptr);
+    ptr = transformer_load_vec(&prm->beta1, l->beta1, e_size, ptr);
+    ptr = transformer_load_vec(&prm->gamma2, l->gamma2, e_size, ptr);
+    ptr = transformer_load_vec(&prm->beta2, l->beta2, e_size, ptr);
+    return ptr;
+}
+
+// Initialize the rows of C which the calling compute core accumulates in
+// gemm() with the bias, plus the residual if not NULL
+static inline void transformer_init_rows(precision_t prec, void *c, uint32_t m,
+                                         uint32_t n, void *bias, void *res) {
+    for (uint32_t r = snrt_cluster_core_idx(); r < m;
+         r += snrt_cluster_compute_core_num()) {
+        for (uint32_t j = 0; j < n; j++) {
+            double v = gemm_load(prec, bias, j);
+            if (res) v += gemm_load(prec, res, r * n + j);
+            gemm_store(prec, c, r * n + j, v);
+        }
+    }
+}
+
+/**
+ * @struct transformer_wbuf_t
+ * @brief Two TCDM buffers through which the weight matrices are streamed
+ *
+ * @var transformer_wbuf_t::size
+ * Size of every buffer in bytes, holding at least one row of every matrix
+ * @var transformer_wbuf_t::cur
+ * Buffer of the first tile of the next matrix
+ * @var transformer_wbuf_t::pre
+ * Matrix whose first tile was prefetched into buffer cur, or NULL
+ */
+typedef struct {
+    void *buf[2];
+    uint32_t size;
+    uint32_t cur;
+    const void *pre;
+} transformer_wbuf_t;
+
+// Rows of an n x k weight matrix per tile
+static inline uint32_t transformer_tile_n(const transformer_wbuf_t *wb,
+                                          precision_t prec, uint32_t n,
+                                          uint32_t k) {
+    uint32_t tn = wb->size / (k * prec);
+    if (tn > GEMM_UNROLL) tn -= tn % GEMM_UNROLL;
+    return tn > n ? n : tn;
+}
+
+/**
+ * @brief Linear projection of TCDM rows with weights streamed from main
+ *        memory
+ *
+ * Computes C = A * W^T + bias (+ res) for an m x k matrix A and an n x k
+ * matrix W in main memory. W is streamed through the weight buffers in tiles
+ * of output features: the DM core prefetches the next tile while the compute
+ * cores multiply with the current one. During the last tile, it prefetches
+ * the first tile of the n' x k' matrix of the next call, such that the
+ * transfers also overlap with the computation across matrices. Must be
+ * called by all cores of the cluster.
+ *
+ * @param wb weight buffers, shared by consecutive calls
+ * @param next matrix of the next call, or NULL
+ */
+static inline void transformer_linear(precision_t prec, uint32_t m, uint32_t n,
+                                      uint32_t k, void *a, void *w, void *bias,
+                                      void *res, void *c,
+                                      transformer_wbuf_t *wb, void *next,
+                                      uint32_t next_n, uint32_t next_k) {
+    const uint32_t tn = transformer_tile_n(wb, prec, n, k);
+    const uint32_t n_tiles = (n + tn - 1) / tn;
+    const uint32_t b = wb->cur;
+
+    // Also waits for all transfers the caller has started
+    if (snrt_is_dm_core()) {
+        if (wb->pre != w) snrt_dma_start_1d(wb->buf[b], w, tn * k * prec);
+        snrt_dma_wait_all();
+    }
+
+    snrt_cluster_hw_barrier();
+
+    for (uint32_t j = 0; j < n_tiles; j++) {
+        uint32_t n0 = j * tn;
+        uint32_t nj = (n - n0 < tn) ? n - n0 : tn;
+        void *nbuf = wb->buf[(b + j + 1) % 2];
+
+        if (snrt_is_dm_core()) {
+            if (j + 1 < n_tiles) {
+                uint32_t n1 = n0 + tn;
+                uint32_t nn = (n - n1 < tn) ? n - n1 : tn;
+                snrt_dma_start_1d(nbuf, w + n1 * k * prec, nn * k * prec);
+                snrt_dma_wait_all();
+            } else if (next) {
+                uint32_t nn = transformer_tile_n(wb, prec, next_n, next_k);
+                snrt_dma_start_1d(nbuf, next, nn * next_k * prec);
+                snrt_dma_wait_all();
+            }
+        } else {
+            // Every core initializes the rows it accumulates into, so no
+            // barrier is required before the first tile
+            if (j == 0) transformer_init_rows(prec, c, m, n, bias, res);
+            gemm(prec, 0, 1, 0, 1, m, nj, k, 1, a, k, wb->buf[(b + j) % 2],
+                 k, 1, c + n0 * prec, n);
+        }
+
+        snrt_cluster_hw_barrier();
+    }
+
+    wb->cur = (b + n_tiles) % 2;
+    wb->pre = next;
+}
+
+// Largest number of rows of a block with row_size bytes per row which fits
+// between ptr and end, rounded to a multiple of the compute cores. Every row
+// buffer is aligned to a double word, hence the slack.
+static inline uint32_t transformer_block_rows(void *ptr, uint32_t end,
+                                              uint32_t row_size) {
+    const uint32_t compute_num = snrt_cluster_compute_core_num();
+    uint32_t slack = 8 * sizeof(double);
+
+    if ((uint32_t)ptr + slack + row_size > end) return 0;
+    uint32_t rows = (end - (uint32_t)ptr - slack) / row_size;
+    if (rows > compute_num) rows -= rows % compute_num;
+    return rows;
+}
+
+/**
+ * @brief  Transformer encoder block
+ *
+ * Computes x1 = LayerNorm(x + MultiHeadAttention(x)) followed by
+ * y = LayerNorm(x1 + W2 * GELU(W1 * x1)), with post-normalization as in the
+ * original transformer.
+ *
+ * The tokens are distributed across the clusters in contiguous blocks. In a
+ * first phase, every cluster projects its tokens to keys and values, which
+ * are exchanged through main memory. In the second phase, every cluster
+ * loads all keys and values into its TCDM and processes its tokens in blocks
+ * which fit into TCDM. All intermediate results of a block stay in TCDM
+ * and the weight matrices are streamed in tiles, one after the other, see
+ * transformer_linear().
+ *
+ * @param l transformer_layer struct that holds addresses and parameters
+ * @return 0 on success, -1 if the shape is invalid or the keys and values do
+ *         not fit into TCDM
+ */
+static inline int transformer_layer(const transformer_layer_t *l) {
+    const precision_t p = l->dtype;
+    const uint32_t S = l->SEQ_LEN;
+    const uint32_t E = l->EMBEDDINGS;
+    const uint32_t F = l->FF;
+    const uint32_t dh = E / l->HEADS;
+    const uint32_t compute_num = snrt_cluster_compute_core_num();
+    const uint32_t compute_id = snrt_cluster_core_idx();
+    const uint32_t end = snrt_l1_end_addr() - DNN_L1_RESERVE;
+
+    if (E % l->HEADS) return -1;
+
+    uint32_t first;
+    uint32_t n_rows = dnn_cluster_rows(S, &first);
+
+    // Resident parameters and weight buffers
+    void *ptr = snrt_l1_next();
+    transformer_params_t prm;
+    ptr = transformer_load_params(l, ptr, &prm);
+    transformer_wbuf_t wb;
+    wb.size = ALIGN_UP(TRANSFORMER_TILE_N * (E > F ? E : F) * p, 8);
+    wb.buf[0] = ptr;
+    wb.buf[1] = ptr + wb.size;
+    wb.cur = 0;
+    wb.pre = NULL;
+    ptr += 2 * wb.size;
+
+    // Phase 1 keeps the input, keys, values and transposed values of a
+    // block. Phase 2 keeps all keys and values, and the input, queries,
+    // scores, context, attention output, normalized attention output and
+    // MLP hidden layer of a block.
+    void *kv = ptr;
+    void *ptr2 = kv + 2 * ALIGN_UP(S * E * p, 8);
+    uint32_t t1 = transformer_block_rows(ptr, end, 4 * E * p);
+    uint32_t t2 = transformer_block_rows(ptr2, end, (5 * E + S + F) * p);
+    if (!t1 || !t2) return -1;
+
+    // Phase 1: keys and values of the tokens of this cluster
+    void *x = ptr;
+    void *kb = x + ALIGN_UP(t1 * E * p, 8);
+    void *v = kb + ALIGN_UP(t1 * E * p, 8);
+    void *vtb = v + ALIGN_UP(t1 * E * p, 8);
+
+    for (uint32_t r0 = 0; r0 < n_rows; r0 += t1) {
+        uint32_t t = (n_rows - r0 < t1) ? n_rows - r0 : t1;
+        uint32_t row = first + r0;
+
+        if (snrt_is_dm_core())
+            snrt_dma_start_1d(x, l->ifmap + row * E * p, t * E * p);
+
+        // The values are followed by the keys of the next block, or the
+        // queries of the first block of phase 2
+        void *next = r0 + t < n_rows ? l->wk : l->wq;
+        transformer_linear(p, t, E, E, x, l->wk, prm.bk, NULL, kb, &wb, l->wv,
+                           E, E);
+        transformer_linear(p, t, E, E, x, l->wv, prm.bv, NULL, v, &wb, next,
+                           E, E);
+
+        if (snrt_is_compute_core()) gemm_tile_transpose(p, v, vtb, t, E);
+
+        snrt_cluster_hw_barrier();
+
+        if (snrt_is_dm_core()) {
+            snrt_dma_start_1d(l->k + row * E * p, kb, t * E * p);
+            snrt_dma_start_2d(l->vt + row * p, vtb, t * p, S * p, t * p, E);
+            snrt_dma_wait_all();
+        }
+
+        snrt_cluster_hw_barrier();
+    }
+
+    snrt_global_barrier();
+
+    // Phase 2: attention and MLP of the tokens of this cluster
+    void *k = kv;
+    void *vt = kv + ALIGN_UP(S * E * p, 8);
+    x = ptr2;
+    void *q = x + ALIGN_UP(t2 * E * p, 8);
+    void *sc = q + ALIGN_UP(t2 * E * p, 8);
+    void *ctx = sc + ALIGN_UP(t2 * S * p, 8);
+    void *xa = ctx + ALIGN_UP(t2 * E * p, 8);
+    void *x1 = xa + ALIGN_UP(t2 * E * p, 8);
+    void *h = x1 + ALIGN_UP(t2 * E * p, 8);
+
+    if (snrt_is_dm_core() && n_rows) {
+        snrt_dma_start_1d(k, l->k, S * E * p);
+        snrt_dma_start_1d(vt, l->vt, S * E * p);
+    }
+
+    // Arguments of the row kernels of the other layers
+    softmax_layer_t sm_l = {.INPUT_SAMPLES = S, .dtype = p};
+    gelu_layer_t gelu_l = {.HIDDEN_NODES = F, .IMPL = l->GELU_IMPL, .dtype = p};
+    layernorm_layer_t ln_l = {.EMBEDDINGS = E, .EPS = l->EPS, .dtype = p};
+    layernorm_rows_args_t ln1 = {&ln_l, prm.gamma1, prm.beta1};
+    layernorm_rows_args_t ln2 = {&ln_l, prm.gamma2, prm.beta2};
+    float scale = fast_rsqrtf((float)dh);
+
+    for (uint32_t r0 = 0; r0 < n_rows; r0 += t2) {
+        uint32_t t = (n_rows - r0 < t2) ? n_rows - r0 : t2;
+        uint32_t row = first + r0;
+
+        if (snrt_is_dm_core())
+            snrt_dma_start_1d(x, l->ifmap + row * E * p, t * E * p);
+
+        transformer_linear(p, t, E, E, x, l->wq, prm.bq, NULL, q, &wb, l->wo,
+                           E, E);
+
+        // gemm() and the row kernels interleave rows across the compute
+        // cores in the same way, so every core only touches its own rows of
+        // the queries, scores and context and no barriers are required
+        if (snrt_is_compute_core()) {
+            for (uint32_t hd = 0; hd < l->HEADS; hd++) {
+                gemm(p, 0, 1, 0, 1, t, S, dh, scale, q + hd * dh * p, E,
+                     k + hd * dh * p, E, 0, sc, S);
+                softmax_rows(&sm_l, sc, sc, t, compute_id, compute_num);
+                gemm(p, 0, 1, 0, 1, t, dh, S, 1, sc, S, vt + hd * dh * S * p,
+                     S, 0, ctx + hd * dh * p, E);
+            }
+        }
+
+        transformer_linear(p, t, E, E, ctx, l->wo, prm.bo, x, xa, &wb, l->w1,
+                           F, E);
+        if (snrt_is_compute_core())
+            layernorm_rows(&ln1, xa, x1, t, compute_id, compute_num);
+
+        transformer_linear(p, t, F, E, x1, l->w1, prm.b1, NULL, h, &wb, l->w2,
+                           E, F);
+        if (snrt_is_compute_core())
+            gelu_rows(&gelu_l, h, h, t, compute_id, compute_num);
+
+        // The second residual reuses the attention output buffer and the
+        // block output the query buffer
+        void *next = r0 + t < n_rows ? l->wq : NULL;
+        transformer_linear(p, t, E, F, h, l->w2, prm.b2, x1, xa, &wb, next,
+                           E, E);
+        if (snrt_is_compute_core())
+            layernorm_rows(&ln2, xa, q, t, compute_id, compute_num);
+
+        snrt_cluster_hw_barrier();
+
+        if (snrt_is_dm_core() && l->ofmap) {
+            snrt_dma_start_1d(l->ofmap + row * E * p, q, t * E * p);
+            snrt_dma_wait_all();
+        }
+    }
+
+    snrt_global_barrier();
+
+    return 0;
+}
@@ -6,6 +6,246 @@
 
 #include "snrt.h"
 
+/**
+ * @brief Fast branch-free approximation of expf
+ *
+ * The argument is split as x * log2(e) = n + f with |f| <= 0.5. 2^f is
+ * evaluated with a degree-5 polynomial and n is added to its exponent field.
+ * The relative error is below 1e-5 for x in [-86, 88]. Smaller arguments
+ * saturate to the smallest normal result instead of flushing to zero.
+ *
+ * @param x argument
+ * @return approximation of e^x
+ */
+static inline float fast_expf(float x) {
+    union {
+        float f;
+        int32_t i;
+    } r, p;
+
+    float t = x * 1.442695041f;
+    t = t < -125.f ? -125.f : t;
+    t = t > 127.f ? 127.f : t;
+
+    // Round to the nearest integer by aligning to the mantissa LSB
+    r.f = t + 12582912.f;
+    int32_t n = r.i - 0x4B400000;
+    float f = t - (float)n;
+
+    p.f = 1.333355815e-3f;
+    p.f = p.f * f + 9.618129108e-3f;
+    p.f = p.f * f + 5.550410866e-2f;
+    p.f = p.f * f + 2.402265070e-1f;
+    p.f = p.f * f + 6.931471806e-1f;
+    p.f = p.f * f + 1.f;
+    p.i += n << 23;
+    return p.f;
+}
+
+/**
+ * @brief Reciprocal of a positive normal float without the FP divider
+ *
+ * An initial estimate obtained from the exponent bits is refined with three
+ * Newton-Raphson iterations, which gives a relative error below 2e-7.
+ *
+ * @param x positive normal argument
+ * @return approximation of 1 / x
+ */
+static inline float fast_recipf(float x) {
+    union {
+        float f;
+        int32_t i;
+    } r;
+
+    r.f = x;
+    r.i = 0x7EF311C7 - r.i;
+    r.f = r.f * (2.f - x * r.f);
+    r.f = r.f * (2.f - x * r.f);
+    r.f = r.f * (2.f - x * r.f);
+    return r.f;
+}
+
+/**
+ * @brief Reciprocal square root of a positive normal float without the FP
+ *        divider and square root unit
+ *
+ * An initial estimate obtained from the exponent bits is refined with three
+ * Newton-Raphson iterations, which gives a relative error below 2e-7.
+ *
+ * @param x positive normal argument
+ * @return approximation of 1 / sqrt(x)
+ */
+static inline float fast_rsqrtf(float x) {
+    union {
+        float f;
+        int32_t i;
+    } r;
+
+    float half = 0.5f * x;
+    r.f = x;
+    r.i = 0x5F3759DF - (r.i >> 1);
+    r.f = r.f * (1.5f - half * r.f * r.f);
+    r.f = r.f * (1.5f - half * r.f * r.f);
+    r.f = r.f * (1.5f - half * r.f * r.f);
+    return r.f;
+}
+
+// Amount of TCDM at the top of L1 which is reserved for the stacks, TLS and
+// CLS and therefore not available to the row-parallel layers
+#ifndef DNN_L1_RESERVE
+#define DNN_L1_RESERVE \
+    (snrt_cluster_core_num() * ((1 << SNRT_LOG2_STACK_SIZE) + 8) + 1024)
+#endif
+
+// Upper bounds on the number of clusters and of compute cores per cluster
+// the row-parallel layers are distributed over, zero means all of them.
+// Meant for scaling studies, must be equal on all cores entering a layer.
+static uint32_t dnn_max_clusters = 0;
+static uint32_t dnn_max_compute_cores = 0;
+
+static inline uint32_t dnn_cluster_num() {
+    uint32_t n = snrt_cluster_num();
+    return (dnn_max_clusters && dnn_max_clusters < n) ? dnn_max_clusters : n;
+}
+
+static inline uint32_t dnn_compute_core_num() {
+    uint32_t n = snrt_cluster_compute_core_num();
+    return (dnn_max_compute_cores && dnn_max_compute_cores < n)
+               ? dnn_max_compute_cores
+               : n;
+}
+
+/**
+ * @brief Contiguous range of rows processed by the calling cluster
+ *
+ * Remainder rows are given to the first clusters, one each. Clusters beyond
+ * dnn_cluster_num() get no rows.
+ *
+ * @param rows total number of rows
+ * @param first returns the first row of the cluster
+ * @return number of rows of the cluster
+ */
+static inline uint32_t dnn_cluster_rows(uint32_t rows, uint32_t *first) {
+    const uint32_t cluster_num = dnn_cluster_num();
+    const uint32_t cluster_id = snrt_cluster_idx();
+
+    *first = 0;
+    if (cluster_id >= cluster_num) return 0;
+    uint32_t frac = rows / cluster_num;
+    uint32_t rem = rows % cluster_num;
+    *first = cluster_id * frac + (cluster_id < rem ? cluster_id : rem);
+    return frac + (cluster_id < rem);
+}
+
+/**
+ * @brief Per-core computation of a row-parallel layer on one TCDM tile
+ *
+ * Rows of the tile are interleaved across the compute cores, i.e. core
+ * `core` processes rows core, core + cores, core + 2 * cores, ...
+ *
+ * @param args layer specific arguments
+ * @param input first input row of the tile
+ * @param output first output row of the tile
+ * @param rows number of rows in the tile
+ * @param core index of the calling compute core
+ * @param cores number of compute cores working on the tile
+ */
+typedef void (*dnn_rows_fn_t)(const void *args, void *input, void *output,
+                              uint32_t rows, uint32_t core, uint32_t cores);
+
+/**
+ * @brief Distribute a layer which maps independent rows to rows across all
+ *        clusters and compute cores
+ *
+ * Every cluster processes a contiguous range of rows, which is streamed
+ * through two TCDM tiles of input and output rows. The DM core loads the
+ * next tile and stores the previous one while the compute cores process the
+ * current one. Every cluster writes back its own rows. Must be called by all
+ * cores of all clusters, the caller synchronizes the clusters afterwards.
+ *
+ * @param fn per-core computation on a tile
+ * @param args layer specific arguments passed to fn
+ * @param ifmap input rows in main memory
+ * @param ofmap output rows in main memory, not written back if NULL
+ * @param rows total number of rows
+ * @param in_row size of an input row in bytes
+ * @param out_row size of an output row in bytes
+ * @param l1 first free TCDM address, e.g. after resident layer parameters
+ * @return 0 on success, -1 if a single row does not fit into TCDM
+ */
+static inline int dnn_rows_run(dnn_rows_fn_t fn, const void *args, void *ifmap,
+                               void *ofmap, uint32_t rows, uint32_t in_row,
+                               uint32_t out_row, void *l1) {
+    const uint32_t compute_num = dnn_compute_core_num();
+    const uint32_t compute_id = snrt_cluster_core_idx();
+
+    uint32_t first;
+    uint32_t n_rows = dnn_cluster_rows(rows, &first);
+    if (n_rows == 0) return 0;
+
+    // Largest tile whose double buffers fit into the free TCDM, rounded to a
+    // multiple of the compute cores to balance the work
+    uint32_t base = ALIGN_UP((uint32_t)l1, sizeof(double));
+    uint32_t end = snrt_l1_end_addr() - DNN_L1_RESERVE;
+    uint32_t slack = 4 * sizeof(double);
+    if (end < base + slack + 2 * (in_row + out_row)) return -1;
+    uint32_t tile = (end - base - slack) / (2 * (in_row + out_row));
+    if (tile >= n_rows)
+        tile = n_rows;
+    else if (tile > compute_num)
+        tile -= tile % compute_num;
+    uint32_t n_tiles = (n_rows + tile - 1) / tile;
+
+    void *in[2], *out[2];
+    in[0] = (void *)base;
+    in[1] = in[0] + ALIGN_UP(tile * in_row, sizeof(double));
+    out[0] = in[1] + ALIGN_UP(tile * in_row, sizeof(double));
+    out[1] = out[0] + ALIGN_UP(tile * out_row, sizeof(double));
+
+    void *src = ifmap + first * in_row;
+    void *dst = ofmap + first * out_row;
+
+    if (snrt_is_dm_core()) {
+        snrt_dma_start_1d(in[0], src, tile * in_row);
+        snrt_dma_wait_all();
+    }
+
+    snrt_cluster_hw_barrier();
+
+    for (uint32_t i = 0; i < n_tiles; i++) {
+        uint32_t r0 = i * tile;
+        uint32_t r = (n_rows - r0 < tile) ? n_rows - r0 : tile;
+
+        if (snrt_is_dm_core()) {
+            // Prefetch the next tile and write back the previous one
+            if (i + 1 < n_tiles) {
+                uint32_t r1 = r0 + tile;
+                uint32_t n1 = (n_rows - r1 < tile) ? n_rows - r1 : tile;
+                snrt_dma_start_1d(in[(i + 1) % 2], src + r1 * in_row,
+                                  n1 * in_row);
+            }
+            if (i > 0 && ofmap)
+                snrt_dma_start_1d(dst + (r0 - tile) * out_row, out[(i - 1) % 2],
+                                  tile * out_row);
+            snrt_dma_wait_all();
+        } else if (compute_id < compute_num) {
+            fn(args, in[i % 2], out[i % 2], r, compute_id, compute_num);
+        }
+
+        snrt_cluster_hw_barrier();
+    }
+
+    // Write back the last tile
+    if (snrt_is_dm_core() && ofmap) {
+        uint32_t r0 = (n_tiles - 1) * tile;
+        snrt_dma_start_1d(dst + r0 * out_row, out[(n_tiles - 1) % 2],
+                          (n_rows - r0) * out_row);
+        snrt_dma_wait_all();
+    }
+
+    return 0;
+}
+
 /**
  * @brief checks correctness of feature map
  *
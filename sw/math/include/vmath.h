@@ -0,0 +1,924 @@
+// Copyright 2023 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <stdint.h>
+
+#include "snrt.h"
+
+/**
+ * @file
+ * @brief Vectorized elementary functions for the Snitch FPU
+ *
+ * Array-in/array-out versions of expf, logf, tanhf and 1/sqrtf, evaluated on
+ * packed v2f32 operands streamed through the SSRs. The FREP sequencer holds
+ * at most 16 instructions, so every function is split into a few passes which
+ * each fit one FREP body. Intermediate streams are staged in chunks of
+ * SNRT_VMATH_CHUNK elements through buffers on the stack, which lives in the
+ * TCDM. The SSRs have no indirection, so range reduction is table-free:
+ * exponents are built and extracted with packed integer conversions.
+ *
+ * Maximum error over the supported domain, measured against a
+ * double-precision reference:
+ *
+ * | Function     | Domain                      | Max error |
+ * |--------------|-----------------------------|-----------|
+ * | snrt_vexpf   | all finite x                | 1.5 ULP   |
+ * | snrt_vlogf   | [2^-126, 2^127 * sqrt(2))   | 4 ULP     |
+ * | snrt_vtanhf  | all finite x                | 4 ULP     |
+ * | snrt_vrsqrtf | [2^-126, 2^128)             | 2 ULP     |
+ *
+ * snrt_vexpf flushes results below about 2^-125 (x < -87) to zero and
+ * overflows to +inf above FLT_MAX. NaN inputs are not propagated.
+ * snrt_vexpf_sum also returns the sum of its results, as softmax needs, within
+ * the same passes. The FP16 variants widen their inputs, evaluate the FP32
+ * kernels and round once, and are within 1 ULP of the FP16 result.
+ *
+ * All functions are single-core and may be called in place (x == y).
+ */
+
+#ifndef SNRT_VMATH_CHUNK
+#define SNRT_VMATH_CHUNK 32
+#endif
+
+typedef float v2f32 __attribute__((vector_size(8)));
+typedef __fp16 v4f16 __attribute__((vector_size(8)));
+
+/**
+ * @brief FP32 kernel over n_vec packed vectors
+ *
+ * @param x Input, 8-byte aligned
+ * @param y Output, 8-byte aligned, may alias x
+ * @param tmp Scratch of 2 * SNRT_VMATH_CHUNK floats
+ */
+typedef void (*snrt_vmath_kernel_t)(const float *x, float *y, float *tmp,
+                                    uint32_t n_vec);
+
+/// Configure a 1D stream of n_vec packed vectors on data mover dm.
+static inline void vmath_stream(enum snrt_ssr_dm dm, uint32_t write,
+                                volatile void *ptr, uint32_t n_vec) {
+    snrt_ssr_loop_1d(dm, n_vec, sizeof(v2f32));
+    if (write)
+        snrt_ssr_write(dm, SNRT_SSR_1D, ptr);
+    else
+        snrt_ssr_read(dm, SNRT_SSR_1D, ptr);
+}
+
+// 2 * (e^r - 1) / r, highest degree first
+static const float vmath_exp_coeffs[6] = {
+    2.7897162e-3f, 1.6762219e-2f, 8.3332479e-2f,
+    3.3332652e-1f, 1.0000000e+0f, 2.0000002e+0f};
+
+// log(1 + r) / r, highest degree first
+static const float vmath_log_coeffs[8] = {
+    -1.0106894e-1f, 1.6222578e-1f, -1.7250830e-1f, 1.9900165e-1f,
+    -2.4969909e-1f, 3.3335060e-1f, -5.0000364e-1f, 9.9999994e-1f};
+
+// (2^f - 1) / f, highest degree first
+static const float vmath_exp2m1_coeffs[6] = {
+    1.5403512e-4f, 1.3390735e-3f, 9.6182376e-3f,
+    5.5503573e-2f, 2.4022649e-1f, 6.9314718e-1f};
+
+// Adding and subtracting 1.5 * 2^23 rounds to the nearest integer
+#define VMATH_ROUND_SHIFT 12582912.0f
+
+/**
+ * @brief Range reduction of exp
+ *
+ * x - offset = n * ln(2) + r with |r| <= ln(2) / 2, using a two-constant
+ * ln(2) so that r is exact. Writes r to r_out and 2^(n - 1), built by
+ * converting the biased exponent to an integer in place, to e_out.
+ */
+static inline void vmath_expf_reduce(const float *x, float offset,
+                                     float *r_out, float *e_out,
+                                     uint32_t n_vec) {
+    const register float x_min = -87.5f;
+    const register float x_max = 88.8f;
+    const register float log2e = 1.44269502f;
+    const register float shift = VMATH_ROUND_SHIFT;
+    const register float ln2_hi = 0.693359375f;
+    const register float ln2_lo = -2.12194442e-4f;
+    const register float bias = VMATH_ROUND_SHIFT - 126.0f;
+    const register float two23 = 8388608.0f;
+    v2f32 k[9], xc, t, a, n, u, r, nb;
+
+    vmath_stream(SNRT_SSR_DM0, 0, (void *)x, n_vec);
+    vmath_stream(SNRT_SSR_DM1, 1, r_out, n_vec);
+    vmath_stream(SNRT_SSR_DM2, 1, e_out, n_vec);
+    snrt_ssr_enable();
+
+    asm volatile(
+        "vfcpka.s.s %[k8], %[offset], %[offset] \n"
+        "vfcpka.s.s %[k0], %[x_min], %[x_min] \n"
+        "vfcpka.s.s %[k1], %[x_max], %[x_max] \n"
+        "vfcpka.s.s %[k2], %[log2e], %[log2e] \n"
+        "vfcpka.s.s %[k3], %[shift], %[shift] \n"
+        "vfcpka.s.s %[k4], %[ln2_hi], %[ln2_hi] \n"
+        "vfcpka.s.s %[k5], %[ln2_lo], %[ln2_lo] \n"
+        "vfcpka.s.s %[k6], %[bias], %[bias] \n"
+        "vfcpka.s.s %[k7], %[two23], %[two23] \n"
+        "frep.o %[n_frep], 13, 0, 0 \n"
+        "vfsub.s %[xc], ft0, %[k8] \n"
+        "vfmax.s %[xc], %[xc], %[k0] \n"
+        "vfmin.s %[xc], %[xc], %[k1] \n"
+        "vfmul.s %[t], %[xc], %[k2] \n"
+        "vfadd.s %[a], %[t], %[k3] \n"
+        "vfsub.s %[n], %[a], %[k3] \n"
+        "vfmul.s %[u], %[n], %[k4] \n"
+        "vfsub.s %[r], %[xc], %[u] \n"
+        "vfmul.s %[u], %[n], %[k5] \n"
+        "vfsub.s ft1, %[r], %[u] \n"
+        "vfsub.s %[nb], %[a], %[k6] \n"
+        "vfmul.s %[nb], %[nb], %[k7] \n"
+        "vfcvt.x.s ft2, %[nb] \n"
+        : [ k0 ] "=&f"(k[0]), [ k1 ] "=&f"(k[1]), [ k2 ] "=&f"(k[2]),
+          [ k3 ] "=&f"(k[3]), [ k4 ] "=&f"(k[4]), [ k5 ] "=&f"(k[5]),
+          [ k6 ] "=&f"(k[6]), [ k7 ] "=&f"(k[7]), [ k8 ] "=&f"(k[8]),
+          [ xc ] "=&f"(xc), [ t ] "=&f"(t), [ a ] "=&f"(a), [ n ] "=&f"(n),
+          [ u ] "=&f"(u), [ r ] "=&f"(r), [ nb ] "=&f"(nb)
+        : [ offset ] "f"(offset), [ x_min ] "f"(x_min), [ x_max ] "f"(x_max),
+          [ log2e ] "f"(log2e), [ shift ] "f"(shift), [ ln2_hi ] "f"(ln2_hi),
+          [ ln2_lo ] "f"(ln2_lo), [ bias ] "f"(bias), [ two23 ] "f"(two23),
+          [ n_frep ] "r"(n_vec - 1)
+        : "ft0", "ft1", "ft2", "memory");
+
+    snrt_fpu_fence();
+    __builtin_ssr_barrier(SNRT_SSR_DM1);
+    __builtin_ssr_barrier(SNRT_SSR_DM2);
+    snrt_ssr_disable();
+}
+
+/**
+ * @brief Polynomial step of exp
+ *
+ * y = (2 + r * P(r)) * 2^(n - 1), with 2 + r * P(r) = 2 * e^r. Scaling the
+ * polynomial by two keeps 2^(n - 1) a normal number up to the overflow
+ * threshold.
+ */
+static inline void vmath_expf_poly(const float *r_in, const float *e_in,
+                                   float *y, uint32_t n_vec) {
+    const register float one = 1.0f;
+    const register float two = 2.0f;
+    v2f32 c[6], k[2], r, p;
+
+    vmath_stream(SNRT_SSR_DM0, 0, (void *)r_in, n_vec);
+    vmath_stream(SNRT_SSR_DM1, 0, (void *)e_in, n_vec);
+    vmath_stream(SNRT_SSR_DM2, 1, y, n_vec);
+    snrt_ssr_enable();
+
+    asm volatile(
+        "vfcpka.s.s %[c0], %[coeff0], %[coeff0] \n"
+        "vfcpka.s.s %[c1], %[coeff1], %[coeff1] \n"
+        "vfcpka.s.s %[c2], %[coeff2], %[coeff2] \n"
+        "vfcpka.s.s %[c3], %[coeff3], %[coeff3] \n"
+        "vfcpka.s.s %[c4], %[coeff4], %[coeff4] \n"
+        "vfcpka.s.s %[c5], %[coeff5], %[coeff5] \n"
+        "vfcpka.s.s %[k0], %[one], %[one] \n"
+        "vfcpka.s.s %[k1], %[two], %[two] \n"
+        "frep.o %[n_frep], 14, 0, 0 \n"
+        "vfmul.s %[r], ft0, %[k0] \n"
+        "vfmul.s %[p], %[r], %[c0] \n"
+        "vfadd.s %[p], %[p], %[c1] \n"
+        "vfmul.s %[p], %[p], %[r] \n"
+        "vfadd.s %[p], %[p], %[c2] \n"
+        "vfmul.s %[p], %[p], %[r] \n"
+        "vfadd.s %[p], %[p], %[c3] \n"
+        "vfmul.s %[p], %[p], %[r] \n"
+        "vfadd.s %[p], %[p], %[c4] \n"
+        "vfmul.s %[p], %[p], %[r] \n"
+        "vfadd.s %[p], %[p], %[c5] \n"
+        "vfmul.s %[p], %[p], %[r] \n"
+        "vfadd.s %[p], %[p], %[k1] \n"
+        "vfmul.s ft2, %[p], ft1 \n"
+        : [ c0 ] "=&f"(c[0]), [ c1 ] "=&f"(c[1]), [ c2 ] "=&f"(c[2]),
+          [ c3 ] "=&f"(c[3]), [ c4 ] "=&f"(c[4]), [ c5 ] "=&f"(c[5]),
+          [ k0 ] "=&f"(k[0]), [ k1 ] "=&f"(k[1]), [ r ] "=&f"(r),
+          [ p ] "=&f"(p)
+        : [ coeff0 ] "f"(vmath_exp_coeffs[0]),
+          [ coeff1 ] "f"(vmath_exp_coeffs[1]),
+          [ coeff2 ] "f"(vmath_exp_coeffs[2]),
+          [ coeff3 ] "f"(vmath_exp_coeffs[3]),
+          [ coeff4 ] "f"(vmath_exp_coeffs[4]),
+          [ coeff5 ] "f"(vmath_exp_coeffs[5]), [ one ] "f"(one),
+          [ two ] "f"(two), [ n_frep ] "r"(n_vec - 1)
+        : "ft0", "ft1", "ft2", "memory");
+
+    snrt_fpu_fence();
+    __builtin_ssr_barrier(SNRT_SSR_DM2);
+    snrt_ssr_disable();
+}
+
+/**
+ * @brief Polynomial step of exp, accumulating the results
+ *
+ * Same as vmath_expf_poly, and adds every result vector to sum. The
+ * accumulation carries over from one FREP iteration to the next, which the
+ * length of the body hides.
+ */
+static inline void vmath_expf_poly_sum(const float *r_in, const float *e_in,
+                                       float *y, uint32_t n_vec,
+                                       v2f32 *sum) {
+    const register float one = 1.0f;
+    const register float two = 2.0f;
+    v2f32 c[6], k[2], r, p;
+
+    vmath_stream(SNRT_SSR_DM0, 0, (void *)r_in, n_vec);
+    vmath_stream(SNRT_SSR_DM1, 0, (void *)e_in, n_vec);
+    vmath_stream(SNRT_SSR_DM2, 1, y, n_vec);
+    snrt_ssr_enable();
+
+    asm volatile(
+        "vfcpka.s.s %[c0], %[coeff0], %[coeff0] \n"
+        "vfcpka.s.s %[c1], %[coeff1], %[coeff1] \n"
+        "vfcpka.s.s %[c2], %[coeff2], %[coeff2] \n"
+        "vfcpka.s.s %[c3], %[coeff3], %[coeff3] \n"
+        "vfcpka.s.s %[c4], %[coeff4], %[coeff4] \n"
+        "vfcpka.s.s %[c5], %[coeff5], %[coeff5] \n"
+        "vfcpka.s.s %[k0], %[one], %[one] \n"
+        "vfcpka.s.s %[k1], %[two], %[two] \n"
+        "frep.o %[n_frep], 16, 0, 0 \n"
+        "vfmul.s %[r], ft0, %[k0] \n"
+        "vfmul.s %[p], %[r], %[c0] \n"
+        "vfadd.s %[p], %[p], %[c1] \n"
+        "vfmul.s %[p], %[p], %[r] \n"
+        "vfadd.s %[p], %[p], %[c2] \n"
+        "vfmul.s %[p], %[p], %[r] \n"
+        "vfadd.s %[p], %[p], %[c3] \n"
+        "vfmul.s %[p], %[p], %[r] \n"
+        "vfadd.s %[p], %[p], %[c4] \n"
+        "vfmul.s %[p], %[p], %[r] \n"
+        "vfadd.s %[p], %[p], %[c5] \n"
+        "vfmul.s %[p], %[p], %[r] \n"
+        "vfadd.s %[p], %[p], %[k1] \n"
+        "vfmul.s %[p], %[p], ft1 \n"
+        "vfadd.s %[sum], %[sum], %[p] \n"
+        "vfmul.s ft2, %[p], %[k0] \n"
+        : [ c0 ] "=&f"(c[0]), [ c1 ] "=&f"(c[1]), [ c2 ] "=&f"(c[2]),
+          [ c3 ] "=&f"(c[3]), [ c4 ] "=&f"(c[4]), [ c5 ] "=&f"(c[5]),
+          [ k0 ] "=&f"(k[0]), [ k1 ] "=&f"(k[1]), [ r ] "=&f"(r),
+          [ p ] "=&f"(p), [ sum ] "+&f"(*sum)
+        : [ coeff0 ] "f"(vmath_exp_coeffs[0]),
+          [ coeff1 ] "f"(vmath_exp_coeffs[1]),
+          [ coeff2 ] "f"(vmath_exp_coeffs[2]),
+          [ coeff3 ] "f"(vmath_exp_coeffs[3]),
+          [ coeff4 ] "f"(vmath_exp_coeffs[4]),
+          [ coeff5 ] "f"(vmath_exp_coeffs[5]), [ one ] "f"(one),
+          [ two ] "f"(two), [ n_frep ] "r"(n_vec - 1)
+        : "ft0", "ft1", "ft2", "memory");
+
+    snrt_fpu_fence();
+    __builtin_ssr_barrier(SNRT_SSR_DM2);
+    snrt_ssr_disable();
+}
+
+/// exp over n_vec packed vectors.
+static inline void vmath_expf_kernel(const float *x, float *y, float *tmp,
+                                     uint32_t n_vec) {
+    vmath_expf_reduce(x, 0.0f, tmp, y, n_vec);
+    vmath_expf_poly(tmp, y, y, n_vec);
+}
+
+/**
+ * @brief Range reduction of log
+ *
+ * x = 2^E * m with m in [sqrt(2) / 2, sqrt(2)). The integer conversion of the
+ * bit pattern of x approximates (E + 127) * 2^23 closely enough to round E,
+ * and 2^-E is built from its biased exponent. Writes r = m - 1 to r_out and
+ * E * ln(2) to l_out.
+ */
+static inline void vmath_logf_reduce(const float *x, float *r_out,
+                                     float *l_out, uint32_t n_vec) {
+    const register float one = 1.0f;
+    const register float two_m23 = 1.0f / 8388608.0f;
+    // Moves the rounding threshold of the mantissa from 1.5 to sqrt(2)
+    const register float offset = 1.5f - 1.41421356f - 127.0f;
+    const register float shift = VMATH_ROUND_SHIFT;
+    const register float bias = VMATH_ROUND_SHIFT + 127.0f;
+    const register float two23 = 8388608.0f;
+    const register float ln2 = 0.693147182f;
+    v2f32 k[7], xr, b, a, s, m, e;
+
+    vmath_stream(SNRT_SSR_DM0, 0, (void *)x, n_vec);
+    vmath_stream(SNRT_SSR_DM1, 1, r_out, n_vec);
+    vmath_stream(SNRT_SSR_DM2, 1, l_out, n_vec);
+    snrt_ssr_enable();
+
+    asm volatile(
+        "vfcpka.s.s %[k0], %[one], %[one] \n"
+        "vfcpka.s.s %[k1], %[two_m23], %[two_m23] \n"
+        "vfcpka.s.s %[k2], %[offset], %[offset] \n"
+        "vfcpka.s.s %[k3], %[shift], %[shift] \n"
+        "vfcpka.s.s %[k4], %[bias], %[bias] \n"
+        "vfcpka.s.s %[k5], %[two23], %[two23] \n"
+        "vfcpka.s.s %[k6], %[ln2], %[ln2] \n"
+        "frep.o %[n_frep], 12, 0, 0 \n"
+        "vfmul.s %[xr], ft0, %[k0] \n"
+        "vfcvt.s.x %[b], %[xr] \n"
+        "vfmul.s %[b], %[b], %[k1] \n"
+        "vfadd.s %[b], %[b], %[k2] \n"
+        "vfadd.s %[a], %[b], %[k3] \n"
+        "vfsub.s %[s], %[k4], %[a] \n"
+        "vfmul.s %[s], %[s], %[k5] \n"
+        "vfcvt.x.s %[s], %[s] \n"
+        "vfmul.s %[m], %[xr], %[s] \n"
+        "vfsub.s ft1, %[m], %[k0] \n"
+        "vfsub.s %[e], %[a], %[k3] \n"
+        "vfmul.s ft2, %[e], %[k6] \n"
+        : [ k0 ] "=&f"(k[0]), [ k1 ] "=&f"(k[1]), [ k2 ] "=&f"(k[2]),
+          [ k3 ] "=&f"(k[3]), [ k4 ] "=&f"(k[4]), [ k5 ] "=&f"(k[5]),
+          [ k6 ] "=&f"(k[6]), [ xr ] "=&f"(xr), [ b ] "=&f"(b),
+          [ a ] "=&f"(a), [ s ] "=&f"(s), [ m ] "=&f"(m), [ e ] "=&f"(e)
+        : [ one ] "f"(one), [ two_m23 ] "f"(two_m23), [ offset ] "f"(offset),
+          [ shift ] "f"(shift), [ bias ] "f"(bias), [ two23 ] "f"(two23),
+          [ ln2 ] "f"(ln2), [ n_frep ] "r"(n_vec - 1)
+        : "ft0", "ft1", "ft2", "memory");
+
+    snrt_fpu_fence();
+    __builtin_ssr_barrier(SNRT_SSR_DM1);
+    __builtin_ssr_barrier(SNRT_SSR_DM2);
+    snrt_ssr_disable();
+}
+
+/// log(1 + r) = r * Q(r), in place on r.
+static inline void vmath_logf_poly(float *r, uint32_t n_vec) {
+    const register float one = 1.0f;
+    v2f32 c[8], k, v, q;
+
+    vmath_stream(SNRT_SSR_DM0, 0, r, n_vec);
+    vmath_stream(SNRT_SSR_DM1, 1, r, n_vec);
+    snrt_ssr_enable();
+
+    asm volatile(
+        "vfcpka.s.s %[c0], %[coeff0], %[coeff0] \n"
+        "vfcpka.s.s %[c1], %[coeff1], %[coeff1] \n"
+        "vfcpka.s.s %[c2], %[coeff2], %[coeff2] \n"
+        "vfcpka.s.s %[c3], %[coeff3], %[coeff3] \n"
+        "vfcpka.s.s %[c4], %[coeff4], %[coeff4] \n"
+        "vfcpka.s.s %[c5], %[coeff5], %[coeff5] \n"
+        "vfcpka.s.s %[c6], %[coeff6], %[coeff6] \n"
+        "vfcpka.s.s %[c7], %[coeff7], %[coeff7] \n"
+        "vfcpka.s.s %[k], %[one], %[one] \n"
+        "frep.o %[n_frep], 16, 0, 0 \n"
+        "vfmul.s %[v], ft0, %[k] \n"
+        "vfmul.s %[q], %[v], %[c0] \n"
+        "vfadd.s %[q], %[q], %[c1] \n"
+        "vfmul.s %[q], %[q], %[v] \n"
+        "vfadd.s %[q], %[q], %[c2] \n"
+        "vfmul.s %[q], %[q], %[v] \n"
+        "vfadd.s %[q], %[q], %[c3] \n"
+        "vfmul.s %[q], %[q], %[v] \n"
+        "vfadd.s %[q], %[q], %[c4] \n"
+        "vfmul.s %[q], %[q], %[v] \n"
+        "vfadd.s %[q], %[q], %[c5] \n"
+        "vfmul.s %[q], %[q], %[v] \n"
+        "vfadd.s %[q], %[q], %[c6] \n"
+        "vfmul.s %[q], %[q], %[v] \n"
+        "vfadd.s %[q], %[q], %[c7] \n"
+        "vfmul.s ft1, %[q], %[v] \n"
+        : [ c0 ] "=&f"(c[0]), [ c1 ] "=&f"(c[1]), [ c2 ] "=&f"(c[2]),
+          [ c3 ] "=&f"(c[3]), [ c4 ] "=&f"(c[4]), [ c5 ] "=&f"(c[5]),
+          [ c6 ] "=&f"(c[6]), [ c7 ] "=&f"(c[7]), [ k ] "=&f"(k),
+          [ v ] "=&f"(v), [ q ] "=&f"(q)
+        : [ coeff0 ] "f"(vmath_log_coeffs[0]),
+          [ coeff1 ] "f"(vmath_log_coeffs[1]),
+          [ coeff2 ] "f"(vmath_log_coeffs[2]),
+          [ coeff3 ] "f"(vmath_log_coeffs[3]),
+          [ coeff4 ] "f"(vmath_log_coeffs[4]),
+          [ coeff5 ] "f"(vmath_log_coeffs[5]),
+          [ coeff6 ] "f"(vmath_log_coeffs[6]),
+          [ coeff7 ] "f"(vmath_log_coeffs[7]), [ one ] "f"(one),
+          [ n_frep ] "r"(n_vec - 1)
+        : "ft0", "ft1", "ft2", "memory");
+
+    snrt_fpu_fence();
+    __builtin_ssr_barrier(SNRT_SSR_DM1);
+    snrt_ssr_disable();
+}
+
+/// y = a + b over n_vec packed vectors.
+static inline void vmath_add(const float *a, const float *b, float *y,
+                             uint32_t n_vec) {
+    vmath_stream(SNRT_SSR_DM0, 0, (void *)a, n_vec);
+    vmath_stream(SNRT_SSR_DM1, 0, (void *)b, n_vec);
+    vmath_stream(SNRT_SSR_DM2, 1, y, n_vec);
+    snrt_ssr_enable();
+
+    asm volatile(
+        "frep.o %[n_frep], 1, 0, 0 \n"
+        "vfadd.s ft2, ft0, ft1 \n"
+        :
+        : [ n_frep ] "r"(n_vec - 1)
+        : "ft0", "ft1", "ft2", "memory");
+
+    snrt_fpu_fence();
+    __builtin_ssr_barrier(SNRT_SSR_DM2);
+    snrt_ssr_disable();
+}
+
+/// log over n_vec packed vectors.
+static inline void vmath_logf_kernel(const float *x, float *y, float *tmp,
+                                     uint32_t n_vec) {
+    vmath_logf_reduce(x, tmp, y, n_vec);
+    vmath_logf_poly(tmp, n_vec);
+    vmath_add(tmp, y, y, n_vec);
+}
+
+/**
+ * @brief Range reduction of tanh
+ *
+ * -2|x| * log2(e) = n + f with |f| <= 1/2, clamped where tanh is 1 in FP32.
+ * Writes f to f_out and 2^n to e_out.
+ */
+static inline void vmath_tanhf_reduce(const float *x, float *f_out,
+                                      float *e_out, uint32_t n_vec) {
+    const register float two_log2e = 2.88539004f;
+    const register float one = 1.0f;
+    const register float t_min = -64.0f;
+    const register float shift = VMATH_ROUND_SHIFT;
+    const register float bias = VMATH_ROUND_SHIFT - 127.0f;
+    const register float two23 = 8388608.0f;
+    v2f32 k[6], t, a, n, nb;
+
+    vmath_stream(SNRT_SSR_DM0, 0, (void *)x, n_vec);
+    vmath_stream(SNRT_SSR_DM1, 1, f_out, n_vec);
+    vmath_stream(SNRT_SSR_DM2, 1, e_out, n_vec);
+    snrt_ssr_enable();
+
+    asm volatile(
+        "vfcpka.s.s %[k0], %[two_log2e], %[two_log2e] \n"
+        "vfcpka.s.s %[k1], %[one], %[one] \n"
+        "vfcpka.s.s %[k2], %[t_min], %[t_min] \n"
+        "vfcpka.s.s %[k3], %[shift], %[shift] \n"
+        "vfcpka.s.s %[k4], %[bias], %[bias] \n"
+        "vfcpka.s.s %[k5], %[two23], %[two23] \n"
+        "frep.o %[n_frep], 9, 0, 0 \n"
+        "vfmul.s %[t], ft0, %[k0] \n"
+        // t = -|t|
+        "vfsgnjn.s %[t], %[t], %[k1] \n"
+        "vfmax.s %[t], %[t], %[k2] \n"
+        "vfadd.s %[a], %[t], %[k3] \n"
+        "vfsub.s %[n], %[a], %[k3] \n"
+        "vfsub.s ft1, %[t], %[n] \n"
+        "vfsub.s %[nb], %[a], %[k4] \n"
+        "vfmul.s %[nb], %[nb], %[k5] \n"
+        "vfcvt.x.s ft2, %[nb] \n"
+        : [ k0 ] "=&f"(k[0]), [ k1 ] "=&f"(k[1]), [ k2 ] "=&f"(k[2]),
+          [ k3 ] "=&f"(k[3]), [ k4 ] "=&f"(k[4]), [ k5 ] "=&f"(k[5]),
+          [ t ] "=&f"(t), [ a ] "=&f"(a), [ n ] "=&f"(n), [ nb ] "=&f"(nb)
+        : [ two_log2e ] "f"(two_log2e), [ one ] "f"(one),
+          [ t_min ] "f"(t_min), [ shift ] "f"(shift), [ bias ] "f"(bias),
+          [ two23 ] "f"(two23), [ n_frep ] "r"(n_vec - 1)
+        : "ft0", "ft1", "ft2", "memory");
+
+    snrt_fpu_fence();
+    __builtin_ssr_barrier(SNRT_SSR_DM1);
+    __builtin_ssr_barrier(SNRT_SSR_DM2);
+    snrt_ssr_disable();
+}
+
+/**
+ * @brief e^(-2|x|) - 1 from the reduced argument
+ *
+ * 2^n * 2^f - 1 = 2^n * (2^f - 1) + (2^n - 1), which avoids the cancellation
+ * of 1 - e^(-2|x|) for small x. Writes the result over f.
+ */
+static inline void vmath_tanhf_expm1(float *f, const float *e,
+                                     uint32_t n_vec) {
+    const register float one = 1.0f;
+    v2f32 c[6], k, v, q, s;
+
+    vmath_stream(SNRT_SSR_DM0, 0, f, n_vec);
+    vmath_stream(SNRT_SSR_DM1, 0, (void *)e, n_vec);
+    vmath_stream(SNRT_SSR_DM2, 1, f, n_vec);
+    snrt_ssr_enable();
+
+    asm volatile(
+        "vfcpka.s.s %[c0], %[coeff0], %[coeff0] \n"
+        "vfcpka.s.s %[c1], %[coeff1], %[coeff1] \n"
+        "vfcpka.s.s %[c2], %[coeff2], %[coeff2] \n"
+        "vfcpka.s.s %[c3], %[coeff3], %[coeff3] \n"
+        "vfcpka.s.s %[c4], %[coeff4], %[coeff4] \n"
+        "vfcpka.s.s %[c5], %[coeff5], %[coeff5] \n"
+        "vfcpka.s.s %[k], %[one], %[one] \n"
+        "frep.o %[n_frep], 16, 0, 0 \n"
+        "vfmul.s %[v], ft0, %[k] \n"
+        "vfmul.s %[q], %[v], %[c0] \n"
+        "vfadd.s %[q], %[q], %[c1] \n"
+        "vfmul.s %[q], %[q], %[v] \n"
+        "vfadd.s %[q], %[q], %[c2] \n"
+        "vfmul.s %[q], %[q], %[v] \n"
+        "vfadd.s %[q], %[q], %[c3] \n"
+        "vfmul.s %[q], %[q], %[v] \n"
+        "vfadd.s %[q], %[q], %[c4] \n"
+        "vfmul.s %[q], %[q], %[v] \n"
+        "vfadd.s %[q], %[q], %[c5] \n"
+        "vfmul.s %[q], %[q], %[v] \n"
+        "vfmul.s %[s], ft1, %[k] \n"
+        "vfmul.s %[q], %[q], %[s] \n"
+        "vfsub.s %[s], %[s], %[k] \n"
+        "vfadd.s ft2, %[q], %[s] \n"
+        : [ c0 ] "=&f"(c[0]), [ c1 ] "=&f"(c[1]), [ c2 ] "=&f"(c[2]),
+          [ c3 ] "=&f"(c[3]), [ c4 ] "=&f"(c[4]), [ c5 ] "=&f"(c[5]),
+          [ k ] "=&f"(k), [ v ] "=&f"(v), [ q ] "=&f"(q), [ s ] "=&f"(s)
+        : [ coeff0 ] "f"(vmath_exp2m1_coeffs[0]),
+          [ coeff1 ] "f"(vmath_exp2m1_coeffs[1]),
+          [ coeff2 ] "f"(vmath_exp2m1_coeffs[2]),
+          [ coeff3 ] "f"(vmath_exp2m1_coeffs[3]),
+          [ coeff4 ] "f"(vmath_exp2m1_coeffs[4]),
+          [ coeff5 ] "f"(vmath_exp2m1_coeffs[5]), [ one ] "f"(one),
+          [ n_frep ] "r"(n_vec - 1)
+        : "ft0", "ft1", "ft2", "memory");
+
+    snrt_fpu_fence();
+    __builtin_ssr_barrier(SNRT_SSR_DM2);
+    snrt_ssr_disable();
+}
+
+/**
+ * @brief tanh from u = e^(-2|x|) - 1
+ *
+ * |tanh(x)| = -u / (2 + u). The denominator lies in (1, 2], so three Newton
+ * iterations from a linear estimate give its reciprocal to full precision.
+ * The sign is copied from x.
+ */
+static inline void vmath_tanhf_div(const float *u, const float *x, float *y,
+                                   uint32_t n_vec) {
+    const register float one = 1.0f;
+    const register float two = 2.0f;
+    const register float r0_a = 24.0f / 17.0f;
+    const register float r0_b = 8.0f / 17.0f;
+    v2f32 k[4], m, d, r, p;
+
+    vmath_stream(SNRT_SSR_DM0, 0, (void *)u, n_vec);
+    vmath_stream(SNRT_SSR_DM1, 0, (void *)x, n_vec);
+    vmath_stream(SNRT_SSR_DM2, 1, y, n_vec);
+    snrt_ssr_enable();
+
+    asm volatile(
+        "vfcpka.s.s %[k0], %[one], %[one] \n"
+        "vfcpka.s.s %[k1], %[two], %[two] \n"
+        "vfcpka.s.s %[k2], %[r0_a], %[r0_a] \n"
+        "vfcpka.s.s %[k3], %[r0_b], %[r0_b] \n"
+        "frep.o %[n_frep], 15, 0, 0 \n"
+        "vfmul.s %[m], ft0, %[k0] \n"
+        "vfadd.s %[d], %[m], %[k1] \n"
+        "vfmul.s %[r], %[d], %[k3] \n"
+        "vfsub.s %[r], %[k2], %[r] \n"
+        "vfmul.s %[p], %[d], %[r] \n"
+        "vfsub.s %[p], %[k0], %[p] \n"
+        "vfmac.s %[r], %[r], %[p] \n"
+        "vfmul.s %[p], %[d], %[r] \n"
+        "vfsub.s %[p], %[k0], %[p] \n"
+        "vfmac.s %[r], %[r], %[p] \n"
+        "vfmul.s %[p], %[d], %[r] \n"
+        "vfsub.s %[p], %[k0], %[p] \n"
+        "vfmac.s %[r], %[r], %[p] \n"
+        "vfmul.s %[m], %[m], %[r] \n"
+        "vfsgnj.s ft2, %[m], ft1 \n"
+        : [ k0 ] "=&f"(k[0]), [ k1 ] "=&f"(k[1]), [ k2 ] "=&f"(k[2]),
+          [ k3 ] "=&f"(k[3]), [ m ] "=&f"(m), [ d ] "=&f"(d), [ r ] "=&f"(r),
+          [ p ] "=&f"(p)
+        : [ one ] "f"(one), [ two ] "f"(two), [ r0_a ] "f"(r0_a),
+          [ r0_b ] "f"(r0_b), [ n_frep ] "r"(n_vec - 1)
+        : "ft0", "ft1", "ft2", "memory");
+
+    snrt_fpu_fence();
+    __builtin_ssr_barrier(SNRT_SSR_DM2);
+    snrt_ssr_disable();
+}
+
+/// tanh over n_vec packed vectors.
+static inline void vmath_tanhf_kernel(const float *x, float *y, float *tmp,
+                                      uint32_t n_vec) {
+    float *f = tmp;
+    float *e = tmp + SNRT_VMATH_CHUNK;
+
+    vmath_tanhf_reduce(x, f, e, n_vec);
+    vmath_tanhf_expm1(f, e, n_vec);
+    vmath_tanhf_div(f, x, y, n_vec);
+}
+
+/**
+ * @brief Initial estimate of 1/sqrt(x)
+ *
+ * The bit-pattern estimate 0x5f3759df - (bits(x) >> 1), evaluated on the
+ * integer conversion of the bit pattern, followed by two Newton iterations.
+ */
+static inline void vmath_rsqrtf_estimate(const float *x, float *r_out,
+                                         uint32_t n_vec) {
+    const register float one = 1.0f;
+    const register float half = 0.5f;
+    const register float magic = 1597463007.0f;
+    const register float three_halves = 1.5f;
+    v2f32 k[4], xr, h, r, p;
+
+    vmath_stream(SNRT_SSR_DM0, 0, (void *)x, n_vec);
+    vmath_stream(SNRT_SSR_DM1, 1, r_out, n_vec);
+    snrt_ssr_enable();
+
+    asm volatile(
+        "vfcpka.s.s %[k0], %[one], %[one] \n"
+        "vfcpka.s.s %[k1], %[half], %[half] \n"
+        "vfcpka.s.s %[k2], %[magic], %[magic] \n"
+        "vfcpka.s.s %[k3], %[three_halves], %[three_halves] \n"
+        "frep.o %[n_frep], 14, 0, 0 \n"
+        "vfmul.s %[xr], ft0, %[k0] \n"
+        "vfcvt.s.x %[r], %[xr] \n"
+        "vfmul.s %[r], %[r], %[k1] \n"
+        "vfsub.s %[r], %[k2], %[r] \n"
+        "vfcvt.x.s %[r], %[r] \n"
+        "vfmul.s %[h], %[xr], %[k1] \n"
+        "vfmul.s %[p], %[r], %[r] \n"
+        "vfmul.s %[p], %[p], %[h] \n"
+        "vfsub.s %[p], %[k3], %[p] \n"
+        "vfmul.s %[r], %[r], %[p] \n"
+        "vfmul.s %[p], %[r], %[r] \n"
+        "vfmul.s %[p], %[p], %[h] \n"
+        "vfsub.s %[p], %[k3], %[p] \n"
+        "vfmul.s ft1, %[r], %[p] \n"
+        : [ k0 ] "=&f"(k[0]), [ k1 ] "=&f"(k[1]), [ k2 ] "=&f"(k[2]),
+          [ k3 ] "=&f"(k[3]), [ xr ] "=&f"(xr), [ h ] "=&f"(h),
+          [ r ] "=&f"(r), [ p ] "=&f"(p)
+        : [ one ] "f"(one), [ half ] "f"(half), [ magic ] "f"(magic),
+          [ three_halves ] "f"(three_halves), [ n_frep ] "r"(n_vec - 1)
+        : "ft0", "ft1", "ft2", "memory");
+
+    snrt_fpu_fence();
+    __builtin_ssr_barrier(SNRT_SSR_DM1);
+    snrt_ssr_disable();
+}
+
+/**
+ * @brief Final Newton iteration of 1/sqrt(x)
+ *
+ * Written as r + r * (1/2 - x/2 * r^2), so that the correction is small and
+ * the result is rounded only once more.
+ */
+static inline void vmath_rsqrtf_refine(const float *x, const float *r_in,
+                                       float *y, uint32_t n_vec) {
+    const register float one = 1.0f;
+    const register float half = 0.5f;
+    v2f32 k[2], h, r, p;
+
+    vmath_stream(SNRT_SSR_DM0, 0, (void *)x, n_vec);
+    vmath_stream(SNRT_SSR_DM1, 0, (void *)r_in, n_vec);
+    vmath_stream(SNRT_SSR_DM2, 1, y, n_vec);
+    snrt_ssr_enable();
+
+    asm volatile(
+        "vfcpka.s.s %[k0], %[one], %[one] \n"
+        "vfcpka.s.s %[k1], %[half], %[half] \n"
+        "frep.o %[n_frep], 7, 0, 0 \n"
+        "vfmul.s %[h], ft0, %[k1] \n"
+        "vfmul.s %[r], ft1, %[k0] \n"
+        "vfmul.s %[p], %[r], %[r] \n"
+        "vfmul.s %[p], %[p], %[h] \n"
+        "vfsub.s %[p], %[k1], %[p] \n"
+        "vfmul.s %[p], %[p], %[r] \n"
+        "vfadd.s ft2, %[r], %[p] \n"
+        : [ k0 ] "=&f"(k[0]), [ k1 ] "=&f"(k[1]), [ h ] "=&f"(h),
+          [ r ] "=&f"(r), [ p ] "=&f"(p)
+        : [ one ] "f"(one), [ half ] "f"(half), [ n_frep ] "r"(n_vec - 1)
+        : "ft0", "ft1", "ft2", "memory");
+
+    snrt_fpu_fence();
+    __builtin_ssr_barrier(SNRT_SSR_DM2);
+    snrt_ssr_disable();
+}
+
+/// 1/sqrt over n_vec packed vectors.
+static inline void vmath_rsqrtf_kernel(const float *x, float *y, float *tmp,
+                                       uint32_t n_vec) {
+    vmath_rsqrtf_estimate(x, tmp, n_vec);
+    vmath_rsqrtf_refine(x, tmp, y, n_vec);
+}
+
+/**
+ * @brief Apply an FP32 kernel to an array in chunks
+ *
+ * Aligned chunks are streamed in place. Unaligned arrays and an odd last chunk
+ * are staged through an aligned buffer, padding the last vector with 1.
+ */
+static inline void snrt_vmath_map(snrt_vmath_kernel_t kernel, const float *x,
+                                  float *y, uint32_t len) {
+    float tmp[2 * SNRT_VMATH_CHUNK] __attribute__((aligned(8)));
+    // One extra element for the padding of an odd chunk
+    float buf[SNRT_VMATH_CHUNK + 1] __attribute__((aligned(8)));
+    uint32_t aligned = !(((uintptr_t)x | (uintptr_t)y) % sizeof(v2f32));
+
+    for (uint32_t i = 0; i < len; i += SNRT_VMATH_CHUNK) {
+        uint32_t n = len - i < SNRT_VMATH_CHUNK ? len - i : SNRT_VMATH_CHUNK;
+
+        if (aligned && !(n % 2)) {
+            kernel(x + i, y + i, tmp, n / 2);
+        } else {
+            for (uint32_t j = 0; j < n; j++) buf[j] = x[i + j];
+            if (n % 2) buf[n] = 1.0f;
+            kernel(buf, buf, tmp, (n + 1) / 2);
+            for (uint32_t j = 0; j < n; j++) y[i + j] = buf[j];
+        }
+    }
+}
+
+/// Widen n_vec packed FP16 vectors to 2 * n_vec packed FP32 vectors.
+static inline void vmath_widen_fp16(const __fp16 *x, float *y,
+                                    uint32_t n_vec) {
+    const register float one = 1.0f;
+    v4f16 k, v;
+
+    vmath_stream(SNRT_SSR_DM0, 0, (void *)x, n_vec);
+    vmath_stream(SNRT_SSR_DM1, 1, y, 2 * n_vec);
+    snrt_ssr_enable();
+
+    asm volatile(
+        "vfcpka.h.s %[k], %[one], %[one] \n"
+        "vfcpkb.h.s %[k], %[one], %[one] \n"
+        "frep.o %[n_frep], 3, 0, 0 \n"
+        "vfmul.h %[v], ft0, %[k] \n"
+        "vfcvt.s.h ft1, %[v] \n"
+        "vfcvtu.s.h ft1, %[v] \n"
+        : [ k ] "=&f"(k), [ v ] "=&f"(v)
+        : [ one ] "f"(one), [ n_frep ] "r"(n_vec - 1)
+        : "ft0", "ft1", "ft2", "memory");
+
+    snrt_fpu_fence();
+    __builtin_ssr_barrier(SNRT_SSR_DM1);
+    snrt_ssr_disable();
+}
+
+/**
+ * @brief Narrow 2 * n_vec packed FP32 vectors to n_vec packed FP16 vectors
+ *
+ * Every result vector is assembled from two FP32 vectors: vfcvt.h.s writes
+ * the lower and vfcvtu.h.s the upper two lanes.
+ */
+static inline void vmath_narrow_fp16(const float *x, __fp16 *y,
+                                     uint32_t n_vec) {
+    v4f16 v;
+
+    vmath_stream(SNRT_SSR_DM0, 0, (void *)x, 2 * n_vec);
+    vmath_stream(SNRT_SSR_DM1, 1, y, n_vec);
+    snrt_ssr_enable();
+
+    asm volatile(
+        "frep.o %[n_frep], 3, 0, 0 \n"
+        "vfcvt.h.s %[v], ft0 \n"
+        "vfcvtu.h.s %[v], ft0 \n"
+        "vfsgnj.h ft1, %[v], %[v] \n"
+        : [ v ] "=&f"(v)
+        : [ n_frep ] "r"(n_vec - 1)
+        : "ft0", "ft1", "ft2", "memory");
+
+    snrt_fpu_fence();
+    __builtin_ssr_barrier(SNRT_SSR_DM1);
+    snrt_ssr_disable();
+}
+
+/**
+ * @brief Apply an FP32 kernel to an FP16 array in chunks
+ *
+ * Evaluating in FP16 would lose most of the result precision in the range
+ * reduction, so each chunk is widened with packed conversions, processed in
+ * FP32 and rounded back to FP16 element by element.
+ */
+static inline void snrt_vmath_map_fp16(snrt_vmath_kernel_t kernel,
+                                       const __fp16 *x, __fp16 *y,
+                                       uint32_t len) {
+    float tmp[2 * SNRT_VMATH_CHUNK] __attribute__((aligned(8)));
+    // One extra element for the padding of an odd chunk
+    float buf[SNRT_VMATH_CHUNK + 1] __attribute__((aligned(8)));
+    uint32_t aligned = !((uintptr_t)x % sizeof(v4f16));
+
+    for (uint32_t i = 0; i < len; i += SNRT_VMATH_CHUNK) {
+        uint32_t n = len - i < SNRT_VMATH_CHUNK ? len - i : SNRT_VMATH_CHUNK;
+        uint32_t n_wide = aligned ? n / 4 : 0;
+
+        if (n_wide) vmath_widen_fp16(x + i, buf, n_wide);
+        for (uint32_t j = n_wide * 4; j < n; j++) buf[j] = x[i + j];
+        if (n % 2) buf[n] = 1.0f;
+
+        kernel(buf, buf, tmp, (n + 1) / 2);
+
+        for (uint32_t j = 0; j < n; j++) y[i + j] = buf[j];
+    }
+}
+
+/**
+ * @brief y[i] = e^x[i]
+ *
+ * Maximum error 1.5 ULP. Results below about 2^-125 flush to zero.
+ */
+static inline void snrt_vexpf(const float *x, float *y, uint32_t len) {
+    snrt_vmath_map(vmath_expf_kernel, x, y, len);
+}
+
+/**
+ * @brief y[i] = log(x[i])
+ *
+ * Maximum error 4 ULP for positive normal x below 2^127 * sqrt(2).
+ */
+static inline void snrt_vlogf(const float *x, float *y, uint32_t len) {
+    snrt_vmath_map(vmath_logf_kernel, x, y, len);
+}
+
+/**
+ * @brief y[i] = tanh(x[i])
+ *
+ * Maximum error 4 ULP.
+ */
+static inline void snrt_vtanhf(const float *x, float *y, uint32_t len) {
+    snrt_vmath_map(vmath_tanhf_kernel, x, y, len);
+}
+
+/**
+ * @brief y[i] = 1 / sqrt(x[i])
+ *
+ * Maximum error 2 ULP for positive normal x.
+ */
+static inline void snrt_vrsqrtf(const float *x, float *y, uint32_t len) {
+    snrt_vmath_map(vmath_rsqrtf_kernel, x, y, len);
+}
+
+/// FP16 version of snrt_vexpf.
+static inline void snrt_vexpf16(const __fp16 *x, __fp16 *y, uint32_t len) {
+    snrt_vmath_map_fp16(vmath_expf_kernel, x, y, len);
+}
+
+/**
+ * @brief y[i] = e^(x[i] - offset), returning the sum of y
+ *
+ * The exponentials are summed in the polynomial pass, in FP32. An odd chunk
+ * is padded with -inf, which the range reduction clamps to an exponential
+ * that flushes to zero, so the padding does not contribute to the sum.
+ */
+static inline float snrt_vexpf_sum(const float *x, float *y, float offset,
+                                   uint32_t len) {
+    float tmp[SNRT_VMATH_CHUNK] __attribute__((aligned(8)));
+    float buf[SNRT_VMATH_CHUNK + 1] __attribute__((aligned(8)));
+    uint32_t aligned = !(((uintptr_t)x | (uintptr_t)y) % sizeof(v2f32));
+    v2f32 sum = {0.0f, 0.0f};
+
+    for (uint32_t i = 0; i < len; i += SNRT_VMATH_CHUNK) {
+        uint32_t n = len - i < SNRT_VMATH_CHUNK ? len - i : SNRT_VMATH_CHUNK;
+
+        if (aligned && !(n % 2)) {
+            vmath_expf_reduce(x + i, offset, tmp, y + i, n / 2);
+            vmath_expf_poly_sum(tmp, y + i, y + i, n / 2, &sum);
+        } else {
+            for (uint32_t j = 0; j < n; j++) buf[j] = x[i + j];
+            if (n % 2) buf[n] = -__builtin_inff();
+            vmath_expf_reduce(buf, offset, tmp, buf, (n + 1) / 2);
+            vmath_expf_poly_sum(tmp, buf, buf, (n + 1) / 2, &sum);
+            for (uint32_t j = 0; j < n; j++) y[i + j] = buf[j];
+        }
+    }
+    return sum[0] + sum[1];
+}
+
+/**
+ * @brief FP16 version of snrt_vexpf_sum
+ *
+ * Chunks are widened, evaluated and summed in FP32, and narrowed back to FP16
+ * with packed conversions. Only the elements past the last full FP16 vector,
+ * or all elements of an unaligned array, are converted one by one.
+ */
+static inline float snrt_vexpf16_sum(const __fp16 *x, __fp16 *y, float offset,
+                                     uint32_t len) {
+    float tmp[SNRT_VMATH_CHUNK] __attribute__((aligned(8)));
+    float buf[SNRT_VMATH_CHUNK + 1] __attribute__((aligned(8)));
+    uint32_t aligned = !(((uintptr_t)x | (uintptr_t)y) % sizeof(v4f16));
+    v2f32 sum = {0.0f, 0.0f};
+
+    for (uint32_t i = 0; i < len; i += SNRT_VMATH_CHUNK) {
+        uint32_t n = len - i < SNRT_VMATH_CHUNK ? len - i : SNRT_VMATH_CHUNK;
+        uint32_t n_wide = aligned ? n / 4 : 0;
+
+        if (n_wide) vmath_widen_fp16(x + i, buf, n_wide);
+        for (uint32_t j = n_wide * 4; j < n; j++) buf[j] = x[i + j];
+        if (n % 2) buf[n] = -__builtin_inff();
+
+        vmath_expf_reduce(buf, offset, tmp, buf, (n + 1) / 2);
+        vmath_expf_poly_sum(tmp, buf, buf, (n + 1) / 2, &sum);
+
+        if (n_wide) vmath_narrow_fp16(buf, y + i, n_wide);
+        for (uint32_t j = n_wide * 4; j < n; j++) y[i + j] = buf[j];
+    }
+    return sum[0] + sum[1];
+}
+
+/// FP16 version of snrt_vlogf.
+static inline void snrt_vlogf16(const __fp16 *x, __fp16 *y, uint32_t len) {
+    snrt_vmath_map_fp16(vmath_logf_kernel, x, y, len);
+}
+
+/// FP16 version of snrt_vtanhf.
+static inline void snrt_vtanhf16(const __fp16 *x, __fp16 *y, uint32_t len) {
+    snrt_vmath_map_fp16(vmath_tanhf_kernel, x, y, len);
+}
+
+/// FP16 version of snrt_vrsqrtf.
+static inline void snrt_vrsqrtf16(const __fp16 *x, __fp16 *y, uint32_t len) {
+    snrt_vmath_map_fp16(vmath_rsqrtf_kernel, x, y, len);
+}
@@ -3,3 +3,10 @@
 // SPDX-License-Identifier: Apache-2.0
 
 static inline void snrt_exit(int exit_code);
+
+extern __thread uint32_t _snrt_startup_cycles;
+
+/// Cycles spent by the calling core in the runtime initialization, from the
+/// entry of snrt_main up to the invocation of main(). The runtime prints the
+/// value of core 0 itself if it is built with SNRT_CRT0_REPORT_STARTUP.
+static inline uint32_t snrt_startup_cycles() { return _snrt_startup_cycles; }
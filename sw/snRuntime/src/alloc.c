@@ -13,3 +13,5 @@ extern void *snrt_l3alloc(size_t size);
 extern void snrt_l1_update_next(void *next);
 
 extern void snrt_alloc_init();
+
+extern void *snrt_memset(void *ptr, int value, size_t num);
@@ -7,6 +7,10 @@
 
 #define MIN_CHUNK_SIZE 8
 
+// Early declaration of the functions
+inline void snrt_memset_words(void *ptr, uint8_t value, size_t len);
+inline void snrt_dma_memset(void *ptr, uint8_t value, uint32_t len);
+
 extern snrt_allocator_t l3_allocator;
 
 inline snrt_allocator_t *snrt_l1_allocator() {
@@ -91,9 +95,15 @@ inline void snrt_alloc_init() {
     }
 }
 
-// TODO colluca: optimize by using DMA
+/**
+ * @brief Set a region of memory to a byte value
+ * @details On the DM core, large regions are offloaded to the DMA. The other
+ * cores fall back to word-wide stores.
+ */
 inline void *snrt_memset(void *ptr, int value, size_t num) {
-    for (uint32_t i = 0; i < num; ++i)
-        *((uint8_t *)ptr + i) = (unsigned char)value;
+    if (snrt_is_dm_core())
+        snrt_dma_memset(ptr, (uint8_t)value, num);
+    else
+        snrt_memset_words(ptr, (uint8_t)value, num);
     return ptr;
 }
@@ -0,0 +1,24 @@
+// Copyright 2023 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+uint32_t snrt_bench_cycles[SNRT_CLUSTER_NUM * SNRT_CLUSTER_CORE_NUM];
+
+uint32_t snrt_bench_fpu[SNRT_CLUSTER_NUM * SNRT_CLUSTER_CORE_NUM];
+
+extern uint32_t snrt_bench_peak(uint32_t elem_size);
+
+extern uint32_t snrt_bench_core_idx();
+
+extern uint32_t snrt_bench_n_counted();
+
+extern void snrt_bench_counters_start();
+
+extern void snrt_bench_counters_stop();
+
+extern void snrt_bench_print_ratio(double num, double den);
+
+extern uint32_t snrt_bench_emit(const snrt_bench_t *bench, uint32_t run);
+
+extern int snrt_bench_run(snrt_bench_t *bench, snrt_bench_fn_t fn,
+                          void *args);
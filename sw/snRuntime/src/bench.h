@@ -0,0 +1,198 @@
+// Copyright 2023 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+//================================================================================
+// Kernel benchmark harness
+//================================================================================
+//
+// Usage, on all cores of all clusters:
+//
+//   int run_gemm(void *args) { ... }
+//
+//   snrt_bench_t bench = {.name = "gemm", .warmup = 1, .runs = 3,
+//                         .flops = 2 * M * N * K, .elem_size = FP64};
+//   int ret = snrt_bench_run(&bench, run_gemm, &args);
+//
+// The kernel is run `warmup` times untimed, to warm up the instruction cache,
+// and then `runs` times, every run starting from a global barrier. Every core
+// measures its own cycles, and the FPU issue counter of every compute core is
+// sampled from the cluster performance counters, so the harness cannot be
+// combined with `profile.h` regions. After every run, core 0 prints a record
+// on a single line, tagged with `SNRT_BENCH_TAG`:
+//
+//   BENCH {"name": "gemm", "run": 0, "cycles": 1042, "flop_per_cycle": 7.862,
+//          "peak_flop_per_cycle": 16, "utilization": 0.491, ...}
+//
+// which `util/sim` collects from the simulation logs. The kernel must be
+// idempotent, since it runs several times on the same operands, and should
+// fence the FPU before returning, like the kernels of `sw/blas` and `sw/dnn`
+// do, for its cycles to include the FP instructions in flight. The GCC
+// toolchain has no float support in printf, so ratios are printed in fixed
+// point with `SNRT_BENCH_DECIMALS` decimals.
+
+#define SNRT_BENCH_TAG "BENCH"
+#define SNRT_BENCH_DECIMALS 3
+
+/// Kernel under test, returning a nonzero value on failure
+typedef int (*snrt_bench_fn_t)(void *args);
+
+typedef struct {
+    const char *name;
+    uint32_t warmup;     // Untimed runs
+    uint32_t runs;       // Timed runs, one record each
+    uint32_t flops;      // FP operations of a run, over all clusters
+    uint32_t elem_size;  // Operand size in bytes, sets the SIMD width
+    uint32_t cycles;     // Result: cycles of the fastest run, on core 0
+} snrt_bench_t;
+
+extern uint32_t snrt_bench_cycles[SNRT_CLUSTER_NUM * SNRT_CLUSTER_CORE_NUM];
+extern uint32_t snrt_bench_fpu[SNRT_CLUSTER_NUM * SNRT_CLUSTER_CORE_NUM];
+
+/**
+ * @brief Peak FLOP/cycle of all compute cores
+ * @details Every compute core issues one FMA per cycle on a 64-bit FPU,
+ * packing `8 / elem_size` SIMD lanes.
+ */
+inline uint32_t snrt_bench_peak(uint32_t elem_size) {
+    uint32_t lanes = elem_size ? sizeof(double) / elem_size : 1;
+    return 2 * lanes * snrt_cluster_compute_core_num() * snrt_cluster_num();
+}
+
+/// Index of the calling core in the per-core result arrays
+inline uint32_t snrt_bench_core_idx() {
+    return snrt_cluster_idx() * SNRT_CLUSTER_CORE_NUM +
+           snrt_cluster_core_idx();
+}
+
+/// Number of compute cores whose FPU issues can be counted
+inline uint32_t snrt_bench_n_counted() {
+    uint32_t n = snrt_cluster_compute_core_num();
+    return n < SNRT_PERF_N_CNT ? n : SNRT_PERF_N_CNT;
+}
+
+/// Count the FPU issues of compute core `c` on counter `c`.
+inline void snrt_bench_counters_start() {
+    for (uint32_t c = 0; c < snrt_bench_n_counted(); c++) {
+        snrt_reset_perf_counter((enum snrt_perf_cnt)c);
+        snrt_start_perf_counter((enum snrt_perf_cnt)c, SNRT_PERF_CNT_ISSUE_FPU,
+                                c);
+    }
+}
+
+/// Stop the counters and write them to the per-core result arrays.
+inline void snrt_bench_counters_stop() {
+    uint32_t *fpu =
+        &snrt_bench_fpu[snrt_cluster_idx() * SNRT_CLUSTER_CORE_NUM];
+    for (uint32_t c = 0; c < snrt_bench_n_counted(); c++) {
+        snrt_stop_perf_counter((enum snrt_perf_cnt)c);
+        fpu[c] = snrt_get_perf_counter((enum snrt_perf_cnt)c);
+    }
+}
+
+/// Print `num / den` in fixed point. The ratio is computed in double, as
+/// 64-bit integer divisions would need the libgcc builtins.
+inline void snrt_bench_print_ratio(double num, double den) {
+    uint32_t scale = 1;
+    for (uint32_t i = 0; i < SNRT_BENCH_DECIMALS; i++) scale *= 10;
+    uint32_t q = den > 0 ? (uint32_t)(num * scale / den + 0.5) : 0;
+    printf("%u.%0*u", q / scale, SNRT_BENCH_DECIMALS, q % scale);
+}
+
+/// Print the record of timed run `run` from the per-core result arrays and
+/// return the cycles of the run.
+inline uint32_t snrt_bench_emit(const snrt_bench_t *bench, uint32_t run) {
+    const uint32_t n_clusters = snrt_cluster_num();
+    const uint32_t n_cores = snrt_cluster_core_num();
+    const uint32_t n_counted = snrt_bench_n_counted();
+    const uint32_t peak = snrt_bench_peak(bench->elem_size);
+
+    // A run lasts until its slowest core is done
+    uint32_t cycles = 0;
+    for (uint32_t k = 0; k < n_clusters; k++) {
+        for (uint32_t c = 0; c < n_cores; c++) {
+            uint32_t t = snrt_bench_cycles[k * SNRT_CLUSTER_CORE_NUM + c];
+            if (t > cycles) cycles = t;
+        }
+    }
+
+    printf("%s {\"name\": \"%s\", \"run\": %u, \"warmup\": %u, ",
+           SNRT_BENCH_TAG, bench->name, run, bench->warmup);
+    printf("\"clusters\": %u, \"cores\": %u, \"compute_cores\": %u, ",
+           n_clusters, n_cores, snrt_cluster_compute_core_num());
+    printf("\"elem_size\": %u, \"flops\": %u, \"cycles\": %u, ",
+           bench->elem_size, bench->flops, cycles);
+    printf("\"flop_per_cycle\": ");
+    snrt_bench_print_ratio(bench->flops, cycles);
+    printf(", \"peak_flop_per_cycle\": %u, \"utilization\": ", peak);
+    snrt_bench_print_ratio(bench->flops, (double)cycles * peak);
+
+    // Per-core results, cluster by cluster
+    printf(", \"core_cycles\": [");
+    for (uint32_t k = 0; k < n_clusters; k++) {
+        for (uint32_t c = 0; c < n_cores; c++) {
+            if (k + c) printf(", ");
+            printf("%u", snrt_bench_cycles[k * SNRT_CLUSTER_CORE_NUM + c]);
+        }
+    }
+    printf("], \"fpu_issues\": [");
+    for (uint32_t k = 0; k < n_clusters; k++) {
+        for (uint32_t c = 0; c < n_counted; c++) {
+            if (k + c) printf(", ");
+            printf("%u", snrt_bench_fpu[k * SNRT_CLUSTER_CORE_NUM + c]);
+        }
+    }
+    printf("], \"fpu_util\": [");
+    for (uint32_t k = 0; k < n_clusters; k++) {
+        for (uint32_t c = 0; c < n_counted; c++) {
+            uint32_t i = k * SNRT_CLUSTER_CORE_NUM + c;
+            if (k + c) printf(", ");
+            snrt_bench_print_ratio(snrt_bench_fpu[i], snrt_bench_cycles[i]);
+        }
+    }
+    printf("]}\n");
+    return cycles;
+}
+
+/**
+ * @brief Benchmark a kernel
+ * @details Must be called by all cores of all clusters, which all call `fn`.
+ *
+ * @param bench name, number of runs and FP operations of the kernel, and
+ * cycles of the fastest run on return
+ * @param fn kernel under test
+ * @param args argument of `fn`
+ * @return return value of the last run of `fn` on the calling core
+ */
+inline int snrt_bench_run(snrt_bench_t *bench, snrt_bench_fn_t fn,
+                          void *args) {
+    const uint32_t idx = snrt_bench_core_idx();
+    int ret = 0;
+
+    bench->cycles = 0;
+    for (uint32_t i = 0; i < bench->warmup; i++) {
+        snrt_global_barrier();
+        ret = fn(args);
+    }
+
+    for (uint32_t run = 0; run < bench->runs; run++) {
+        if (snrt_cluster_core_idx() == 0) snrt_bench_counters_start();
+        snrt_global_barrier();
+
+        uint32_t start_cycle = snrt_mcycle();
+        ret = fn(args);
+        uint32_t end_cycle = snrt_mcycle();
+        snrt_bench_cycles[idx] = end_cycle - start_cycle;
+
+        snrt_global_barrier();
+        if (snrt_cluster_core_idx() == 0) snrt_bench_counters_stop();
+        snrt_global_barrier();
+        if (snrt_global_core_idx() == 0) {
+            uint32_t cycles = snrt_bench_emit(bench, run);
+            if (!run || cycles < bench->cycles) bench->cycles = cycles;
+        }
+    }
+
+    snrt_global_barrier();
+    return ret;
+}
@@ -2,6 +2,10 @@
 // Licensed under the Apache License, Version 2.0, see LICENSE for details.
 // SPDX-License-Identifier: Apache-2.0
 
+__thread uint32_t _snrt_dma_next_channel;
+
+snrt_dma_memset_backend_t _snrt_dma_memset_backend;
+
 extern snrt_dma_txid_t snrt_dma_start_1d_wideptr(uint64_t dst, uint64_t src,
                                                  size_t size);
 
@@ -20,3 +24,45 @@ extern snrt_dma_txid_t snrt_dma_start_2d(void *dst, const void *src,
 extern void snrt_dma_wait(snrt_dma_txid_t tid);
 
 extern void snrt_dma_wait_all();
+
+extern uint32_t snrt_dma_channel(uint32_t channel);
+
+extern uint32_t snrt_dma_next_channel();
+
+extern snrt_dma_txid_t snrt_dma_start_1d_channel_wideptr(uint64_t dst,
+                                                         uint64_t src,
+                                                         size_t size,
+                                                         uint32_t channel);
+
+extern snrt_dma_txid_t snrt_dma_start_1d_channel(void *dst, const void *src,
+                                                 size_t size,
+                                                 uint32_t channel);
+
+extern snrt_dma_txid_t snrt_dma_start_2d_channel_wideptr(
+    uint64_t dst, uint64_t src, size_t size, size_t dst_stride,
+    size_t src_stride, size_t repeat, uint32_t channel);
+
+extern snrt_dma_txid_t snrt_dma_start_2d_channel(void *dst, const void *src,
+                                                 size_t size, size_t dst_stride,
+                                                 size_t src_stride,
+                                                 size_t repeat,
+                                                 uint32_t channel);
+
+extern void snrt_dma_wait_channel(snrt_dma_txid_t tid, uint32_t channel);
+
+extern void snrt_dma_wait_all_channel(uint32_t channel);
+
+extern void snrt_dma_wait_all_channels();
+
+extern void snrt_dma_set_memset_backend(snrt_dma_memset_backend_t backend);
+
+extern void snrt_memset_words(void *ptr, uint8_t value, size_t len);
+
+extern snrt_dma_txid_t snrt_dma_memset_async(void *ptr, uint8_t value,
+                                             size_t len);
+
+extern void snrt_dma_memset(void *ptr, uint8_t value, uint32_t len);
+
+extern snrt_dma_txid_t snrt_dma_zero_async(void *ptr, size_t len);
+
+extern void snrt_dma_zero(void *ptr, size_t len);
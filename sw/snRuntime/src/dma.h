@@ -5,6 +5,16 @@
 /// A DMA transfer identifier.
 typedef uint32_t snrt_dma_txid_t;
 
+/// Number of iDMA channels instantiated in the cluster frontend. Channel
+/// indices wrap around modulo this number, so code written for multiple
+/// channels still runs (serialized on channel 0) on single-channel clusters.
+#ifndef SNRT_DMA_NUM_CHANNELS
+#define SNRT_DMA_NUM_CHANNELS 1
+#endif
+
+/// Next channel handed out by the round-robin channel policy.
+extern __thread uint32_t _snrt_dma_next_channel;
+
 // Early declaration of the functions
 inline uint32_t __attribute__((const)) snrt_cluster_base_addrh();
 
@@ -42,6 +52,11 @@ inline uint32_t __attribute__((const)) snrt_cluster_base_addrh();
 // So to set the config you write the immediate as:
 //   imm = (chan << 2) | (twod << 1) | decouple_aw
 //   1D, decouple_aw=0, ch0 -> 0b00000  ;  2D, decouple_aw=0, ch0 -> 0b00010
+//
+// The `*_channel` variants below use the register forms DMCPY and DMSTAT
+// (funct7 0b0000011 and 0b0000101) instead, which take the same config
+// (resp. channel and status selector) from rs2, so the channel can be chosen
+// at run time.
 // ---------------------------------------------------------------------------
 
 /// Initiate an asynchronous 1D DMA transfer with wide 64-bit pointers.
@@ -190,6 +205,175 @@ inline snrt_dma_txid_t snrt_dma_start_2d(void *dst, const void *src,
                                      src_stride, repeat);
 }
 
+/// Map an arbitrary channel index onto an instantiated DMA channel.
+inline uint32_t snrt_dma_channel(uint32_t channel) {
+    return channel % SNRT_DMA_NUM_CHANNELS;
+}
+
+/// Return the next DMA channel according to a round-robin policy.
+inline uint32_t snrt_dma_next_channel() {
+    uint32_t channel = _snrt_dma_next_channel;
+    _snrt_dma_next_channel = snrt_dma_channel(channel + 1);
+    return channel;
+}
+
+/// Initiate an asynchronous 1D DMA transfer with wide 64-bit pointers on a
+/// specific channel. Transfer IDs are only meaningful within their channel.
+inline snrt_dma_txid_t snrt_dma_start_1d_channel_wideptr(uint64_t dst,
+                                                         uint64_t src,
+                                                         size_t size,
+                                                         uint32_t channel) {
+    // Zero-size transfers block, see snrt_dma_start_1d_wideptr()
+    if (size > 0) {
+        register uint32_t reg_dst_low asm("a0") = dst >> 0;    // 10
+        register uint32_t reg_dst_high asm("a1") = dst >> 32;  // 11
+        register uint32_t reg_src_low asm("a2") = src >> 0;    // 12
+        register uint32_t reg_src_high asm("a3") = src >> 32;  // 13
+        register uint32_t reg_size asm("a4") = size;           // 14
+        register uint32_t reg_cfg asm("a5") =                  // 15
+            snrt_dma_channel(channel) << 2;
+
+        // dmsrc a2, a3
+        asm volatile(
+            ".word (0b0000000 << 25) | \
+                (     (13) << 20) | \
+                (     (12) << 15) | \
+                (    0b000 << 12) | \
+                (0b0101011 <<  0)   \n" ::"r"(reg_src_high),
+            "r"(reg_src_low));
+
+        // dmdst a0, a1
+        asm volatile(
+            ".word (0b0000001 << 25) | \
+                (     (11) << 20) | \
+                (     (10) << 15) | \
+                (    0b000 << 12) | \
+                (0b0101011 <<  0)   \n" ::"r"(reg_dst_high),
+            "r"(reg_dst_low));
+
+        // dmcpy a0, a4, a5
+        // config a5 = chan << 2: twod=0 (1D), decouple_aw=0 (R-AW coupled)
+        register uint32_t reg_txid asm("a0");  // 10
+        asm volatile(
+            ".word (0b0000011 << 25) | \
+                (     (15) << 20) | \
+                (     (14) << 15) | \
+                (    0b000 << 12) | \
+                (     (10) <<  7) | \
+                (0b0101011 <<  0)   \n"
+            : "=r"(reg_txid)
+            : "r"(reg_size), "r"(reg_cfg));
+
+        return reg_txid;
+    } else {
+        return -1;
+    }
+}
+
+/// Initiate an asynchronous 1D DMA transfer on a specific channel. (for
+/// local-chip transfers)
+inline snrt_dma_txid_t snrt_dma_start_1d_channel(void *dst, const void *src,
+                                                 size_t size,
+                                                 uint32_t channel) {
+    uint64_t dst_wideptr = (uint64_t)dst;
+    dst_wideptr += (uint64_t)snrt_cluster_base_addrh() << 32;
+    uint64_t src_wideptr = (uint64_t)src;
+    src_wideptr += (uint64_t)snrt_cluster_base_addrh() << 32;
+    return snrt_dma_start_1d_channel_wideptr(dst_wideptr, src_wideptr, size,
+                                             channel);
+}
+
+/// Initiate an asynchronous 2D DMA transfer with wide 64-bit pointers on a
+/// specific channel. Transfer IDs are only meaningful within their channel.
+inline snrt_dma_txid_t snrt_dma_start_2d_channel_wideptr(
+    uint64_t dst, uint64_t src, size_t size, size_t dst_stride,
+    size_t src_stride, size_t repeat, uint32_t channel) {
+    // Zero-size transfers block, see snrt_dma_start_2d_wideptr()
+    if (size > 0) {
+        register uint32_t reg_dst_low asm("a0") = dst >> 0;       // 10
+        register uint32_t reg_dst_high asm("a1") = dst >> 32;     // 11
+        register uint32_t reg_src_low asm("a2") = src >> 0;       // 12
+        register uint32_t reg_src_high asm("a3") = src >> 32;     // 13
+        register uint32_t reg_size asm("a4") = size;              // 14
+        register uint32_t reg_dst_stride asm("a5") = dst_stride;  // 15
+        register uint32_t reg_src_stride asm("a6") = src_stride;  // 16
+        register uint32_t reg_repeat asm("a7") = repeat;          // 17
+        register uint32_t reg_cfg asm("t1") =                     // 6
+            (snrt_dma_channel(channel) << 2) | 0b10;
+
+        // dmsrc a2, a3
+        asm volatile(
+            ".word (0b0000000 << 25) | \
+                (     (13) << 20) | \
+                (     (12) << 15) | \
+                (    0b000 << 12) | \
+                (0b0101011 <<  0)   \n" ::"r"(reg_src_high),
+            "r"(reg_src_low));
+
+        // dmdst a0, a1
+        asm volatile(
+            ".word (0b0000001 << 25) | \
+                (     (11) << 20) | \
+                (     (10) << 15) | \
+                (    0b000 << 12) | \
+                (0b0101011 <<  0)   \n" ::"r"(reg_dst_high),
+            "r"(reg_dst_low));
+
+        // dmstr a5, a6
+        asm volatile(
+            ".word (0b0000110 << 25) | \
+                (     (15) << 20) | \
+                (     (16) << 15) | \
+                (    0b000 << 12) | \
+                (0b0101011 <<  0)   \n"
+            :
+            : "r"(reg_dst_stride), "r"(reg_src_stride));
+
+        // dmrep a7
+        asm volatile(
+            ".word (0b0000111 << 25) | \
+                (     (17) << 15) | \
+                (    0b000 << 12) | \
+                (0b0101011 <<  0)   \n"
+            :
+            : "r"(reg_repeat));
+
+        // dmcpy a0, a4, t1
+        // config t1 = (chan << 2) | 0b10: twod=1 (2D), decouple_aw=0 (R-AW
+        // coupled)
+        register uint32_t reg_txid asm("a0");  // 10
+        asm volatile(
+            ".word (0b0000011 << 25) | \
+                (      (6) << 20) | \
+                (     (14) << 15) | \
+                (    0b000 << 12) | \
+                (     (10) <<  7) | \
+                (0b0101011 <<  0)   \n"
+            : "=r"(reg_txid)
+            : "r"(reg_size), "r"(reg_cfg));
+
+        return reg_txid;
+    } else {
+        return -1;
+    }
+}
+
+/// Initiate an asynchronous 2D DMA transfer on a specific channel. (for
+/// local-chip transfers)
+inline snrt_dma_txid_t snrt_dma_start_2d_channel(void *dst, const void *src,
+                                                 size_t size, size_t dst_stride,
+                                                 size_t src_stride,
+                                                 size_t repeat,
+                                                 uint32_t channel) {
+    uint64_t dst_wideptr = (uint64_t)dst;
+    dst_wideptr += (uint64_t)snrt_cluster_base_addrh() << 32;
+    uint64_t src_wideptr = (uint64_t)src;
+    src_wideptr += (uint64_t)snrt_cluster_base_addrh() << 32;
+    return snrt_dma_start_2d_channel_wideptr(dst_wideptr, src_wideptr, size,
+                                             dst_stride, src_stride, repeat,
+                                             channel);
+}
+
 /// Block until a transfer finishes.
 inline void snrt_dma_wait(snrt_dma_txid_t tid) {
     // dmstati t0, 0  # 2=status.completed_id
@@ -219,6 +403,46 @@ inline void snrt_dma_wait_all() {
             : "t0");
 }
 
+/// Block until a transfer issued on `channel` finishes.
+inline void snrt_dma_wait_channel(snrt_dma_txid_t tid, uint32_t channel) {
+    // dmstat t0, t1  # t1 = (chan << 2) | 0, 0=status.completed_id
+    register uint32_t reg_cfg asm("t1") = snrt_dma_channel(channel) << 2;
+    asm volatile(
+        "1: \n"
+        ".word (0b0000101 << 25) | \
+               (      (6) << 20) | \
+               (    0b000 << 12) | \
+               (      (5) <<  7) | \
+               (0b0101011 <<  0)   \n"
+        "sub t0, t0, %0 \n"
+        "blez t0, 1b \n" ::"r"(tid),
+        "r"(reg_cfg)
+        : "t0");
+}
+
+/// Block until all operation on DMA channel `channel` ceases.
+inline void snrt_dma_wait_all_channel(uint32_t channel) {
+    // dmstat t0, t1  # t1 = (chan << 2) | 2, 2=status.busy
+    register uint32_t reg_cfg asm("t1") =
+        (snrt_dma_channel(channel) << 2) | 0b10;
+    asm volatile(
+        "1: \n"
+        ".word (0b0000101 << 25) | \
+               (      (6) << 20) | \
+               (    0b000 << 12) | \
+               (      (5) <<  7) | \
+               (0b0101011 <<  0)   \n"
+        "bne t0, zero, 1b \n" ::"r"(reg_cfg)
+        : "t0");
+}
+
+/// Block until all operation on every DMA channel ceases.
+inline void snrt_dma_wait_all_channels() {
+    for (uint32_t c = 0; c < SNRT_DMA_NUM_CHANNELS; c++) {
+        snrt_dma_wait_all_channel(c);
+    }
+}
+
 /**
  * @brief start tracking of dma performance region. Does not have any
  * implications on the HW. Only injects a marker in the DMA traces that can be
@@ -235,24 +459,117 @@ inline void snrt_dma_start_tracking() { asm volatile("dmstati zero, 1"); }
  */
 inline void snrt_dma_stop_tracking() { asm volatile("dmstati zero, 3"); }
 
+/// Number of bytes written by the core to seed a DMA memset. The seed is
+/// grown by exponential doubling up to `SNRT_DMA_MEMSET_BLOCK` bytes, which
+/// is then replicated over the rest of the region by a single 2D transfer.
+#define SNRT_DMA_MEMSET_SEED 64
+#ifndef SNRT_DMA_MEMSET_BLOCK
+#define SNRT_DMA_MEMSET_BLOCK 1024
+#endif
+
+/// Regions smaller than this are set by the core, without involving the DMA.
+#ifndef SNRT_DMA_MEMSET_MIN_SIZE
+#define SNRT_DMA_MEMSET_MIN_SIZE (2 * SNRT_DMA_MEMSET_SEED)
+#endif
+
+/// Alternative memset engine, e.g. the XDMA of SNAX clusters. It returns 0
+/// once it has set the region, or nonzero if it cannot handle the region, in
+/// which case the iDMA is used instead.
+typedef int32_t (*snrt_dma_memset_backend_t)(void *ptr, uint8_t value,
+                                             uint32_t len);
+
+/// Memset engine selected by `snrt_dma_set_memset_backend()`, if any.
+extern snrt_dma_memset_backend_t _snrt_dma_memset_backend;
+
+/// Select the engine used by `snrt_dma_memset()`, NULL for the iDMA.
+inline void snrt_dma_set_memset_backend(snrt_dma_memset_backend_t backend) {
+    _snrt_dma_memset_backend = backend;
+}
+
+/// Set `len` bytes starting at `ptr` to `value` using word-wide core stores.
+inline void snrt_memset_words(void *ptr, uint8_t value, size_t len) {
+    uint8_t *p = (uint8_t *)ptr;
+    uint8_t *end = p + len;
+    uint32_t word = value * 0x01010101U;
+    while (p < end && ((uintptr_t)p & 3)) *p++ = value;
+    for (; p + 4 <= end; p += 4) *(uint32_t *)p = word;
+    while (p < end) *p++ = value;
+}
+
+/**
+ * @brief asynchronous memset function performed by DMA
+ * @details The core seeds the first `SNRT_DMA_MEMSET_SEED` bytes with word
+ * stores. The seed is then doubled in place with DMA copies up to
+ * `SNRT_DMA_MEMSET_BLOCK` bytes, and the block is replicated over the
+ * remainder of the region with a 2D transfer reading from a zero source
+ * stride, followed by a 1D transfer for the tail. Only the last two transfers
+ * are left in flight. Every doubling copy reads what the previous one wrote,
+ * so the function waits for each of them, but not for transfers issued
+ * after it returns. Always uses the iDMA, whose transfer IDs it returns.
+ *
+ * @param ptr pointer to the start of the region
+ * @param value value to set
+ * @param len number of bytes, any size and alignment
+ * @return ID of the last transfer issued, to be passed to `snrt_dma_wait()`.
+ * -1 if no transfer is pending on return.
+ */
+inline snrt_dma_txid_t snrt_dma_memset_async(void *ptr, uint8_t value,
+                                             size_t len) {
+    if (len < SNRT_DMA_MEMSET_MIN_SIZE) {
+        snrt_memset_words(ptr, value, len);
+        return -1;
+    }
+
+    // Seed the first block with the core
+    uint8_t *block = (uint8_t *)ptr;
+    size_t block_size = SNRT_DMA_MEMSET_SEED;
+    snrt_memset_words(block, value, block_size);
+    // Make sure the seed is visible to the DMA, e.g. for regions in L3
+    asm volatile("fence" ::: "memory");
+
+    // Grow the block by exponential doubling. Every copy reads what the
+    // previous one wrote, so they have to be serialized.
+    while (block_size < SNRT_DMA_MEMSET_BLOCK && 2 * block_size <= len) {
+        snrt_dma_wait(snrt_dma_start_1d(block + block_size, block, block_size));
+        block_size *= 2;
+    }
+
+    // Replicate the block over the rest of the region, then fill the tail
+    snrt_dma_txid_t txid = -1;
+    size_t remaining = len - block_size;
+    size_t repeat = remaining / block_size;
+    size_t tail = remaining % block_size;
+    uint8_t *dst = block + block_size;
+    if (repeat) {
+        txid = snrt_dma_start_2d(dst, block, block_size, block_size, 0, repeat);
+        dst += repeat * block_size;
+    }
+    if (tail) txid = snrt_dma_start_1d(dst, block, tail);
+    return txid;
+}
+
 /**
  * @brief fast memset function performed by DMA
+ * @details Blocking version of `snrt_dma_memset_async()`, which goes through
+ * the engine selected by `snrt_dma_set_memset_backend()` if there is one.
  *
  * @param ptr pointer to the start of the region
  * @param value value to set
- * @param len number of bytes, must be multiple of DMA bus-width
+ * @param len number of bytes, any size and alignment
  */
 inline void snrt_dma_memset(void *ptr, uint8_t value, uint32_t len) {
-    // set first 64bytes to value
-    // memset(ptr, value, 64);
-    uint8_t *p = ptr;
-    uint32_t nbytes = 64;
-    while (nbytes--) {
-        *p++ = value;
-    }
+    if (_snrt_dma_memset_backend && !_snrt_dma_memset_backend(ptr, value, len))
+        return;
+    snrt_dma_txid_t txid = snrt_dma_memset_async(ptr, value, len);
+    if (txid != (snrt_dma_txid_t)-1) snrt_dma_wait(txid);
+}
+
+/// Asynchronously zero-fill `len` bytes starting at `ptr` using the DMA.
+inline snrt_dma_txid_t snrt_dma_zero_async(void *ptr, size_t len) {
+    return snrt_dma_memset_async(ptr, 0, len);
+}
 
-    // DMA copy the the rest
-    snrt_dma_txid_t memset_txid =
-        snrt_dma_start_2d(ptr, ptr, 64, 64, 0, len / 64);
-    snrt_dma_wait_all();
+/// Zero-fill `len` bytes starting at `ptr` using the DMA.
+inline void snrt_dma_zero(void *ptr, size_t len) {
+    snrt_dma_memset(ptr, 0, len);
 }
@@ -57,6 +57,7 @@ enum snrt_perf_cnt_type {
     SNRT_PERF_CNT_ICACHE_PREFETCH,
     SNRT_PERF_CNT_ICACHE_DOUBLE_HIT,
     SNRT_PERF_CNT_ICACHE_STALL,
+    SNRT_PERF_CNT_N_TYPES,
 };
 
 typedef union {
@@ -0,0 +1,18 @@
+// Copyright 2023 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+__thread snrt_profile_t *_snrt_profile;
+
+snrt_profile_record_t
+    snrt_profile_records[SNRT_CLUSTER_NUM * SNRT_PROFILE_MAX_REGIONS];
+
+extern void snrt_profile_init(uint32_t event_mask);
+
+extern snrt_profile_record_t *snrt_profile_region(const char *name);
+
+extern void snrt_profile_begin(const char *name);
+
+extern void snrt_profile_end();
+
+extern void snrt_profile_dump();
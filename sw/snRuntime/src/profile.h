@@ -0,0 +1,166 @@
+// Copyright 2023 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+//================================================================================
+// Region profiling on top of the cluster performance counters
+//================================================================================
+//
+// Usage, on a single core per cluster:
+//
+//   snrt_profile_init(SNRT_PROFILE_EVENTS_TCDM | SNRT_PROFILE_EVENTS_DMA);
+//   for (...) {
+//       SNRT_PROFILE_BEGIN("gemm_tile");
+//       ...
+//       SNRT_PROFILE_END();
+//   }
+//   snrt_profile_dump();
+//
+// Regions cannot be nested, as they share the cluster performance counters.
+// When more events are requested than there are hardware counters, the event
+// set is split into groups of `SNRT_PERF_N_CNT` events and every run of a
+// region measures the next group, round-robin. Totals are accumulated in L1
+// and written to `snrt_profile_records` in L3 by `snrt_profile_dump()`, from
+// where `util/sim/perf_profile.py` converts them to CSV, scaling multiplexed
+// events to the total number of runs.
+
+#define SNRT_PROFILE_MAX_REGIONS 8
+#define SNRT_PROFILE_NAME_LEN 16
+
+/// Event sets, as bitmasks over `enum snrt_perf_cnt_type`
+#define SNRT_PROFILE_EVENTS_TCDM \
+    ((1 << SNRT_PERF_CNT_TCDM_ACCESSED) | (1 << SNRT_PERF_CNT_TCDM_CONGESTED))
+#define SNRT_PROFILE_EVENTS_CORE                                              \
+    ((1 << SNRT_PERF_CNT_ISSUE_FPU) | (1 << SNRT_PERF_CNT_ISSUE_FPU_SEQ) |    \
+     (1 << SNRT_PERF_CNT_ISSUE_CORE_TO_FPU) |                                 \
+     (1 << SNRT_PERF_CNT_RETIRED_INSTR) | (1 << SNRT_PERF_CNT_RETIRED_LOAD) | \
+     (1 << SNRT_PERF_CNT_RETIRED_I) | (1 << SNRT_PERF_CNT_RETIRED_ACC))
+#define SNRT_PROFILE_EVENTS_DMA                  \
+    (((1 << (SNRT_PERF_CNT_DMA_BUSY + 1)) - 1) & \
+     ~((1 << SNRT_PERF_CNT_DMA_AW_STALL) - 1))
+#define SNRT_PROFILE_EVENTS_ICACHE                   \
+    (((1 << (SNRT_PERF_CNT_ICACHE_STALL + 1)) - 1) & \
+     ~((1 << SNRT_PERF_CNT_ICACHE_MISS) - 1))
+#define SNRT_PROFILE_EVENTS_ALL ((1U << SNRT_PERF_CNT_N_TYPES) - 1)
+
+/// Per-region record, as accumulated in L1 and emitted to L3
+typedef struct {
+    char name[SNRT_PROFILE_NAME_LEN];
+    uint32_t runs;
+    uint32_t cycles;
+    uint32_t event_mask;
+    uint32_t counts[32];  // Indexed by `enum snrt_perf_cnt_type`
+} snrt_profile_record_t;
+
+typedef struct {
+    uint32_t event_mask;
+    uint32_t n_events;
+    uint32_t n_groups;
+    uint8_t events[SNRT_PERF_CNT_N_TYPES];
+    // State of the region being measured
+    snrt_profile_record_t *active;
+    uint32_t active_group;
+    uint32_t start_cycle;
+    uint32_t n_regions;
+    snrt_profile_record_t regions[SNRT_PROFILE_MAX_REGIONS];
+} snrt_profile_t;
+
+extern __thread snrt_profile_t *_snrt_profile;
+extern snrt_profile_record_t
+    snrt_profile_records[SNRT_CLUSTER_NUM * SNRT_PROFILE_MAX_REGIONS];
+
+/**
+ * @brief Initialize the profiler of the calling core
+ * @details Allocates the region table in L1. Must be called by at most one
+ * core per cluster, since the performance counters are shared.
+ *
+ * @param event_mask bitmask of `enum snrt_perf_cnt_type` events to measure
+ */
+inline void snrt_profile_init(uint32_t event_mask) {
+    snrt_profile_t *prof = (snrt_profile_t *)snrt_l1alloc(sizeof(*prof));
+    snrt_memset_words(prof, 0, sizeof(*prof));
+    event_mask &= SNRT_PROFILE_EVENTS_ALL;
+    prof->event_mask = event_mask;
+    for (uint32_t e = 0; e < SNRT_PERF_CNT_N_TYPES; e++) {
+        if (event_mask & (1 << e)) prof->events[prof->n_events++] = e;
+    }
+    prof->n_groups = (prof->n_events + SNRT_PERF_N_CNT - 1) / SNRT_PERF_N_CNT;
+    _snrt_profile = prof;
+}
+
+/// Find the region called `name`, or create it if there is room left.
+inline snrt_profile_record_t *snrt_profile_region(const char *name) {
+    snrt_profile_t *prof = _snrt_profile;
+    for (uint32_t r = 0; r < prof->n_regions; r++) {
+        const char *a = prof->regions[r].name;
+        uint32_t i = 0;
+        while (i < SNRT_PROFILE_NAME_LEN && a[i] == name[i] && name[i]) i++;
+        if (i == SNRT_PROFILE_NAME_LEN || a[i] == name[i])
+            return &prof->regions[r];
+    }
+    if (prof->n_regions == SNRT_PROFILE_MAX_REGIONS) return 0;
+    snrt_profile_record_t *region = &prof->regions[prof->n_regions++];
+    for (uint32_t i = 0; i < SNRT_PROFILE_NAME_LEN && name[i]; i++)
+        region->name[i] = name[i];
+    region->event_mask = prof->event_mask;
+    return region;
+}
+
+/// Start measuring a run of the region called `name`.
+inline void snrt_profile_begin(const char *name) {
+    snrt_profile_t *prof = _snrt_profile;
+    if (!prof || prof->active) return;
+    snrt_profile_record_t *region = snrt_profile_region(name);
+    if (!region) return;
+
+    // Program the next event group of this region
+    uint32_t group = prof->n_groups ? region->runs % prof->n_groups : 0;
+    uint32_t first = group * SNRT_PERF_N_CNT;
+    for (uint32_t c = 0; c < SNRT_PERF_N_CNT; c++) {
+        snrt_reset_perf_counter((enum snrt_perf_cnt)c);
+        if (first + c < prof->n_events) {
+            snrt_start_perf_counter((enum snrt_perf_cnt)c,
+                                    prof->events[first + c],
+                                    snrt_cluster_core_idx());
+        }
+    }
+    prof->active = region;
+    prof->active_group = group;
+    prof->start_cycle = snrt_mcycle();
+}
+
+/// Stop measuring the active region and accumulate its counters.
+inline void snrt_profile_end() {
+    uint32_t end_cycle = snrt_mcycle();
+    snrt_profile_t *prof = _snrt_profile;
+    if (!prof || !prof->active) return;
+    snrt_profile_record_t *region = prof->active;
+
+    uint32_t first = prof->active_group * SNRT_PERF_N_CNT;
+    for (uint32_t c = 0; c < SNRT_PERF_N_CNT && first + c < prof->n_events;
+         c++) {
+        snrt_stop_perf_counter((enum snrt_perf_cnt)c);
+        region->counts[prof->events[first + c]] +=
+            snrt_get_perf_counter((enum snrt_perf_cnt)c);
+    }
+    region->cycles += end_cycle - prof->start_cycle;
+    region->runs++;
+    prof->active = 0;
+}
+
+/// Write the accumulated records of the calling core's cluster to L3.
+inline void snrt_profile_dump() {
+    snrt_profile_t *prof = _snrt_profile;
+    if (!prof) return;
+    snrt_profile_record_t *dst =
+        &snrt_profile_records[snrt_cluster_idx() * SNRT_PROFILE_MAX_REGIONS];
+    for (uint32_t r = 0; r < prof->n_regions; r++) dst[r] = prof->regions[r];
+}
+
+#ifdef SNRT_PROFILE_DISABLE
+#define SNRT_PROFILE_BEGIN(name)
+#define SNRT_PROFILE_END()
+#else
+#define SNRT_PROFILE_BEGIN(name) snrt_profile_begin(name)
+#define SNRT_PROFILE_END() snrt_profile_end()
+#endif
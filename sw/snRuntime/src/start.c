@@ -15,9 +15,14 @@ static inline uint32_t snrt_cls_base_addr() {
     return l1_end_addr - cdata_size - cbss_size;
 }
 #endif
+// Cycles spent in snrt_main before invoking main()
+__thread uint32_t _snrt_startup_cycles;
+
 // In the future we will remove the idma in the cluster
 // Hence we remove the init code that using DMA to init
-// We use the CPU to init
+// We use the CPU to init, unless SNRT_INIT_DMA is defined. In that case the
+// DM core only issues the TLS, BSS and CLS transfers, and waits for all of
+// them at once in snrt_init_dma_wait()
 #ifdef SNRT_INIT_TLS
 static inline void snrt_init_tls() {
     extern volatile uint32_t __tdata_start, __tdata_end;
@@ -30,8 +35,26 @@ static inline void snrt_init_tls() {
     uint8_t* tdata_end = (uint8_t*)&__tdata_end;
     if (snrt_is_dm_core()) {
         size = (size_t)(&__tdata_end) - (size_t)(&__tdata_start);
-        // First initialize the DM core's .tdata section from main memory
         asm volatile("mv %0, tp" : "=r"(tls_ptr) : :);
+#ifdef SNRT_INIT_DMA
+        // The offset between the TLS section of successive cores is defined
+        // in start.S
+        size_t tls_offset = (1 << SNRT_LOG2_STACK_SIZE) + 8;
+        uint8_t* tls_dst = (uint8_t*)tls_ptr;
+        uint8_t* tbss_dst = tls_dst + size;
+        size_t tbss_size = (size_t)(&__tbss_end) - (size_t)(&__tbss_start);
+        // Broadcast .tdata from main memory to all cores' TLS
+        snrt_dma_start_2d(tls_dst, tdata_src, size, tls_offset, 0,
+                          snrt_cluster_core_num());
+        // Zero the DM core's .tbss on the iDMA and replicate it to all other
+        // cores. snrt_dma_zero() dispatches through the memset backend, a
+        // .bss variable which is not initialized yet.
+        snrt_dma_wait(snrt_dma_zero_async(tbss_dst, tbss_size));
+        if (snrt_cluster_core_num() > 1)
+            snrt_dma_start_2d(tbss_dst + tls_offset, tbss_dst, tbss_size,
+                              tls_offset, 0, snrt_cluster_core_num() - 1);
+#else
+        // First initialize the DM core's .tdata section from main memory
         uint8_t* tls_dst = (uint8_t*)tls_ptr;
         for (size_t i = 0; i < size; i++) {
             tls_dst[i] = tdata_src[i];
@@ -57,9 +80,12 @@ static inline void snrt_init_tls() {
                 tbss_dst[j] = 0;
             }
         }
+#endif
     }
 
+#ifndef SNRT_INIT_DMA
     snrt_cluster_hw_barrier();
+#endif
 }
 #endif
 
@@ -69,9 +95,14 @@ static inline void snrt_init_bss() {
     // Only one core needs to perform the initialization
     // As the snitch core is 32bit, initialize the bss region above 4GB does not
     // make sense.
-    // We temporally using the CPU to init the bss
+    // We temporally using the CPU to init the bss, unless the DMA is
+    // explicitly enabled for initialization with SNRT_INIT_DMA
 
     if (snrt_cluster_idx() == 0 && snrt_is_dm_core()) {
+#ifdef SNRT_INIT_DMA
+        size_t size = (size_t)(&__bss_end) - (size_t)(&__bss_start);
+        snrt_dma_zero_async((void*)&__bss_start, size);
+#else
         volatile uint8_t* bss_start = (volatile uint8_t*)&__bss_start;
         volatile uint8_t* bss_end = (volatile uint8_t*)&__bss_end;
 
@@ -92,6 +123,7 @@ static inline void snrt_init_bss() {
         for (volatile uint8_t* p = tail_start; p < bss_end; p++) {
             *p = 0U;
         }
+#endif
     }
 }
 #endif
@@ -101,7 +133,11 @@ static inline void snrt_init_cls() {
     extern volatile uint32_t __cdata_start, __cdata_end;
     extern volatile uint32_t __cbss_start, __cbss_end;
 
+#ifndef SNRT_INIT_DMA
+    // With SNRT_INIT_DMA the TLS may still be in flight, the pointer is set
+    // in snrt_init_dma_wait() instead
     _cls_ptr = (cls_t*)snrt_cls_base_addr();
+#endif
     if (snrt_is_dm_core()) {
         volatile uint8_t* tcdm_base = (volatile uint8_t*)snrt_cls_base_addr();
         size_t size;
@@ -110,6 +146,11 @@ static inline void snrt_init_cls() {
         volatile uint8_t* cdata_end = (volatile uint8_t*)&__cdata_end;
         size = cdata_end - cdata_src;
 
+#ifdef SNRT_INIT_DMA
+        snrt_dma_start_1d((void*)tcdm_base, (void*)cdata_src, size);
+        size_t cbss_size = (size_t)(&__cbss_end) - (size_t)(&__cbss_start);
+        snrt_dma_zero_async((void*)(tcdm_base + size), cbss_size);
+#else
         for (size_t i = 0; i < size; i++) {
             tcdm_base[i] = cdata_src[i];
         }
@@ -122,10 +163,23 @@ static inline void snrt_init_cls() {
         for (size_t i = 0; i < cbss_size; i++) {
             cbss_dst[i] = 0U;
         }
+#endif
     }
 }
 #endif
 
+#ifdef SNRT_INIT_DMA
+static inline void snrt_init_dma_wait() {
+    // Block until all initialization transfers issued by the DM core are
+    // done, the barrier then releases the other cores
+    if (snrt_is_dm_core()) snrt_dma_wait_all();
+    snrt_cluster_hw_barrier();
+#ifdef SNRT_INIT_CLS
+    _cls_ptr = (cls_t*)snrt_cls_base_addr();
+#endif
+}
+#endif
+
 #ifdef SNRT_INIT_LIBS
 static inline void snrt_init_libs() { snrt_alloc_init(); }
 #endif
@@ -147,6 +201,7 @@ static inline void snrt_exit(int exit_code) { snrt_exit_default(exit_code); }
 
 void snrt_main() {
     int exit_code = 0;
+    uint32_t startup_start = snrt_mcycle();
 
 #ifdef SNRT_CRT0_CALLBACK0
     snrt_crt0_callback0();
@@ -172,6 +227,10 @@ void snrt_main() {
     snrt_init_cls();
 #endif
 
+#ifdef SNRT_INIT_DMA
+    snrt_init_dma_wait();
+#endif
+
 #ifdef SNRT_CRT0_CALLBACK3
     snrt_crt0_callback3();
 #endif
@@ -188,6 +247,13 @@ void snrt_main() {
     snrt_cluster_hw_barrier();
 #endif
 
+    _snrt_startup_cycles = snrt_mcycle() - startup_start;
+
+#ifdef SNRT_CRT0_REPORT_STARTUP
+    if (snrt_global_core_idx() == 0)
+        printf("snrt: startup took %u cycles\n", _snrt_startup_cycles);
+#endif
+
 #ifdef SNRT_CRT0_CALLBACK5
     snrt_crt0_callback5();
 #endif
@@ -0,0 +1,52 @@
+// Copyright 2023 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <snrt.h>
+
+#define BUFFER_SIZE 4096
+
+// Check that [ptr + offset, ptr + offset + len) is set to `value` and that the
+// guard bytes around it are untouched.
+static uint32_t check(uint8_t *ptr, uint32_t offset, uint32_t len,
+                      uint8_t value, uint8_t guard) {
+    uint32_t errors = 0;
+    for (uint32_t i = 0; i < BUFFER_SIZE; i++) {
+        uint8_t expected = (i >= offset && i < offset + len) ? value : guard;
+        errors += (ptr[i] != expected);
+    }
+    return errors;
+}
+
+int main() {
+    if (!snrt_is_dm_core()) return 0;
+    uint32_t errors = 0;
+
+    uint8_t *buffer = (uint8_t *)snrt_l1_next();
+
+    // Sizes below, at and above the seed/block thresholds, with odd tails and
+    // unaligned starts.
+    const uint32_t offsets[] = {0, 1, 3, 64};
+    const uint32_t lens[] = {0, 5, 127, 128, 200, 1024, 1500, 3000};
+
+    for (uint32_t o = 0; o < sizeof(offsets) / sizeof(offsets[0]); o++) {
+        for (uint32_t l = 0; l < sizeof(lens) / sizeof(lens[0]); l++) {
+            snrt_memset_words(buffer, 0xAA, BUFFER_SIZE);
+            snrt_dma_memset(buffer + offsets[o], 0x5C, lens[l]);
+            errors += check(buffer, offsets[o], lens[l], 0x5C, 0xAA);
+        }
+    }
+
+    // Asynchronous zero-fill
+    snrt_memset_words(buffer, 0xAA, BUFFER_SIZE);
+    snrt_dma_zero_async(buffer + 7, 2049);
+    snrt_dma_wait_all();
+    errors += check(buffer, 7, 2049, 0, 0xAA);
+
+    // Generic memset routed through the DMA
+    snrt_memset_words(buffer, 0xAA, BUFFER_SIZE);
+    snrt_memset(buffer + 2, 0x11, 777);
+    errors += check(buffer, 2, 777, 0x11, 0xAA);
+
+    return errors;
+}
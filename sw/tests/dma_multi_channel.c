@@ -0,0 +1,54 @@
+// Copyright 2023 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <snrt.h>
+
+// Buffers in main memory for the write-back stream.
+uint32_t buffer_out[32];
+
+int main() {
+    if (!snrt_is_dm_core()) return 0;
+    uint32_t errors = 0;
+
+    // Populate buffers.
+    uint32_t buffer_in[32], buffer_src[32], buffer_dst[32];
+    for (uint32_t i = 0; i < 32; i++) {
+        buffer_src[i] = i + 1;
+        buffer_in[i] = 0x55555555;
+        buffer_out[i] = 0xAAAAAAAA;
+        buffer_dst[i] = 0x55555555;
+    }
+
+    // Issue a write-back and a fetch on two (possibly aliasing) channels
+    // assigned by the round-robin policy, then wait on each independently.
+    uint32_t ch_out = snrt_dma_next_channel();
+    uint32_t ch_in = snrt_dma_next_channel();
+    snrt_dma_txid_t tx_out = snrt_dma_start_1d_channel(
+        buffer_out, buffer_src, sizeof(buffer_out), ch_out);
+    snrt_dma_txid_t tx_in = snrt_dma_start_2d_channel(
+        buffer_in, buffer_src, sizeof(uint32_t) * 4, sizeof(uint32_t) * 4,
+        sizeof(uint32_t) * 4, 8, ch_in);
+    snrt_dma_wait_channel(tx_out, ch_out);
+    snrt_dma_wait_channel(tx_in, ch_in);
+
+    for (uint32_t i = 0; i < 32; i++) {
+        errors += (buffer_out[i] != buffer_src[i]);
+        errors += (buffer_in[i] != buffer_src[i]);
+    }
+
+    // Copy back from main memory on a user-assigned channel.
+    uint32_t ch = SNRT_DMA_NUM_CHANNELS - 1;
+    snrt_dma_start_1d_channel(buffer_dst, buffer_out, sizeof(buffer_out), ch);
+    snrt_dma_wait_all_channel(ch);
+    snrt_dma_wait_all_channels();
+
+    for (uint32_t i = 0; i < 32; i++) {
+        errors += (buffer_dst[i] != buffer_src[i]);
+    }
+
+    // The round-robin policy wraps around the instantiated channels.
+    errors += (snrt_dma_channel(SNRT_DMA_NUM_CHANNELS) != 0);
+
+    return errors;
+}
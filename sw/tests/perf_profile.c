@@ -0,0 +1,38 @@
+// Copyright 2023 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "snrt.h"
+
+int main() {
+    uint32_t errors = 0;
+
+    if (snrt_cluster_core_idx() != 0) return 0;
+
+    // More events than counters, to exercise multiplexing
+    snrt_profile_init(SNRT_PROFILE_EVENTS_ALL);
+
+    volatile uint32_t *ptr = (uint32_t *)snrt_l1_next();
+    for (uint32_t run = 0; run < 4; run++) {
+        SNRT_PROFILE_BEGIN("nops");
+        for (int i = 0; i < 100; i++) asm volatile("nop");
+        SNRT_PROFILE_END();
+
+        SNRT_PROFILE_BEGIN("tcdm");
+        for (uint32_t i = 0; i < 100; i++) ptr[i] = i;
+        SNRT_PROFILE_END();
+    }
+
+    snrt_profile_dump();
+
+    snrt_profile_record_t *records =
+        &snrt_profile_records[snrt_cluster_idx() * SNRT_PROFILE_MAX_REGIONS];
+    errors += (records[0].name[0] != 'n') + (records[1].name[0] != 't');
+    errors += (records[0].runs != 4) + (records[1].runs != 4);
+    errors += (records[0].cycles < 4 * 100);
+    // Each event group was measured in two of the four runs
+    errors += (records[1].counts[SNRT_PERF_CNT_TCDM_ACCESSED] < 2 * 100);
+    errors += (records[2].runs != 0);
+
+    return errors;
+}
@@ -0,0 +1,28 @@
+// Copyright 2023 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <snrt.h>
+
+// Large enough for the DMA to take the doubling and tail paths
+uint32_t bss[1000];
+
+__thread uint32_t tdata[4] = {1, 2, 3, 4};
+__thread uint32_t tbss[16];
+
+int main() {
+    uint32_t errors = 0;
+
+    if (snrt_cluster_core_idx() == 0) {
+        for (uint32_t i = 0; i < 1000; i++) errors += (bss[i] != 0);
+    }
+
+    for (uint32_t i = 0; i < 4; i++) errors += (tdata[i] != i + 1);
+    for (uint32_t i = 0; i < 16; i++) errors += (tbss[i] != 0);
+
+    errors += (snrt_startup_cycles() == 0);
+    if (snrt_global_core_idx() == 0)
+        printf("startup: %u cycles\n", snrt_startup_cycles());
+
+    return errors;
+}
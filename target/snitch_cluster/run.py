@@ -29,7 +29,8 @@ def main():
                            n_procs=args.n_procs,
                            run_dir=Path(args.run_dir),
                            dry_run=args.dry_run,
-                           early_exit=args.early_exit)
+                           early_exit=args.early_exit,
+                           bench_report=args.bench_report)
 
 
 if __name__ == '__main__':
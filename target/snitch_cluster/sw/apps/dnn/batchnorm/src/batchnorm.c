@@ -17,7 +17,7 @@ int main() {
     batchnorm_l.beta = (double *)batchnorm_beta_dram;
     batchnorm_l.TILE_CI = 32;
 
-    batchnorm_layer(&batchnorm_l);
+    batchnorm_conv_layer(&batchnorm_l);
 
     snrt_global_barrier();
 
@@ -0,0 +1,157 @@
+// Copyright 2023 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+// Check batchnorm_layer() in training and inference mode, in FP32 and FP16,
+// against a direct computation on device. The inputs have a large mean
+// compared to their spread. The shapes cover odd numbers of rows per core,
+// rows which do not fill whole SSR words and a layer which must be tiled.
+// Training mode must also update the running statistics.
+
+#include "dnn.h"
+#include "snrt.h"
+
+typedef struct {
+    uint32_t rows, channels;
+} batchnorm_case_t;
+
+static const batchnorm_case_t cases[] = {
+    {64, 16}, {45, 24}, {7, 4}, {37, 5}, {400, 64},
+};
+
+#define N_CASES (sizeof(cases) / sizeof(cases[0]))
+#define MAX_ROWS 400
+#define MAX_CHANNELS 64
+
+static const precision_t precs[] = {FP32, FP16};
+static const double tolerance[] = {1e-4, 1e-2};
+#define N_PRECS (sizeof(precs) / sizeof(precs[0]))
+
+#define TEST_MOMENTUM 0.125f
+#define TEST_EPS 1e-5f
+#define INIT_MEAN 0.5f
+#define INIT_VAR 2.0f
+
+// Layer data in main memory, large enough for FP32
+static float layer_ifmap[MAX_ROWS * MAX_CHANNELS];
+static float layer_ofmap[MAX_ROWS * MAX_CHANNELS];
+static float layer_gamma[MAX_CHANNELS];
+static float layer_beta[MAX_CHANNELS];
+static float layer_running_mean[MAX_CHANNELS];
+static float layer_running_var[MAX_CHANNELS];
+
+// Deterministic operands in offset + [-scale, scale], exactly representable
+// in FP16 for the offsets and scales used here
+static inline void fill(precision_t prec, void *p, uint32_t len,
+                        uint32_t seed, double offset, double scale) {
+    for (uint32_t i = 0; i < len; i++) {
+        seed = seed * 1664525 + 1013904223;
+        double v = offset + scale * ((int32_t)(seed >> 27) - 16) / 16;
+        blas_store(prec, p, i, v);
+    }
+}
+
+// Reciprocal square root refined to double precision
+static inline double ref_rsqrt(double x) {
+    double r = fast_rsqrtf(x);
+    for (uint32_t i = 0; i < 2; i++) r = r * (1.5 - 0.5 * x * r * r);
+    return r;
+}
+
+static inline uint32_t mismatch(double res, double ref, double tol) {
+    double err = res - ref;
+    return (err < 0 ? -err : err) > tol * (1 + (ref < 0 ? -ref : ref));
+}
+
+// Check the outputs and running statistics against a direct computation
+static uint32_t check(const batchnorm_layer_t *l, double tol) {
+    const precision_t prec = l->dtype;
+    uint32_t errors = 0;
+
+    for (uint32_t c = 0; c < l->CHANNELS; c++) {
+        double mean = INIT_MEAN, var = INIT_VAR;
+
+        if (l->TRAIN) {
+            double sum = 0, sumsq = 0;
+            for (uint32_t r = 0; r < l->ROWS; r++)
+                sum += blas_load(prec, l->ifmap, r * l->CHANNELS + c);
+            mean = sum / l->ROWS;
+            for (uint32_t r = 0; r < l->ROWS; r++) {
+                double d =
+                    blas_load(prec, l->ifmap, r * l->CHANNELS + c) - mean;
+                sumsq += d * d;
+            }
+            var = sumsq / l->ROWS;
+
+            double m = l->MOMENTUM;
+            double unbiased = var * l->ROWS / (l->ROWS - 1);
+            errors += mismatch(l->running_mean[c],
+                               (1 - m) * INIT_MEAN + m * mean, 1e-5);
+            errors += mismatch(l->running_var[c],
+                               (1 - m) * INIT_VAR + m * unbiased, 1e-3);
+        }
+
+        double scale = blas_load(prec, l->gamma, c) * ref_rsqrt(var + l->EPS);
+        for (uint32_t r = 0; r < l->ROWS; r++) {
+            uint32_t i = r * l->CHANNELS + c;
+            double ref = (blas_load(prec, l->ifmap, i) - mean) * scale +
+                         blas_load(prec, l->beta, c);
+            errors += mismatch(blas_load(prec, l->ofmap, i), ref, tol);
+        }
+    }
+    return errors;
+}
+
+int main() {
+    uint32_t errors = 0;
+
+    for (uint32_t p = 0; p < N_PRECS; p++) {
+        const precision_t prec = precs[p];
+
+        for (uint32_t i = 0; i < N_CASES; i++) {
+            for (uint32_t train = 0; train < 2; train++) {
+                const batchnorm_case_t *t = &cases[i];
+                batchnorm_layer_t l = {.ROWS = t->rows,
+                                       .CHANNELS = t->channels,
+                                       .TRAIN = train,
+                                       .EPS = TEST_EPS,
+                                       .MOMENTUM = TEST_MOMENTUM,
+                                       .ifmap = layer_ifmap,
+                                       .ofmap = layer_ofmap,
+                                       .gamma = layer_gamma,
+                                       .beta = layer_beta,
+                                       .running_mean = layer_running_mean,
+                                       .running_var = layer_running_var,
+                                       .dtype = prec};
+
+                if (snrt_global_core_idx() == 0) {
+                    fill(prec, layer_ifmap, t->rows * t->channels, i + 1, 3, 1);
+                    fill(prec, layer_gamma, t->channels, i + 2, 1, 0.5);
+                    fill(prec, layer_beta, t->channels, i + 3, 0, 0.5);
+                    for (uint32_t c = 0; c < t->channels; c++) {
+                        layer_running_mean[c] = INIT_MEAN;
+                        layer_running_var[c] = INIT_VAR;
+                    }
+                }
+
+                snrt_global_barrier();
+
+                uint32_t start_cycle = snrt_mcycle();
+                int ret = batchnorm_layer(&l);
+                uint32_t end_cycle = snrt_mcycle();
+
+                if (snrt_global_core_idx() == 0) {
+                    uint32_t e = ret ? 1 : check(&l, tolerance[p]);
+                    printf("FP%u %s %ux%u: %u errors, %u cycles\n", 8 * prec,
+                           train ? "train" : "inference", t->rows,
+                           t->channels, e, end_cycle - start_cycle);
+                    errors += e;
+                }
+
+                snrt_global_barrier();
+            }
+        }
+    }
+
+    return errors;
+}
@@ -11,40 +11,38 @@
 #include "data.h"
 
 int main() {
-    conv2d_l.ifmap = (double*)conv2d_ifmap_dram;
-    conv2d_l.weights = (double*)conv2d_weights_dram;
-    conv2d_l.ofmap = (double*)conv2d_ofmap_dram;
-    conv2d_l.TILE_CI = min(32, conv2d_l.CI);
-    conv2d_l.pad = (conv2d_l.FH - 1) / 2;
-    conv2d_l.cluster2cluster = 0;
+    conv2d_l.ifmap = (double *)conv2d_ifmap_dram;
+    conv2d_l.weights = (double *)conv2d_weights_dram;
+    conv2d_l.ofmap = (double *)conv2d_result;
 
-    const conv_layer l1_conv2d_l = conv2d_l;
+    int ret = conv2d_layer(&conv2d_l);
 
-    uint32_t cycles, dma_busy;
-
-    if (snrt_global_core_idx() == 0) {
-        snrt_reset_perf_counter(SNRT_PERF_CNT0);
-        snrt_reset_perf_counter(SNRT_PERF_CNT1);
-        snrt_start_perf_counter(SNRT_PERF_CNT0, SNRT_PERF_CNT_CYCLES, 0);
-        snrt_start_perf_counter(SNRT_PERF_CNT1, SNRT_PERF_CNT_DMA_BUSY, 0);
-    }
+    snrt_global_barrier();
 
-    conv2d_layer(&l1_conv2d_l);
+    uint32_t errors = ret ? 1 : 0;
 
+    // Compare every output element, the checksums over the output channels
+    // would hide compensating errors
     if (snrt_global_core_idx() == 0) {
-        snrt_stop_perf_counter(SNRT_PERF_CNT0);
-        snrt_stop_perf_counter(SNRT_PERF_CNT1);
-
-        cycles = snrt_get_perf_counter(SNRT_PERF_CNT0);
-        dma_busy = snrt_get_perf_counter(SNRT_PERF_CNT1);
-        // printf("perf: %d/%d dma/total\n", dma_busy, cycles);
+        const conv_layer *l = &conv2d_l;
+        uint32_t len = l->OH * l->OW * l->CO;
+        double tol = l->dtype == FP16 ? 1e-2 : l->dtype == FP32 ? 1e-4 : 1e-9;
+
+        for (uint32_t i = 0; i < len; i++) {
+            double res, ref;
+            if (l->dtype == FP16) {
+                res = ((__fp16 *)l->ofmap)[i];
+                ref = ((__fp16 *)conv2d_ofmap_dram)[i];
+            } else if (l->dtype == FP32) {
+                res = ((float *)l->ofmap)[i];
+                ref = ((float *)conv2d_ofmap_dram)[i];
+            } else {
+                res = ((double *)l->ofmap)[i];
+                ref = ((double *)conv2d_ofmap_dram)[i];
+            }
+            if (fabs(res - ref) > tol * (1 + fabs(ref))) errors++;
+        }
     }
 
-    snrt_global_barrier();
-
-    uint32_t errors = check_layer(&conv2d_l, (double*)conv2d_checksum);
-
-    snrt_global_barrier();
-
     return errors;
 }
@@ -0,0 +1,59 @@
+// Copyright 2023 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+// SW testbench for a Conv2d -> BatchNorm -> ReLU -> MaxPool block computed
+// on tiles resident in TCDM
+// Correctness of results are checked automatically
+
+#include "dnn.h"
+#include "snrt.h"
+
+#include "data.h"
+
+int main() {
+    conv2d_fused_l.conv.ifmap = (double *)conv2d_fused_ifmap_dram;
+    conv2d_fused_l.conv.weights = (double *)conv2d_fused_weights_dram;
+    conv2d_fused_l.conv.ofmap = (double *)conv2d_fused_result;
+    conv2d_fused_l.kappa = (void *)conv2d_fused_kappa;
+    conv2d_fused_l.lambda = (void *)conv2d_fused_lambda;
+
+    // Fold the BatchNorm statistics once at layer setup
+    if (snrt_global_core_idx() == 0) {
+        conv2d_fused_fold_bn(&conv2d_fused_l, conv2d_fused_gamma,
+                             conv2d_fused_beta, conv2d_fused_mean,
+                             conv2d_fused_var, conv2d_fused_eps);
+    }
+
+    snrt_global_barrier();
+
+    int ret = conv2d_fused_layer(&conv2d_fused_l);
+
+    snrt_global_barrier();
+
+    uint32_t errors = ret ? 1 : 0;
+
+    if (snrt_global_core_idx() == 0) {
+        const conv_layer *l = &conv2d_fused_l.conv;
+        uint32_t len = (l->OH / conv2d_fused_l.PH) *
+                       (l->OW / conv2d_fused_l.PW) * l->CO;
+        double tol = l->dtype == FP16 ? 1e-2 : l->dtype == FP32 ? 1e-4 : 1e-9;
+
+        for (uint32_t i = 0; i < len; i++) {
+            double res, ref;
+            if (l->dtype == FP16) {
+                res = ((__fp16 *)l->ofmap)[i];
+                ref = ((__fp16 *)conv2d_fused_ofmap_dram)[i];
+            } else if (l->dtype == FP32) {
+                res = ((float *)l->ofmap)[i];
+                ref = ((float *)conv2d_fused_ofmap_dram)[i];
+            } else {
+                res = ((double *)l->ofmap)[i];
+                ref = ((double *)conv2d_fused_ofmap_dram)[i];
+            }
+            if (fabs(res - ref) > tol * (1 + fabs(ref))) errors++;
+        }
+    }
+
+    return errors;
+}
@@ -47,6 +47,8 @@ def emit_header_file(file, layer_type: str, **kwargs):
 
     if layer_type == 'Conv2d':
         emit_str += emit_conv2d_layer(**kwargs)
+    elif layer_type == 'Conv2dFused':
+        emit_str += emit_conv2d_fused_layer(**kwargs)
     elif layer_type == 'GEMM':
         emit_str += emit_GEMM_layer(**kwargs)
     elif layer_type == 'BatchNorm':
@@ -63,6 +65,8 @@ def emit_header_file(file, layer_type: str, **kwargs):
         emit_str += emit_softmax_layer(**kwargs)
     elif layer_type == 'LayerNorm':
         emit_str += emit_layernorm_layer(**kwargs)
+    elif layer_type == 'Transformer':
+        emit_str += emit_transformer_layer(**kwargs)
 
     with file.open('w') as f:
         f.write(emit_str)
@@ -83,15 +87,23 @@ def emit_layernorm_layer(name='layernorm', **kwargs):
 
     dtype = ctypes[str(kwargs['prec'])]
     checksum = torch.sum(ifmap, dim=-1)
+    gamma = kwargs['gamma']
+    beta = kwargs['beta']
 
     layer_str = ''
     layer_str += f'layernorm_layer_t {name}_l = {{\n'
     layer_str += f'\t.BATCH_SIZE = {batch_size},\n'  # batch_size
     layer_str += f'\t.SEQ_LEN = {seq_len},\n'        # seq_len
     layer_str += f'\t.EMBEDDINGS = {embeddings},\n'  # embeddings
+    layer_str += f'\t.EPS = {kwargs["eps"]},\n'      # eps
     layer_str += f'\t.dtype = FP{kwargs["prec"]},\n'
     layer_str += '};\n\n\n'
 
+    layer_str += f'static {dtype} {name}_gamma_dram[{embeddings}] = ' \
+        + array_to_cstr(gamma) + ';\n\n'
+    layer_str += f'static {dtype} {name}_beta_dram[{embeddings}] = ' \
+        + array_to_cstr(beta) + ';\n\n'
+
     layer_str += f'static {dtype} {name}_result[{batch_size}][{seq_len}]'
     layer_str += f'[{embeddings}] __attribute__((section(".data")));\n\n'
     layer_str += f'static {dtype} {name}_ifmap_dram[{batch_size}][{seq_len}][{embeddings}] = ' \
@@ -171,6 +183,7 @@ def emit_gelu_layer(name='gelu', **kwargs):
     layer_str += f'\t.BATCH_SIZE = {batch_size},\n'  # batch_size
     layer_str += f'\t.SEQ_LEN = {seq_len},\n'        # seq_len
     layer_str += f'\t.HIDDEN_NODES = {hidden_nodes},\n'  # hidden_size
+    layer_str += f'\t.IMPL = GELU_{kwargs["impl"].upper()},\n'
     layer_str += f'\t.dtype = FP{kwargs["prec"]},\n'
     layer_str += '};\n\n\n'
 
@@ -209,7 +222,8 @@ def emit_linear_layer(name='linear', **kwargs):
     layer_str += f'\t.CO = {co},\n'  # out_features
     layer_str += f'\t.CI = {ci},\n'  # in_features
     layer_str += f'\t.CH = {ch},\n'  # height
-    layer_str += f'\t.CW = {ci}\n'   # width
+    layer_str += f'\t.CW = {ci},\n'  # width
+    layer_str += f'\t.dtype = FP{kwargs["prec"]}\n'
     layer_str += '};\n\n\n'
 
     layer_str += f'static {dtype} {name}_result[{co*ch}] __attribute__((section(".data")));\n\n'
@@ -226,6 +240,54 @@ def emit_linear_layer(name='linear', **kwargs):
     return layer_str
 
 
+def emit_transformer_layer(name='transformer', **kwargs):
+    ifmap = kwargs['ifmap']
+    ofmap = kwargs['ofmap']
+    params = kwargs['params']
+
+    seq_len, embeddings = ifmap.shape
+    ff = params['w1'].shape[0]
+
+    ctypes = {
+        '64': 'double',
+        '32': 'float',
+        '16': '__fp16',
+        '8': 'char'
+    }
+
+    dtype = ctypes[str(kwargs['prec'])]
+
+    layer_str = ''
+    layer_str += f'transformer_layer_t {name}_l = {{\n'
+    layer_str += f'\t.SEQ_LEN = {seq_len},\n'
+    layer_str += f'\t.EMBEDDINGS = {embeddings},\n'
+    layer_str += f'\t.HEADS = {kwargs["heads"]},\n'
+    layer_str += f'\t.FF = {ff},\n'
+    layer_str += f'\t.EPS = {kwargs["eps"]},\n'
+    layer_str += f'\t.GELU_IMPL = GELU_{kwargs["impl"].upper()},\n'
+    layer_str += f'\t.dtype = FP{kwargs["prec"]}\n'
+    layer_str += '};\n\n\n'
+
+    for key, value in params.items():
+        dims = ''.join(f'[{d}]' for d in value.shape)
+        layer_str += f'static {dtype} {name}_{key}_dram{dims} = ' \
+            + array_to_cstr(value) + ';\n\n'
+
+    # Keys and transposed values are exchanged between clusters in main memory
+    layer_str += f'static {dtype} {name}_k[{seq_len}][{embeddings}]'
+    layer_str += ' __attribute__((section(".data")));\n\n'
+    layer_str += f'static {dtype} {name}_vt[{embeddings}][{seq_len}]'
+    layer_str += ' __attribute__((section(".data")));\n\n'
+    layer_str += f'static {dtype} {name}_result[{seq_len}][{embeddings}]'
+    layer_str += ' __attribute__((section(".data")));\n\n'
+    layer_str += f'static {dtype} {name}_ifmap_dram[{seq_len}][{embeddings}] = ' \
+        + array_to_cstr(ifmap) + ';\n\n'
+    layer_str += f'static {dtype} {name}_ofmap_dram[{seq_len}][{embeddings}] = ' \
+        + array_to_cstr(ofmap) + ';\n\n'
+
+    return layer_str
+
+
 def emit_conv2d_layer(name='conv2d', **kwargs):
     ifmap = kwargs['ifmap']
     ofmap = kwargs['ofmap']
@@ -235,6 +297,15 @@ def emit_conv2d_layer(name='conv2d', **kwargs):
     _, oh, ow, co = ofmap.shape
     _, fh, fw, _ = weights.shape
 
+    ctypes = {
+        '64': 'double',
+        '32': 'float',
+        '16': '__fp16',
+        '8': 'char'
+    }
+
+    dtype = ctypes[str(kwargs['prec'])]
+
     layer_str = ''
     layer_str += f'conv_layer {name}_l = {{\n'
     layer_str += f'\t.CO = {co},\n'
@@ -244,23 +315,86 @@ def emit_conv2d_layer(name='conv2d', **kwargs):
     layer_str += f'\t.OH = {oh},\n'
     layer_str += f'\t.OW = {ow},\n'
     layer_str += f'\t.FH = {fh},\n'
-    layer_str += f'\t.FW = {fw}\n'
+    layer_str += f'\t.FW = {fw},\n'
+    layer_str += f'\t.pad = {kwargs["padding"]},\n'
+    layer_str += f'\t.stride = {kwargs["stride"]},\n'
+    layer_str += f'\t.dilation = {kwargs["dilation"]},\n'
+    layer_str += f'\t.groups = {kwargs["groups"]},\n'
+    layer_str += f'\t.dtype = FP{kwargs["prec"]}\n'
     layer_str += '};\n\n\n'
 
-    layer_str += f'static double {name}_result' + \
+    layer_str += f'static {dtype} {name}_result' + \
                  f'[{oh}][{ow}][{co}] __attribute__((section(".data")));\n\n'
     layer_str += f'static double {name}_checksum' + \
-                 f'[{oh}][{ow}] = ' + array_to_cstr(torch.sum(ofmap, dim=-1)) + ';\n\n\n'
-    layer_str += f'static double {name}_ifmap_dram' + \
+                 f'[{oh}][{ow}] = ' + array_to_cstr(torch.sum(ofmap.double(), dim=-1)) + ';\n\n\n'
+    layer_str += f'static {dtype} {name}_ifmap_dram' + \
                  f'[{ih}][{iw}][{ci}] = ' + array_to_cstr(ifmap) + ';\n\n\n'
-    layer_str += f'static double {name}_weights_dram' + \
-                 f'[{co}][{ci}][{fh}][{fw}] = ' + array_to_cstr(weights) + ';\n\n\n'
-    layer_str += f'static double {name}_ofmap_dram' + \
+    layer_str += f'static {dtype} {name}_weights_dram' + \
+                 f'[{co}][{fh}][{fw}][{weights.shape[-1]}] = ' + \
+                 array_to_cstr(weights) + ';\n\n\n'
+    layer_str += f'static {dtype} {name}_ofmap_dram' + \
                  f'[{oh}][{ow}][{co}] = ' + array_to_cstr(ofmap) + ';\n\n\n'
 
     return layer_str
 
 
+def emit_conv2d_fused_layer(name='conv2d_fused', **kwargs):
+    ifmap = kwargs['ifmap']
+    ofmap = kwargs['ofmap']
+    weights = kwargs['weights']
+
+    n, ih, iw, ci = ifmap.shape
+    _, pooled_h, pooled_w, co = ofmap.shape
+    _, fh, fw, _ = weights.shape
+    oh, ow = ih - fh + 1 + 2 * kwargs['padding'], iw - fw + 1 + 2 * kwargs['padding']
+
+    ctypes = {
+        '64': 'double',
+        '32': 'float',
+        '16': '__fp16',
+        '8': 'char'
+    }
+
+    dtype = ctypes[str(kwargs['prec'])]
+
+    layer_str = ''
+    layer_str += f'conv2d_fused_layer_t {name}_l = {{\n'
+    layer_str += '\t.conv = {\n'
+    layer_str += f'\t\t.CO = {co},\n'
+    layer_str += f'\t\t.CI = {ci},\n'
+    layer_str += f'\t\t.IH = {ih},\n'
+    layer_str += f'\t\t.IW = {iw},\n'
+    layer_str += f'\t\t.OH = {oh},\n'
+    layer_str += f'\t\t.OW = {ow},\n'
+    layer_str += f'\t\t.FH = {fh},\n'
+    layer_str += f'\t\t.FW = {fw},\n'
+    layer_str += f'\t\t.pad = {kwargs["padding"]},\n'
+    layer_str += f'\t\t.dtype = FP{kwargs["prec"]}\n'
+    layer_str += '\t},\n'
+    layer_str += f'\t.flag_batch_norm = {int(kwargs["batchnorm"])},\n'
+    layer_str += f'\t.flag_relu = {int(kwargs["relu"])},\n'
+    layer_str += f'\t.PH = {kwargs["pool"]},\n'
+    layer_str += f'\t.PW = {kwargs["pool"]}\n'
+    layer_str += '};\n\n\n'
+
+    layer_str += f'static const double {name}_eps = {kwargs["eps"]};\n\n'
+    for param in ['gamma', 'beta', 'mean', 'var']:
+        layer_str += f'static double {name}_{param}[{co}] = ' + \
+                     array_to_cstr(kwargs[param]) + ';\n\n'
+    layer_str += f'static {dtype} {name}_kappa[{co}] __attribute__((section(".data")));\n\n'
+    layer_str += f'static {dtype} {name}_lambda[{co}] __attribute__((section(".data")));\n\n'
+    layer_str += f'static {dtype} {name}_result' + \
+                 f'[{pooled_h}][{pooled_w}][{co}] __attribute__((section(".data")));\n\n'
+    layer_str += f'static {dtype} {name}_ifmap_dram' + \
+                 f'[{ih}][{iw}][{ci}] = ' + array_to_cstr(ifmap) + ';\n\n\n'
+    layer_str += f'static {dtype} {name}_weights_dram' + \
+                 f'[{co}][{fh}][{fw}][{ci}] = ' + array_to_cstr(weights) + ';\n\n\n'
+    layer_str += f'static {dtype} {name}_ofmap_dram' + \
+                 f'[{pooled_h}][{pooled_w}][{co}] = ' + array_to_cstr(ofmap) + ';\n\n\n'
+
+    return layer_str
+
+
 def emit_GEMM_layer(name='gemm', **kwargs):
     mat_A = kwargs['A']
     mat_B = kwargs['B']
@@ -487,11 +621,12 @@ def rand_data_generator(shape, prec, alt=False):
         return val, bits
 
 
-def conv2d(ifmap, weights, padding=1, stride=1):
+def conv2d(ifmap, weights, padding=1, stride=1, dilation=1, groups=1):
     n, ci, ih, iw = ifmap.shape
     co, _, fh, fw = weights.shape
 
-    conv2d = nn.Conv2d(ci, co, (fh, fw), padding=((fh-1)//2, (fw-1)//2))
+    conv2d = nn.Conv2d(ci, co, (fh, fw), padding=padding, stride=stride,
+                       dilation=dilation, groups=groups)
     conv2d.weight = nn.Parameter(weights, requires_grad=False)
     conv2d.bias = nn.Parameter(
         torch.zeros_like(conv2d.bias, dtype=weights.dtype),
@@ -501,6 +636,17 @@ def conv2d(ifmap, weights, padding=1, stride=1):
     return ofmap
 
 
+def conv2d_fused(ifmap, weights, kappa, lambd, padding, relu, pool):
+    ofmap = conv2d(ifmap, weights, padding=padding)
+    ofmap = ofmap * kappa[None, :, None, None] + lambd[None, :, None, None]
+    if relu:
+        ofmap = torch.relu(ofmap)
+    if pool > 1:
+        ofmap = max_pooling(ofmap, pool)
+
+    return ofmap
+
+
 def max_pooling(ifmap, kernel):
     n, ci, ih, iw = ifmap.shape
     max_pool = nn.MaxPool2d(kernel_size=kernel)
@@ -590,21 +736,25 @@ def fused_conv(ifmap, weights, bn_k, bn_l, padding, stride, bn, relu, accumulate
 def linear(ifmap, weights, bias):
 
     ifmap = ifmap.flatten(1)
-    ofmap = torch.matmul(ifmap, weights.T) + bias
+    # Compute in FP32, as not all backends support FP16 matmul
+    ofmap = torch.matmul(ifmap.float(), weights.float().T) + bias.float()
+    ofmap = ofmap.to(ifmap.dtype)
 
     return ofmap
 
 
 def gelu(ifmap):
     gelu = torch.nn.GELU()
-    ofmap = gelu(ifmap)
+    # Compute in FP32, as not all backends support FP16 GELU
+    ofmap = gelu(ifmap.float()).to(ifmap.dtype)
 
     return ofmap
 
 
 def softmax(ifmap, axis):
     softmax = torch.nn.Softmax(dim=axis)
-    ofmap = softmax(ifmap)
+    # Compute in FP32, as not all backends support FP16 softmax
+    ofmap = softmax(ifmap.float()).to(ifmap.dtype)
 
     # print the global max of the input
     # print("max of input: ", torch.max(ifmap))
@@ -612,13 +762,45 @@ def softmax(ifmap, axis):
     return ofmap
 
 
-def layernorm(ifmap, eps, shape):
+def layernorm(ifmap, gamma, beta, eps, shape):
     ln = torch.nn.LayerNorm(shape, eps=eps)
-    ofmap = ln(ifmap)
+    with torch.no_grad():
+        ln.weight.copy_(gamma)
+        ln.bias.copy_(beta)
+    # Compute in FP32, as not all backends support FP16 layernorm
+    ofmap = ln(ifmap.float()).to(ifmap.dtype)
 
     return ofmap
 
 
+def transformer(ifmap, params, heads, eps):
+    # Compute in FP32, as not all backends support FP16 on all operators
+    x = ifmap.float()
+    p = {key: value.float() for key, value in params.items()}
+    seq_len, embeddings = x.shape
+    head_dim = embeddings // heads
+
+    def proj(t, w, b):
+        return torch.matmul(t, p[w].T) + p[b]
+
+    def heads_first(t):
+        return t.reshape(seq_len, heads, head_dim).transpose(0, 1)
+
+    q = heads_first(proj(x, 'wq', 'bq'))
+    k = heads_first(proj(x, 'wk', 'bk'))
+    v = heads_first(proj(x, 'wv', 'bv'))
+    scores = torch.matmul(q, k.transpose(1, 2)) / head_dim**0.5
+    ctx = torch.matmul(torch.softmax(scores, dim=-1), v)
+    ctx = ctx.transpose(0, 1).reshape(seq_len, embeddings)
+
+    ln = nn.functional.layer_norm
+    x1 = ln(x + proj(ctx, 'wo', 'bo'), (embeddings,), p['gamma1'], p['beta1'], eps)
+    hidden = nn.functional.gelu(proj(x1, 'w1', 'b1'), approximate='tanh')
+    y = ln(x1 + proj(hidden, 'w2', 'b2'), (embeddings,), p['gamma2'], p['beta2'], eps)
+
+    return y.to(ifmap.dtype)
+
+
 def main():
 
     parser = argparse.ArgumentParser(description='Generate data for kernels')
@@ -661,25 +843,80 @@ def main():
         dtype = torch.float32
 
     if param['kernel'] == 'Conv2d':
+        groups = param['filter'].get('groups', 1)
+        dilation = param['filter'].get('dilation', 1)
         ifmap = torch.randn(1, param['channels']['in'],
                             param['input_dim']['height'],
                             param['input_dim']['width'], requires_grad=False, dtype=dtype)
         weights = torch.randn(param['channels']['out'],
-                              param['channels']['in'],
+                              param['channels']['in'] // groups,
                               param['filter']['height'],
                               param['filter']['width'], requires_grad=False, dtype=dtype)
 
-        ofmap = conv2d(ifmap, weights,
+        # Reduced precisions are computed in float and rounded afterwards
+        ofmap = conv2d(ifmap.float() if param['prec'] != 64 else ifmap,
+                       weights.float() if param['prec'] != 64 else weights,
                        padding=param['filter']['padding'],
-                       stride=param['filter']['stride'])
+                       stride=param['filter']['stride'],
+                       dilation=dilation, groups=groups).to(dtype)
 
         # convert from CHW to HWC format
         ifmap = ifmap.permute(0, 2, 3, 1)
         ofmap = ofmap.permute(0, 2, 3, 1)
         weights = weights.permute(0, 2, 3, 1)
-        kwargs = {'ifmap': ifmap, 'weights': weights, 'ofmap': ofmap}
+        kwargs = {'ifmap': ifmap, 'weights': weights, 'ofmap': ofmap,
+                  'prec': param['prec'],
+                  'padding': param['filter']['padding'],
+                  'stride': param['filter']['stride'],
+                  'dilation': dilation, 'groups': groups}
         emit_header_file(args.output, 'Conv2d', **kwargs)
 
+    elif param['kernel'] == 'Conv2dFused':
+        ci, co = param['channels']['in'], param['channels']['out']
+        ifmap = torch.randn(1, ci, param['input_dim']['height'],
+                            param['input_dim']['width'], requires_grad=False, dtype=dtype)
+        weights = torch.randn(co, ci, param['filter']['height'],
+                              param['filter']['width'], requires_grad=False, dtype=dtype)
+
+        # BatchNorm statistics in inference mode
+        eps = param['eps']
+        gamma = torch.randn(co, dtype=torch.float64)
+        beta = torch.randn(co, dtype=torch.float64)
+        mean = torch.randn(co, dtype=torch.float64)
+        var = torch.rand(co, dtype=torch.float64) + 0.5
+        if param['batchnorm']:
+            kappa = gamma / torch.sqrt(var + eps)
+            lambd = beta - mean * kappa
+        else:
+            kappa = torch.ones(co, dtype=torch.float64)
+            lambd = torch.zeros(co, dtype=torch.float64)
+
+        # The folded parameters are rounded to the layer precision, reduced
+        # precisions are computed in float and rounded afterwards
+        ctype = torch.float64 if param['prec'] == 64 else torch.float32
+        ofmap = conv2d_fused(ifmap.to(ctype), weights.to(ctype),
+                             kappa.to(dtype).to(ctype), lambd.to(dtype).to(ctype),
+                             param['filter']['padding'], param['relu'],
+                             param['pool']).to(dtype)
+
+        # convert from CHW to HWC format
+        kwargs = {
+            'ifmap': ifmap.permute(0, 2, 3, 1),
+            'weights': weights.permute(0, 2, 3, 1),
+            'ofmap': ofmap.permute(0, 2, 3, 1),
+            'gamma': gamma,
+            'beta': beta,
+            'mean': mean,
+            'var': var,
+            'eps': eps,
+            'padding': param['filter']['padding'],
+            'batchnorm': param['batchnorm'],
+            'relu': param['relu'],
+            'pool': param['pool'],
+            'prec': param['prec'],
+        }
+        emit_header_file(args.output, 'Conv2dFused', **kwargs)
+
     elif param['kernel'] == 'GEMM':
         mat_A, bits_A = rand_data_generator((param['M'], param['K']), param['prec'])
         mat_B, bits_B = rand_data_generator((param['K'], param['N']), param['prec'])
@@ -815,6 +1052,7 @@ def main():
         kwargs = {
             'ifmap': ifmap,
             'ofmap': ofmap,
+            'impl': param.get('impl', 'tanh'),
             'prec': param['prec'],
         }
 
@@ -838,9 +1076,12 @@ def main():
         ifmap = torch.randn(param['input_dim']['batch_size'], param['input_dim']['seq_len'],
                             param['input_dim']['embeddings'], requires_grad=False, dtype=dtype)
 
+        gamma = torch.randn(param['input_dim']['embeddings'], requires_grad=False, dtype=dtype)
+        beta = torch.randn(param['input_dim']['embeddings'], requires_grad=False, dtype=dtype)
+
         eps = param['eps']
 
-        ofmap = layernorm(ifmap, eps, param['input_dim']['embeddings'])
+        ofmap = layernorm(ifmap, gamma, beta, eps, param['input_dim']['embeddings'])
 
         ofmap = ofmap.detach().numpy()
 
@@ -850,11 +1091,59 @@ def main():
         kwargs = {
             'ifmap': ifmap,
             'ofmap': ofmap,
+            'gamma': gamma,
+            'beta': beta,
+            'eps': eps,
             'prec': param['prec'],
         }
 
         emit_header_file(args.output, 'LayerNorm', **kwargs)
 
+    elif param['kernel'] == 'Transformer':
+        seq_len = param['input_dim']['seq_len']
+        embeddings = param['input_dim']['embeddings']
+        ff = param['ff']
+
+        ifmap = torch.randn(seq_len, embeddings, requires_grad=False, dtype=dtype)
+
+        # Weights are scaled by the square root of their fan-in to keep the
+        # activations in a reasonable range
+        def weight(rows, cols):
+            return (torch.randn(rows, cols) / cols**0.5).to(dtype)
+
+        params = {
+            'wq': weight(embeddings, embeddings),
+            'wk': weight(embeddings, embeddings),
+            'wv': weight(embeddings, embeddings),
+            'wo': weight(embeddings, embeddings),
+            'bq': torch.randn(embeddings, dtype=dtype),
+            'bk': torch.randn(embeddings, dtype=dtype),
+            'bv': torch.randn(embeddings, dtype=dtype),
+            'bo': torch.randn(embeddings, dtype=dtype),
+            'gamma1': torch.randn(embeddings, dtype=dtype),
+            'beta1': torch.randn(embeddings, dtype=dtype),
+            'w1': weight(ff, embeddings),
+            'b1': torch.randn(ff, dtype=dtype),
+            'w2': weight(embeddings, ff),
+            'b2': torch.randn(embeddings, dtype=dtype),
+            'gamma2': torch.randn(embeddings, dtype=dtype),
+            'beta2': torch.randn(embeddings, dtype=dtype),
+        }
+
+        ofmap = transformer(ifmap, params, param['heads'], param['eps'])
+
+        kwargs = {
+            'ifmap': ifmap,
+            'ofmap': ofmap,
+            'params': params,
+            'heads': param['heads'],
+            'eps': param['eps'],
+            'impl': param['impl'],
+            'prec': param['prec'],
+        }
+
+        emit_header_file(args.output, 'Transformer', **kwargs)
+
     else:
         print("No valid kernel selected")
 
@@ -2,10 +2,10 @@
 // Licensed under the Apache License, Version 2.0, see LICENSE for details.
 // SPDX-License-Identifier: Apache-2.0
 
-// SW testbench for profiling linear kernels in different
-// floating point precisions (fp64, fp32, fp16), as well as
-// different memory layouts for matrices (transposed/not-transposed)
-// Correctness of results are checked automatically
+// SW testbench for profiling the GELU layer in different
+// floating point precisions (fp32, fp16)
+// Correctness of results are checked automatically, for every GELU
+// implementation in turn
 
 #include "dnn.h"
 #include "snrt.h"
@@ -13,14 +13,38 @@
 #include "data.h"
 
 int main() {
-    gelu_l.ifmap = (float*)gelu_ifmap_dram;
-    // gelu_l.result = (float*)gelu_ofmap_dram;
-
-    // checksum = (float*)gelu_checksum;
-
-    gelu_layer(&gelu_l);
-
-    // uint32_t error = check_gelu_layer(&linear_l, (float*)linear_checksum);
-
-    return 0;
-}
\ No newline at end of file
+    uint32_t errors = 0;
+
+    for (uint32_t impl = GELU_TANH; impl <= GELU_POLY; impl++) {
+        gelu_layer_t l = gelu_l;
+        l.IMPL = impl;
+        l.ifmap = (void *)gelu_ifmap_dram;
+        l.ofmap = (void *)gelu_result;
+        l.result = (void *)gelu_ofmap_dram;
+
+        if (gelu_layer(&l)) return -1;
+
+        if (snrt_global_core_idx() == 0) {
+            uint32_t len = l.BATCH_SIZE * l.SEQ_LEN * l.HIDDEN_NODES;
+            float tol = impl == GELU_SIGMOID ? 3e-2 : 3e-3;
+            if (l.dtype == FP16) tol += 3e-2;
+
+            for (uint32_t i = 0; i < len; i++) {
+                float res, ref;
+                if (l.dtype == FP16) {
+                    res = ((__fp16 *)l.ofmap)[i];
+                    ref = ((__fp16 *)l.result)[i];
+                } else {
+                    res = ((float *)l.ofmap)[i];
+                    ref = ((float *)l.result)[i];
+                }
+                if (fabs(res - ref) > tol) errors++;
+            }
+        }
+
+        // The next implementation overwrites the results
+        snrt_global_barrier();
+    }
+
+    return errors;
+}
@@ -0,0 +1,80 @@
+// Copyright 2023 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+// Accuracy versus cycles of the GELU implementations in FP32 and FP16.
+// The reference is the double-precision tanh formulation. The number of
+// implementations whose maximum error exceeds its bound is returned.
+
+#include "dnn.h"
+#include "snrt.h"
+
+#define N_SAMPLES 1024
+#define X_MIN -6.0f
+#define X_MAX 6.0f
+
+static const char *impl_names[] = {"tanh", "sigmoid", "lut", "poly"};
+
+// Maximum absolute error of each implementation in FP32
+static const float max_err[] = {1e-3, 3e-2, 1e-3, 3e-3};
+
+// Additional error allowed for the FP16 rounding of inputs and outputs
+#define FP16_EXTRA_ERR 3e-2
+
+static inline float gelu_ref(float x) {
+    return 0.5 * x *
+           (1.0 + tanh(sqrt(2.0 / M_PI) * (x + 0.044715 * x * x * x)));
+}
+
+int main() {
+    if (snrt_global_core_idx() != 0) return 0;
+
+    uint32_t errors = 0;
+
+    float *x32 = snrt_l1_next();
+    float *y32 = x32 + N_SAMPLES;
+    float *ref = y32 + N_SAMPLES;
+    __fp16 *x16 = (__fp16 *)(ref + N_SAMPLES);
+    __fp16 *y16 = x16 + N_SAMPLES;
+
+    for (uint32_t i = 0; i < N_SAMPLES; i++) {
+        x32[i] = X_MIN + (X_MAX - X_MIN) * i / N_SAMPLES;
+        x16[i] = x32[i];
+    }
+
+    uint32_t start = snrt_mcycle();
+    for (uint32_t i = 0; i < N_SAMPLES; i++) ref[i] = gelu_ref(x32[i]);
+    uint32_t ref_cycles = snrt_mcycle() - start;
+    printf("reference: %u cycles\n", ref_cycles);
+
+    for (uint32_t impl = GELU_TANH; impl <= GELU_POLY; impl++) {
+        float err32 = 0.0;
+        float err16 = 0.0;
+
+        start = snrt_mcycle();
+        gelu_fp32(x32, y32, N_SAMPLES, 1, N_SAMPLES, impl);
+        uint32_t cycles32 = snrt_mcycle() - start;
+
+        start = snrt_mcycle();
+        gelu_fp16(x16, y16, N_SAMPLES, 1, N_SAMPLES, impl);
+        uint32_t cycles16 = snrt_mcycle() - start;
+
+        for (uint32_t i = 0; i < N_SAMPLES; i++) {
+            float e32 = fabs(y32[i] - ref[i]);
+            float e16 = fabs((float)y16[i] - ref[i]);
+            err32 = e32 > err32 ? e32 : err32;
+            err16 = e16 > err16 ? e16 : err16;
+        }
+
+        // The printf of the runtime has no float support
+        printf("%s: fp32 %u cycles, max err %ue-6; fp16 %u cycles, "
+               "max err %ue-6\n",
+               impl_names[impl], cycles32, (uint32_t)(err32 * 1e6f), cycles16,
+               (uint32_t)(err16 * 1e6f));
+
+        if (err32 > max_err[impl]) errors++;
+        if (err16 > max_err[impl] + FP16_EXTRA_ERR) errors++;
+    }
+
+    return errors;
+}
@@ -2,9 +2,8 @@
 // Licensed under the Apache License, Version 2.0, see LICENSE for details.
 // SPDX-License-Identifier: Apache-2.0
 
-// SW testbench for profiling linear kernels in different
-// floating point precisions (fp64, fp32, fp16), as well as
-// different memory layouts for matrices (transposed/not-transposed)
+// SW testbench for profiling the LayerNorm layer in different
+// floating point precisions (fp32, fp16)
 // Correctness of results are checked automatically
 
 #include "dnn.h"
@@ -13,17 +12,33 @@
 #include "data.h"
 
 int main() {
-    layernorm_l.ifmap = (float*)layernorm_ifmap_dram;
-    layernorm_l.result = (float*)layernorm_ofmap_dram;
-
-    // checksum = (float*)layernorm_checksum;
-
-    // printf("Starting layernorm layer\n");
-
-    layernorm_layer(&layernorm_l);
-
-    // uint32_t error = check_layernorm_layer(&linear_l,
-    // (float*)linear_checksum);
-
-    return 0;
-}
\ No newline at end of file
+    layernorm_l.ifmap = (void *)layernorm_ifmap_dram;
+    layernorm_l.ofmap = (void *)layernorm_result;
+    layernorm_l.gamma = (void *)layernorm_gamma_dram;
+    layernorm_l.beta = (void *)layernorm_beta_dram;
+    layernorm_l.result = (void *)layernorm_ofmap_dram;
+
+    if (layernorm_layer(&layernorm_l)) return -1;
+
+    uint32_t errors = 0;
+
+    if (snrt_global_core_idx() == 0) {
+        uint32_t len = layernorm_l.BATCH_SIZE * layernorm_l.SEQ_LEN *
+                       layernorm_l.EMBEDDINGS;
+        float tol = layernorm_l.dtype == FP16 ? 5e-2 : 1e-3;
+
+        for (uint32_t i = 0; i < len; i++) {
+            float res, ref;
+            if (layernorm_l.dtype == FP16) {
+                res = ((__fp16 *)layernorm_l.ofmap)[i];
+                ref = ((__fp16 *)layernorm_l.result)[i];
+            } else {
+                res = ((float *)layernorm_l.ofmap)[i];
+                ref = ((float *)layernorm_l.result)[i];
+            }
+            if (fabs(res - ref) > tol * (1 + fabs(ref))) errors++;
+        }
+    }
+
+    return errors;
+}
@@ -2,9 +2,8 @@
 // Licensed under the Apache License, Version 2.0, see LICENSE for details.
 // SPDX-License-Identifier: Apache-2.0
 
-// SW testbench for profiling linear kernels in different
-// floating point precisions (fp64, fp32, fp16), as well as
-// different memory layouts for matrices (transposed/not-transposed)
+// SW testbench for profiling the linear layer in different
+// floating point precisions (fp64, fp32, fp16)
 // Correctness of results are checked automatically
 
 #include "dnn.h"
@@ -13,14 +12,28 @@
 #include "data.h"
 
 int main() {
-    linear_l.ifmap = (float*)linear_ifmap_dram;
-    linear_l.weights = (float*)linear_weights_dram;
-    linear_l.bias = (float*)linear_bias_dram;
-    linear_l.result = (float*)linear_ofmap_dram;
+    linear_l.ifmap = (void *)linear_ifmap_dram;
+    linear_l.weights = (void *)linear_weights_dram;
+    linear_l.bias = (void *)linear_bias_dram;
+    linear_l.ofmap = (void *)linear_result;
+    linear_l.result = (void *)linear_ofmap_dram;
 
-    linear_layer(&linear_l);
+    if (linear_layer(&linear_l)) return -1;
 
-    // uint32_t error = check_linear_layer(&linear_l, (float*)linear_checksum);
+    uint32_t errors = 0;
 
-    return 0;
-}
\ No newline at end of file
+    if (snrt_global_core_idx() == 0) {
+        uint32_t len = linear_l.CH * linear_l.CO;
+        double tol = linear_l.dtype == FP16   ? 5e-2
+                     : linear_l.dtype == FP32 ? 1e-4
+                                              : 1e-9;
+
+        for (uint32_t i = 0; i < len; i++) {
+            double res = gemm_load(linear_l.dtype, linear_l.ofmap, i);
+            double ref = gemm_load(linear_l.dtype, linear_l.result, i);
+            if (fabs(res - ref) > tol * (1 + fabs(ref))) errors++;
+        }
+    }
+
+    return errors;
+}
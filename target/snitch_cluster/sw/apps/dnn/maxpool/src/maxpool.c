@@ -12,21 +12,15 @@
 
 int main() {
     maxpool_l.ifmap = (double*)maxpool_ifmap_dram;
-    maxpool_l.ofmap = (double*)maxpool_ofmap_dram;
-    maxpool_l.TILE_CI = 32;
+    maxpool_l.ofmap = (double*)maxpool_result;
 
     maxpool_layer(&maxpool_l);
 
     snrt_global_barrier();
 
-    // FIXME: The checksum is overwritten in DRAM by the
-    //        output of the cores. This is a bug.
+    uint32_t error = check_layer(&maxpool_l, (double*)maxpool_checksum);
 
-    // uint32_t error = check_layer(&maxpool_l, (double*)maxpool_checksum);
-
-    // snrt_global_barrier();
-
-    // return error;
+    snrt_global_barrier();
 
-    return 0;
+    return error;
 }
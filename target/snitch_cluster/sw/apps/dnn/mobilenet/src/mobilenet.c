@@ -0,0 +1,188 @@
+// Copyright 2023 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+// Run a MobileNet-style stack of convolutions end to end through
+// conv2d_layer() in every supported precision: a strided stem, depthwise
+// separable blocks with and without stride, a grouped dilated convolution and
+// a dilated depthwise convolution. Every layer reads the output of the
+// previous one from main memory and is checked against a direct convolution
+// of that input, computed in double precision on device. Standalone layers
+// whose feature maps do not fit into the TCDM check the tiled paths, the
+// depthwise one with rows wide enough to also split the channels, and that
+// conv2d_layer() fails on a layer of which not even a single output row
+// fits.
+
+#include "dnn.h"
+#include "snrt.h"
+
+typedef struct {
+    uint32_t ci, co, ih, iw, fh, fw, pad, stride, dilation, groups;
+    uint32_t fails;  // conv2d_layer() is expected to return -1
+} mobilenet_layer_t;
+
+static const mobilenet_layer_t layers[] = {
+    {3, 10, 16, 16, 3, 3, 1, 2, 1, 1},    // Stem
+    {10, 10, 8, 8, 3, 3, 1, 1, 1, 10},    // Depthwise
+    {10, 24, 8, 8, 1, 1, 0, 1, 1, 1},     // Pointwise
+    {24, 24, 8, 8, 3, 3, 1, 2, 1, 24},    // Depthwise, strided
+    {24, 32, 4, 4, 1, 1, 0, 1, 1, 1},     // Pointwise
+    {32, 32, 4, 4, 3, 3, 2, 1, 2, 4},     // Grouped, dilated
+    {32, 32, 4, 4, 3, 3, 2, 1, 2, 32},    // Depthwise, dilated
+};
+
+static const mobilenet_layer_t tiled[] = {
+    {16, 16, 40, 40, 1, 1, 0, 1, 1, 1},    // Pointwise
+    {64, 64, 4, 256, 3, 3, 1, 1, 1, 64},   // Depthwise, tiled channels
+    {8, 8, 1, 8192, 1, 1, 0, 1, 1, 2, 1},  // Grouped, a row exceeds TCDM
+};
+
+#define N_LAYERS (sizeof(layers) / sizeof(layers[0]))
+#define N_TILED (sizeof(tiled) / sizeof(tiled[0]))
+#define FMAP_SIZE (8 * 8 * 24)
+#define TILED_FMAP_SIZE (8192 * 8)
+#define WEIGHTS_SIZE (32 * 3 * 3 * 8)
+
+static const precision_t precs[] = {FP64, FP32, FP16};
+static const double tolerance[] = {1e-12, 1e-5, 1e-2};
+#define N_PRECS (sizeof(precs) / sizeof(precs[0]))
+
+// Feature maps and weights in main memory, large enough for FP64
+static double fmaps[N_LAYERS + 1][FMAP_SIZE];
+static double weights[N_LAYERS][WEIGHTS_SIZE];
+static double tiled_ifmap[TILED_FMAP_SIZE];
+static double tiled_ofmap[TILED_FMAP_SIZE];
+static double tiled_weights[WEIGHTS_SIZE];
+
+// Deterministic operands in [-1, 1], exactly representable in FP16
+static inline void fill(precision_t prec, void *p, uint32_t len,
+                        uint32_t seed, double scale) {
+    for (uint32_t i = 0; i < len; i++) {
+        seed = seed * 1664525 + 1013904223;
+        blas_store(prec, p, i, scale * ((int32_t)(seed >> 27) - 16) / 16);
+    }
+}
+
+// Check an output feature map against a direct convolution of its input.
+// The error bound is relative to the sum of the magnitudes of the products,
+// as the result can be much smaller than the terms it is computed from.
+static uint32_t check(const conv_layer *l, double tol) {
+    const precision_t prec = l->dtype;
+    const uint32_t g = conv2d_groups(l);
+    const uint32_t s = conv2d_stride(l);
+    const uint32_t d = conv2d_dilation(l);
+    const uint32_t ci = l->CI / g, co = l->CO / g;
+    uint32_t errors = 0;
+
+    for (uint32_t oh = 0; oh < l->OH; oh++) {
+        for (uint32_t ow = 0; ow < l->OW; ow++) {
+            for (uint32_t c = 0; c < l->CO; c++) {
+                double ref = 0, mag = 0;
+                for (uint32_t fh = 0; fh < l->FH; fh++) {
+                    int32_t ih = (int32_t)(oh * s + fh * d) - (int32_t)l->pad;
+                    if (ih < 0 || ih >= (int32_t)l->IH) continue;
+                    for (uint32_t fw = 0; fw < l->FW; fw++) {
+                        int32_t iw =
+                            (int32_t)(ow * s + fw * d) - (int32_t)l->pad;
+                        if (iw < 0 || iw >= (int32_t)l->IW) continue;
+                        for (uint32_t k = 0; k < ci; k++) {
+                            uint32_t i = (ih * l->IW + iw) * l->CI +
+                                         (c / co) * ci + k;
+                            uint32_t w = ((c * l->FH + fh) * l->FW + fw) * ci;
+                            double t = blas_load(prec, l->ifmap, i) *
+                                       blas_load(prec, l->weights, w + k);
+                            ref += t;
+                            mag += t < 0 ? -t : t;
+                        }
+                    }
+                }
+                double res =
+                    blas_load(prec, l->ofmap, (oh * l->OW + ow) * l->CO + c);
+                double err = res - ref;
+                if ((err < 0 ? -err : err) > tol * (1 + mag)) errors++;
+            }
+        }
+    }
+    return errors;
+}
+
+// Run a layer on all cores and return its errors on core 0
+static uint32_t run(const mobilenet_layer_t *t, precision_t prec, double tol,
+                    const char *name, uint32_t i, void *ifmap, void *weights,
+                    void *ofmap) {
+    conv_layer l = {.CO = t->co,
+                    .CI = t->ci,
+                    .IH = t->ih,
+                    .IW = t->iw,
+                    .FH = t->fh,
+                    .FW = t->fw,
+                    .pad = t->pad,
+                    .stride = t->stride,
+                    .dilation = t->dilation,
+                    .groups = t->groups,
+                    .ifmap = ifmap,
+                    .weights = weights,
+                    .ofmap = ofmap,
+                    .dtype = prec};
+    l.OH = conv2d_out_dim(t->ih, t->fh, t->pad, t->stride, t->dilation);
+    l.OW = conv2d_out_dim(t->iw, t->fw, t->pad, t->stride, t->dilation);
+
+    uint32_t start_cycle = snrt_mcycle();
+    int ret = conv2d_layer(&l);
+    snrt_global_barrier();
+    uint32_t end_cycle = snrt_mcycle();
+
+    uint32_t e = 0;
+    if (snrt_global_core_idx() == 0) {
+        if (t->fails)
+            e = ret != -1;
+        else
+            e = ret ? l.OH * l.OW * l.CO : check(&l, tol);
+        printf("FP%u %s %u: %u/%u errors, %u cycles\n", 8 * prec, name, i, e,
+               l.OH * l.OW * l.CO, end_cycle - start_cycle);
+    }
+
+    snrt_global_barrier();
+    return e;
+}
+
+int main() {
+    uint32_t errors = 0;
+
+    for (uint32_t p = 0; p < N_PRECS; p++) {
+        const precision_t prec = precs[p];
+
+        if (snrt_global_core_idx() == 0) {
+            const mobilenet_layer_t *t = &layers[0];
+            fill(prec, fmaps[0], t->ih * t->iw * t->ci, 1, 1.0);
+            for (uint32_t i = 0; i < N_LAYERS; i++) {
+                t = &layers[i];
+                fill(prec, weights[i],
+                     t->co * t->fh * t->fw * t->ci / t->groups, i + 2, 0.5);
+            }
+        }
+
+        snrt_global_barrier();
+
+        for (uint32_t i = 0; i < N_LAYERS; i++)
+            errors += run(&layers[i], prec, tolerance[p], "layer", i,
+                          fmaps[i], weights[i], fmaps[i + 1]);
+
+        for (uint32_t i = 0; i < N_TILED; i++) {
+            const mobilenet_layer_t *t = &tiled[i];
+
+            if (snrt_global_core_idx() == 0) {
+                fill(prec, tiled_ifmap, t->ih * t->iw * t->ci, i + 1, 1.0);
+                fill(prec, tiled_weights,
+                     t->co * t->fh * t->fw * t->ci / t->groups, i + 2, 0.5);
+            }
+
+            snrt_global_barrier();
+
+            errors += run(t, prec, tolerance[p], "tiled", i, tiled_ifmap,
+                          tiled_weights, tiled_ofmap);
+        }
+    }
+
+    return errors;
+}
@@ -0,0 +1,146 @@
+// Copyright 2023 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+// Check pool_layer() in every supported precision against a direct
+// computation on device: max and average pooling with overlapping,
+// non-square and padded windows, global pooling, and layers whose feature
+// maps do not fit into the TCDM and must be tiled. Channel counts are not
+// multiples of the SIMD width. Every case is timed with the benchmark harness
+// of the runtime, counting one FP operation per window element.
+
+#include "dnn.h"
+#include "snrt.h"
+
+typedef struct {
+    pool_type_t type;
+    uint32_t c, ih, iw, fh, fw, stride_h, stride_w, pad_h, pad_w;
+} pool_case_t;
+
+static const pool_case_t cases[] = {
+    {POOL_MAX, 10, 9, 9, 3, 3, 2, 2, 1, 1},
+    {POOL_AVG, 7, 8, 10, 3, 2, 1, 2, 1, 1},
+    {POOL_MAX, 16, 8, 8, 2, 2, 0, 0, 0, 0},
+    {POOL_AVG, 3, 11, 6, 5, 1, 3, 1, 2, 0},
+    {POOL_GLOBAL_AVG, 12, 7, 7, 0, 0, 0, 0, 0, 0},
+    {POOL_GLOBAL_MAX, 5, 6, 9, 0, 0, 0, 0, 0, 0},
+    {POOL_MAX, 32, 40, 40, 3, 3, 2, 2, 1, 1},  // Tiled
+    {POOL_GLOBAL_AVG, 32, 40, 40, 0, 0, 0, 0, 0, 0},  // Tiled
+};
+
+#define N_CASES (sizeof(cases) / sizeof(cases[0]))
+#define FMAP_SIZE (40 * 40 * 32)
+
+static const precision_t precs[] = {FP64, FP32, FP16};
+static const double tolerance[] = {1e-12, 1e-5, 1e-2};
+#define N_PRECS (sizeof(precs) / sizeof(precs[0]))
+
+// Feature maps in main memory, large enough for FP64
+static double ifmap[FMAP_SIZE];
+static double ofmap[FMAP_SIZE];
+
+static int run_pool(void *args) { return pool_layer((pool_layer_t *)args); }
+
+// Deterministic operands in [-1, 1], exactly representable in FP16
+static inline void fill(precision_t prec, void *p, uint32_t len,
+                        uint32_t seed) {
+    for (uint32_t i = 0; i < len; i++) {
+        seed = seed * 1664525 + 1013904223;
+        blas_store(prec, p, i, ((int32_t)(seed >> 27) - 16) / 16.0);
+    }
+}
+
+// Check an output feature map against a direct pooling of its input. The
+// error bound of averages is relative to the mean magnitude of the inputs.
+static uint32_t check(const pool_layer_t *l, double tol) {
+    const precision_t prec = l->dtype;
+    const uint32_t global = pool_is_global(l);
+    const uint32_t fh = global ? l->IH : l->FH;
+    const uint32_t fw = global ? l->IW : l->FW;
+    const uint32_t sh = pool_stride_h(l), sw = pool_stride_w(l);
+    uint32_t errors = 0;
+
+    for (uint32_t oh = 0; oh < l->OH; oh++) {
+        for (uint32_t ow = 0; ow < l->OW; ow++) {
+            for (uint32_t c = 0; c < l->C; c++) {
+                double ref = pool_is_max(l) ? -2 : 0, mag = 0;
+                for (uint32_t y = 0; y < fh; y++) {
+                    int32_t ih = (int32_t)(oh * sh + y) - (int32_t)l->pad_h;
+                    if (ih < 0 || ih >= (int32_t)l->IH) continue;
+                    for (uint32_t x = 0; x < fw; x++) {
+                        int32_t iw =
+                            (int32_t)(ow * sw + x) - (int32_t)l->pad_w;
+                        if (iw < 0 || iw >= (int32_t)l->IW) continue;
+                        double v = blas_load(prec, l->ifmap,
+                                             (ih * l->IW + iw) * l->C + c);
+                        if (pool_is_max(l))
+                            ref = v > ref ? v : ref;
+                        else
+                            ref += v / (fh * fw);
+                        mag += (v < 0 ? -v : v) / (fh * fw);
+                    }
+                }
+                double res =
+                    blas_load(prec, l->ofmap, (oh * l->OW + ow) * l->C + c);
+                double err = res - ref;
+                if ((err < 0 ? -err : err) > tol * (1 + mag)) errors++;
+            }
+        }
+    }
+    return errors;
+}
+
+int main() {
+    uint32_t errors = 0;
+
+    for (uint32_t p = 0; p < N_PRECS; p++) {
+        const precision_t prec = precs[p];
+
+        for (uint32_t i = 0; i < N_CASES; i++) {
+            const pool_case_t *t = &cases[i];
+            pool_layer_t l = {.type = t->type,
+                              .C = t->c,
+                              .IH = t->ih,
+                              .IW = t->iw,
+                              .OH = 1,
+                              .OW = 1,
+                              .FH = t->fh,
+                              .FW = t->fw,
+                              .stride_h = t->stride_h,
+                              .stride_w = t->stride_w,
+                              .pad_h = t->pad_h,
+                              .pad_w = t->pad_w,
+                              .ifmap = ifmap,
+                              .ofmap = ofmap,
+                              .dtype = prec};
+            if (!pool_is_global(&l)) {
+                l.OH = pool_out_dim(t->ih, t->fh, t->pad_h, pool_stride_h(&l));
+                l.OW = pool_out_dim(t->iw, t->fw, t->pad_w, pool_stride_w(&l));
+            }
+
+            if (snrt_global_core_idx() == 0)
+                fill(prec, ifmap, t->ih * t->iw * t->c, i + 1);
+
+            const uint32_t fh = pool_is_global(&l) ? l.IH : l.FH;
+            const uint32_t fw = pool_is_global(&l) ? l.IW : l.FW;
+            char name[16];
+            snprintf(name, sizeof(name), "pool_fp%u_%u", 8 * prec, i);
+            snrt_bench_t bench = {.name = name,
+                                  .runs = 1,
+                                  .flops = l.OH * l.OW * l.C * fh * fw,
+                                  .elem_size = prec};
+            int ret = snrt_bench_run(&bench, run_pool, &l);
+
+            if (snrt_global_core_idx() == 0) {
+                uint32_t e = ret ? 1 : check(&l, tolerance[p]);
+                printf("FP%u case %u: %u/%u errors, %u cycles\n", 8 * prec, i,
+                       e, l.OH * l.OW * l.C, bench.cycles);
+                errors += e;
+            }
+
+            snrt_global_barrier();
+        }
+    }
+
+    return errors;
+}
@@ -0,0 +1,207 @@
+// Copyright 2023 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+// Check the quantized GEMM and depthwise convolution kernels against their
+// integer golden models, computed on device. The shapes are not multiples of
+// the kernel granularities, and the last case of every kernel has zero
+// points and reduction sizes for which the FP fast path would not be exact,
+// exercising the integer path. Results must match bit by bit.
+
+#include "dnn.h"
+#include "snrt.h"
+
+typedef struct {
+    uint32_t m, n, k, transb;
+    int8_t zp_a, zp_b;
+} qgemm_case_t;
+
+typedef struct {
+    uint32_t h, w, c, kh, kw, stride, pad;
+    int8_t zp_i, zp_w;
+} qdwconv_case_t;
+
+static const qgemm_case_t gemm_cases[] = {
+    {1, 1, 1, 0, 0, 0},      {3, 5, 7, 1, 3, -7},    {9, 17, 13, 0, -128, 5},
+    {17, 8, 33, 1, 12, 0},   {5, 24, 16, 0, 1, 127}, {16, 16, 64, 1, -3, 9},
+    {4, 8, 700, 0, -100, 100},
+};
+
+static const qdwconv_case_t dwconv_cases[] = {
+    {5, 6, 3, 3, 3, 1, 1, 0, 0},      {8, 7, 20, 3, 3, 2, 1, -5, 17},
+    {6, 6, 9, 5, 5, 1, 2, 127, -128}, {7, 9, 16, 3, 1, 2, 0, 3, 3},
+    {20, 20, 4, 19, 19, 1, 0, 100, -100},
+};
+
+#define N_GEMM_CASES (sizeof(gemm_cases) / sizeof(gemm_cases[0]))
+#define N_DWCONV_CASES (sizeof(dwconv_cases) / sizeof(dwconv_cases[0]))
+
+// Requantization in 8 groups, with the CSR encoding of the GeMMX library
+#define GROUPS 8
+static const int32_t shift[GROUPS / 4] = {0x23262a2d, 0x1f24282b};
+static const int32_t multiplier[GROUPS] = {
+    1073741824, -1518500250, 2147483647, 858993459,
+    -65536,     1234567891,  -2147483647 - 1, 305419896};
+
+static inline uint32_t csr0_config(int8_t input_zp, int8_t output_zp,
+                                   int8_t max_int, int8_t min_int) {
+    return ((uint32_t)(uint8_t)min_int << 24) |
+           ((uint32_t)(uint8_t)max_int << 16) |
+           ((uint32_t)(uint8_t)output_zp << 8) | (uint8_t)input_zp;
+}
+
+// Deterministic pseudo-random int8 values
+static inline void fill(int8_t *p, uint32_t len, uint32_t seed) {
+    for (uint32_t i = 0; i < len; i++) {
+        seed = seed * 1664525 + 1013904223;
+        p[i] = (int8_t)(seed >> 24);
+    }
+}
+
+static inline void fill_bias(int32_t *p, uint32_t len, uint32_t seed) {
+    for (uint32_t i = 0; i < len; i++) {
+        seed = seed * 1664525 + 1013904223;
+        p[i] = (int32_t)seed >> 12;
+    }
+}
+
+static inline uint32_t compare(const int32_t *d32, const int32_t *ref32,
+                               const int8_t *d8, const int8_t *ref8,
+                               uint32_t len) {
+    uint32_t errors = 0;
+    for (uint32_t i = 0; i < len; i++)
+        errors += (d32[i] != ref32[i]) + (d8[i] != ref8[i]);
+    return errors;
+}
+
+int main() {
+    uint32_t errors = 0;
+    qnt_rescale_t rescale;
+
+    if (snrt_cluster_idx() != 0) return 0;
+
+    for (uint32_t i = 0; i < N_GEMM_CASES; i++) {
+        const qgemm_case_t *t = &gemm_cases[i];
+        qnt_rescale_init(&rescale, csr0_config(t->zp_a, -t->zp_b, 127, -128),
+                         i & 1, shift, multiplier, GROUPS);
+
+        qgemm_layer_t l = {.M = t->m,
+                           .N = t->n,
+                           .K = t->k,
+                           .lda = t->k,
+                           .zp_a = t->zp_a,
+                           .ldb = t->transb ? t->k : t->n,
+                           .transb = t->transb,
+                           .zp_b = t->zp_b,
+                           .ldc = t->n,
+                           .ldd = t->n,
+                           .rescale = &rescale};
+        const uint32_t size = t->m * t->n;
+
+        char *ptr = (char *)snrt_l1_next();
+        l.A = (int8_t *)ptr;
+        ptr += ALIGN_UP(t->m * t->k, 8);
+        l.B = (int8_t *)ptr;
+        ptr += ALIGN_UP(t->k * t->n, 8);
+        l.C = (int32_t *)ptr;
+        ptr += ALIGN_UP(size * sizeof(int32_t), 8);
+        int32_t *d32 = (int32_t *)ptr;
+        ptr += ALIGN_UP(size * sizeof(int32_t), 8);
+        int32_t *ref32 = (int32_t *)ptr;
+        ptr += ALIGN_UP(size * sizeof(int32_t), 8);
+        int8_t *d8 = (int8_t *)ptr;
+        ptr += ALIGN_UP(size, 8);
+        int8_t *ref8 = (int8_t *)ptr;
+        ptr += ALIGN_UP(size, 8);
+
+        if (snrt_cluster_core_idx() == 0) {
+            fill((int8_t *)l.A, t->m * t->k, 3 * i + 1);
+            fill((int8_t *)l.B, t->k * t->n, 3 * i + 2);
+            fill_bias((int32_t *)l.C, size, 3 * i + 3);
+            l.D32 = ref32;
+            l.D8 = ref8;
+            qgemm_baseline(&l);
+        }
+
+        snrt_cluster_hw_barrier();
+
+        l.D32 = d32;
+        l.D8 = d8;
+        uint32_t start_cycle = snrt_mcycle();
+        qgemm(&l, ptr);
+        snrt_cluster_hw_barrier();
+        uint32_t end_cycle = snrt_mcycle();
+
+        if (snrt_cluster_core_idx() == 0) {
+            uint32_t e = compare(d32, ref32, d8, ref8, size);
+            printf("qgemm %ux%ux%u: %u errors, %u cycles\n", t->m, t->n, t->k,
+                   e, end_cycle - start_cycle);
+            errors += e;
+        }
+
+        snrt_cluster_hw_barrier();
+    }
+
+    for (uint32_t i = 0; i < N_DWCONV_CASES; i++) {
+        const qdwconv_case_t *t = &dwconv_cases[i];
+        qnt_rescale_init(&rescale, csr0_config(-t->zp_i, t->zp_w, 100, -100),
+                         i & 1, shift, multiplier, GROUPS);
+
+        qdwconv_layer_t l = {.H = t->h,
+                             .W = t->w,
+                             .C = t->c,
+                             .KH = t->kh,
+                             .KW = t->kw,
+                             .stride = t->stride,
+                             .pad = t->pad,
+                             .zp_i = t->zp_i,
+                             .zp_w = t->zp_w,
+                             .rescale = &rescale};
+        const uint32_t size = qdwconv_out_h(&l) * qdwconv_out_w(&l) * t->c;
+
+        char *ptr = (char *)snrt_l1_next();
+        l.ifmap = (int8_t *)ptr;
+        ptr += ALIGN_UP(t->h * t->w * t->c, 8);
+        l.weights = (int8_t *)ptr;
+        ptr += ALIGN_UP(t->kh * t->kw * t->c, 8);
+        l.bias = (int32_t *)ptr;
+        ptr += ALIGN_UP(t->c * sizeof(int32_t), 8);
+        int32_t *d32 = (int32_t *)ptr;
+        ptr += ALIGN_UP(size * sizeof(int32_t), 8);
+        int32_t *ref32 = (int32_t *)ptr;
+        ptr += ALIGN_UP(size * sizeof(int32_t), 8);
+        int8_t *d8 = (int8_t *)ptr;
+        ptr += ALIGN_UP(size, 8);
+        int8_t *ref8 = (int8_t *)ptr;
+        ptr += ALIGN_UP(size, 8);
+
+        if (snrt_cluster_core_idx() == 0) {
+            fill((int8_t *)l.ifmap, t->h * t->w * t->c, 5 * i + 1);
+            fill((int8_t *)l.weights, t->kh * t->kw * t->c, 5 * i + 2);
+            fill_bias((int32_t *)l.bias, t->c, 5 * i + 3);
+            l.ofmap32 = ref32;
+            l.ofmap8 = ref8;
+            qdwconv_baseline(&l);
+        }
+
+        snrt_cluster_hw_barrier();
+
+        l.ofmap32 = d32;
+        l.ofmap8 = d8;
+        uint32_t start_cycle = snrt_mcycle();
+        qdwconv(&l, ptr);
+        snrt_cluster_hw_barrier();
+        uint32_t end_cycle = snrt_mcycle();
+
+        if (snrt_cluster_core_idx() == 0) {
+            uint32_t e = compare(d32, ref32, d8, ref8, size);
+            printf("qdwconv %ux%ux%u k%ux%u: %u errors, %u cycles\n", t->h,
+                   t->w, t->c, t->kh, t->kw, e, end_cycle - start_cycle);
+            errors += e;
+        }
+
+        snrt_cluster_hw_barrier();
+    }
+
+    return errors;
+}
@@ -0,0 +1,148 @@
+// Copyright 2023 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+// Strong scaling of the row-parallel layers (GELU, LayerNorm, SoftMax and
+// Linear) over the number of clusters and of compute cores per cluster. Every
+// configuration reports its cycles and the speedup over a single compute
+// core. Rows are computed independently of the partitioning, so all results
+// must match the single-core run exactly. The number of mismatches and of
+// failed layer calls is returned.
+
+#include "dnn.h"
+#include "snrt.h"
+
+#define ROWS 64
+#define COLS 64
+
+static const char *layer_names[] = {"gelu", "layernorm", "softmax", "linear"};
+
+#define N_LAYERS (sizeof(layer_names) / sizeof(layer_names[0]))
+
+static float ifmap[ROWS * COLS];
+static float ofmap[ROWS * COLS];
+static float ref[ROWS * COLS];
+static float weights[COLS * COLS];
+static float ln_gamma[COLS];
+static float ln_beta[COLS];
+static float bias[COLS];
+
+// Deterministic values in [-2, 2)
+static inline float value(uint32_t i, uint32_t salt) {
+    return (float)((i * 37 + salt * 11) % 64) / 16 - 2;
+}
+
+static inline int run_layer(uint32_t layer) {
+    switch (layer) {
+        case 0: {
+            gelu_layer_t l = {.BATCH_SIZE = 1,
+                              .SEQ_LEN = ROWS,
+                              .HIDDEN_NODES = COLS,
+                              .IMPL = GELU_POLY,
+                              .ifmap = ifmap,
+                              .ofmap = ofmap,
+                              .dtype = FP32};
+            return gelu_layer(&l);
+        }
+        case 1: {
+            layernorm_layer_t l = {.BATCH_SIZE = 1,
+                                   .SEQ_LEN = ROWS,
+                                   .EMBEDDINGS = COLS,
+                                   .EPS = 1e-5,
+                                   .ifmap = ifmap,
+                                   .ofmap = ofmap,
+                                   .gamma = ln_gamma,
+                                   .beta = ln_beta,
+                                   .dtype = FP32};
+            return layernorm_layer(&l);
+        }
+        case 2: {
+            softmax_layer_t l = {.BATCH_SIZE = 1,
+                                 .SEQ_LEN = ROWS,
+                                 .INPUT_SAMPLES = COLS,
+                                 .ifmap = ifmap,
+                                 .ofmap = ofmap,
+                                 .dtype = FP32};
+            return softmax_layer(&l);
+        }
+        default: {
+            linear_layer_t l = {.CO = COLS,
+                                .CI = COLS,
+                                .CH = ROWS,
+                                .CW = COLS,
+                                .ifmap = ifmap,
+                                .weights = weights,
+                                .bias = bias,
+                                .ofmap = ofmap,
+                                .dtype = FP32};
+            return linear_layer(&l);
+        }
+    }
+}
+
+// Powers of two up to and including max
+static inline uint32_t next_count(uint32_t n, uint32_t max) {
+    return (n < max && 2 * n > max) ? max : 2 * n;
+}
+
+int main() {
+    const uint32_t cluster_num = snrt_cluster_num();
+    const uint32_t compute_num = snrt_cluster_compute_core_num();
+    const uint32_t is_master = snrt_global_core_idx() == 0;
+    uint32_t errors = 0;
+
+    if (is_master) {
+        for (uint32_t i = 0; i < ROWS * COLS; i++) ifmap[i] = value(i, 1);
+        for (uint32_t i = 0; i < COLS * COLS; i++)
+            weights[i] = value(i, 2) / COLS;
+        for (uint32_t i = 0; i < COLS; i++) {
+            ln_gamma[i] = value(i, 3);
+            ln_beta[i] = value(i, 4);
+            bias[i] = value(i, 5);
+        }
+    }
+
+    for (uint32_t layer = 0; layer < N_LAYERS; layer++) {
+        uint32_t base_cycles = 0;
+
+        for (uint32_t clusters = 1; clusters <= cluster_num;
+             clusters = next_count(clusters, cluster_num)) {
+            for (uint32_t cores = 1; cores <= compute_num;
+                 cores = next_count(cores, compute_num)) {
+                // Only the single-cluster runs sweep the cores per cluster
+                if (clusters > 1 && cores < compute_num) continue;
+
+                if (is_master) {
+                    dnn_max_clusters = clusters;
+                    dnn_max_compute_cores = cores;
+                }
+                snrt_global_barrier();
+
+                uint32_t start = snrt_mcycle();
+                int ret = run_layer(layer);
+                uint32_t cycles = snrt_mcycle() - start;
+
+                if (is_master) {
+                    if (ret) errors++;
+                    if (!base_cycles) {
+                        base_cycles = cycles;
+                        for (uint32_t i = 0; i < ROWS * COLS; i++)
+                            ref[i] = ofmap[i];
+                    } else {
+                        for (uint32_t i = 0; i < ROWS * COLS; i++)
+                            if (ofmap[i] != ref[i]) errors++;
+                    }
+
+                    // The printf of the runtime has no float support, the
+                    // speedup is printed with two decimals
+                    uint32_t speedup = 100.0 * base_cycles / cycles + 0.5;
+                    printf("%s: %u clusters x %u cores: %u cycles, ",
+                           layer_names[layer], clusters, cores, cycles);
+                    printf("speedup %u.%02u\n", speedup / 100, speedup % 100);
+                }
+            }
+        }
+    }
+
+    return errors;
+}
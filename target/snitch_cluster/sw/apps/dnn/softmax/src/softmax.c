@@ -2,9 +2,8 @@
 // Licensed under the Apache License, Version 2.0, see LICENSE for details.
 // SPDX-License-Identifier: Apache-2.0
 
-// SW testbench for profiling linear kernels in different
-// floating point precisions (fp64, fp32, fp16), as well as
-// different memory layouts for matrices (transposed/not-transposed)
+// SW testbench for profiling the SoftMax layer in different
+// floating point precisions (fp32, fp16)
 // Correctness of results are checked automatically
 
 #include "dnn.h"
@@ -13,16 +12,31 @@
 #include "data.h"
 
 int main() {
-    softmax_l.ifmap = (float*)softmax_ifmap_dram;
-    // softmax_l.result = (float*)softmax_ofmap_dram;
-
-    // checksum = (float*)softmax_checksum;
-
-    softmax_layer(&softmax_l);
-
-    snrt_global_barrier();
-
-    // uint32_t error = check_softmax_layer(&linear_l, (float*)linear_checksum);
-
-    return 0;
-}
\ No newline at end of file
+    softmax_l.ifmap = (void *)softmax_ifmap_dram;
+    softmax_l.ofmap = (void *)softmax_result;
+    softmax_l.result = (void *)softmax_ofmap_dram;
+
+    if (softmax_layer(&softmax_l)) return -1;
+
+    uint32_t errors = 0;
+
+    if (snrt_global_core_idx() == 0) {
+        uint32_t len =
+            softmax_l.BATCH_SIZE * softmax_l.SEQ_LEN * softmax_l.INPUT_SAMPLES;
+        float tol = softmax_l.dtype == FP16 ? 1e-2 : 1e-4;
+
+        for (uint32_t i = 0; i < len; i++) {
+            float res, ref;
+            if (softmax_l.dtype == FP16) {
+                res = ((__fp16 *)softmax_l.ofmap)[i];
+                ref = ((__fp16 *)softmax_l.result)[i];
+            } else {
+                res = ((float *)softmax_l.ofmap)[i];
+                ref = ((float *)softmax_l.result)[i];
+            }
+            if (fabs(res - ref) > tol) errors++;
+        }
+    }
+
+    return errors;
+}
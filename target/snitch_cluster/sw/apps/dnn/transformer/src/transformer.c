@@ -0,0 +1,55 @@
+// Copyright 2023 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+// SW testbench for profiling the transformer encoder block in different
+// floating point precisions (fp32, fp16)
+// Correctness of results are checked automatically
+
+#include "dnn.h"
+#include "snrt.h"
+
+#include "data.h"
+
+int main() {
+    transformer_l.ifmap = (void *)transformer_ifmap_dram;
+    transformer_l.ofmap = (void *)transformer_result;
+    transformer_l.wq = (void *)transformer_wq_dram;
+    transformer_l.wk = (void *)transformer_wk_dram;
+    transformer_l.wv = (void *)transformer_wv_dram;
+    transformer_l.wo = (void *)transformer_wo_dram;
+    transformer_l.bq = (void *)transformer_bq_dram;
+    transformer_l.bk = (void *)transformer_bk_dram;
+    transformer_l.bv = (void *)transformer_bv_dram;
+    transformer_l.bo = (void *)transformer_bo_dram;
+    transformer_l.gamma1 = (void *)transformer_gamma1_dram;
+    transformer_l.beta1 = (void *)transformer_beta1_dram;
+    transformer_l.w1 = (void *)transformer_w1_dram;
+    transformer_l.b1 = (void *)transformer_b1_dram;
+    transformer_l.w2 = (void *)transformer_w2_dram;
+    transformer_l.b2 = (void *)transformer_b2_dram;
+    transformer_l.gamma2 = (void *)transformer_gamma2_dram;
+    transformer_l.beta2 = (void *)transformer_beta2_dram;
+    transformer_l.k = (void *)transformer_k;
+    transformer_l.vt = (void *)transformer_vt;
+    transformer_l.result = (void *)transformer_ofmap_dram;
+
+    if (transformer_layer(&transformer_l)) return -1;
+
+    uint32_t errors = 0;
+
+    if (snrt_global_core_idx() == 0) {
+        uint32_t len = transformer_l.SEQ_LEN * transformer_l.EMBEDDINGS;
+        double tol = transformer_l.dtype == FP16 ? 1e-1 : 2e-3;
+
+        precision_t prec = transformer_l.dtype;
+
+        for (uint32_t i = 0; i < len; i++) {
+            double res = gemm_load(prec, transformer_l.ofmap, i);
+            double ref = gemm_load(prec, transformer_l.result, i);
+            if (fabs(res - ref) > tol * (1 + fabs(ref))) errors++;
+        }
+    }
+
+    return errors;
+}
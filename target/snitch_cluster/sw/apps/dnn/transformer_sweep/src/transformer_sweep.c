@@ -0,0 +1,112 @@
+// Copyright 2023 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+// Cycles of the transformer encoder block over the sequence length, for a
+// fixed embedding size, number of heads and MLP size. The attention cost
+// grows quadratically with the sequence length, the projections and the MLP
+// linearly. The number of sequence lengths which could not be run is
+// returned.
+
+#include "dnn.h"
+#include "snrt.h"
+
+#define MAX_SEQ_LEN 128
+#define D_MODEL 64
+#define N_HEADS 4
+#define D_FF 128
+
+static const uint32_t seq_lens[] = {16, 32, 64, 128};
+
+#define N_SEQ_LENS (sizeof(seq_lens) / sizeof(seq_lens[0]))
+
+static float ifmap[MAX_SEQ_LEN * D_MODEL];
+static float ofmap[MAX_SEQ_LEN * D_MODEL];
+static float k[MAX_SEQ_LEN * D_MODEL];
+static float vt[D_MODEL * MAX_SEQ_LEN];
+static float wq[D_MODEL * D_MODEL];
+static float wk[D_MODEL * D_MODEL];
+static float wv[D_MODEL * D_MODEL];
+static float wo[D_MODEL * D_MODEL];
+static float w1[D_FF * D_MODEL];
+static float w2[D_MODEL * D_FF];
+static float b1[D_FF];
+static float vec[4][D_MODEL];
+static float ln_gamma[D_MODEL];
+static float ln_beta[D_MODEL];
+
+// Deterministic values in [-2, 2)
+static inline float value(uint32_t i, uint32_t salt) {
+    return (float)((i * 37 + salt * 11) % 64) / 16 - 2;
+}
+
+static inline void fill(float *x, uint32_t len, uint32_t salt, float scale) {
+    for (uint32_t i = 0; i < len; i++) x[i] = value(i, salt) * scale;
+}
+
+int main() {
+    const uint32_t is_master = snrt_global_core_idx() == 0;
+    uint32_t errors = 0;
+
+    if (is_master) {
+        fill(ifmap, MAX_SEQ_LEN * D_MODEL, 1, 1);
+        fill(wq, D_MODEL * D_MODEL, 2, 1.f / D_MODEL);
+        fill(wk, D_MODEL * D_MODEL, 3, 1.f / D_MODEL);
+        fill(wv, D_MODEL * D_MODEL, 4, 1.f / D_MODEL);
+        fill(wo, D_MODEL * D_MODEL, 5, 1.f / D_MODEL);
+        fill(w1, D_FF * D_MODEL, 6, 1.f / D_MODEL);
+        fill(w2, D_MODEL * D_FF, 7, 1.f / D_FF);
+        fill(b1, D_FF, 8, 1);
+        fill(&vec[0][0], 4 * D_MODEL, 9, 1);
+        fill(ln_gamma, D_MODEL, 10, 1);
+        fill(ln_beta, D_MODEL, 11, 1);
+    }
+
+    for (uint32_t i = 0; i < N_SEQ_LENS; i++) {
+        transformer_layer_t l = {.SEQ_LEN = seq_lens[i],
+                                 .EMBEDDINGS = D_MODEL,
+                                 .HEADS = N_HEADS,
+                                 .FF = D_FF,
+                                 .EPS = 1e-5,
+                                 .GELU_IMPL = GELU_POLY,
+                                 .ifmap = ifmap,
+                                 .ofmap = ofmap,
+                                 .wq = wq,
+                                 .wk = wk,
+                                 .wv = wv,
+                                 .wo = wo,
+                                 .bq = vec[0],
+                                 .bk = vec[1],
+                                 .bv = vec[2],
+                                 .bo = vec[3],
+                                 .gamma1 = ln_gamma,
+                                 .beta1 = ln_beta,
+                                 .w1 = w1,
+                                 .b1 = b1,
+                                 .w2 = w2,
+                                 .b2 = vec[3],
+                                 .gamma2 = ln_gamma,
+                                 .beta2 = ln_beta,
+                                 .k = k,
+                                 .vt = vt,
+                                 .dtype = FP32};
+
+        snrt_global_barrier();
+
+        uint32_t start = snrt_mcycle();
+        int ret = transformer_layer(&l);
+        uint32_t cycles = snrt_mcycle() - start;
+
+        if (is_master) {
+            if (ret) {
+                printf("seq_len %d: does not fit\n", seq_lens[i]);
+                errors++;
+            } else {
+                printf("seq_len %d: %d cycles, %d cycles per token\n",
+                       seq_lens[i], cycles, cycles / seq_lens[i]);
+            }
+        }
+    }
+
+    return errors;
+}
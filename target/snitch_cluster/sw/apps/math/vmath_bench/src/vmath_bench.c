@@ -0,0 +1,188 @@
+// Copyright 2023 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+// Cycles per element and maximum ULP error of the vectorized elementary
+// functions in FP32 and FP16, next to the cycles of a scalar loop over the
+// libm subset. The reference is evaluated in double precision. The number of
+// functions whose maximum error exceeds its bound is returned.
+
+#include "math.h"
+#include "snrt.h"
+#include "vmath.h"
+
+#define N_SAMPLES 512
+
+typedef enum { VMATH_EXP, VMATH_LOG, VMATH_TANH, VMATH_RSQRT } vmath_func_t;
+
+static const char *func_names[] = {"exp", "log", "tanh", "rsqrt"};
+
+// Documented maximum error in FP32 ULP
+static const double max_ulp32[] = {1.5, 4.0, 4.0, 2.0};
+
+// Maximum error in FP16 ULP, one rounding of an accurate FP32 result
+#define MAX_ULP16 1.0
+
+// Input ranges in FP32 and FP16. Ranges of log and rsqrt are sampled
+// logarithmically.
+static const float x_min32[] = {-80.0f, 1e-30f, -8.0f, 1e-30f};
+static const float x_max32[] = {80.0f, 1e30f, 8.0f, 1e30f};
+static const float x_min16[] = {-9.0f, 1e-4f, -4.0f, 1e-4f};
+static const float x_max16[] = {10.0f, 6e4f, 4.0f, 6e4f};
+
+typedef union {
+    float f;
+    uint32_t u;
+} vmath_bits_t;
+
+static inline float sample(vmath_func_t func, float lo, float hi,
+                           uint32_t i) {
+    if (func == VMATH_LOG || func == VMATH_RSQRT) {
+        // Linear in the bit pattern is close to linear in the exponent
+        vmath_bits_t a = {.f = lo}, b = {.f = hi}, x;
+        x.u = a.u + (uint32_t)(((uint64_t)(b.u - a.u) * i) / N_SAMPLES);
+        return x.f;
+    }
+    return lo + (hi - lo) * i / N_SAMPLES;
+}
+
+static inline double reference(vmath_func_t func, double x) {
+    switch (func) {
+        case VMATH_EXP:
+            return expm1(x) + 1.0;
+        case VMATH_LOG:
+            return log2(x) * M_LN2;
+        case VMATH_TANH:
+            return tanh(x);
+        default:
+            return 1.0 / sqrt(x);
+    }
+}
+
+// Scalar loop over the libm subset, which has no logf and no tanhf
+static inline void scalar(vmath_func_t func, const float *x, float *y) {
+    switch (func) {
+        case VMATH_EXP:
+            for (uint32_t i = 0; i < N_SAMPLES; i++) y[i] = expf(x[i]);
+            break;
+        case VMATH_LOG:
+            for (uint32_t i = 0; i < N_SAMPLES; i++)
+                y[i] = log2f(x[i]) * (float)M_LN2;
+            break;
+        case VMATH_TANH:
+            for (uint32_t i = 0; i < N_SAMPLES; i++) y[i] = tanh(x[i]);
+            break;
+        default:
+            for (uint32_t i = 0; i < N_SAMPLES; i++)
+                y[i] = 1.0f / sqrtf(x[i]);
+            break;
+    }
+}
+
+static inline void vector32(vmath_func_t func, const float *x, float *y) {
+    switch (func) {
+        case VMATH_EXP:
+            snrt_vexpf(x, y, N_SAMPLES);
+            break;
+        case VMATH_LOG:
+            snrt_vlogf(x, y, N_SAMPLES);
+            break;
+        case VMATH_TANH:
+            snrt_vtanhf(x, y, N_SAMPLES);
+            break;
+        default:
+            snrt_vrsqrtf(x, y, N_SAMPLES);
+            break;
+    }
+}
+
+static inline void vector16(vmath_func_t func, const __fp16 *x, __fp16 *y) {
+    switch (func) {
+        case VMATH_EXP:
+            snrt_vexpf16(x, y, N_SAMPLES);
+            break;
+        case VMATH_LOG:
+            snrt_vlogf16(x, y, N_SAMPLES);
+            break;
+        case VMATH_TANH:
+            snrt_vtanhf16(x, y, N_SAMPLES);
+            break;
+        default:
+            snrt_vrsqrtf16(x, y, N_SAMPLES);
+            break;
+    }
+}
+
+// Error of y in units of the last place of ref, for a format with mant_bits
+// fraction bits and minimum normal exponent min_exp
+static inline double ulp_err(double y, double ref, int32_t mant_bits,
+                             int32_t min_exp) {
+    union {
+        double d;
+        uint64_t u;
+    } ulp;
+    vmath_bits_t r = {.f = (float)ref};
+    int32_t e = (int32_t)((r.u >> 23) & 0xff) - 127;
+    if (e < min_exp) e = min_exp;
+    ulp.u = (uint64_t)(e - mant_bits + 1023) << 52;
+    return fabs(y - ref) / ulp.d;
+}
+
+int main() {
+    if (snrt_global_core_idx() != 0) return 0;
+
+    uint32_t errors = 0;
+
+    float *x32 = snrt_l1_next();
+    float *y32 = x32 + N_SAMPLES;
+    float *s32 = y32 + N_SAMPLES;
+    __fp16 *x16 = (__fp16 *)(s32 + N_SAMPLES);
+    __fp16 *y16 = x16 + N_SAMPLES;
+
+    for (vmath_func_t func = VMATH_EXP; func <= VMATH_RSQRT; func++) {
+        double err32 = 0.0;
+        double err16 = 0.0;
+
+        for (uint32_t i = 0; i < N_SAMPLES; i++) {
+            x32[i] = sample(func, x_min32[func], x_max32[func], i);
+            x16[i] = sample(func, x_min16[func], x_max16[func], i);
+        }
+
+        uint32_t start = snrt_mcycle();
+        scalar(func, x32, s32);
+        uint32_t scalar_cycles = snrt_mcycle() - start;
+
+        start = snrt_mcycle();
+        vector32(func, x32, y32);
+        uint32_t cycles32 = snrt_mcycle() - start;
+
+        start = snrt_mcycle();
+        vector16(func, x16, y16);
+        uint32_t cycles16 = snrt_mcycle() - start;
+
+        for (uint32_t i = 0; i < N_SAMPLES; i++) {
+            double e32 = ulp_err(y32[i], reference(func, x32[i]), 23, -126);
+            double e16 = ulp_err(y16[i], reference(func, x16[i]), 10, -14);
+            err32 = e32 > err32 ? e32 : err32;
+            err16 = e16 > err16 ? e16 : err16;
+        }
+
+        // The printf of the runtime has no float support
+        printf("%s: libm ", func_names[func]);
+        snrt_bench_print_ratio(scalar_cycles, N_SAMPLES);
+        printf(" cycles/elem; fp32 ");
+        snrt_bench_print_ratio(cycles32, N_SAMPLES);
+        printf(" cycles/elem, max err ");
+        snrt_bench_print_ratio(err32, 1);
+        printf(" ulp; fp16 ");
+        snrt_bench_print_ratio(cycles16, N_SAMPLES);
+        printf(" cycles/elem, max err ");
+        snrt_bench_print_ratio(err16, 1);
+        printf(" ulp\n");
+
+        if (err32 > max_ulp32[func]) errors++;
+        if (err16 > MAX_ULP16) errors++;
+    }
+
+    return errors;
+}
@@ -0,0 +1,106 @@
+// Copyright 2023 ETH Zurich and University of Bologna.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+// Training throughput of the optimized MNIST backend. A synthetic dataset of
+// MNIST-sized images is generated in main memory: every class is a noisy
+// shifted stripe pattern, so a linear classifier can learn it within a few
+// mini-batches. Reports the cycles, the images per second at the assumed
+// clock frequency, the loss and the accuracy. Returns a non-zero value if the
+// accuracy stays below the expected one.
+
+#include "dnn.h"
+#include "nnlinear_backend_opt.h"
+#include "snrt.h"
+
+#define IMAGE_H 28
+#define IMAGE_W 28
+#define N_PIXELS (IMAGE_H * IMAGE_W)
+#define N_CLASSES 10
+#define N_IMAGES 256
+#define BATCH_SIZE 64
+#define EPOCHS 2
+#define LEARNING_RATE 0.1f
+
+// Clock frequency the images per second refer to
+#define FREQ_MHZ 1000
+
+// Minimum accuracy over all epochs. The first mini-batch is predicted by the
+// initial zero weights, later ones should be almost all correct.
+#define MIN_ACCURACY 0.8f
+
+static float images[N_IMAGES * N_PIXELS];
+static uint32_t targets[N_IMAGES];
+static float weights[N_CLASSES * N_PIXELS];
+static float biases[N_CLASSES];
+static float weight_grads[SNRT_CLUSTER_NUM * N_CLASSES * N_PIXELS];
+static float bias_grads[SNRT_CLUSTER_NUM * N_CLASSES];
+
+static inline uint32_t hash(uint32_t x) {
+    x = x * 1103515245 + 12345;
+    x ^= x >> 16;
+    x *= 0x45d9f3b;
+    x ^= x >> 16;
+    return x;
+}
+
+// Pixel j of image i with class label, the noise is uniform in [-0.5, 0.5)
+static inline float pixel(uint32_t i, uint32_t j, uint32_t label) {
+    float stripe = ((j + 9 * label) % 10 < 3) ? 1.0f : 0.0f;
+    return stripe + (float)(hash(i * N_PIXELS + j) >> 8) / (1 << 24) - 0.5f;
+}
+
+int main() {
+    const uint32_t compute_num = snrt_cluster_compute_core_num();
+    const uint32_t compute_id = snrt_cluster_core_idx();
+
+    if (snrt_cluster_idx() == 0 && snrt_is_compute_core()) {
+        for (uint32_t i = compute_id; i < N_IMAGES; i += compute_num) {
+            targets[i] = i % N_CLASSES;
+            for (uint32_t j = 0; j < N_PIXELS; j++)
+                images[i * N_PIXELS + j] = pixel(i, j, targets[i]);
+        }
+        for (uint32_t j = compute_id; j < N_CLASSES * N_PIXELS;
+             j += compute_num)
+            weights[j] = 0;
+        if (compute_id == 0)
+            for (uint32_t o = 0; o < N_CLASSES; o++) biases[o] = 0;
+    }
+
+    snrt_global_barrier();
+
+    network_fp32_t net = {.IN_CH1 = IMAGE_H,
+                          .IN_CH2 = IMAGE_W,
+                          .OUT_CH = N_CLASSES,
+                          .b = biases,
+                          .W = weights,
+                          .b_grad = bias_grads,
+                          .W_grad = weight_grads,
+                          .images = images,
+                          .targets = targets,
+                          .learning_rate = LEARNING_RATE,
+                          .dtype = FP32};
+    nnlinear_stats_t stats;
+
+    if (nnlinear_backend_opt(&net, N_IMAGES, BATCH_SIZE, EPOCHS, &stats))
+        return 1;
+
+    if (snrt_global_core_idx() != 0) return 0;
+
+    float accuracy = (float)stats.correct / stats.images;
+
+    // The printf of the runtime has no float support
+    printf("%u images on %u clusters in %u cycles: ", stats.images,
+           snrt_cluster_num(), stats.cycles);
+    snrt_bench_print_ratio(stats.cycles, stats.images);
+    printf(" cycles/image, ");
+    snrt_bench_print_ratio((double)stats.images * FREQ_MHZ * 1e6,
+                           stats.cycles);
+    printf(" images/s at %u MHz\nloss ", FREQ_MHZ);
+    snrt_bench_print_ratio(stats.loss, 1);
+    printf(", accuracy ");
+    snrt_bench_print_ratio(stats.correct, stats.images);
+    printf("\n");
+
+    return accuracy < MIN_ACCURACY;
+}
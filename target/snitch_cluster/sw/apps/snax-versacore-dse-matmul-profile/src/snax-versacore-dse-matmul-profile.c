@@ -6,6 +6,7 @@
 
 #include "data.h"
 
+#include "snax-telemetry.h"
 #include "snax-versacore-dse-lib.h"
 
 int main() {
@@ -89,6 +90,21 @@ int main() {
                               data_type);
         }
 
+        snax_telemetry_t telemetry;
+        snax_telemetry_init(&telemetry, "matmul");
+        int32_t gemm_src = snax_telemetry_add(&telemetry, "versacore",
+                                              read_versacore_perf_counter,
+                                              SNAX_TELEMETRY_LAST_TASK);
+        snax_telemetry_add(&telemetry, "streamer",
+                           read_versacore_streamer_perf_counter,
+                           SNAX_TELEMETRY_LAST_TASK);
+        snax_telemetry_set_ideal(&telemetry, gemm_src, M * K * N);
+        snax_telemetry_add_cluster_event(&telemetry,
+                                         SNRT_PERF_CNT_TCDM_ACCESSED, 0);
+        snax_telemetry_add_cluster_event(&telemetry,
+                                         SNRT_PERF_CNT_TCDM_CONGESTED, 0);
+        snax_telemetry_begin(&telemetry);
+
         // Set CSR to start Streamer
         set_versacore_streamer_start();
 
@@ -98,6 +114,8 @@ int main() {
         // Poll until Streamer and GEMM accelerator finish
         wait_versacore_and_streamer();
 
+        snax_telemetry_end(&telemetry);
+
         // Result check
         err += check_versacore_result_D32((int8_t *)local_d, (int8_t *)D,
                                           d_data_length, false);
@@ -108,12 +126,8 @@ int main() {
             array_shape, meshRow, tileSize, meshCol, stationary,
             err ? "FAIL" : "PASS", err);
 
-        int32_t gemmx_cycles = read_versacore_perf_counter();
-        int32_t gemmx_streamer_cycles = read_versacore_streamer_perf_counter();
         printf("Workload size: M = %d, N = %d, K = %d\n", M, N, K);
-        printf("SNAX GEMM Ideal cycles: %d\n", M * K * N);
-        printf("SNAX GEMM cycles: %d\n", gemmx_cycles);
-        printf("SNAX GEMM Streamer cycles: %d\n", gemmx_streamer_cycles);
+        snax_telemetry_report(&telemetry);
     };
 
     return err;
@@ -184,6 +184,23 @@ int main() {
             }
         }
         printf("The memset of 4KB - 12KB is correct\n");
+
+        // Test 4: Setting the 16-32KB region to 0 through the runtime's
+        // snrt_dma_memset(), after selecting the xdma as its engine
+        printf(
+            "Test 4: Setting the 16-32KB region to 0 with "
+            "snrt_dma_memset\n");
+        snrt_memset_words(tcdm_16, 0xAA, 0x4000 * sizeof(uint8_t));
+        snax_xdma_select_memset();
+        snrt_dma_memset(tcdm_16, 0, 0x4000 * sizeof(uint8_t));
+        snrt_dma_set_memset_backend(NULL);
+        for (int i = 0; i < 0x4000; i++) {
+            if (tcdm_16[i] != 0x00) {
+                printf("The memset of 16KB - 32KB is not correct\n");
+                return -1;
+            }
+        }
+        printf("The memset of 16KB - 32KB is correct\n");
     } else {
         printf("Core %d is not xdma core. \n", snrt_cluster_core_idx());
     }
@@ -5,6 +5,7 @@
 #include "snrt.h"
 
 #include "alloc.c"
+#include "bench.c"
 #include "cls.c"
 #include "cluster_interrupts.c"
 #include "dm.c"
@@ -13,6 +14,7 @@
 #include "kmp.c"
 #include "omp.c"
 #include "printf.c"
+#include "profile.c"
 #include "putchar.c"
 #include "snitch_cluster_start.c"
 #include "sync.c"
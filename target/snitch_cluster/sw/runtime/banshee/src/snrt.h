@@ -30,8 +30,12 @@
 #include "omp.h"
 #include "perf_cnt.h"
 #include "printf.h"
+#include "profile.h"
 #include "riscv.h"
 #include "snitch_cluster_global_interrupts.h"
 #include "ssr.h"
 #include "sync.h"
 #include "team.h"
+
+// Built on top of the implementation
+#include "bench.h"
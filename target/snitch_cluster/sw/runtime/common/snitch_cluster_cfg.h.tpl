@@ -3,4 +3,7 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #define CFG_CLUSTER_NR_CORES ${cfg['cluster']['nr_cores']}
-#define CFG_CLUSTER_BASE_HARTID ${cfg['cluster']['cluster_base_hartid']}
\ No newline at end of file
+#define CFG_CLUSTER_BASE_HARTID ${cfg['cluster']['cluster_base_hartid']}
+#define CFG_CLUSTER_DMA_DATA_WIDTH ${cfg['cluster']['dma_data_width']}% if cfg['cluster']['init_dma']:
+#define CFG_CLUSTER_INIT_DMA
+% endif
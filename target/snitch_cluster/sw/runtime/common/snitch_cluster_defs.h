@@ -11,6 +11,7 @@
 #define SNRT_CLUSTER_CORE_NUM CFG_CLUSTER_NR_CORES
 #define SNRT_CLUSTER_NUM 1
 #define SNRT_CLUSTER_DM_CORE_NUM 1
+#define SNRT_DMA_DATA_WIDTH CFG_CLUSTER_DMA_DATA_WIDTH
 #define SNRT_TCDM_START_ADDR CLUSTER_TCDM_BASE_ADDR
 #define SNRT_TCDM_SIZE (CLUSTER_PERIPH_BASE_ADDR - CLUSTER_TCDM_BASE_ADDR)
 #define SNRT_CLUSTER_OFFSET 0
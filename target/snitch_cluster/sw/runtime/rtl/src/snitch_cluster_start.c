@@ -6,6 +6,10 @@
 #define SNRT_INIT_BSS
 #define SNRT_INIT_CLS
 #define SNRT_INIT_LIBS
+// Initialize with the iDMA only in configurations which opt in
+#ifdef CFG_CLUSTER_INIT_DMA
+#define SNRT_INIT_DMA
+#endif
 #define SNRT_CRT0_PRE_BARRIER
 #define SNRT_INVOKE_MAIN
 #define SNRT_CRT0_POST_BARRIER
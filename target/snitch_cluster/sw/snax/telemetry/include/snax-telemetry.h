@@ -0,0 +1,170 @@
+// Copyright 2025 KU Leuven.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#include <stdbool.h>
+#include "snrt.h"
+#include "stdint.h"
+
+// Unified telemetry for SNAX accelerators, streamers, the XDMA and the
+// cluster performance counters.
+//
+// Every accelerator library exposes its own perf counter read function, e.g.
+// read_gemmx_perf_counter() or snax_xdma_last_task_cycle(). The application
+// registers the ones it links against as sources, and optionally cluster
+// performance counter events with snax_telemetry_add_cluster_event(), then
+// brackets a region with snax_telemetry_begin()/snax_telemetry_end(). The
+// cluster counters of the registered events are reset and started at the
+// beginning of the region, and stopped at its end. All sources and mcycle are
+// sampled back-to-back at both ends of the region, and the per-source cycles
+// are reported against the region cycles and an optional ideal cycle count,
+// one line per source, followed by one line per cluster event:
+//
+//   TELEMETRY,<region>,<source>,<cycles>,<ideal>,<region_cycles>,<util%>
+//   TELEMETRY,<region>,cluster_event<e>_hart<h>,<count>,0,<region_cycles>,0
+
+#define SNAX_TELEMETRY_MAX_SOURCES 8
+
+// How the value returned by a source reader should be interpreted
+enum snax_telemetry_kind {
+    // Free-running counter, the region value is the difference end - begin
+    SNAX_TELEMETRY_CUMULATIVE,
+    // Counter restarted with every task, the region value is read at the end
+    SNAX_TELEMETRY_LAST_TASK,
+};
+
+typedef uint32_t (*snax_telemetry_reader_t)(void);
+
+typedef struct {
+    const char* name;
+    snax_telemetry_reader_t read;
+    enum snax_telemetry_kind kind;
+    uint32_t ideal_cycles;
+    uint32_t begin;
+    uint32_t cycles;
+} snax_telemetry_source_t;
+
+typedef struct {
+    const char* region;
+    uint32_t n_sources;
+    snax_telemetry_source_t sources[SNAX_TELEMETRY_MAX_SOURCES];
+    uint32_t begin_cycle;
+    uint32_t region_cycles;
+    // Cluster counter c measures event cluster_events[c] of cluster_harts[c]
+    uint32_t n_cluster_events;
+    enum snrt_perf_cnt_type cluster_events[SNRT_PERF_N_CNT];
+    uint32_t cluster_harts[SNRT_PERF_N_CNT];
+    uint32_t cluster_counts[SNRT_PERF_N_CNT];
+} snax_telemetry_t;
+
+static inline void snax_telemetry_init(snax_telemetry_t* t,
+                                       const char* region) {
+    t->region = region;
+    t->n_sources = 0;
+    t->region_cycles = 0;
+    t->n_cluster_events = 0;
+}
+
+// Register a perf counter reader. Returns the source index, or -1 if full.
+static inline int32_t snax_telemetry_add(snax_telemetry_t* t,
+                                         const char* name,
+                                         snax_telemetry_reader_t read,
+                                         enum snax_telemetry_kind kind) {
+    if (t->n_sources == SNAX_TELEMETRY_MAX_SOURCES) {
+        return -1;
+    }
+    snax_telemetry_source_t* s = &t->sources[t->n_sources];
+    s->name = name;
+    s->read = read;
+    s->kind = kind;
+    s->ideal_cycles = 0;
+    s->begin = 0;
+    s->cycles = 0;
+    return t->n_sources++;
+}
+
+// Measure a cluster performance counter event of the core with cluster-local
+// index hart over the region, on the next free cluster counter. The counters
+// are shared by the cluster, so they must not be used by anything else during
+// the region. Returns the counter index, or -1 if all counters are taken.
+static inline int32_t snax_telemetry_add_cluster_event(
+    snax_telemetry_t* t, enum snrt_perf_cnt_type event, uint32_t hart) {
+    if (t->n_cluster_events == SNRT_PERF_N_CNT) {
+        return -1;
+    }
+    t->cluster_events[t->n_cluster_events] = event;
+    t->cluster_harts[t->n_cluster_events] = hart;
+    t->cluster_counts[t->n_cluster_events] = 0;
+    return t->n_cluster_events++;
+}
+
+// Set the ideal number of cycles of a source, e.g. M * N * K / PEs
+static inline void snax_telemetry_set_ideal(snax_telemetry_t* t,
+                                            int32_t source,
+                                            uint32_t ideal_cycles) {
+    if (source >= 0 && source < (int32_t)t->n_sources) {
+        t->sources[source].ideal_cycles = ideal_cycles;
+    }
+}
+
+static inline void snax_telemetry_begin(snax_telemetry_t* t) {
+    // Start the cluster counters from zero
+    for (uint32_t c = 0; c < t->n_cluster_events; c++) {
+        snrt_reset_perf_counter((enum snrt_perf_cnt)c);
+        snrt_start_perf_counter((enum snrt_perf_cnt)c, t->cluster_events[c],
+                                t->cluster_harts[c]);
+    }
+    // Sample all sources as close together as possible
+    for (uint32_t i = 0; i < t->n_sources; i++) {
+        t->sources[i].begin = t->sources[i].read();
+    }
+    t->begin_cycle = snrt_mcycle();
+}
+
+static inline void snax_telemetry_end(snax_telemetry_t* t) {
+    uint32_t end_cycle = snrt_mcycle();
+    uint32_t sources[SNAX_TELEMETRY_MAX_SOURCES];
+    for (uint32_t i = 0; i < t->n_sources; i++) {
+        sources[i] = t->sources[i].read();
+    }
+    for (uint32_t c = 0; c < t->n_cluster_events; c++) {
+        snrt_stop_perf_counter((enum snrt_perf_cnt)c);
+        t->cluster_counts[c] = snrt_get_perf_counter((enum snrt_perf_cnt)c);
+    }
+    t->region_cycles = end_cycle - t->begin_cycle;
+    for (uint32_t i = 0; i < t->n_sources; i++) {
+        snax_telemetry_source_t* s = &t->sources[i];
+        s->cycles = s->kind == SNAX_TELEMETRY_CUMULATIVE ? sources[i] - s->begin
+                                                         : sources[i];
+    }
+}
+
+// Utilization of a source in percent: against its ideal cycles if set,
+// otherwise against the region cycles
+static inline uint32_t snax_telemetry_utilization(snax_telemetry_t* t,
+                                                  int32_t source) {
+    snax_telemetry_source_t* s = &t->sources[source];
+    if (s->cycles == 0) {
+        return 0;
+    }
+    if (s->ideal_cycles) {
+        return (uint32_t)(((uint64_t)s->ideal_cycles * 100) / s->cycles);
+    }
+    return (uint32_t)(((uint64_t)s->cycles * 100) / t->region_cycles);
+}
+
+// Print one record per source, and one per cluster event
+static inline void snax_telemetry_report(snax_telemetry_t* t) {
+    for (uint32_t i = 0; i < t->n_sources; i++) {
+        snax_telemetry_source_t* s = &t->sources[i];
+        printf("TELEMETRY,%s,%s,%d,%d,%d,%d\n", t->region, s->name, s->cycles,
+               s->ideal_cycles, t->region_cycles,
+               snax_telemetry_utilization(t, i));
+    }
+    for (uint32_t c = 0; c < t->n_cluster_events; c++) {
+        printf("TELEMETRY,%s,cluster_event%d_hart%d,%d,0,%d,0\n", t->region,
+               t->cluster_events[c], t->cluster_harts[c], t->cluster_counts[c],
+               t->region_cycles);
+    }
+}
@@ -52,6 +52,26 @@ int32_t snax_xdma_row_major_transpose(void* src, void* dst, uint32_t rows,
                                       uint32_t cols,
                                       uint32_t element_width_bits);
 
+// Memset helper.
+// Configures a 1D task that sets size bytes starting at dst to value. Zero-fill
+// disables all reader channels, so no data is read; other values require the
+// writer-side Memset extension, which stays enabled after the call. The caller
+// still needs to launch the task with snax_xdma_start() and wait for completion
+// separately. size must be a multiple of XDMA_WIDTH.
+int32_t snax_xdma_memset(void* dst, uint8_t value, uint32_t size);
+
+// Blocking memset, which launches the task configured by snax_xdma_memset(),
+// waits for it and disables the Memset extension again. Returns nonzero if
+// dst or size is not a multiple of XDMA_WIDTH, or if the value needs the
+// extension and it is not built in.
+int32_t snax_xdma_memset_sync(void* dst, uint8_t value, uint32_t size);
+
+// Route snrt_dma_memset() through the XDMA, for the regions it can handle.
+// The others, as well as snrt_dma_memset_async(), keep using the iDMA.
+static inline void snax_xdma_select_memset() {
+    snrt_dma_set_memset_backend(snax_xdma_memset_sync);
+}
+
 // Multicast Task
 int32_t snax_xdma_multicast_nd_full_address(
     uint64_t src, uint64_t* dst, uint32_t dst_num, uint32_t spatial_stride_src,
@@ -288,6 +288,64 @@ int32_t snax_xdma_memcpy_1d(void* src, void* dst, uint32_t size) {
         temporal_stride, temporal_bound, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF);
 }
 
+int32_t snax_xdma_memset(void* dst, uint8_t value, uint32_t size) {
+    if (size % XDMA_WIDTH != 0) {
+        XDMA_DEBUG_PRINT("Size is not multiple of XDMA_WIDTH\n");
+        return -1;
+    }
+    uint32_t temporal_stride[1] = {XDMA_WIDTH};
+    uint32_t temporal_bound[1] = {size / XDMA_WIDTH};
+    if (value == 0) {
+        // With all reader channels disabled the writer emits zeros
+#ifdef WRITER_EXT_VERILOGMEMSET
+        snax_xdma_disable_dst_ext(WRITER_EXT_VERILOGMEMSET);
+#endif
+        return snax_xdma_memcpy_nd(dst, dst, XDMA_WIDTH / XDMA_SPATIAL_CHAN,
+                                   XDMA_WIDTH / XDMA_SPATIAL_CHAN, 1,
+                                   temporal_stride, temporal_bound, 1,
+                                   temporal_stride, temporal_bound, 0x0,
+                                   0xFFFFFFFF, 0xFFFFFFFF);
+    }
+#ifndef WRITER_EXT_VERILOGMEMSET
+    XDMA_DEBUG_PRINT("Writer memset extension is not available\n");
+    return -5;
+#else
+    int32_t ret = snax_xdma_memcpy_1d(dst, dst, size);
+    if (ret != 0) {
+        return ret;
+    }
+    uint32_t csr_value[1] = {value * 0x01010101U};
+    ret = snax_xdma_enable_dst_ext(WRITER_EXT_VERILOGMEMSET, csr_value);
+    if (ret != 0) {
+        XDMA_DEBUG_PRINT("Failed to enable writer memset extension\n");
+    }
+    return ret;
+#endif
+}
+
+int32_t snax_xdma_memset_sync(void* dst, uint8_t value, uint32_t size) {
+    // Fall back quietly for the regions which snax_xdma_memset() rejects
+    if ((uintptr_t)dst % XDMA_WIDTH != 0 || size % XDMA_WIDTH != 0) {
+        return -1;
+    }
+#ifndef WRITER_EXT_VERILOGMEMSET
+    if (value != 0) {
+        return -5;
+    }
+#endif
+    int32_t ret = snax_xdma_memset(dst, value, size);
+    if (ret != 0) {
+        return ret;
+    }
+    snax_xdma_local_wait(snax_xdma_start());
+#ifdef WRITER_EXT_VERILOGMEMSET
+    if (value != 0) {
+        snax_xdma_disable_dst_ext(WRITER_EXT_VERILOGMEMSET);
+    }
+#endif
+    return 0;
+}
+
 int32_t snax_xdma_multicast_nd_full_address(
     uint64_t src, uint64_t* dst, uint32_t dst_num, uint32_t spatial_stride_src,
     uint32_t spatial_stride_dst, uint32_t temp_dim_src,
@@ -9,12 +9,14 @@ from pathlib import Path
 import subprocess
 import re
 import os
+import json
 from mako.template import Template
 
 
 class Simulation(object):
 
     LOG_FILE = 'sim.txt'
+    BENCH_REGEX = re.compile(r'BENCH (\{.*\})')
 
     def __init__(self, elf=None):
         self.elf = elf
@@ -56,6 +58,25 @@ class Simulation(object):
         with open(self.log, 'r') as f:
             print(f.read())
 
+    def get_bench_records(self):
+        # Extract the records printed by the benchmark harness of the runtime
+        # (`snrt_bench_run()`) from the simulation log
+        records = []
+        if self.log is None or not Path(self.log).exists():
+            return records
+        with open(self.log, 'r') as f:
+            for line in f.readlines():
+                match = self.BENCH_REGEX.search(line)
+                if match:
+                    try:
+                        record = json.loads(match.group(1))
+                    except json.JSONDecodeError:
+                        cprint(f'Malformed benchmark record in {self.log}', 'yellow')
+                        continue
+                    record['test'] = self.testname
+                    records.append(record)
+        return records
+
     def print_status(self):
         if self.completed():
             if self.successful():
@@ -0,0 +1,89 @@
+#!/usr/bin/env python3
+# Copyright 2023 ETH Zurich and University of Bologna.
+# Licensed under the Apache License, Version 2.0, see LICENSE for details.
+# SPDX-License-Identifier: Apache-2.0
+
+# Shared parts of the data generators of the level 1 and 2 BLAS kernels in
+# sw/blas, which take their parameters from an hjson file with the
+# precision in bits under `prec`.
+
+import argparse
+import pathlib
+import hjson
+import numpy as np
+
+from data_utils import emit_license, format_scalar_definition, \
+                       format_vector_definition
+
+C_TYPES = {
+  '64': 'double',
+  '32': 'float',
+  '16': '__fp16'
+}
+
+NUMPY_TYPES = {
+  '64': np.double,
+  '32': np.single,
+  '16': np.half
+}
+
+# Relative error tolerated by the on-device check of every kernel, per
+# precision. FP16 products are accumulated in FP32 by the reductions, the
+# element-wise kernels round every result to FP16.
+TOLERANCES = {
+  'dot':  {'64': 1e-10, '32': 1e-4, '16': 1e-3},
+  'nrm2': {'64': 1e-10, '32': 1e-4, '16': 1e-3},
+  'asum': {'64': 1e-10, '32': 1e-4, '16': 1e-3},
+  'scal': {'64': 1e-12, '32': 1e-6, '16': 2e-3},
+  'gemv': {'64': 1e-10, '32': 1e-4, '16': 2e-3},
+  'ger':  {'64': 1e-12, '32': 1e-6, '16': 4e-3}
+}
+
+# AXI splits bursts crossing 4KB address boundaries. To minimize
+# the occurrence of these splits the data should be aligned to 4KB
+BURST_ALIGNMENT = 4096
+
+
+def random_operand(prec, shape):
+    """Uniformly distributed operand in [-1, 1) of the given precision."""
+    return np.random.uniform(-1, 1, shape).astype(NUMPY_TYPES[str(prec)])
+
+
+def format_operand(prec, uid, operand, section):
+    """Definition of an operand in main memory, aligned to a burst."""
+    return format_vector_definition(C_TYPES[str(prec)], uid, operand.flatten(),
+                                    alignment=BURST_ALIGNMENT, section=section)
+
+
+def format_check(kernel, prec):
+    """Definitions of the operand size and tolerance read by the check."""
+    return [format_scalar_definition('uint32_t', 'dtype_size', prec // 8),
+            format_scalar_definition('double', 'tolerance',
+                                     TOLERANCES[kernel][str(prec)])]
+
+
+def main(emit_header, section_help='Section to store vectors in'):
+    """Parse the arguments and print a header with the definitions returned
+    by emit_header, which is called with the parameters of the config file
+    and `section`."""
+    parser = argparse.ArgumentParser(description='Generate data for kernels')
+    parser.add_argument(
+        "-c", "--cfg",
+        type=pathlib.Path,
+        required=True,
+        help='Select param config file kernel'
+    )
+    parser.add_argument(
+        '--section',
+        type=str,
+        help=section_help)
+    args = parser.parse_args()
+
+    # Load param config file
+    with args.cfg.open() as f:
+        param = hjson.loads(f.read())
+    param['section'] = args.section
+
+    # Emit header file
+    np.random.seed(42)
+    print('\n\n'.join([emit_license()] + emit_header(**param)))
@@ -0,0 +1,92 @@
+#!/usr/bin/env python3
+# Copyright 2023 ETH Zurich and University of Bologna.
+# Licensed under the Apache License, Version 2.0, see LICENSE for details.
+# SPDX-License-Identifier: Apache-2.0
+#
+# Converts the region records emitted by the snRuntime profiler
+# (`sw/snRuntime/src/profile.h`) to CSV.
+
+import argparse
+import csv
+import struct
+
+# Must match `enum snrt_perf_cnt_type` in `sw/snRuntime/src/perf_cnt.h`
+EVENTS = [
+    'cnt_cycles', 'tcdm_accessed', 'tcdm_congested', 'issue_fpu',
+    'issue_fpu_seq', 'issue_core_to_fpu', 'retired_instr', 'retired_load',
+    'retired_i', 'retired_acc', 'dma_aw_stall', 'dma_ar_stall',
+    'dma_r_stall', 'dma_w_stall', 'dma_buf_w_stall', 'dma_buf_r_stall',
+    'dma_aw_done', 'dma_aw_bw', 'dma_ar_done', 'dma_ar_bw', 'dma_r_done',
+    'dma_r_bw', 'dma_w_done', 'dma_w_bw', 'dma_b_done', 'dma_busy',
+    'icache_miss', 'icache_hit', 'icache_prefetch', 'icache_double_hit',
+    'icache_stall'
+]
+
+# Must match `snrt_profile_record_t` and `SNRT_PERF_N_CNT`
+NAME_LEN = 16
+RECORD_FMT = f'<{NAME_LEN}s3I32I'
+RECORD_SIZE = struct.calcsize(RECORD_FMT)
+MAX_REGIONS = 8
+N_COUNTERS = 16
+
+
+def parse_records(raw):
+    """Parse the raw `snrt_profile_records` array into a list of dicts.
+
+    Multiplexed events are scaled from the runs in which they were actually
+    measured to the total number of runs of the region.
+    """
+    records = []
+    for i in range(len(raw) // RECORD_SIZE):
+        fields = struct.unpack_from(RECORD_FMT, raw, i * RECORD_SIZE)
+        name, runs, cycles, event_mask = fields[:4]
+        counts = fields[4:]
+        if runs == 0:
+            continue
+        events = [e for e in range(len(EVENTS)) if event_mask & (1 << e)]
+        n_groups = max(1, -(-len(events) // N_COUNTERS))
+        record = {
+            'cluster': i // MAX_REGIONS,
+            'region': name.rstrip(b'\0').decode(errors='replace'),
+            'runs': runs,
+            'cycles': cycles,
+        }
+        for idx, e in enumerate(events):
+            # Round-robin group assignment, see `snrt_profile_begin()`
+            group = idx // N_COUNTERS
+            measured = runs // n_groups + (group < runs % n_groups)
+            if measured:
+                record[EVENTS[e]] = counts[e] * runs / measured
+        records.append(record)
+    return records
+
+
+def dump_records_to_csv(records, path):
+    fields = ['cluster', 'region', 'runs', 'cycles']
+    fields += [e for e in EVENTS if any(e in r for r in records)]
+    with open(path, 'w') as csv_file:
+        csv_writer = csv.DictWriter(csv_file, fieldnames=fields)
+        csv_writer.writeheader()
+        csv_writer.writerows(records)
+    print(f"Wrote profile to {path}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument(
+        'dump',
+        help='Binary dump of the `snrt_profile_records` symbol, e.g. as '
+             'returned by `verification.simulate()`')
+    parser.add_argument(
+        '-o', '--output',
+        default='profile.csv',
+        help='Path of the output CSV file')
+    args = parser.parse_args()
+
+    with open(args.dump, 'rb') as f:
+        raw = f.read()
+    dump_records_to_csv(parse_records(raw), args.output)
+
+
+if __name__ == '__main__':
+    main()
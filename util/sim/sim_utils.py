@@ -9,6 +9,7 @@ from termcolor import colored, cprint
 from pathlib import Path
 import os
 import time
+import json
 import yaml
 import signal
 import psutil
@@ -55,6 +56,13 @@ def parser(default_simulator='vsim', simulator_choices=['vsim']):
         help=('Maximum number of tests to run in parallel. '
               'One if the option is not present. Equal to the number of CPU cores '
               'if the option is present but not followed by an argument.'))
+    parser.add_argument(
+        '--bench-report',
+        action='store',
+        nargs='?',
+        const='bench.json',
+        help=('Collect the records of the benchmark harness from the simulation logs '
+              'into a JSON report. Defaults to bench.json if no path is given.'))
     return parser
 
 
@@ -112,6 +120,43 @@ def print_summary(failed_sims, early_exit=False, dry_run=False):
             print(f'{colored("All tests passed!", "green")}')
 
 
+# Aggregate the benchmark records of all runs of a kernel in a test
+def summarize_bench_records(records):
+    groups = {}
+    for record in records:
+        groups.setdefault((record['test'], record['name']), []).append(record)
+    summary = []
+    for (test, name), runs in groups.items():
+        cycles = [run['cycles'] for run in runs]
+        fastest = min(runs, key=lambda run: run['cycles'])
+        summary.append({
+            'test': test,
+            'name': name,
+            'runs': len(runs),
+            'min_cycles': min(cycles),
+            'mean_cycles': sum(cycles) / len(cycles),
+            'max_cycles': max(cycles),
+            'flops': fastest['flops'],
+            'flop_per_cycle': fastest['flop_per_cycle'],
+            'peak_flop_per_cycle': fastest['peak_flop_per_cycle'],
+            'utilization': fastest['utilization'],
+            'fpu_util': fastest['fpu_util']
+        })
+    return summary
+
+
+def write_bench_report(simulations, path):
+    records = [record for sim in simulations for record in sim.get_bench_records()]
+    summary = summarize_bench_records(records)
+    with open(path, 'w') as f:
+        json.dump({'summary': summary, 'records': records}, f, indent=4)
+    cprint(f'==== Benchmark summary ({path}) ====', attrs=['bold'])
+    for entry in summary:
+        print(f'{entry["test"]}/{entry["name"]}: {entry["min_cycles"]} cycles, '
+              f'{entry["flop_per_cycle"]:.3f} FLOP/cycle '
+              f'({100 * entry["utilization"]:.1f}% of {entry["peak_flop_per_cycle"]})')
+
+
 def terminate_simulations():
     print('Terminating simulations')
     # Get PID and PGID of parent process (current Python script)
@@ -124,13 +169,15 @@ def terminate_simulations():
             os.kill(pid, signal.SIGKILL)
 
 
-def run_simulations(simulations, n_procs=1, run_dir=None, dry_run=False, early_exit=False):
+def run_simulations(simulations, n_procs=1, run_dir=None, dry_run=False, early_exit=False,
+                    bench_report=None):
     # Register SIGTERM handler, used to gracefully terminate all simulation subprocesses
     signal.signal(signal.SIGTERM, lambda _, __: terminate_simulations())
 
     # Spawn a process for every test, wait for all running tests to terminate and check results
     running_sims = []
     failed_sims = []
+    completed_sims = []
     early_exit_requested = False
     uniquify_run_dir = len(simulations) > 1
     try:
@@ -150,9 +197,10 @@ def run_simulations(simulations, n_procs=1, run_dir=None, dry_run=False, early_e
                 running_sims[-1].launch(run_dir=unique_run_dir, dry_run=dry_run)
             # Remove completed sims from running sims list
             idcs = [i for i, sim in enumerate(running_sims) if dry_run or sim.completed()]
-            completed_sims = [running_sims.pop(i) for i in sorted(idcs, reverse=True)]
+            newly_completed_sims = [running_sims.pop(i) for i in sorted(idcs, reverse=True)]
+            completed_sims.extend(newly_completed_sims)
             # Check completed sims and report status
-            for sim in completed_sims:
+            for sim in newly_completed_sims:
                 if sim.successful():
                     sim.print_status()
                 else:
@@ -173,4 +221,8 @@ def run_simulations(simulations, n_procs=1, run_dir=None, dry_run=False, early_e
 
     # Print summary
     print_summary(failed_sims, early_exit_requested)
+
+    # Collect benchmark records, also of failed simulations
+    if bench_report and not dry_run:
+        write_bench_report(completed_sims, bench_report)
     return len(failed_sims)